@@ -39,6 +39,14 @@ find_package(JeMalloc)
 include_directories(SYSTEM ${JEMALLOC_INCLUDE_DIR})
 list(APPEND Peloton_LINKER_LIBS ${JEMALLOC_LIBRARIES})
 
+# ---[ Liburing (optional, for writing the log through io_uring)
+find_package(Liburing)
+if(LIBURING_FOUND)
+  include_directories(SYSTEM ${LIBURING_INCLUDE_DIR})
+  list(APPEND Peloton_LINKER_LIBS ${LIBURING_LIBRARIES})
+  add_definitions(-DPELOTON_HAVE_LIBURING)
+endif()
+
 # --[ Valgrind
 find_program(MEMORYCHECK_COMMAND valgrind)
 set(MEMORYCHECK_COMMAND_OPTIONS "--trace-children=yes --leak-check=full")
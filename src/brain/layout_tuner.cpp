@@ -10,12 +10,15 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+
 #include "brain/layout_tuner.h"
 #include "brain/clusterer.h"
 
 #include "catalog/schema.h"
 #include "common/logger.h"
 #include "storage/data_table.h"
+#include "storage/tile_group.h"
 
 namespace peloton {
 namespace brain {
@@ -74,28 +77,165 @@ void LayoutTuner::UpdateDefaultPartition(storage::DataTable* table) {
 
 }
 
-void LayoutTuner::Tune(){
+std::vector<oid_t> LayoutTuner::GetTransformCandidates(
+    storage::DataTable* table) {
+  auto& default_layout = table->GetDefaultLayout();
+  auto tile_group_count = table->GetTileGroupCount();
+  oid_t live_tile_group_count = 0;
+  oid_t converged_tile_group_count = 0;
+
+  // only the tile groups still in the table keep their heat
+  auto &table_heat = tile_group_heat[table];
+  std::unordered_map<oid_t, TileGroupHeat> next_table_heat;
+
+  // <heat, tile group offset>
+  std::vector<std::pair<double, oid_t>> candidates;
+
+  for (oid_t tile_group_offset = 0; tile_group_offset < tile_group_count;
+       tile_group_offset++) {
+    auto tile_group = table->GetTileGroup(tile_group_offset);
+    if (tile_group == nullptr) {
+      continue;
+    }
+
+    live_tile_group_count++;
 
+    auto& entry = next_table_heat[tile_group->GetTileGroupId()];
+    auto heat_itr = table_heat.find(tile_group->GetTileGroupId());
+    if (heat_itr != table_heat.end()) {
+      entry = heat_itr->second;
+    }
+    auto access_count = tile_group->GetAccessCount();
+    auto write_count = tile_group->GetWriteCount();
+
+    // Counters start from zero again once a tile group is transformed
+    if (access_count < entry.last_access_count) {
+      entry.last_access_count = 0;
+    }
+    if (write_count < entry.last_write_count) {
+      entry.last_write_count = 0;
+    }
+
+    auto write_delta = write_count - entry.last_write_count;
+    entry.heat = entry.heat * heat_decay +
+                 (access_count - entry.last_access_count);
+    entry.last_access_count = access_count;
+    entry.last_write_count = write_count;
+
+    // Skip tile groups that already have the desired layout
+    if (tile_group->GetSchemaDifference(default_layout) <= theta) {
+      converged_tile_group_count++;
+      continue;
+    }
+
+    // Skip tile groups that are still receiving writes
+    if (write_delta > write_threshold) {
+      continue;
+    }
+
+    candidates.emplace_back(entry.heat, tile_group_offset);
+  }
+
+  table_heat.swap(next_table_heat);
+
+  {
+    std::lock_guard<std::mutex> lock(layout_tuner_mutex);
+    table_convergence[table] =
+        (live_tile_group_count == 0)
+            ? 1.0
+            : (double)converged_tile_group_count / live_tile_group_count;
+  }
+
+  // Hottest tile groups first
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const std::pair<double, oid_t>& lhs,
+                      const std::pair<double, oid_t>& rhs) {
+                     return lhs.first > rhs.first;
+                   });
+
+  if (candidates.size() > max_tile_groups_per_round) {
+    candidates.resize(max_tile_groups_per_round);
+  }
+
+  std::vector<oid_t> tile_group_offsets;
+  for (auto& candidate : candidates) {
+    tile_group_offsets.push_back(candidate.second);
+  }
+
+  return tile_group_offsets;
+}
+
+void LayoutTuner::TransformTileGroups(
+    storage::DataTable* table, const std::vector<oid_t>& tile_group_offsets) {
+  std::atomic<size_t> next_offset(0);
+
+  auto transform = [&]() {
+    size_t itr;
+    while ((itr = next_offset.fetch_add(1)) < tile_group_offsets.size()) {
+      if (layout_tuning_stop == true) {
+        break;
+      }
+      table->TransformTileGroup(tile_group_offsets[itr], theta);
+    }
+  };
+
+  // The tuner thread is one of the workers
+  size_t thread_count = std::min<size_t>(worker_count,
+                                         tile_group_offsets.size());
+  std::vector<std::thread> workers;
+  for (size_t thread_itr = 1; thread_itr < thread_count; thread_itr++) {
+    workers.push_back(std::thread(transform));
+  }
+
+  transform();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void LayoutTuner::Tune(){
 
   // Continue till signal is not false
   while(layout_tuning_stop == false) {
 
-    // Go over all tables
-    for(auto table : tables) {
+    std::vector<storage::DataTable*> current_tables;
+    {
+      std::lock_guard<std::mutex> lock(layout_tuner_mutex);
+      current_tables = tables;
+    }
+
+    // Forget the heat of the tables that are no longer tuned
+    for (auto heat_itr = tile_group_heat.begin();
+         heat_itr != tile_group_heat.end();) {
+      if (std::find(current_tables.begin(), current_tables.end(),
+                    heat_itr->first) == current_tables.end()) {
+        heat_itr = tile_group_heat.erase(heat_itr);
+      } else {
+        ++heat_itr;
+      }
+    }
 
-      // Transform
-      auto tile_group_count = table->GetTileGroupCount();
-      auto tile_group_offset = rand() % tile_group_count;
+    // Go over all tables
+    for(auto table : current_tables) {
 
-      table->TransformTileGroup(tile_group_offset, theta);
+      // Transform the hottest tile groups that have not converged yet
+      auto tile_group_offsets = GetTransformCandidates(table);
+      TransformTileGroups(table, tile_group_offsets);
 
       // Update partitioning periodically
+      // (no transformation is in flight at this point)
       UpdateDefaultPartition(table);
 
       // Sleep a bit
       std::this_thread::sleep_for(std::chrono::microseconds(sleep_duration));
     }
 
+    // Avoid spinning when there are no tables
+    if (current_tables.empty()) {
+      std::this_thread::sleep_for(std::chrono::microseconds(sleep_duration));
+    }
+
   }
 
 }
@@ -123,7 +263,19 @@ void LayoutTuner::ClearTables() {
   {
     std::lock_guard<std::mutex> lock(layout_tuner_mutex);
     tables.clear();
+    table_convergence.clear();
+  }
+}
+
+double LayoutTuner::GetConvergence(storage::DataTable* table) {
+  std::lock_guard<std::mutex> lock(layout_tuner_mutex);
+
+  auto table_itr = table_convergence.find(table);
+  if (table_itr == table_convergence.end()) {
+    return 0.0;
   }
+
+  return table_itr->second;
 }
 
 
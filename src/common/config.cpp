@@ -23,4 +23,16 @@ DEFINE_string(socket_family, "AF_INET", "Socket family (AF_UNIX, AF_INET)");
 DEFINE_uint64(stats_mode, peloton::STATS_TYPE_INVALID,
               "Enable statistics collection (default: STATS_TYPE_INVALID)");
 
+DEFINE_bool(numa_aware, false,
+            "Spread tile groups over NUMA nodes (default: false)");
+
+DEFINE_uint64(hot_tuple_threshold, 0,
+              "Failed acquisitions after which a tuple is hot and "
+              "transactions wait for it instead of aborting, 0 disables "
+              "(default: 0)");
+
+DEFINE_uint64(concurrency_type, peloton::CONCURRENCY_TYPE_TIMESTAMP_ORDERING,
+              "Concurrency control protocol "
+              "(default: CONCURRENCY_TYPE_TIMESTAMP_ORDERING)");
+
 DEFINE_bool(h, false, "Show help");
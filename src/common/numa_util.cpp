@@ -0,0 +1,167 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// numa_util.cpp
+//
+// Identification: src/common/numa_util.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "common/numa_util.h"
+#include "common/logger.h"
+
+// Memory policy constants (see linux/mempolicy.h)
+#define NUMA_MPOL_PREFERRED 1
+
+namespace peloton {
+
+// Parse a sysfs cpu list such as "0-3,8-11"
+static std::vector<int> ParseCpuList(const std::string &cpu_list) {
+  std::vector<int> cpus;
+  std::stringstream cpu_list_stream(cpu_list);
+  std::string range;
+
+  while (std::getline(cpu_list_stream, range, ',')) {
+    if (range.empty()) {
+      continue;
+    }
+
+    auto separator = range.find('-');
+    int first = std::stoi(range.substr(0, separator));
+    int last = first;
+    if (separator != std::string::npos) {
+      last = std::stoi(range.substr(separator + 1));
+    }
+
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+const std::vector<std::vector<int>> &NumaUtil::GetNodeCpus() {
+  static std::vector<std::vector<int>> node_cpus = []() {
+    std::vector<std::vector<int>> cpus;
+
+    for (int node = 0;; node++) {
+      std::ifstream cpu_list_file("/sys/devices/system/node/node" +
+                                  std::to_string(node) + "/cpulist");
+      if (cpu_list_file.good() == false) {
+        break;
+      }
+
+      std::string cpu_list;
+      std::getline(cpu_list_file, cpu_list);
+      cpus.push_back(ParseCpuList(cpu_list));
+    }
+
+    // No NUMA support, treat the machine as a single node
+    if (cpus.empty()) {
+      std::vector<int> all_cpus;
+      auto cpu_count = sysconf(_SC_NPROCESSORS_CONF);
+      for (int cpu = 0; cpu < cpu_count; cpu++) {
+        all_cpus.push_back(cpu);
+      }
+      cpus.push_back(all_cpus);
+    }
+
+    LOG_TRACE("NUMA node count : %lu", cpus.size());
+    return cpus;
+  }();
+
+  return node_cpus;
+}
+
+int NumaUtil::GetNodeCount() { return GetNodeCpus().size(); }
+
+int NumaUtil::GetCurrentNode() {
+  auto cpu = sched_getcpu();
+  if (cpu < 0) {
+    return 0;
+  }
+
+  auto &node_cpus = GetNodeCpus();
+  for (size_t node = 0; node < node_cpus.size(); node++) {
+    for (auto node_cpu : node_cpus[node]) {
+      if (node_cpu == cpu) {
+        return node;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int NumaUtil::GetTileGroupNode(const oid_t &tile_group_id) {
+  return tile_group_id % GetNodeCount();
+}
+
+bool NumaUtil::PinCurrentThread(const int &numa_node) {
+  auto &node_cpus = GetNodeCpus();
+  if (numa_node < 0 || numa_node >= (int)node_cpus.size()) {
+    return false;
+  }
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (auto cpu : node_cpus[numa_node]) {
+    CPU_SET(cpu, &cpu_set);
+  }
+
+  int status = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                      &cpu_set);
+  if (status != 0) {
+    LOG_ERROR("Could not pin thread to node %d", numa_node);
+    return false;
+  }
+
+  return true;
+}
+
+void *NumaUtil::AllocateOnNode(const size_t &length, const int &numa_node) {
+  // Nothing to do on a single node
+  if (GetNodeCount() <= 1 || numa_node < 0 || numa_node >= GetNodeCount() ||
+      length == 0) {
+    return nullptr;
+  }
+
+  void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (address == MAP_FAILED) {
+    LOG_ERROR("Could not map memory for node %d", numa_node);
+    return nullptr;
+  }
+
+  // the policy is set before the pages are faulted in, so none has to move
+  unsigned long node_mask = 1UL << numa_node;
+  long status = syscall(SYS_mbind, address, length, NUMA_MPOL_PREFERRED,
+                        &node_mask, sizeof(node_mask) * 8, 0);
+  if (status != 0) {
+    LOG_TRACE("Could not bind memory to node %d", numa_node);
+  }
+
+  return address;
+}
+
+void NumaUtil::FreeOnNode(void *address, const size_t &length) {
+  if (munmap(address, length) != 0) {
+    LOG_ERROR("Could not unmap memory");
+  }
+}
+
+}  // End peloton namespace
@@ -963,6 +963,9 @@ std::string LogRecordTypeToString(LogRecordType type) {
     case LOGRECORD_TYPE_ITERATION_DELIMITER: {
       return "LOGRECORD_TYPE_ITERATION_DELIMITER";
     }
+    case LOGRECORD_TYPE_CHECKPOINT_FULL: {
+      return "LOGRECORD_TYPE_CHECKPOINT_FULL";
+    }
   }
   return "INVALID";
 }
@@ -0,0 +1,431 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// ssi_transaction_manager.cpp
+//
+// Identification: src/concurrency/ssi_transaction_manager.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/ssi_transaction_manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catalog/manager.h"
+#include "common/logger.h"
+#include "concurrency/transaction.h"
+#include "logging/log_manager.h"
+
+namespace peloton {
+namespace concurrency {
+
+SsiTransactionManager &SsiTransactionManager::GetInstance() {
+  static SsiTransactionManager txn_manager;
+  return txn_manager;
+}
+
+// an insert conflicts with the latest committed or pending version of the
+// key, whether or not it is in the snapshot of the transaction.
+bool SsiTransactionManager::IsOccupied(Transaction *const current_txn,
+                                       const ItemPointer &position) {
+  auto tile_group_header =
+      catalog::Manager::GetInstance().GetTileGroup(position.block)->GetHeader();
+  auto tuple_id = position.offset;
+
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  if (tuple_txn_id == INVALID_TXN_ID) {
+    // the tuple is not available.
+    return false;
+  }
+
+  if (current_txn->GetTransactionId() == tuple_txn_id) {
+    // only the newly inserted or updated version is visible.
+    return tuple_begin_cid == MAX_CID && tuple_end_cid != INVALID_CID;
+  }
+
+  if (tuple_txn_id != INITIAL_TXN_ID) {
+    // a dirty delete is invisible, anything else owned by another
+    // transaction is either a dirty version or the version it replaces.
+    return !(tuple_begin_cid == MAX_CID && tuple_end_cid == INVALID_CID);
+  }
+
+  // the latest committed version.
+  return tuple_end_cid == MAX_CID;
+}
+
+// only the latest version can be owned, and only if it is in the snapshot of
+// the transaction (first-updater-wins).
+bool SsiTransactionManager::IsOwnable(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  auto tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  auto tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  return tuple_txn_id == INITIAL_TXN_ID &&
+         tuple_begin_cid <= current_txn->GetBeginCommitId() &&
+         tuple_end_cid == MAX_CID;
+}
+
+bool SsiTransactionManager::AcquireOwnership(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  // read-only transactions never write.
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return false;
+  }
+
+  if (tile_group_header->SetAtomicTransactionId(
+          tuple_id, current_txn->GetTransactionId()) == false) {
+    return false;
+  }
+
+  // a concurrent transaction may have committed a newer version between the
+  // ownership check and the acquisition.
+  if (tile_group_header->GetEndCommitId(tuple_id) != MAX_CID) {
+    tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+    return false;
+  }
+
+  auto txn_context = GetTxnContext(current_txn->GetTransactionId());
+  PL_ASSERT(txn_context != nullptr);
+
+  *GetOverwriterField(tile_group_header, tuple_id) =
+      current_txn->GetTransactionId();
+
+  // every reader that recorded the version before the ownership was taken
+  // is marked here, the later ones see the owner in PerformRead.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  std::vector<std::shared_ptr<SsiTxnContext>> txn_contexts;
+  {
+    auto locked_table = txn_table_.lock_table();
+    for (auto &txn_entry : locked_table) {
+      if (txn_entry.first != current_txn->GetTransactionId()) {
+        txn_contexts.push_back(txn_entry.second);
+      }
+    }
+  }
+
+  ItemPointer location(tile_group_header->GetTileGroup()->GetTileGroupId(),
+                       tuple_id);
+  for (auto &reader_context : txn_contexts) {
+    reader_context->lock.Lock();
+    bool has_read = reader_context->read_set.count(location) != 0;
+    reader_context->lock.Unlock();
+
+    if (has_read == true) {
+      AddConflict(reader_context, txn_context);
+    }
+  }
+
+  return true;
+}
+
+// a read registers on the version it reads, and marks the transaction that
+// owns or has overwritten the version.
+bool SsiTransactionManager::PerformRead(Transaction *const current_txn,
+                                        const ItemPointer &location) {
+  LOG_TRACE("PerformRead (%u, %u)\n", location.block, location.offset);
+
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return TimestampOrderingTransactionManager::PerformRead(current_txn,
+                                                            location);
+  }
+
+  auto tile_group_header = catalog::Manager::GetInstance()
+                               .GetTileGroup(location.block)
+                               ->GetHeader();
+  auto tuple_id = location.offset;
+
+  if (IsOwner(current_txn, tile_group_header, tuple_id) == false &&
+      RegisterRead(current_txn, location) == false) {
+    LOG_TRACE("Read into a committed pivot");
+    return false;
+  }
+
+  // Increment table read op stats
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance().IncrementTableReads(
+        location.block);
+  }
+  return true;
+}
+
+bool SsiTransactionManager::RegisterRead(Transaction *const current_txn,
+                                         const ItemPointer &location) {
+  auto tile_group_header = catalog::Manager::GetInstance()
+                               .GetTileGroup(location.block)
+                               ->GetHeader();
+  auto tuple_id = location.offset;
+  txn_id_t txn_id = current_txn->GetTransactionId();
+  auto txn_context = GetTxnContext(txn_id);
+  PL_ASSERT(txn_context != nullptr);
+
+  current_txn->RecordRead(location);
+
+  txn_context->lock.Lock();
+  txn_context->read_set.insert(location);
+  txn_context->lock.Unlock();
+
+  // a writer that takes the ownership from now on finds the read in the
+  // read set, an earlier one is found on the tuple header.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  COMPILER_MEMORY_FENCE;
+  txn_id_t overwriter_id = *GetOverwriterField(tile_group_header, tuple_id);
+
+  txn_id_t writer_id = INVALID_TXN_ID;
+  if (tuple_txn_id != INITIAL_TXN_ID && tuple_txn_id != INVALID_TXN_ID) {
+    // a concurrent transaction owns the version.
+    writer_id = tuple_txn_id;
+  } else if (tuple_end_cid != MAX_CID && tuple_end_cid != INVALID_CID &&
+             tuple_end_cid > current_txn->GetBeginCommitId()) {
+    // a concurrent transaction has committed a newer version.
+    writer_id = overwriter_id;
+  }
+
+  if (writer_id != INVALID_TXN_ID) {
+    auto writer_context = GetTxnContext(writer_id);
+    if (writer_context != nullptr) {
+      return AddConflict(txn_context, writer_context);
+    }
+  }
+  return true;
+}
+
+// a version owned by a transaction that is installing a commit below the
+// begin commit id is waited for, so the snapshot never holds half a commit.
+VisibilityType SsiTransactionManager::IsVisible(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+
+  if (tuple_txn_id != INITIAL_TXN_ID && tuple_txn_id != INVALID_TXN_ID &&
+      tuple_txn_id != current_txn->GetTransactionId()) {
+    auto owner_context = GetTxnContext(tuple_txn_id);
+    if (owner_context != nullptr) {
+      cid_t owner_commit_cid = WaitForCommitId(*owner_context);
+      if (owner_commit_cid != MAX_CID && owner_commit_cid != INVALID_CID &&
+          owner_commit_cid < current_txn->GetBeginCommitId()) {
+        while (tile_group_header->GetTransactionId(tuple_id) ==
+               tuple_txn_id) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+
+  return TimestampOrderingTransactionManager::IsVisible(
+      current_txn, tile_group_header, tuple_id);
+}
+
+void SsiTransactionManager::InitTupleReserved(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t tuple_id) {
+  TimestampOrderingTransactionManager::InitTupleReserved(tile_group_header,
+                                                         tuple_id);
+
+  auto reserved_area = tile_group_header->GetReservedFieldRef(tuple_id);
+  *(txn_id_t *)(reserved_area + OVERWRITER_OFFSET) = INVALID_TXN_ID;
+}
+
+txn_id_t *SsiTransactionManager::GetOverwriterField(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  return (txn_id_t *)(tile_group_header->GetReservedFieldRef(tuple_id) +
+                      OVERWRITER_OFFSET);
+}
+
+std::shared_ptr<SsiTransactionManager::SsiTxnContext>
+SsiTransactionManager::GetTxnContext(const txn_id_t &txn_id) {
+  std::shared_ptr<SsiTxnContext> txn_context;
+  if (txn_table_.find(txn_id, txn_context) == false) {
+    return nullptr;
+  }
+  return txn_context;
+}
+
+cid_t SsiTransactionManager::WaitForCommitId(
+    const SsiTxnContext &txn_context) {
+  cid_t commit_cid = txn_context.commit_cid.load();
+  while (commit_cid == COMMITTING_CID) {
+    std::this_thread::yield();
+    commit_cid = txn_context.commit_cid.load();
+  }
+  return commit_cid;
+}
+
+bool SsiTransactionManager::AddConflict(
+    const std::shared_ptr<SsiTxnContext> &reader,
+    const std::shared_ptr<SsiTxnContext> &writer) {
+  if (reader == writer) {
+    return true;
+  }
+
+  cid_t reader_commit_cid = WaitForCommitId(*reader);
+  cid_t writer_commit_cid = WaitForCommitId(*writer);
+  if (reader_commit_cid == INVALID_CID || writer_commit_cid == INVALID_CID) {
+    // aborted transactions have no edges.
+    return true;
+  }
+  if (reader_commit_cid < writer->begin_cid ||
+      writer_commit_cid < reader->begin_cid) {
+    // the transactions did not run concurrently.
+    return true;
+  }
+
+  writer->lock.Lock();
+  writer->in_conflict = true;
+  bool is_pivot = writer->decided && writer->dangerous_out;
+  writer->lock.Unlock();
+
+  reader->lock.Lock();
+  if (std::find(reader->out_txns.begin(), reader->out_txns.end(), writer) ==
+      reader->out_txns.end()) {
+    reader->out_txns.push_back(writer);
+  }
+  reader->lock.Unlock();
+
+  return !is_pivot;
+}
+
+void SsiTransactionManager::ReclaimTxnContexts(const txn_id_t &txn_id,
+                                               const cid_t &commit_cid) {
+  std::lock_guard<std::mutex> lock(reclaim_mutex_);
+
+  committed_txns_[commit_cid] = txn_id;
+
+  // a context is only needed by transactions that began before its commit.
+  cid_t max_committed_cid = GetMaxCommittedCid();
+  auto txn_itr = committed_txns_.begin();
+  while (txn_itr != committed_txns_.end() &&
+         txn_itr->first <= max_committed_cid) {
+    auto txn_context = GetTxnContext(txn_itr->second);
+    if (txn_context != nullptr) {
+      // break the reference cycles between partners.
+      txn_context->lock.Lock();
+      txn_context->out_txns.clear();
+      txn_context->lock.Unlock();
+      txn_table_.erase(txn_itr->second);
+    }
+    txn_itr = committed_txns_.erase(txn_itr);
+  }
+}
+
+Result SsiTransactionManager::CommitTransaction(
+    Transaction *const current_txn) {
+  LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return CommitReadonlyTransaction(current_txn);
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+
+  auto &rw_set = current_txn->GetRWSet();
+
+  oid_t database_id = 0;
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    if (!rw_set.empty()) {
+      database_id =
+          manager.GetTileGroup(rw_set.begin()->first)->GetDatabaseId();
+    }
+  }
+
+  auto txn_context = GetTxnContext(current_txn->GetTransactionId());
+  PL_ASSERT(txn_context != nullptr);
+
+  // waits for a group commit of the write behind log, so it is done before
+  // the commit id is drawn.
+  logging::LogManager::GetInstance().RegisterDirtyTileGroups(current_txn);
+
+  // a partner that reads the commit id while it is drawn waits for it.
+  txn_context->commit_cid = COMMITTING_CID;
+  cid_t end_commit_id = GetNextCommitId();
+  txn_context->commit_cid = end_commit_id;
+
+  // out partners added from now on commit after this transaction.
+  txn_context->lock.Lock();
+  auto out_txns = txn_context->out_txns;
+  txn_context->lock.Unlock();
+
+  bool dangerous_out = false;
+  for (auto &out_txn : out_txns) {
+    cid_t out_commit_cid = WaitForCommitId(*out_txn);
+    if (out_commit_cid != INVALID_CID && out_commit_cid < end_commit_id) {
+      dangerous_out = true;
+      break;
+    }
+  }
+
+  // an in edge added after the decision aborts the transaction adding it.
+  txn_context->lock.Lock();
+  bool is_pivot = txn_context->in_conflict && dangerous_out;
+  txn_context->dangerous_out = dangerous_out;
+  txn_context->decided = !is_pivot;
+  txn_context->lock.Unlock();
+
+  if (is_pivot == true) {
+    logging::LogManager::GetInstance().ReleaseDirtyTileGroups(INVALID_CID);
+    LOG_TRACE("Transaction aborted by serialization failure");
+    return AbortTransaction(current_txn);
+  }
+
+  // the writes are visible before they are logged, see timestamp ordering.
+  logging::LogManager::GetInstance().PrepareLogging();
+
+  std::vector<logging::LogWrite> log_writes;
+  InstallWriteSet(current_txn, end_commit_id, log_writes);
+
+  ReclaimTxnContexts(current_txn->GetTransactionId(), end_commit_id);
+
+  if (logging::LogManager::GetInstance().LogTransaction(
+          end_commit_id, log_writes, current_txn->IsSyncCommit()) == false) {
+    SetTransactionResult(current_txn, RESULT_FAILURE);
+  }
+
+  Result result = current_txn->GetResult();
+
+  EndTransaction(current_txn);
+
+  // Increment # txns committed metric
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance()
+        .GetDatabaseMetric(database_id)
+        ->IncrementTxnCommitted();
+  }
+
+  return result;
+}
+
+Result SsiTransactionManager::AbortTransaction(
+    Transaction *const current_txn) {
+  auto txn_context = GetTxnContext(current_txn->GetTransactionId());
+  if (txn_context != nullptr) {
+    txn_context->commit_cid = INVALID_CID;
+
+    txn_context->lock.Lock();
+    txn_context->out_txns.clear();
+    txn_context->lock.Unlock();
+
+    txn_table_.erase(current_txn->GetTransactionId());
+  }
+
+  return TimestampOrderingTransactionManager::AbortTransaction(current_txn);
+}
+
+}  // End concurrency namespace
+}  // End peloton namespace
@@ -0,0 +1,1032 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// timestamp_ordering_rb_transaction_manager.cpp
+//
+// Identification:
+// src/concurrency/timestamp_ordering_rb_transaction_manager.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/timestamp_ordering_rb_transaction_manager.h"
+
+#include "catalog/manager.h"
+#include "common/logger.h"
+#include "common/platform.h"
+#include "common/pool.h"
+#include "concurrency/transaction.h"
+#include "expression/container_tuple.h"
+#include "gc/gc_manager_factory.h"
+#include "index/index.h"
+#include "logging/log_manager.h"
+#include "storage/data_table.h"
+#include "storage/tuple.h"
+
+namespace peloton {
+namespace concurrency {
+
+TimestampOrderingRbTransactionManager::
+    ~TimestampOrderingRbTransactionManager() {
+  for (auto rb_seg_pool : garbage_rb_seg_pools_) {
+    delete rb_seg_pool;
+  }
+}
+
+TimestampOrderingRbTransactionManager &
+TimestampOrderingRbTransactionManager::GetInstance() {
+  static TimestampOrderingRbTransactionManager txn_manager;
+  return txn_manager;
+}
+
+char *TimestampOrderingRbTransactionManager::GetRbSeg(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  return *(char **)(tile_group_header->GetReservedFieldRef(tuple_id) +
+                    RB_SEG_OFFSET);
+}
+
+void TimestampOrderingRbTransactionManager::SetRbSeg(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id, const char *rb_seg) {
+  *(const char **)(tile_group_header->GetReservedFieldRef(tuple_id) +
+                   RB_SEG_OFFSET) = rb_seg;
+}
+
+uint64_t TimestampOrderingRbTransactionManager::GetMasterSeq(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  return *(volatile uint64_t *)(tile_group_header->GetReservedFieldRef(
+                                    tuple_id) +
+                                RB_SEQ_OFFSET);
+}
+
+// every write gets a new sequence number, also when the previous one was
+// never finished.
+void TimestampOrderingRbTransactionManager::StartMasterWrite(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  uint64_t *seq_ptr = (uint64_t *)(tile_group_header->GetReservedFieldRef(
+                                       tuple_id) +
+                                   RB_SEQ_OFFSET);
+  *seq_ptr += ((*seq_ptr & 1) == 0) ? 1 : 2;
+
+  COMPILER_MEMORY_FENCE;
+}
+
+void TimestampOrderingRbTransactionManager::FinishMasterWrite(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  COMPILER_MEMORY_FENCE;
+
+  uint64_t *seq_ptr = (uint64_t *)(tile_group_header->GetReservedFieldRef(
+                                       tuple_id) +
+                                   RB_SEQ_OFFSET);
+  if ((*seq_ptr & 1) == 1) {
+    *seq_ptr += 1;
+  }
+}
+
+storage::RollbackSegmentPool *
+TimestampOrderingRbTransactionManager::GetRbSegPool(
+    Transaction *const current_txn) {
+  auto rb_seg_pool = current_txn->GetRbSegPool();
+  if (rb_seg_pool == nullptr) {
+    rb_seg_pool = new storage::RollbackSegmentPool(BACKEND_TYPE_MM);
+    current_txn->SetRbSegPool(rb_seg_pool);
+  }
+  return rb_seg_pool;
+}
+
+bool TimestampOrderingRbTransactionManager::IsOccupied(
+    Transaction *const current_txn, const ItemPointer &position) {
+  auto tile_group_header =
+      catalog::Manager::GetInstance().GetTileGroup(position.block)->GetHeader();
+  auto tuple_id = position.offset;
+
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  if (tuple_txn_id == INVALID_TXN_ID) {
+    // the tuple is not available.
+    return false;
+  }
+
+  if (current_txn->GetTransactionId() == tuple_txn_id) {
+    // the tuple is occupied unless the current transaction deleted it.
+    return tuple_end_cid != INVALID_CID;
+  }
+
+  if (tuple_txn_id != INITIAL_TXN_ID && tuple_end_cid == INVALID_CID) {
+    // dirty delete is invisible
+    return false;
+  }
+
+  // dirty inserts and updates are visible. a committed tuple is occupied
+  // until it is deleted.
+  return current_txn->GetBeginCommitId() < tuple_end_cid;
+}
+
+// Visibility check of the master version. VISIBILITY_INVISIBLE means that an
+// older version may still be visible through the rollback segments.
+VisibilityType TimestampOrderingRbTransactionManager::IsVisible(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+
+  if (tuple_txn_id == INVALID_TXN_ID) {
+    // aborted or deleted tuple
+    return VISIBILITY_INVISIBLE;
+  }
+
+  // the master version is the one written by the current transaction.
+  if (current_txn->GetTransactionId() == tuple_txn_id) {
+    if (tuple_end_cid == INVALID_CID) {
+      // tuple being deleted by current txn
+      return VISIBILITY_DELETED;
+    }
+    return VISIBILITY_OK;
+  }
+
+  if (tuple_begin_cid == MAX_CID) {
+    // uncommitted insert or update. we do not allow cascading abort, so
+    // the committed version, if any, has to be rebuilt from the rollback
+    // segments.
+    return VISIBILITY_INVISIBLE;
+  }
+
+  if (tuple_txn_id != INITIAL_TXN_ID && tuple_end_cid == INVALID_CID) {
+    // the delete is not committed yet.
+    tuple_end_cid = MAX_CID;
+  }
+
+  bool activated = (current_txn->GetBeginCommitId() >= tuple_begin_cid);
+  bool invalidated = (current_txn->GetBeginCommitId() >= tuple_end_cid);
+
+  if (activated && !invalidated) {
+    return VISIBILITY_OK;
+  } else if (activated && invalidated) {
+    return VISIBILITY_DELETED;
+  } else {
+    return VISIBILITY_INVISIBLE;
+  }
+}
+
+// the master version must also be visible, as it is updated in place.
+bool TimestampOrderingRbTransactionManager::IsOwnable(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  auto tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  auto tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  return tuple_txn_id == INITIAL_TXN_ID &&
+         tuple_begin_cid <= current_txn->GetBeginCommitId() &&
+         tuple_end_cid > current_txn->GetBeginCommitId();
+}
+
+void TimestampOrderingRbTransactionManager::PerformInsert(
+    Transaction *const current_txn, const ItemPointer &location,
+    ItemPointer *index_entry_ptr) {
+  TimestampOrderingTransactionManager::PerformInsert(current_txn, location,
+                                                     index_entry_ptr);
+
+  auto tile_group_header = catalog::Manager::GetInstance()
+                               .GetTileGroup(location.block)
+                               ->GetHeader();
+  SetRbSeg(tile_group_header, location.offset, nullptr);
+}
+
+void TimestampOrderingRbTransactionManager::PerformUpdateWithRb(
+    Transaction *const current_txn, const ItemPointer &location,
+    const TargetList &target_list) {
+  auto tile_group = catalog::Manager::GetInstance().GetTileGroup(location.block);
+  auto tile_group_header = tile_group->GetHeader();
+  auto tuple_id = location.offset;
+
+  PL_ASSERT(tile_group_header->GetTransactionId(tuple_id) ==
+            current_txn->GetTransactionId());
+  PL_ASSERT(tile_group_header->GetEndCommitId(tuple_id) != INVALID_CID);
+
+  auto rb_seg = GetRbSeg(tile_group_header, tuple_id);
+  auto tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+
+  // nothing to save for a tuple inserted by the current transaction.
+  if ((tuple_begin_cid == MAX_CID && rb_seg == nullptr) ||
+      target_list.empty() == true) {
+    return;
+  }
+
+  auto schema = tile_group->GetAbstractTable()->GetSchema();
+  auto rb_seg_pool = GetRbSegPool(current_txn);
+  expression::ContainerTuple<storage::TileGroup> master_tuple(tile_group.get(),
+                                                              tuple_id);
+
+  if (tuple_begin_cid != MAX_CID) {
+    // first update of the tuple by the current transaction.
+    auto new_rb_seg = rb_seg_pool->CreateSegmentFromTuple(schema, target_list,
+                                                          &master_tuple);
+    storage::RollbackSegmentPool::SetBeginTimeStamp(new_rb_seg,
+                                                    tuple_begin_cid);
+    storage::RollbackSegmentPool::SetNextPtr(new_rb_seg, rb_seg);
+
+    COMPILER_MEMORY_FENCE;
+
+    SetRbSeg(tile_group_header, tuple_id, new_rb_seg);
+
+    COMPILER_MEMORY_FENCE;
+
+    // from now on, readers rebuild the committed version from the segment.
+    tile_group_header->SetBeginCommitId(tuple_id, MAX_CID);
+
+    COMPILER_MEMORY_FENCE;
+
+    StartMasterWrite(tile_group_header, tuple_id);
+
+    current_txn->RecordUpdate(location);
+    return;
+  }
+
+  // the head segment holds the committed values of the columns updated so
+  // far by the current transaction. replace it with a segment that also
+  // holds the columns updated for the first time.
+  std::vector<bool> saved_columns(schema->GetColumnCount(), false);
+  TargetList saved_list;
+  storage::Tuple committed_tuple(schema, true);
+
+  auto col_count = storage::RollbackSegmentPool::GetColCount(rb_seg);
+  for (size_t idx = 0; idx < col_count; ++idx) {
+    auto col_id =
+        storage::RollbackSegmentPool::GetIdOffsetPair(rb_seg, idx)->col_id;
+    committed_tuple.SetValue(
+        col_id, storage::RollbackSegmentPool::GetValue(rb_seg, schema, idx),
+        nullptr);
+    saved_columns[col_id] = true;
+    saved_list.emplace_back(col_id, nullptr);
+  }
+
+  bool has_new_column = false;
+  for (auto &target : target_list) {
+    if (saved_columns[target.first] == false) {
+      committed_tuple.SetValue(target.first,
+                               master_tuple.GetValue(target.first), nullptr);
+      saved_columns[target.first] = true;
+      saved_list.emplace_back(target.first, nullptr);
+      has_new_column = true;
+    }
+  }
+
+  if (has_new_column == false) {
+    StartMasterWrite(tile_group_header, tuple_id);
+    return;
+  }
+
+  auto new_rb_seg = rb_seg_pool->CreateSegmentFromTuple(schema, saved_list,
+                                                        &committed_tuple);
+  storage::RollbackSegmentPool::SetBeginTimeStamp(
+      new_rb_seg, storage::RollbackSegmentPool::GetBeginTimeStamp(rb_seg));
+  storage::RollbackSegmentPool::SetNextPtr(
+      new_rb_seg, storage::RollbackSegmentPool::GetNextPtr(rb_seg));
+
+  COMPILER_MEMORY_FENCE;
+
+  SetRbSeg(tile_group_header, tuple_id, new_rb_seg);
+
+  COMPILER_MEMORY_FENCE;
+
+  StartMasterWrite(tile_group_header, tuple_id);
+}
+
+void TimestampOrderingRbTransactionManager::PerformUpdate(
+    UNUSED_ATTRIBUTE Transaction *const current_txn,
+    UNUSED_ATTRIBUTE const ItemPointer &old_location,
+    UNUSED_ATTRIBUTE const ItemPointer &new_location) {
+  LOG_ERROR("New versions are not installed with rollback segments");
+  PL_ASSERT(false);
+}
+
+void TimestampOrderingRbTransactionManager::PerformDelete(
+    UNUSED_ATTRIBUTE Transaction *const current_txn,
+    UNUSED_ATTRIBUTE const ItemPointer &old_location,
+    UNUSED_ATTRIBUTE const ItemPointer &new_location) {
+  LOG_ERROR("New versions are not installed with rollback segments");
+  PL_ASSERT(false);
+}
+
+// the update has already been recorded by PerformUpdateWithRb, and the
+// master version has been written.
+void TimestampOrderingRbTransactionManager::PerformUpdate(
+    UNUSED_ATTRIBUTE Transaction *const current_txn,
+    const ItemPointer &location) {
+  auto tile_group_header = catalog::Manager::GetInstance()
+                               .GetTileGroup(location.block)
+                               ->GetHeader();
+  PL_ASSERT(tile_group_header->GetTransactionId(location.offset) ==
+            current_txn->GetTransactionId());
+
+  FinishMasterWrite(tile_group_header, location.offset);
+
+  // Increment table update op stats
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance().IncrementTableUpdates(
+        location.block);
+  }
+}
+
+void TimestampOrderingRbTransactionManager::PerformDelete(
+    Transaction *const current_txn, const ItemPointer &location) {
+  auto tile_group_header = catalog::Manager::GetInstance()
+                               .GetTileGroup(location.block)
+                               ->GetHeader();
+  auto tuple_id = location.offset;
+
+  PL_ASSERT(tile_group_header->GetTransactionId(tuple_id) ==
+            current_txn->GetTransactionId());
+
+  tile_group_header->SetEndCommitId(tuple_id, INVALID_CID);
+
+  // turns a tuple inserted by the current transaction into INS_DEL.
+  current_txn->RecordDelete(location);
+
+  // Increment table delete op stats
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance().IncrementTableDeletes(
+        location.block);
+  }
+}
+
+// the master version is copied between two reads of its sequence number. a
+// writer changes the number before it writes the master version, and only
+// after it has installed the segment that holds the committed values of the
+// columns it writes. a copy taken while the number stays the same is thus
+// either the master version or, once undone by the head segment read with
+// it, the committed version.
+char *TimestampOrderingRbTransactionManager::CopyMasterVersion(
+    storage::TileGroup *tile_group, const oid_t &tuple_id,
+    storage::Tuple *tuple, VarlenPool *pool, txn_id_t &tuple_txn_id,
+    cid_t &tuple_begin_cid, cid_t &tuple_end_cid) {
+  auto tile_group_header = tile_group->GetHeader();
+  auto column_count =
+      tile_group->GetAbstractTable()->GetSchema()->GetColumnCount();
+
+  while (true) {
+    auto seq = GetMasterSeq(tile_group_header, tuple_id);
+
+    COMPILER_MEMORY_FENCE;
+
+    tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+    tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+    tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+    auto rb_seg = GetRbSeg(tile_group_header, tuple_id);
+
+    for (oid_t col_id = 0; col_id < column_count; ++col_id) {
+      tuple->SetValue(col_id, tile_group->GetValue(tuple_id, col_id), pool);
+    }
+
+    COMPILER_MEMORY_FENCE;
+
+    // a commit installs its commit id without writing the master version,
+    // but a committed delete must not be read with the old begin commit id.
+    if (GetMasterSeq(tile_group_header, tuple_id) == seq &&
+        tile_group_header->GetBeginCommitId(tuple_id) == tuple_begin_cid) {
+      return rb_seg;
+    }
+  }
+}
+
+bool TimestampOrderingRbTransactionManager::CopyVisibleVersion(
+    Transaction *const current_txn, storage::TileGroup *tile_group,
+    const oid_t &tuple_id, storage::Tuple *tuple, VarlenPool *pool) {
+  auto current_cid = current_txn->GetBeginCommitId();
+
+  txn_id_t tuple_txn_id;
+  cid_t tuple_begin_cid;
+  cid_t tuple_end_cid;
+  auto rb_seg = CopyMasterVersion(tile_group, tuple_id, tuple, pool,
+                                  tuple_txn_id, tuple_begin_cid, tuple_end_cid);
+
+  if (tuple_txn_id == INVALID_TXN_ID) {
+    return false;
+  }
+
+  // the master version itself decides the visibility.
+  if (tuple_begin_cid != MAX_CID && current_cid >= tuple_begin_cid) {
+    if (tuple_txn_id != INITIAL_TXN_ID && tuple_end_cid == INVALID_CID) {
+      // the delete is not committed yet.
+      tuple_end_cid = MAX_CID;
+    }
+    return current_cid < tuple_end_cid;
+  }
+
+  auto schema = tile_group->GetAbstractTable()->GetSchema();
+
+  // undo the newer versions one by one. the begin timestamp of a segment is
+  // checked before following its next pointer, so segments older than the
+  // visible one are never touched.
+  while (rb_seg != nullptr) {
+    auto col_count = storage::RollbackSegmentPool::GetColCount(rb_seg);
+    for (size_t idx = 0; idx < col_count; ++idx) {
+      auto col_id =
+          storage::RollbackSegmentPool::GetIdOffsetPair(rb_seg, idx)->col_id;
+      tuple->SetValue(
+          col_id, storage::RollbackSegmentPool::GetValue(rb_seg, schema, idx),
+          pool);
+    }
+
+    if (current_cid >= storage::RollbackSegmentPool::GetBeginTimeStamp(rb_seg)) {
+      return true;
+    }
+
+    rb_seg = storage::RollbackSegmentPool::GetNextPtr(rb_seg);
+  }
+
+  // the tuple did not exist before.
+  return false;
+}
+
+bool TimestampOrderingRbTransactionManager::ReadVisibleVersion(
+    Transaction *const current_txn, storage::TileGroup *tile_group,
+    const oid_t &tuple_id, storage::Tuple *tuple, VarlenPool *pool,
+    bool &is_visible) {
+  auto tile_group_header = tile_group->GetHeader();
+  PL_ASSERT(tile_group_header->GetTransactionId(tuple_id) !=
+            current_txn->GetTransactionId());
+
+  is_visible = false;
+
+  // neither an invalid tuple nor an uncommitted insert has a version to
+  // read.
+  if (tile_group_header->GetTransactionId(tuple_id) == INVALID_TXN_ID ||
+      (tile_group_header->GetBeginCommitId(tuple_id) == MAX_CID &&
+       GetRbSeg(tile_group_header, tuple_id) == nullptr)) {
+    return true;
+  }
+
+  ItemPointer location(tile_group->GetTileGroupId(), tuple_id);
+  if (PerformRead(current_txn, location) == false) {
+    return false;
+  }
+
+  is_visible =
+      CopyVisibleVersion(current_txn, tile_group, tuple_id, tuple, pool);
+  return true;
+}
+
+// only the default secondary indexes get an entry for every key an update
+// writes.
+static bool HasKeyPerVersion(storage::DataTable *table) {
+  if (table == nullptr) {
+    return false;
+  }
+  for (oid_t index_itr = 0; index_itr < table->GetIndexCount(); index_itr++) {
+    auto index = table->GetIndex(index_itr);
+    if (index != nullptr &&
+        index->GetIndexType() == INDEX_CONSTRAINT_TYPE_DEFAULT) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// the segments of the versions that ended before min_cid may have been freed
+// already. the commit id that ends the version rebuilt from a segment is the
+// begin commit id of the newer version, so it is known before the segment is
+// touched.
+bool TimestampOrderingRbTransactionManager::IsKeyInUse(
+    storage::TileGroup *tile_group, const oid_t &tuple_id,
+    index::Index *index, const storage::Tuple *key, const cid_t &min_cid,
+    VarlenPool *pool) {
+  auto schema = tile_group->GetAbstractTable()->GetSchema();
+  auto index_schema = index->GetKeySchema();
+  auto indexed_columns = index_schema->GetIndexedColumns();
+
+  storage::Tuple version(schema, true);
+  txn_id_t tuple_txn_id;
+  cid_t version_end_cid;
+  cid_t tuple_end_cid;
+  auto rb_seg = CopyMasterVersion(tile_group, tuple_id, &version, pool,
+                                  tuple_txn_id, version_end_cid, tuple_end_cid);
+  if (tuple_txn_id == INVALID_TXN_ID) {
+    return false;
+  }
+
+  storage::Tuple version_key(index_schema, true);
+  version_key.SetFromTuple(&version, indexed_columns, pool);
+  if (version_key.EqualsNoSchemaCheck(*key) == true) {
+    return true;
+  }
+
+  while (rb_seg != nullptr && version_end_cid >= min_cid) {
+    auto col_count = storage::RollbackSegmentPool::GetColCount(rb_seg);
+    for (size_t idx = 0; idx < col_count; ++idx) {
+      auto col_id =
+          storage::RollbackSegmentPool::GetIdOffsetPair(rb_seg, idx)->col_id;
+      version.SetValue(
+          col_id, storage::RollbackSegmentPool::GetValue(rb_seg, schema, idx),
+          pool);
+    }
+
+    version_key.SetFromTuple(&version, indexed_columns, pool);
+    if (version_key.EqualsNoSchemaCheck(*key) == true) {
+      return true;
+    }
+
+    version_end_cid = storage::RollbackSegmentPool::GetBeginTimeStamp(rb_seg);
+    rb_seg = storage::RollbackSegmentPool::GetNextPtr(rb_seg);
+  }
+
+  return false;
+}
+
+void TimestampOrderingRbTransactionManager::DeleteUnusedKeys(
+    storage::TileGroup *tile_group, const oid_t &tuple_id,
+    ItemPointer *index_entry_ptr, const storage::Tuple *version,
+    const cid_t &min_cid) {
+  auto table =
+      dynamic_cast<storage::DataTable *>(tile_group->GetAbstractTable());
+  if (table == nullptr || index_entry_ptr == nullptr) {
+    return;
+  }
+
+  VarlenPool pool(BACKEND_TYPE_MM);
+  for (oid_t index_itr = 0; index_itr < table->GetIndexCount(); index_itr++) {
+    auto index = table->GetIndex(index_itr);
+    if (index == nullptr ||
+        index->GetIndexType() != INDEX_CONSTRAINT_TYPE_DEFAULT) {
+      continue;
+    }
+
+    auto index_schema = index->GetKeySchema();
+    std::unique_ptr<storage::Tuple> key(new storage::Tuple(index_schema, true));
+    key->SetFromTuple(version, index_schema->GetIndexedColumns(), &pool);
+
+    if (IsKeyInUse(tile_group, tuple_id, index.get(), key.get(), min_cid,
+                   &pool) == false) {
+      index->DeleteEntry(key.get(), index_entry_ptr);
+    }
+  }
+}
+
+// the lock keeps the segments newer than the max committed cid from being
+// freed while they are read.
+void TimestampOrderingRbTransactionManager::DeleteOverwrittenKeys(
+    storage::TileGroup *tile_group, const oid_t &tuple_id,
+    const storage::Tuple *overwritten_version) {
+  if (HasKeyPerVersion(dynamic_cast<storage::DataTable *>(
+          tile_group->GetAbstractTable())) == false) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(garbage_rb_seg_pools_mutex_);
+  DeleteUnusedKeys(tile_group, tuple_id,
+                   tile_group->GetHeader()->GetIndirection(tuple_id),
+                   overwritten_version, GetMaxCommittedCid());
+}
+
+void TimestampOrderingRbTransactionManager::RollbackUpdate(
+    storage::TileGroup *tile_group, const oid_t &tuple_id) {
+  auto tile_group_header = tile_group->GetHeader();
+  auto rb_seg = GetRbSeg(tile_group_header, tuple_id);
+  PL_ASSERT(rb_seg != nullptr);
+  PL_ASSERT(storage::RollbackSegmentPool::GetTimeStamp(rb_seg) == MAX_CID);
+
+  StartMasterWrite(tile_group_header, tuple_id);
+
+  // readers keep using the segment until the begin commit id is restored.
+  tile_group->ApplyRollbackSegment(rb_seg, tuple_id);
+
+  COMPILER_MEMORY_FENCE;
+
+  tile_group_header->SetBeginCommitId(
+      tuple_id, storage::RollbackSegmentPool::GetBeginTimeStamp(rb_seg));
+
+  COMPILER_MEMORY_FENCE;
+
+  SetRbSeg(tile_group_header, tuple_id,
+           storage::RollbackSegmentPool::GetNextPtr(rb_seg));
+
+  FinishMasterWrite(tile_group_header, tuple_id);
+}
+
+void TimestampOrderingRbTransactionManager::CollectOverwrittenVersion(
+    storage::TileGroup *tile_group, const oid_t &tuple_id,
+    const cid_t &end_commit_id,
+    std::list<OverwrittenVersion> &overwritten_versions) {
+  auto table =
+      dynamic_cast<storage::DataTable *>(tile_group->GetAbstractTable());
+  if (HasKeyPerVersion(table) == false) {
+    return;
+  }
+
+  auto tile_group_header = tile_group->GetHeader();
+  auto rb_seg = GetRbSeg(tile_group_header, tuple_id);
+  PL_ASSERT(rb_seg != nullptr);
+
+  // the committed version is the master version undone by the head segment
+  auto schema = table->GetSchema();
+  std::unique_ptr<VarlenPool> pool(new VarlenPool(BACKEND_TYPE_MM));
+  std::unique_ptr<storage::Tuple> version(new storage::Tuple(schema, true));
+  for (oid_t col_id = 0; col_id < schema->GetColumnCount(); ++col_id) {
+    version->SetValue(col_id, tile_group->GetValue(tuple_id, col_id),
+                      pool.get());
+  }
+  auto col_count = storage::RollbackSegmentPool::GetColCount(rb_seg);
+  for (size_t idx = 0; idx < col_count; ++idx) {
+    auto col_id =
+        storage::RollbackSegmentPool::GetIdOffsetPair(rb_seg, idx)->col_id;
+    version->SetValue(
+        col_id, storage::RollbackSegmentPool::GetValue(rb_seg, schema, idx),
+        pool.get());
+  }
+
+  expression::ContainerTuple<storage::TileGroup> master_tuple(tile_group,
+                                                              tuple_id);
+  bool key_changed = false;
+  for (oid_t index_itr = 0; index_itr < table->GetIndexCount() &&
+                            key_changed == false;
+       index_itr++) {
+    auto index = table->GetIndex(index_itr);
+    if (index == nullptr ||
+        index->GetIndexType() != INDEX_CONSTRAINT_TYPE_DEFAULT) {
+      continue;
+    }
+
+    auto index_schema = index->GetKeySchema();
+    auto indexed_columns = index_schema->GetIndexedColumns();
+    storage::Tuple old_key(index_schema, true);
+    storage::Tuple new_key(index_schema, true);
+    old_key.SetFromTuple(version.get(), indexed_columns, pool.get());
+    new_key.SetFromTuple(&master_tuple, indexed_columns, pool.get());
+    key_changed = (old_key.EqualsNoSchemaCheck(new_key) == false);
+  }
+
+  if (key_changed == false) {
+    return;
+  }
+
+  OverwrittenVersion overwritten_version;
+  overwritten_version.commit_id = end_commit_id;
+  overwritten_version.location =
+      ItemPointer(tile_group->GetTileGroupId(), tuple_id);
+  overwritten_version.index_entry_ptr =
+      tile_group_header->GetIndirection(tuple_id);
+  overwritten_version.tuple = std::move(version);
+  overwritten_version.pool = std::move(pool);
+  overwritten_versions.push_back(std::move(overwritten_version));
+}
+
+Result TimestampOrderingRbTransactionManager::CommitTransaction(
+    Transaction *const current_txn) {
+  LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return CommitReadonlyTransaction(current_txn);
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+
+  // generate transaction id.
+  cid_t end_commit_id = current_txn->GetBeginCommitId();
+
+  auto &rw_set = current_txn->GetRWSet();
+
+  oid_t database_id = 0;
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    if (!rw_set.empty()) {
+      database_id =
+          manager.GetTileGroup(rw_set.begin()->first)->GetDatabaseId();
+    }
+  }
+
+  // the commit id is installed once the write behind log covers the tile
+  // groups it goes to.
+  logging::LogManager::GetInstance().RegisterDirtyTileGroups(current_txn);
+
+  // the writes are visible before they are logged, see timestamp ordering.
+  logging::LogManager::GetInstance().PrepareLogging();
+
+  bool is_logging = logging::LogManager::GetInstance().IsInLoggingMode();
+  bool is_collecting = (gc::GCManagerFactory::GetGCType() ==
+                        GARBAGE_COLLECTION_TYPE_ON);
+  std::vector<logging::LogWrite> log_writes;
+  std::vector<TupleMetadata> garbage;
+  std::list<OverwrittenVersion> overwritten_versions;
+
+  // the master versions already hold the new values, so we only need to
+  // publish the commit id on the master versions and on their head segments.
+  for (auto &tile_group_entry : rw_set) {
+    oid_t tile_group_id = tile_group_entry.first;
+    auto tile_group = manager.GetTileGroup(tile_group_id);
+    auto tile_group_header = tile_group->GetHeader();
+    for (auto &tuple_entry : tile_group_entry.second) {
+      auto tuple_slot = tuple_entry.first;
+      if (tuple_entry.second == RW_TYPE_UPDATE) {
+        auto rb_seg = GetRbSeg(tile_group_header, tuple_slot);
+        PL_ASSERT(rb_seg != nullptr);
+
+        CollectOverwrittenVersion(tile_group.get(), tuple_slot, end_commit_id,
+                                  overwritten_versions);
+
+        tile_group_header->SetBeginCommitId(tuple_slot, end_commit_id);
+
+        COMPILER_MEMORY_FENCE;
+
+        storage::RollbackSegmentPool::SetTimeStamp(rb_seg, end_commit_id);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+        tile_group->SetCheckpointDirty();
+
+        // the tuple is replayed in place from its full image.
+        if (is_logging == true) {
+          log_writes.emplace_back(LOGRECORD_TYPE_TUPLE_INSERT,
+                                  INVALID_ITEMPOINTER,
+                                  ItemPointer(tile_group_id, tuple_slot));
+        }
+
+      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+        // the tuple was also updated by the current transaction.
+        bool is_updated =
+            (tile_group_header->GetBeginCommitId(tuple_slot) == MAX_CID);
+        if (is_updated == true) {
+          CollectOverwrittenVersion(tile_group.get(), tuple_slot,
+                                    end_commit_id, overwritten_versions);
+        }
+
+        tile_group_header->SetEndCommitId(tuple_slot, end_commit_id);
+
+        COMPILER_MEMORY_FENCE;
+
+        if (is_updated == true) {
+          auto rb_seg = GetRbSeg(tile_group_header, tuple_slot);
+          PL_ASSERT(rb_seg != nullptr);
+
+          tile_group_header->SetBeginCommitId(tuple_slot, end_commit_id);
+          storage::RollbackSegmentPool::SetTimeStamp(rb_seg, end_commit_id);
+        }
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+        tile_group->SetCheckpointDirty();
+
+        if (is_logging == true) {
+          log_writes.emplace_back(LOGRECORD_TYPE_TUPLE_DELETE,
+                                  ItemPointer(tile_group_id, tuple_slot),
+                                  INVALID_ITEMPOINTER);
+        }
+
+        // the GC removes the index entries once no transaction can read
+        // the tuple anymore.
+        if (is_collecting == true) {
+          garbage.push_back(GetGarbage(tile_group->GetTableId(),
+                                       ItemPointer(tile_group_id, tuple_slot),
+                                       end_commit_id, GC_VERSION_TYPE_DELETE));
+        }
+
+      } else if (tuple_entry.second == RW_TYPE_INSERT) {
+        PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
+                  current_txn->GetTransactionId());
+        // set the begin commit id to persist insert
+        tile_group_header->SetBeginCommitId(tuple_slot, end_commit_id);
+        tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+        tile_group->SetCheckpointDirty();
+
+        if (is_logging == true) {
+          log_writes.emplace_back(LOGRECORD_TYPE_TUPLE_INSERT,
+                                  INVALID_ITEMPOINTER,
+                                  ItemPointer(tile_group_id, tuple_slot));
+        }
+
+      } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
+        PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
+                  current_txn->GetTransactionId());
+
+        tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
+        tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
+
+        if (is_collecting == true) {
+          garbage.push_back(GetGarbage(
+              tile_group->GetTableId(), ItemPointer(tile_group_id, tuple_slot),
+              end_commit_id, GC_VERSION_TYPE_ABORT_INSERT));
+        }
+      }
+    }
+  }
+
+  // the segments stay readable by transactions older than the commit id.
+  auto rb_seg_pool = current_txn->GetRbSegPool();
+  if (rb_seg_pool != nullptr) {
+    rb_seg_pool->SetPoolTimestamp(end_commit_id);
+  }
+
+  if (overwritten_versions.empty() == false) {
+    std::lock_guard<std::mutex> lock(garbage_rb_seg_pools_mutex_);
+    overwritten_versions_.splice(overwritten_versions_.end(),
+                                 overwritten_versions);
+  }
+
+  RecycleVersions(garbage);
+
+  WakeOwnerWaiters(current_txn);
+
+  // the written versions cannot be recycled before the transaction ends.
+  if (logging::LogManager::GetInstance().LogTransaction(
+          end_commit_id, log_writes, current_txn->IsSyncCommit()) == false) {
+    SetTransactionResult(current_txn, RESULT_FAILURE);
+  }
+
+  Result result = current_txn->GetResult();
+
+  EndTransaction(current_txn);
+
+  // Increment # txns committed metric
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance()
+        .GetDatabaseMetric(database_id)
+        ->IncrementTxnCommitted();
+  }
+
+  return result;
+}
+
+// the keys the transaction wrote are removed from the secondary indexes
+// unless the restored version holds them too.
+void TimestampOrderingRbTransactionManager::RollbackUpdateAndKeys(
+    storage::TileGroup *tile_group, const oid_t &tuple_id) {
+  auto table =
+      dynamic_cast<storage::DataTable *>(tile_group->GetAbstractTable());
+  if (HasKeyPerVersion(table) == false) {
+    RollbackUpdate(tile_group, tuple_id);
+    return;
+  }
+
+  auto schema = table->GetSchema();
+  VarlenPool pool(BACKEND_TYPE_MM);
+  storage::Tuple aborted_version(schema, true);
+  for (oid_t col_id = 0; col_id < schema->GetColumnCount(); ++col_id) {
+    aborted_version.SetValue(col_id, tile_group->GetValue(tuple_id, col_id),
+                             &pool);
+  }
+
+  RollbackUpdate(tile_group, tuple_id);
+
+  DeleteOverwrittenKeys(tile_group, tuple_id, &aborted_version);
+}
+
+Result TimestampOrderingRbTransactionManager::AbortTransaction(
+    Transaction *const current_txn) {
+  LOG_TRACE("Aborting peloton txn : %lu ", current_txn->GetTransactionId());
+  auto &manager = catalog::Manager::GetInstance();
+
+  auto &rw_set = current_txn->GetRWSet();
+
+  oid_t database_id = 0;
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    if (!rw_set.empty()) {
+      database_id =
+          manager.GetTileGroup(rw_set.begin()->first)->GetDatabaseId();
+    }
+  }
+
+  std::vector<TupleMetadata> aborted_versions;
+
+  for (auto &tile_group_entry : rw_set) {
+    oid_t tile_group_id = tile_group_entry.first;
+    auto tile_group = manager.GetTileGroup(tile_group_id);
+    auto tile_group_header = tile_group->GetHeader();
+
+    for (auto &tuple_entry : tile_group_entry.second) {
+      auto tuple_slot = tuple_entry.first;
+      if (tuple_entry.second == RW_TYPE_UPDATE) {
+        RollbackUpdateAndKeys(tile_group.get(), tuple_slot);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+
+      } else if (tuple_entry.second == RW_TYPE_DELETE) {
+        tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
+
+        // the tuple was also updated by the current transaction.
+        if (tile_group_header->GetBeginCommitId(tuple_slot) == MAX_CID) {
+          RollbackUpdateAndKeys(tile_group.get(), tuple_slot);
+        }
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+
+      } else if (tuple_entry.second == RW_TYPE_INSERT ||
+                 tuple_entry.second == RW_TYPE_INS_DEL) {
+        tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
+        tile_group_header->SetEndCommitId(tuple_slot, MAX_CID);
+
+        COMPILER_MEMORY_FENCE;
+
+        tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
+
+        aborted_versions.push_back(
+            GetGarbage(tile_group->GetTableId(),
+                       ItemPointer(tile_group_id, tuple_slot), INVALID_CID,
+                       GC_VERSION_TYPE_ABORT_INSERT));
+      }
+    }
+  }
+
+  // concurrent readers may still be rebuilding versions from the aborted
+  // segments.
+  cid_t next_commit_id = GetCurrentCommitId();
+
+  auto rb_seg_pool = current_txn->GetRbSegPool();
+  if (rb_seg_pool != nullptr) {
+    rb_seg_pool->MarkedAsGarbage();
+    rb_seg_pool->SetPoolTimestamp(next_commit_id);
+  }
+
+  for (auto &aborted_version : aborted_versions) {
+    aborted_version.tuple_end_cid = next_commit_id;
+  }
+  RecycleVersions(aborted_versions);
+
+  WakeOwnerWaiters(current_txn);
+
+  EndTransaction(current_txn);
+
+  // Increment # txns aborted metric
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance().IncrementTxnAborted(database_id);
+  }
+
+  return Result::RESULT_ABORTED;
+}
+
+void TimestampOrderingRbTransactionManager::EndTransaction(
+    Transaction *current_txn) {
+  auto rb_seg_pool = current_txn->GetRbSegPool();
+  if (rb_seg_pool != nullptr) {
+    std::lock_guard<std::mutex> lock(garbage_rb_seg_pools_mutex_);
+    garbage_rb_seg_pools_.push_back(rb_seg_pool);
+  }
+
+  TimestampOrderingTransactionManager::EndTransaction(current_txn);
+
+  ReclaimRbSegPools();
+}
+
+// a pool can be freed once every transaction that may read its segments,
+// i.e. every transaction older than the pool timestamp, has finished.
+void TimestampOrderingRbTransactionManager::ReclaimRbSegPools() {
+  std::lock_guard<std::mutex> lock(garbage_rb_seg_pools_mutex_);
+  if (garbage_rb_seg_pools_.empty() == true &&
+      overwritten_versions_.empty() == true) {
+    return;
+  }
+
+  cid_t max_committed_cid = GetMaxCommittedCid();
+
+  // the keys of the versions replaced before are removed while the segments
+  // of the newer versions are still there.
+  auto &manager = catalog::Manager::GetInstance();
+  auto version_itr = overwritten_versions_.begin();
+  while (version_itr != overwritten_versions_.end()) {
+    if (version_itr->commit_id >= max_committed_cid) {
+      ++version_itr;
+      continue;
+    }
+
+    auto tile_group = manager.GetTileGroup(version_itr->location.block);
+    if (tile_group != nullptr) {
+      DeleteUnusedKeys(tile_group.get(), version_itr->location.offset,
+                       version_itr->index_entry_ptr, version_itr->tuple.get(),
+                       max_committed_cid);
+    }
+    version_itr = overwritten_versions_.erase(version_itr);
+  }
+
+  auto rb_seg_pool_itr = garbage_rb_seg_pools_.begin();
+  while (rb_seg_pool_itr != garbage_rb_seg_pools_.end()) {
+    if ((*rb_seg_pool_itr)->GetPoolTimestamp() < max_committed_cid) {
+      delete *rb_seg_pool_itr;
+      rb_seg_pool_itr = garbage_rb_seg_pools_.erase(rb_seg_pool_itr);
+    } else {
+      ++rb_seg_pool_itr;
+    }
+  }
+}
+
+}  // End concurrency namespace
+}  // End peloton namespace
@@ -12,6 +12,9 @@
 
 #include "concurrency/timestamp_ordering_transaction_manager.h"
 
+#include <chrono>
+#include <thread>
+
 #include "common/platform.h"
 #include "logging/log_manager.h"
 #include "logging/records/transaction_record.h"
@@ -19,6 +22,7 @@
 #include "catalog/manager.h"
 #include "common/exception.h"
 #include "common/logger.h"
+#include "gc/gc_manager_factory.h"
 
 namespace peloton {
 namespace concurrency {
@@ -84,6 +88,85 @@ void TimestampOrderingTransactionManager::InitTupleReserved(
   *(cid_t *)(reserved_area + LAST_READER_OFFSET) = 0;
 }
 
+bool TimestampOrderingTransactionManager::IsHotTuple(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  return FLAGS_hot_tuple_threshold != 0 &&
+         tile_group_header->GetAbortCount(tuple_id) >=
+             FLAGS_hot_tuple_threshold;
+}
+
+// only owners with a larger transaction id are waited for, so that waiting
+// transactions never form a cycle.
+bool TimestampOrderingTransactionManager::WaitForOwner(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto &wait_queue = GetOwnerWaitQueue(tile_group_header, tuple_id);
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(HOT_TUPLE_WAIT_MS);
+
+  std::unique_lock<std::mutex> wait_lock(wait_queue.mutex);
+  owner_waiter_count_++;
+
+  // the owner is checked under the queue mutex, and an owner wakes the queue
+  // only after releasing the tuple, so no wake-up is lost.
+  bool released = false;
+  while (true) {
+    txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+    if (tuple_txn_id == INITIAL_TXN_ID) {
+      released = true;
+      break;
+    }
+    if (tuple_txn_id == INVALID_TXN_ID ||
+        tuple_txn_id < current_txn->GetTransactionId()) {
+      break;
+    }
+    if (wait_queue.cv.wait_until(wait_lock, deadline) ==
+        std::cv_status::timeout) {
+      released =
+          tile_group_header->GetTransactionId(tuple_id) == INITIAL_TXN_ID;
+      break;
+    }
+  }
+
+  owner_waiter_count_--;
+  return released;
+}
+
+void TimestampOrderingTransactionManager::WakeOwnerWaiters(
+    Transaction *const current_txn) {
+  if (owner_waiter_count_.load() == 0) {
+    return;
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+  for (auto &tile_group_entry : current_txn->GetRWSet()) {
+    auto tile_group_header =
+        manager.GetTileGroup(tile_group_entry.first)->GetHeader();
+    for (auto &tuple_entry : tile_group_entry.second) {
+      if (tuple_entry.second == RW_TYPE_READ) {
+        continue;
+      }
+      auto &wait_queue =
+          GetOwnerWaitQueue(tile_group_header, tuple_entry.first);
+      std::lock_guard<std::mutex> wait_lock(wait_queue.mutex);
+      wait_queue.cv.notify_all();
+    }
+  }
+}
+
+TimestampOrderingTransactionManager::OwnerWaitQueue &
+TimestampOrderingTransactionManager::GetOwnerWaitQueue(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  size_t bucket =
+      (std::hash<const storage::TileGroupHeader *>()(tile_group_header) ^
+       std::hash<oid_t>()(tuple_id)) %
+      OWNER_WAIT_QUEUE_COUNT;
+  return owner_wait_queues_[bucket];
+}
+
 TimestampOrderingTransactionManager &
 TimestampOrderingTransactionManager::GetInstance() {
   static TimestampOrderingTransactionManager txn_manager;
@@ -246,6 +329,11 @@ bool TimestampOrderingTransactionManager::AcquireOwnership(
     const oid_t &tuple_id) {
   auto txn_id = current_txn->GetTransactionId();
 
+  // read-only transactions never write.
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return false;
+  }
+
   // to acquire the ownership, we must guarantee that no other transactions that
   // has read
   // the tuple has a larger timestamp than the current transaction.
@@ -257,12 +345,43 @@ bool TimestampOrderingTransactionManager::AcquireOwnership(
 
     GetSpinlockField(tile_group_header, tuple_id)->Unlock();
 
+    tile_group_header->IncrementAbortCount(tuple_id);
+
     return false;
   } else {
     if (tile_group_header->SetAtomicTransactionId(tuple_id, txn_id) == false) {
 
       GetSpinlockField(tile_group_header, tuple_id)->Unlock();
 
+      // on a hot tuple, wait for the owner instead of aborting right away. if
+      // the owner aborts, the version is still the latest one.
+      if (IsHotTuple(tile_group_header, tuple_id) == true &&
+          WaitForOwner(current_txn, tile_group_header, tuple_id) == true) {
+        GetSpinlockField(tile_group_header, tuple_id)->Lock();
+
+        bool acquired =
+            GetLastReaderCommitId(tile_group_header, tuple_id) <=
+                current_txn->GetBeginCommitId() &&
+            tile_group_header->SetAtomicTransactionId(tuple_id, txn_id);
+
+        // the owner committed a newer version.
+        if (acquired == true &&
+            (tile_group_header->GetEndCommitId(tuple_id) != MAX_CID ||
+             tile_group_header->GetBeginCommitId(tuple_id) >
+                 current_txn->GetBeginCommitId())) {
+          tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+          acquired = false;
+        }
+
+        GetSpinlockField(tile_group_header, tuple_id)->Unlock();
+
+        if (acquired == true) {
+          return true;
+        }
+      }
+
+      tile_group_header->IncrementAbortCount(tuple_id);
+
       return false;
     } else {
 
@@ -287,6 +406,12 @@ void TimestampOrderingTransactionManager::YieldOwnership(
   auto tile_group_header = manager.GetTileGroup(tile_group_id)->GetHeader();
   PL_ASSERT(IsOwner(current_txn, tile_group_header, tuple_id));
   tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+
+  if (owner_waiter_count_.load() != 0) {
+    auto &wait_queue = GetOwnerWaitQueue(tile_group_header, tuple_id);
+    std::lock_guard<std::mutex> wait_lock(wait_queue.mutex);
+    wait_queue.cv.notify_all();
+  }
 }
 
 bool TimestampOrderingTransactionManager::PerformRead(
@@ -296,6 +421,18 @@ bool TimestampOrderingTransactionManager::PerformRead(
   oid_t tuple_id = location.offset;
 
   LOG_TRACE("PerformRead (%u, %u)\n", location.block, location.offset);
+
+  // a read-only transaction reads at a snapshot that no running transaction
+  // can write to, so the read needs neither tracking nor the last reader cid.
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    // Increment table read op stats
+    if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+      stats::BackendStatsContext::GetInstance().IncrementTableReads(
+          location.block);
+    }
+    return true;
+  }
+
   auto &manager = catalog::Manager::GetInstance();
   auto tile_group = manager.GetTileGroup(tile_group_id);
   auto tile_group_header = tile_group->GetHeader();
@@ -314,8 +451,21 @@ bool TimestampOrderingTransactionManager::PerformRead(
   }
   // if the current transaction does not own this tuple, then attemp to set last
   // reader cid.
-  if (SetLastReaderCommitId(tile_group_header, tuple_id,
-                            current_txn->GetBeginCommitId()) == true) {
+  bool read_success = SetLastReaderCommitId(tile_group_header, tuple_id,
+                                            current_txn->GetBeginCommitId());
+
+  // on a hot tuple, wait for a younger owner instead of failing the read. the
+  // version stays visible if the owner commits a newer one.
+  if (read_success == false &&
+      IsHotTuple(tile_group_header, tuple_id) == true &&
+      WaitForOwner(current_txn, tile_group_header, tuple_id) == true &&
+      tile_group_header->GetEndCommitId(tuple_id) >
+          current_txn->GetBeginCommitId()) {
+    read_success = SetLastReaderCommitId(tile_group_header, tuple_id,
+                                         current_txn->GetBeginCommitId());
+  }
+
+  if (read_success == true) {
     current_txn->RecordRead(location);
     // Increment table read op stats
     if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
@@ -327,6 +477,7 @@ bool TimestampOrderingTransactionManager::PerformRead(
     // if the tuple has been owned by some concurrent transactions, then read
     // fails.
     LOG_TRACE("Transaction read failed");
+    tile_group_header->IncrementAbortCount(tuple_id);
     return false;
   }
 }
@@ -357,6 +508,10 @@ void TimestampOrderingTransactionManager::PerformInsert(
 
   InitTupleReserved(tile_group_header, tuple_id);
 
+  tile_group_header->SetAbortCount(tuple_id, 0);
+
+  tile_group_header->SetVersionHint(tuple_id, INVALID_ITEMPOINTER);
+
   // Write down the head pointer's address in tile group header
   tile_group_header->SetIndirection(tuple_id, index_entry_ptr);
 
@@ -424,6 +579,16 @@ void TimestampOrderingTransactionManager::PerformUpdate(
 
   InitTupleReserved(new_tile_group_header, new_location.offset);
 
+  // the new version inherits the contention of the tuple.
+  new_tile_group_header->SetAbortCount(
+      new_location.offset,
+      tile_group_header->GetAbortCount(old_location.offset));
+
+  // and the hint into the older part of the chain.
+  new_tile_group_header->SetVersionHint(
+      new_location.offset,
+      tile_group_header->GetVersionHint(old_location.offset));
+
   // if the transaction is not updating the latest version,
   // then do not change item pointer header.
   if (old_prev.IsNull() == true) {
@@ -540,6 +705,16 @@ void TimestampOrderingTransactionManager::PerformDelete(
 
   InitTupleReserved(new_tile_group_header, new_location.offset);
 
+  // the new version inherits the contention of the tuple.
+  new_tile_group_header->SetAbortCount(
+      new_location.offset,
+      tile_group_header->GetAbortCount(old_location.offset));
+
+  // and the hint into the older part of the chain.
+  new_tile_group_header->SetVersionHint(
+      new_location.offset,
+      tile_group_header->GetVersionHint(old_location.offset));
+
   // if the transaction is not deleting the latest version,
   // then do not change item pointer header.
   if (old_prev.IsNull() == true) {
@@ -607,24 +782,41 @@ void TimestampOrderingTransactionManager::PerformDelete(
   }
 }
 
-Result TimestampOrderingTransactionManager::CommitTransaction(
-    Transaction *const current_txn) {
-  LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
+// the garbage of a transaction reaches the GC queue in one bulk enqueue.
+void TimestampOrderingTransactionManager::RecycleVersions(
+    const std::vector<TupleMetadata> &garbage) {
+  if (garbage.empty() == true ||
+      gc::GCManagerFactory::GetGCType() != GARBAGE_COLLECTION_TYPE_ON) {
+    return;
+  }
 
-  auto &manager = catalog::Manager::GetInstance();
+  gc::GCManagerFactory::GetInstance().RecycleTupleSlots(garbage);
+}
 
-  // generate transaction id.
-  cid_t end_commit_id = current_txn->GetBeginCommitId();
+TupleMetadata TimestampOrderingTransactionManager::GetGarbage(
+    const oid_t &table_id, const ItemPointer &location, const cid_t &end_cid,
+    const GCVersionType &version_type) {
+  TupleMetadata garbage;
+  garbage.table_id = table_id;
+  garbage.tile_group_id = location.block;
+  garbage.tuple_slot_id = location.offset;
+  garbage.tuple_end_cid = end_cid;
+  garbage.version_type = version_type;
+  return garbage;
+}
+
+// install everything written by the transaction at the commit id.
+void TimestampOrderingTransactionManager::InstallWriteSet(
+    Transaction *const current_txn, const cid_t &end_commit_id,
+    std::vector<logging::LogWrite> &log_writes) {
+  auto &manager = catalog::Manager::GetInstance();
 
   auto &rw_set = current_txn->GetRWSet();
 
-  oid_t database_id = 0;
-  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
-    if (!rw_set.empty()) {
-      database_id =
-          manager.GetTileGroup(rw_set.begin()->first)->GetDatabaseId();
-    }
-  }
+  bool is_logging = logging::LogManager::GetInstance().IsInLoggingMode();
+  bool is_collecting = (gc::GCManagerFactory::GetGCType() ==
+                        GARBAGE_COLLECTION_TYPE_ON);
+  std::vector<TupleMetadata> garbage;
 
   // install everything.
   // 1. install a new version for update operations;
@@ -646,8 +838,8 @@ Result TimestampOrderingTransactionManager::CommitTransaction(
 
         auto cid = tile_group_header->GetEndCommitId(tuple_slot);
         PL_ASSERT(cid > end_commit_id);
-        auto new_tile_group_header =
-            manager.GetTileGroup(new_version.block)->GetHeader();
+        auto new_tile_group = manager.GetTileGroup(new_version.block);
+        auto new_tile_group_header = new_tile_group->GetHeader();
         new_tile_group_header->SetBeginCommitId(new_version.offset,
                                                 end_commit_id);
         new_tile_group_header->SetEndCommitId(new_version.offset, cid);
@@ -661,8 +853,22 @@ Result TimestampOrderingTransactionManager::CommitTransaction(
         new_tile_group_header->SetTransactionId(new_version.offset,
                                                 INITIAL_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
+
+        tile_group->SetCheckpointDirty();
+        new_tile_group->SetCheckpointDirty();
+
+        if (is_logging == true) {
+          log_writes.emplace_back(LOGRECORD_TYPE_TUPLE_UPDATE,
+                                  ItemPointer(tile_group_id, tuple_slot),
+                                  new_version);
+        }
+
         // GC recycle.
-        // RecycleOldTupleSlot(tile_group_id, tuple_slot, end_commit_id);
+        if (is_collecting == true) {
+          garbage.push_back(GetGarbage(tile_group->GetTableId(),
+                                       ItemPointer(tile_group_id, tuple_slot),
+                                       end_commit_id, GC_VERSION_TYPE_UPDATE));
+        }
 
       } else if (tuple_entry.second == RW_TYPE_DELETE) {
         ItemPointer new_version =
@@ -686,8 +892,24 @@ Result TimestampOrderingTransactionManager::CommitTransaction(
                                                 INVALID_TXN_ID);
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
+        // the empty version is never visible
+        tile_group->SetCheckpointDirty();
+
+        if (is_logging == true) {
+          log_writes.emplace_back(LOGRECORD_TYPE_TUPLE_DELETE,
+                                  ItemPointer(tile_group_id, tuple_slot),
+                                  INVALID_ITEMPOINTER);
+        }
+
         // GC recycle.
-        // RecycleOldTupleSlot(tile_group_id, tuple_slot, end_commit_id);
+        if (is_collecting == true) {
+          garbage.push_back(GetGarbage(tile_group->GetTableId(),
+                                       ItemPointer(tile_group_id, tuple_slot),
+                                       end_commit_id, GC_VERSION_TYPE_DELETE));
+          garbage.push_back(GetGarbage(tile_group->GetTableId(), new_version,
+                                       end_commit_id,
+                                       GC_VERSION_TYPE_INVALID));
+        }
 
       } else if (tuple_entry.second == RW_TYPE_INSERT) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
@@ -700,6 +922,14 @@ Result TimestampOrderingTransactionManager::CommitTransaction(
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
+        tile_group->SetCheckpointDirty();
+
+        if (is_logging == true) {
+          log_writes.emplace_back(LOGRECORD_TYPE_TUPLE_INSERT,
+                                  INVALID_ITEMPOINTER,
+                                  ItemPointer(tile_group_id, tuple_slot));
+        }
+
       } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
         PL_ASSERT(tile_group_header->GetTransactionId(tuple_slot) ==
                   current_txn->GetTransactionId());
@@ -711,10 +941,84 @@ Result TimestampOrderingTransactionManager::CommitTransaction(
 
         // set the begin commit id to persist insert
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
+
+        // GC recycle.
+        if (is_collecting == true) {
+          garbage.push_back(GetGarbage(
+              tile_group->GetTableId(), ItemPointer(tile_group_id, tuple_slot),
+              end_commit_id, GC_VERSION_TYPE_ABORT_INSERT));
+        }
       }
     }
   }
 
+  WakeOwnerWaiters(current_txn);
+
+  RecycleVersions(garbage);
+}
+
+// a read-only transaction has nothing to install or validate.
+Result TimestampOrderingTransactionManager::CommitReadonlyTransaction(
+    Transaction *const current_txn) {
+  PL_ASSERT(current_txn->GetRWSet().empty() == true);
+
+  Result result = current_txn->GetResult();
+
+  EndTransaction(current_txn);
+
+  // Increment # txns committed metric
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance()
+        .GetDatabaseMetric(0)
+        ->IncrementTxnCommitted();
+  }
+
+  return result;
+}
+
+Result TimestampOrderingTransactionManager::CommitTransaction(
+    Transaction *const current_txn) {
+  LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return CommitReadonlyTransaction(current_txn);
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+
+  // generate transaction id.
+  cid_t end_commit_id = current_txn->GetBeginCommitId();
+
+  auto &rw_set = current_txn->GetRWSet();
+
+  oid_t database_id = 0;
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    if (!rw_set.empty()) {
+      database_id =
+          manager.GetTileGroup(rw_set.begin()->first)->GetDatabaseId();
+    }
+  }
+
+  // the commit id is installed once the write behind log covers the tile
+  // groups it goes to.
+  logging::LogManager::GetInstance().RegisterDirtyTileGroups(current_txn);
+
+  // the writes are visible once installed, before they are logged. until
+  // the commit record is in the log buffer, the frontend logger reports no
+  // commit id durable beyond those it has already seen, so a transaction
+  // that reads the writes is not acknowledged before them.
+  logging::LogManager::GetInstance().PrepareLogging();
+
+  std::vector<logging::LogWrite> log_writes;
+  InstallWriteSet(current_txn, end_commit_id, log_writes);
+
+  // the written versions cannot be recycled before the transaction ends.
+  if (logging::LogManager::GetInstance().LogTransaction(
+          end_commit_id, log_writes, current_txn->IsSyncCommit()) == false) {
+    // the writes are installed, but not durable.
+    SetTransactionResult(current_txn, RESULT_FAILURE);
+  }
+
   Result result = current_txn->GetResult();
 
   // gc::GCManagerFactory::GetInstance().EndGCContext(end_commit_id);
@@ -745,7 +1049,7 @@ Result TimestampOrderingTransactionManager::AbortTransaction(
     }
   }
 
-  std::vector<ItemPointer> aborted_versions;
+  std::vector<TupleMetadata> aborted_versions;
 
   for (auto &tile_group_entry : rw_set) {
     oid_t tile_group_id = tile_group_entry.first;
@@ -808,7 +1112,9 @@ Result TimestampOrderingTransactionManager::AbortTransaction(
         COMPILER_MEMORY_FENCE;
 
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
-        aborted_versions.push_back(new_version);
+        aborted_versions.push_back(GetGarbage(
+            tile_group->GetTableId(), new_version, INVALID_CID,
+            GC_VERSION_TYPE_ABORT_UPDATE));
 
       } else if (tuple_entry.second == RW_TYPE_DELETE) {
 
@@ -861,8 +1167,9 @@ Result TimestampOrderingTransactionManager::AbortTransaction(
         tile_group_header->SetTransactionId(tuple_slot, INITIAL_TXN_ID);
 
         // GC recycle
-        // RecycleInvalidTupleSlot(new_version.block, new_version.offset);
-        // aborted_versions.push_back(new_version);
+        aborted_versions.push_back(GetGarbage(
+            tile_group->GetTableId(), new_version, INVALID_CID,
+            GC_VERSION_TYPE_INVALID));
 
       } else if (tuple_entry.second == RW_TYPE_INSERT) {
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
@@ -871,10 +1178,12 @@ Result TimestampOrderingTransactionManager::AbortTransaction(
         COMPILER_MEMORY_FENCE;
 
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
-        // aborted_versions.push_back(ItemPointer(tile_group_id, tuple_slot));
 
         // GC recycle
-        // RecycleInvalidTupleSlot(tile_group_id, tuple_slot);
+        aborted_versions.push_back(
+            GetGarbage(tile_group->GetTableId(),
+                       ItemPointer(tile_group_id, tuple_slot), INVALID_CID,
+                       GC_VERSION_TYPE_ABORT_INSERT));
 
       } else if (tuple_entry.second == RW_TYPE_INS_DEL) {
         tile_group_header->SetBeginCommitId(tuple_slot, MAX_CID);
@@ -883,24 +1192,26 @@ Result TimestampOrderingTransactionManager::AbortTransaction(
         COMPILER_MEMORY_FENCE;
 
         tile_group_header->SetTransactionId(tuple_slot, INVALID_TXN_ID);
-        // aborted_versions.push_back(ItemPointer(tile_group_id, tuple_slot));
 
         // GC recycle
-        // RecycleInvalidTupleSlot(tile_group_id, tuple_slot);
+        aborted_versions.push_back(
+            GetGarbage(tile_group->GetTableId(),
+                       ItemPointer(tile_group_id, tuple_slot), INVALID_CID,
+                       GC_VERSION_TYPE_ABORT_INSERT));
       }
     }
   }
 
-  // cid_t next_commit_id = GetNextCommitId();
+  // the aborted versions are garbage once every transaction that is running
+  // now has finished.
+  cid_t next_commit_id = GetCurrentCommitId();
 
-  // for (auto &item_pointer : aborted_versions) {
-  //    RecycleOldTupleSlot(item_pointer.block, item_pointer.offset,
-  // next_commit_id);
-  // }
+  for (auto &aborted_version : aborted_versions) {
+    aborted_version.tuple_end_cid = next_commit_id;
+  }
+  RecycleVersions(aborted_versions);
 
-  // Need to change next_commit_id to INVALID_CID if disable the recycle of
-  // aborted version
-  // gc::GCManagerFactory::GetInstance().EndGCContext(next_commit_id);
+  WakeOwnerWaiters(current_txn);
 
   EndTransaction(current_txn);
 
@@ -0,0 +1,457 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// two_phase_locking_transaction_manager.cpp
+//
+// Identification: src/concurrency/two_phase_locking_transaction_manager.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "concurrency/two_phase_locking_transaction_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "catalog/manager.h"
+#include "common/logger.h"
+#include "concurrency/transaction.h"
+#include "logging/log_manager.h"
+
+namespace peloton {
+namespace concurrency {
+
+TwoPhaseLockingTransactionManager &
+TwoPhaseLockingTransactionManager::GetInstance(
+    const ConcurrencyType &protocol) {
+  switch (protocol) {
+    case CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE: {
+      static TwoPhaseLockingTransactionManager wait_die_txn_manager(
+          CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE);
+      return wait_die_txn_manager;
+    }
+
+    default: {
+      static TwoPhaseLockingTransactionManager no_wait_txn_manager(
+          CONCURRENCY_TYPE_TWO_PHASE_LOCKING_NO_WAIT);
+      return no_wait_txn_manager;
+    }
+  }
+}
+
+void TwoPhaseLockingTransactionManager::InitTupleReserved(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t tuple_id) {
+  TimestampOrderingTransactionManager::InitTupleReserved(tile_group_header,
+                                                         tuple_id);
+
+  auto read_lock = GetReadLock(tile_group_header, tuple_id);
+  read_lock->holder_count = 0;
+  read_lock->oldest_holder = MAX_TXN_ID;
+}
+
+TwoPhaseLockingTransactionManager::ReadLock *
+TwoPhaseLockingTransactionManager::GetReadLock(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  return (ReadLock *)(tile_group_header->GetReservedFieldRef(tuple_id) +
+                      READ_LOCK_OFFSET);
+}
+
+void TwoPhaseLockingTransactionManager::AddReadLockHolder(
+    ReadLock *read_lock, const txn_id_t &txn_id) {
+  if (read_lock->holder_count == 0 || txn_id < read_lock->oldest_holder) {
+    read_lock->oldest_holder = txn_id;
+  }
+  read_lock->holder_count++;
+}
+
+void TwoPhaseLockingTransactionManager::RemoveReadLockHolder(
+    ReadLock *read_lock) {
+  PL_ASSERT(read_lock->holder_count > 0);
+  read_lock->holder_count--;
+  if (read_lock->holder_count == 0) {
+    read_lock->oldest_holder = MAX_TXN_ID;
+  }
+}
+
+bool TwoPhaseLockingTransactionManager::HoldsReadLock(
+    Transaction *const current_txn, const oid_t &tile_group_id,
+    const oid_t &tuple_id) {
+  auto &rw_set = current_txn->GetRWSet();
+  auto tile_group_itr = rw_set.find(tile_group_id);
+  if (tile_group_itr == rw_set.end()) {
+    return false;
+  }
+  auto tuple_itr = tile_group_itr->second.find(tuple_id);
+  return tuple_itr != tile_group_itr->second.end() &&
+         tuple_itr->second == RW_TYPE_READ;
+}
+
+// a shared request conflicts with the exclusive holder, an exclusive one
+// with the shared holders as well. a transaction upgrading its own shared
+// lock only conflicts with the other readers.
+bool TwoPhaseLockingTransactionManager::LockVersion(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id, const bool &exclusive) {
+  auto txn_id = current_txn->GetTransactionId();
+  auto spinlock = GetSpinlockField(tile_group_header, tuple_id);
+  auto read_lock = GetReadLock(tile_group_header, tuple_id);
+  auto &wait_queue = GetOwnerWaitQueue(tile_group_header, tuple_id);
+
+  // an upgrade does not count the shared lock of the transaction itself.
+  bool upgrade =
+      exclusive == true &&
+      HoldsReadLock(current_txn,
+                    tile_group_header->GetTileGroup()->GetTileGroupId(),
+                    tuple_id) == true;
+
+  // the queue mutex is only taken once the request has to wait.
+  std::unique_lock<std::mutex> wait_lock(wait_queue.mutex, std::defer_lock);
+
+  bool granted = false;
+  bool dies = false;
+  while (true) {
+    spinlock->Lock();
+
+    txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+
+    // the version was deleted or replaced while we waited.
+    if (tuple_txn_id == INVALID_TXN_ID ||
+        (tuple_txn_id == INITIAL_TXN_ID &&
+         tile_group_header->GetEndCommitId(tuple_id) != MAX_CID)) {
+      spinlock->Unlock();
+      break;
+    }
+
+    // the oldest conflicting holder. an upgrading transaction that is the
+    // oldest shared holder is older than every other one.
+    txn_id_t oldest_holder =
+        (tuple_txn_id == INITIAL_TXN_ID) ? MAX_TXN_ID : tuple_txn_id;
+    uint64_t other_readers = read_lock->holder_count - (upgrade ? 1 : 0);
+    if (exclusive == true && other_readers > 0) {
+      oldest_holder = std::min(oldest_holder, read_lock->oldest_holder);
+    }
+
+    if (oldest_holder == MAX_TXN_ID) {
+      if (exclusive == true) {
+        // the shared lock of the transaction itself is given up.
+        tile_group_header->SetTransactionId(tuple_id, txn_id);
+        if (upgrade == true) {
+          RemoveReadLockHolder(read_lock);
+        }
+      } else {
+        AddReadLockHolder(read_lock, txn_id);
+      }
+      spinlock->Unlock();
+      granted = true;
+      break;
+    }
+
+    spinlock->Unlock();
+
+    // wait-die: only a transaction that is older than every conflicting
+    // holder waits.
+    if (protocol_ != CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE ||
+        oldest_holder < txn_id) {
+      dies = true;
+      break;
+    }
+
+    // the lock is checked again under the queue mutex before sleeping, and a
+    // holder wakes the queue only after leaving, so no wake-up is lost.
+    if (wait_lock.owns_lock() == false) {
+      wait_lock.lock();
+      owner_waiter_count_++;
+      continue;
+    }
+    wait_queue.cv.wait_for(wait_lock,
+                           std::chrono::milliseconds(LOCK_RECHECK_MS));
+  }
+
+  if (wait_lock.owns_lock() == true) {
+    owner_waiter_count_--;
+  }
+
+  if (dies == true) {
+    tile_group_header->IncrementAbortCount(tuple_id);
+  }
+  return granted;
+}
+
+void TwoPhaseLockingTransactionManager::WakeLockWaiters(
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  if (owner_waiter_count_.load() == 0) {
+    return;
+  }
+  auto &wait_queue = GetOwnerWaitQueue(tile_group_header, tuple_id);
+  std::lock_guard<std::mutex> wait_lock(wait_queue.mutex);
+  wait_queue.cv.notify_all();
+}
+
+// an insert conflicts with the latest committed or pending version of the
+// key.
+bool TwoPhaseLockingTransactionManager::IsOccupied(
+    Transaction *const current_txn, const ItemPointer &position) {
+  auto tile_group_header =
+      catalog::Manager::GetInstance().GetTileGroup(position.block)->GetHeader();
+  auto tuple_id = position.offset;
+
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  if (tuple_txn_id == INVALID_TXN_ID) {
+    // the tuple is not available.
+    return false;
+  }
+
+  if (current_txn->GetTransactionId() == tuple_txn_id) {
+    // only the newly inserted or updated version is visible.
+    return tuple_begin_cid == MAX_CID && tuple_end_cid != INVALID_CID;
+  }
+
+  if (tuple_txn_id != INITIAL_TXN_ID) {
+    // a dirty delete is invisible, anything else owned by another
+    // transaction is either a dirty version or the version it replaces.
+    return !(tuple_begin_cid == MAX_CID && tuple_end_cid == INVALID_CID);
+  }
+
+  // the latest committed version.
+  return tuple_end_cid == MAX_CID;
+}
+
+// the latest committed version is visible, whatever the begin commit id of
+// the transaction. read-only transactions still read their snapshot.
+VisibilityType TwoPhaseLockingTransactionManager::IsVisible(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return TimestampOrderingTransactionManager::IsVisible(
+        current_txn, tile_group_header, tuple_id);
+  }
+
+  txn_id_t tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  cid_t tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  cid_t tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+
+  bool own = (current_txn->GetTransactionId() == tuple_txn_id);
+  bool committed = (tuple_begin_cid != MAX_CID);
+  bool latest = (tuple_end_cid == MAX_CID);
+
+  if (tuple_txn_id == INVALID_TXN_ID || CidIsInDirtyRange(tuple_begin_cid)) {
+    if (committed && latest) {
+      // deleted tuple
+      return VISIBILITY_DELETED;
+    } else {
+      // aborted tuple
+      return VISIBILITY_INVISIBLE;
+    }
+  }
+
+  if (own == true) {
+    if (tuple_begin_cid == MAX_CID && tuple_end_cid != INVALID_CID) {
+      // the newly inserted/updated version.
+      return VISIBILITY_OK;
+    } else if (tuple_end_cid == INVALID_CID) {
+      // tuple being deleted by current txn
+      return VISIBILITY_DELETED;
+    } else {
+      // old version of the tuple that is being updated by current txn
+      return VISIBILITY_INVISIBLE;
+    }
+  }
+
+  // a version owned by another transaction stays visible until it commits,
+  // the read then waits for its lock.
+  if (committed && latest) {
+    return VISIBILITY_OK;
+  } else {
+    return VISIBILITY_INVISIBLE;
+  }
+}
+
+// the latest committed version can be owned, even if another transaction
+// holds its lock for now.
+bool TwoPhaseLockingTransactionManager::IsOwnable(
+    UNUSED_ATTRIBUTE Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+  auto tuple_begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+  auto tuple_end_cid = tile_group_header->GetEndCommitId(tuple_id);
+  return tuple_txn_id != INVALID_TXN_ID && tuple_begin_cid != MAX_CID &&
+         tuple_end_cid == MAX_CID;
+}
+
+bool TwoPhaseLockingTransactionManager::AcquireOwnership(
+    Transaction *const current_txn,
+    const storage::TileGroupHeader *const tile_group_header,
+    const oid_t &tuple_id) {
+  // read-only transactions never write.
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return false;
+  }
+
+  // the values of a replaced version are stale, so the writer aborts.
+  return LockVersion(current_txn, tile_group_header, tuple_id, true);
+}
+
+// a shared lock that was given up by the upgrade is taken back.
+void TwoPhaseLockingTransactionManager::YieldOwnership(
+    Transaction *const current_txn, const oid_t &tile_group_id,
+    const oid_t &tuple_id) {
+  if (HoldsReadLock(current_txn, tile_group_id, tuple_id) == false) {
+    TimestampOrderingTransactionManager::YieldOwnership(
+        current_txn, tile_group_id, tuple_id);
+    return;
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group_header = manager.GetTileGroup(tile_group_id)->GetHeader();
+  PL_ASSERT(IsOwner(current_txn, tile_group_header, tuple_id));
+
+  GetSpinlockField(tile_group_header, tuple_id)->Lock();
+  AddReadLockHolder(GetReadLock(tile_group_header, tuple_id),
+                    current_txn->GetTransactionId());
+  tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+  GetSpinlockField(tile_group_header, tuple_id)->Unlock();
+
+  WakeLockWaiters(tile_group_header, tuple_id);
+}
+
+bool TwoPhaseLockingTransactionManager::PerformRead(
+    Transaction *const current_txn, const ItemPointer &location) {
+  LOG_TRACE("PerformRead (%u, %u)\n", location.block, location.offset);
+
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return TimestampOrderingTransactionManager::PerformRead(current_txn,
+                                                            location);
+  }
+
+  oid_t tile_group_id = location.block;
+  oid_t tuple_id = location.offset;
+
+  auto tile_group_header =
+      catalog::Manager::GetInstance().GetTileGroup(tile_group_id)->GetHeader();
+
+  // the transaction already holds a lock on the version.
+  if (IsOwner(current_txn, tile_group_header, tuple_id) == true ||
+      HoldsReadLock(current_txn, tile_group_id, tuple_id) == true) {
+    // Increment table read op stats
+    if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+      stats::BackendStatsContext::GetInstance().IncrementTableReads(
+          location.block);
+    }
+    return true;
+  }
+
+  if (LockVersion(current_txn, tile_group_header, tuple_id, false) == false) {
+    LOG_TRACE("Transaction read failed");
+    return false;
+  }
+
+  current_txn->RecordRead(location);
+  // Increment table read op stats
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance().IncrementTableReads(
+        location.block);
+  }
+  return true;
+}
+
+void TwoPhaseLockingTransactionManager::ReleaseReadLocks(
+    Transaction *const current_txn) {
+  auto &manager = catalog::Manager::GetInstance();
+
+  for (auto &tile_group_entry : current_txn->GetRWSet()) {
+    storage::TileGroupHeader *tile_group_header = nullptr;
+
+    for (auto &tuple_entry : tile_group_entry.second) {
+      if (tuple_entry.second != RW_TYPE_READ) {
+        continue;
+      }
+      if (tile_group_header == nullptr) {
+        tile_group_header =
+            manager.GetTileGroup(tile_group_entry.first)->GetHeader();
+      }
+
+      auto tuple_id = tuple_entry.first;
+      GetSpinlockField(tile_group_header, tuple_id)->Lock();
+      RemoveReadLockHolder(GetReadLock(tile_group_header, tuple_id));
+      GetSpinlockField(tile_group_header, tuple_id)->Unlock();
+
+      WakeLockWaiters(tile_group_header, tuple_id);
+    }
+  }
+}
+
+Result TwoPhaseLockingTransactionManager::CommitTransaction(
+    Transaction *const current_txn) {
+  LOG_TRACE("Committing peloton txn : %lu ", current_txn->GetTransactionId());
+
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    return CommitReadonlyTransaction(current_txn);
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+
+  auto &rw_set = current_txn->GetRWSet();
+
+  oid_t database_id = 0;
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    if (!rw_set.empty()) {
+      database_id =
+          manager.GetTileGroup(rw_set.begin()->first)->GetDatabaseId();
+    }
+  }
+
+  logging::LogManager::GetInstance().RegisterDirtyTileGroups(current_txn);
+
+  // the commit id is drawn while all locks are held, so the versions are
+  // committed in the order the transactions serialize in.
+  cid_t end_commit_id = GetNextCommitId();
+
+  // the writes are visible before they are logged, see timestamp ordering.
+  logging::LogManager::GetInstance().PrepareLogging();
+
+  std::vector<logging::LogWrite> log_writes;
+  InstallWriteSet(current_txn, end_commit_id, log_writes);
+
+  ReleaseReadLocks(current_txn);
+
+  // the log is written once every lock is released.
+  if (logging::LogManager::GetInstance().LogTransaction(
+          end_commit_id, log_writes, current_txn->IsSyncCommit()) == false) {
+    SetTransactionResult(current_txn, RESULT_FAILURE);
+  }
+
+  Result result = current_txn->GetResult();
+
+  EndTransaction(current_txn);
+
+  // Increment # txns committed metric
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance()
+        .GetDatabaseMetric(database_id)
+        ->IncrementTxnCommitted();
+  }
+
+  return result;
+}
+
+Result TwoPhaseLockingTransactionManager::AbortTransaction(
+    Transaction *const current_txn) {
+  ReleaseReadLocks(current_txn);
+
+  return TimestampOrderingTransactionManager::AbortTransaction(current_txn);
+}
+
+}  // End concurrency namespace
+}  // End peloton namespace
@@ -25,6 +25,11 @@ void QUEUE_TYPE::Enqueue(ValueType& item) {
   queue_.enqueue(item);
 }
 
+QUEUE_TEMPLATE_ARGUMENTS
+void QUEUE_TYPE::EnqueueBulk(const ValueType* items, const size_t& count) {
+  queue_.enqueue_bulk(items, count);
+}
+
 QUEUE_TEMPLATE_ARGUMENTS
 bool QUEUE_TYPE::Dequeue(ValueType& item) {
   return queue_.try_dequeue(item);
@@ -14,16 +14,21 @@
 #include "executor/abstract_scan_executor.h"
 
 #include <memory>
+#include <numeric>
 #include <utility>
 #include <vector>
 
 #include "common/types.h"
+#include "concurrency/transaction_manager_factory.h"
+#include "executor/executor_context.h"
 #include "executor/logical_tile.h"
 #include "executor/logical_tile_factory.h"
 #include "expression/abstract_expression.h"
 #include "expression/container_tuple.h"
 #include "storage/data_table.h"
+#include "storage/table_factory.h"
 #include "storage/tile_group.h"
+#include "storage/tuple.h"
 
 #include "common/logger.h"
 
@@ -38,6 +43,8 @@ AbstractScanExecutor::AbstractScanExecutor(const planner::AbstractPlan *node,
                                            ExecutorContext *executor_context)
     : AbstractExecutor(node, executor_context) {}
 
+AbstractScanExecutor::~AbstractScanExecutor() {}
+
 /**
  * @brief Extract predicate and simple projections
  * @return true on success, false otherwise.
@@ -54,8 +61,105 @@ bool AbstractScanExecutor::DInit() {
 
   column_ids_ = std::move(node.GetColumnIds());
 
+  old_version_table_.reset();
+  old_version_tile_group_offset_ = 0;
+  old_version_tuple_offset_ = 0;
+
   return true;
 }
 
+/**
+ * @brief Copy the version of a tuple visible to the transaction, and store it
+ * if it satisfies the predicate. The copy points at the master version.
+ * @return false if the read fails, true otherwise.
+ */
+bool AbstractScanExecutor::CopyVisibleVersion(storage::TileGroup *tile_group,
+                                              const oid_t &tuple_id) {
+  auto &rb_txn_manager =
+      concurrency::TimestampOrderingRbTransactionManager::GetInstance();
+  auto current_txn = executor_context_->GetTransaction();
+  auto schema = tile_group->GetAbstractTable()->GetSchema();
+
+  std::unique_ptr<storage::Tuple> tuple(new storage::Tuple(schema, true));
+  bool is_visible = false;
+  if (rb_txn_manager.ReadVisibleVersion(
+          current_txn, tile_group, tuple_id, tuple.get(),
+          executor_context_->GetExecutorContextPool(), is_visible) == false) {
+    return false;
+  }
+
+  if (is_visible == false) {
+    return true;
+  }
+
+  if (predicate_ != nullptr &&
+      predicate_->Evaluate(tuple.get(), nullptr, executor_context_)
+              .IsTrue() == false) {
+    return true;
+  }
+
+  if (IsCopyQualified(tuple.get()) == false) {
+    return true;
+  }
+
+  if (old_version_table_ == nullptr) {
+    bool own_schema = false;
+    bool adapt_table = false;
+    old_version_table_.reset(storage::TableFactory::GetDataTable(
+        INVALID_OID, INVALID_OID, schema, "old_version_temp_table",
+        DEFAULT_TUPLES_PER_TILEGROUP, own_schema, adapt_table));
+  }
+
+  // updates and deletes find the master version through the copy.
+  auto copy_location = old_version_table_->InsertTuple(tuple.get());
+  if (copy_location.IsNull() == true) {
+    return false;
+  }
+  ItemPointer master_location(tile_group->GetTileGroupId(), tuple_id);
+  old_version_table_->GetTileGroupById(copy_location.block)
+      ->GetHeader()
+      ->SetNextItemPointer(copy_location.offset, master_location);
+  return true;
+}
+
+// a hybrid scan returns the copies of its index part before its sequential
+// part adds more, so the copies are returned from where the last call
+// stopped.
+LogicalTile *AbstractScanExecutor::GetNextOldVersionTile(
+    const std::vector<oid_t> &column_ids) {
+  if (old_version_table_ == nullptr) {
+    return nullptr;
+  }
+
+  auto tile_group_count = old_version_table_->GetTileGroupCount();
+  while (old_version_tile_group_offset_ < tile_group_count) {
+    auto tile_group =
+        old_version_table_->GetTileGroup(old_version_tile_group_offset_);
+    auto tuple_count =
+        (tile_group == nullptr) ? 0 : tile_group->GetNextTupleSlot();
+    if (old_version_tuple_offset_ >= tuple_count) {
+      // the last tile group may still get more copies
+      if (old_version_tile_group_offset_ + 1 == tile_group_count) {
+        return nullptr;
+      }
+      old_version_tile_group_offset_++;
+      old_version_tuple_offset_ = 0;
+      continue;
+    }
+
+    std::vector<oid_t> position_list(tuple_count - old_version_tuple_offset_);
+    std::iota(position_list.begin(), position_list.end(),
+              old_version_tuple_offset_);
+    old_version_tuple_offset_ = tuple_count;
+
+    std::unique_ptr<LogicalTile> logical_tile(LogicalTileFactory::GetTile());
+    logical_tile->AddColumns(tile_group, column_ids);
+    logical_tile->AddPositionList(std::move(position_list));
+    return logical_tile.release();
+  }
+
+  return nullptr;
+}
+
 }  // namespace executor
 }  // namespace peloton
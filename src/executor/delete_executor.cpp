@@ -76,15 +76,18 @@ bool DeleteExecutor::DExecute() {
 
   auto &pos_lists = source_tile.get()->GetPositionLists();
   storage::Tile *tile = source_tile->GetBaseTile(0);
-  storage::TileGroup *tile_group = tile->GetTileGroup();
-  storage::TileGroupHeader *tile_group_header = tile_group->GetHeader();
-  auto tile_group_id = tile_group->GetTileGroupId();
+  storage::TileGroup *source_tile_group = tile->GetTileGroup();
 
   auto &transaction_manager =
       concurrency::TransactionManagerFactory::GetInstance();
 
   auto current_txn = executor_context_->GetTransaction();
 
+  // with rollback segments, the tuples the transaction does not own are read
+  // from copies, which point at their master versions.
+  bool is_copy = (concurrency::TransactionManagerFactory::IsRB() == true &&
+                  source_tile_group->GetAbstractTable() != target_table_);
+
   LOG_TRACE("Source tile : %p Tuples : %lu ", source_tile.get(),
             source_tile->GetTupleCount());
 
@@ -97,7 +100,29 @@ bool DeleteExecutor::DExecute() {
   for (oid_t visible_tuple_id : *source_tile) {
     oid_t physical_tuple_id = pos_lists[0][visible_tuple_id];
 
-    ItemPointer old_location(tile_group_id, physical_tuple_id);
+    ItemPointer old_location(source_tile_group->GetTileGroupId(),
+                             physical_tuple_id);
+
+    // a copy is deleted through its master version. a copy of an older
+    // version fails to own it.
+    std::shared_ptr<storage::TileGroup> master_tile_group;
+    storage::TileGroup *tile_group = source_tile_group;
+    if (is_copy == true) {
+      old_location = source_tile_group->GetHeader()->GetNextItemPointer(
+          physical_tuple_id);
+      master_tile_group =
+          catalog::Manager::GetInstance().GetTileGroup(old_location.block);
+      if (master_tile_group == nullptr) {
+        LOG_TRACE("Fail to find the master version. Set txn failure.");
+        transaction_manager.SetTransactionResult(current_txn,
+                                                 Result::RESULT_FAILURE);
+        return false;
+      }
+      tile_group = master_tile_group.get();
+      physical_tuple_id = old_location.offset;
+    }
+    storage::TileGroupHeader *tile_group_header = tile_group->GetHeader();
+    auto tile_group_id = tile_group->GetTileGroupId();
 
     LOG_TRACE("Visible Tuple id : %u, Physical Tuple id : %u ",
               visible_tuple_id, physical_tuple_id);
@@ -128,6 +153,15 @@ bool DeleteExecutor::DExecute() {
           transaction_manager.SetTransactionResult(current_txn, Result::RESULT_FAILURE);
           return false;
         }
+
+        // with rollback segments, the tuple is marked as deleted in place.
+        if (concurrency::TransactionManagerFactory::IsRB() == true) {
+          transaction_manager.PerformDelete(current_txn, old_location);
+
+          executor_context_->num_processed += 1;  // deleted one
+          continue;
+        }
+
         // if it is the latest version and not locked by other threads, then
         // insert an empty version.
         ItemPointer new_location = target_table_->InsertEmptyVersion();
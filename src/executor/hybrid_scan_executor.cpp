@@ -122,15 +122,26 @@ bool HybridScanExecutor::DInit() {
     } else {
       current_tile_group_offset_ = indexed_tile_offset_ + 1;
       std::shared_ptr<storage::TileGroup> tile_group;
-      if (current_tile_group_offset_ < table_tile_group_count_) {
-        tile_group = table_->GetTileGroup(current_tile_group_offset_);
-      } else {
-        tile_group = table_->GetTileGroup(table_tile_group_count_ - 1);
+
+      // the first tile group that is not indexed, skipping the ones dropped
+      // by compaction
+      for (oid_t offset = current_tile_group_offset_;
+           offset < table_tile_group_count_ && tile_group == nullptr;
+           offset++) {
+        tile_group = table_->GetTileGroup(offset);
       }
 
-      oid_t tuple_id = 0;
-      ItemPointer location(tile_group->GetTileGroupId(), tuple_id);
-      block_threshold = location.block;
+      // or the last one still in the table
+      for (oid_t offset = table_tile_group_count_;
+           offset > 0 && tile_group == nullptr; offset--) {
+        tile_group = table_->GetTileGroup(offset - 1);
+      }
+
+      if (tile_group != nullptr) {
+        oid_t tuple_id = 0;
+        ItemPointer location(tile_group->GetTileGroupId(), tuple_id);
+        block_threshold = location.block;
+      }
     }
 
     result_itr_ = START_OID;
@@ -189,7 +200,14 @@ bool HybridScanExecutor::SeqScanUtil() {
   while (current_tile_group_offset_ < table_tile_group_count_) {
     LOG_TRACE("Current tile group offset : %u", current_tile_group_offset_);
     auto tile_group = table_->GetTileGroup(current_tile_group_offset_++);
+
+    // Skip tile groups dropped by compaction
+    if (tile_group == nullptr) {
+      continue;
+    }
+
     auto tile_group_header = tile_group->GetHeader();
+    tile_group->IncrementAccessCount();
 
     oid_t active_tuple_count = tile_group->GetNextTupleSlot();
 
@@ -211,6 +229,18 @@ bool HybridScanExecutor::SeqScanUtil() {
         }
       }
 
+      // with rollback segments, the tuples of the other transactions are
+      // read from copies.
+      if (concurrency::TransactionManagerFactory::IsRB() == true &&
+          transaction_manager.IsOwner(current_txn, tile_group_header,
+                                      tuple_id) == false) {
+        if (CopyVisibleVersion(tile_group.get(), tuple_id) == false) {
+          transaction_manager.SetTransactionResult(current_txn, RESULT_FAILURE);
+          return false;
+        }
+        continue;
+      }
+
       // Check transaction visibility
       if (transaction_manager.IsVisible(current_txn, tile_group_header, tuple_id) == VISIBILITY_OK) {
         // If the tuple is visible, then perform predicate evaluation.
@@ -258,6 +288,13 @@ bool HybridScanExecutor::SeqScanUtil() {
     return true;
   }
 
+  // Finally, return the copied versions.
+  auto old_version_tile = GetNextOldVersionTile(column_ids_);
+  if (old_version_tile != nullptr) {
+    SetOutput(old_version_tile);
+    return true;
+  }
+
   return false;
 }
 
@@ -390,6 +427,20 @@ bool HybridScanExecutor::ExecPrimaryIndexLookup() {
     while (true) {
       ++chain_length;
 
+      // there is no version chain with rollback segments. the tuples of the
+      // other transactions are read from copies.
+      if (concurrency::TransactionManagerFactory::IsRB() == true &&
+          transaction_manager.IsOwner(current_txn, tile_group_header,
+                                      tuple_location.offset) == false) {
+        if (CopyVisibleVersion(tile_group.get(), tuple_location.offset) ==
+            false) {
+          transaction_manager.SetTransactionResult(current_txn,
+                                                   RESULT_FAILURE);
+          return false;
+        }
+        break;
+      }
+
       auto visibility = transaction_manager.IsVisible(current_txn, tile_group_header, tuple_location.offset);
 
       if (visibility == VISIBILITY_OK) {
@@ -449,6 +500,17 @@ bool HybridScanExecutor::ExecPrimaryIndexLookup() {
     result_.push_back(logical_tile.release());
   }
 
+  // Add the copied versions
+  LogicalTile *old_version_tile = nullptr;
+  while ((old_version_tile = GetNextOldVersionTile(full_column_ids_)) !=
+         nullptr) {
+    std::unique_ptr<LogicalTile> logical_tile(old_version_tile);
+    if (column_ids_.size() != 0) {
+      logical_tile->ProjectColumns(full_column_ids_, column_ids_);
+    }
+    result_.push_back(logical_tile.release());
+  }
+
   index_done_ = true;
 
   LOG_TRACE("Result tiles : %lu", result_.size());
@@ -174,16 +174,42 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
 
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tuple_location.block);
+
+    // the entry was taken out of the index and its tile group dropped
+    // while we were scanning
+    if (tile_group == nullptr) {
+      continue;
+    }
     auto tile_group_header = tile_group.get()->GetHeader();
 
     size_t chain_length = 0;
 
+    // the head of the chain and the newest version that is too new for the
+    // transaction, used to leave a hint for readers walking the same way.
+    auto head_tile_group = tile_group;
+    oid_t head_tuple_id = tuple_location.offset;
+    ItemPointer last_invisible_location = INVALID_ITEMPOINTER;
+
     // the following code traverses the version chain until a certain visible
     // version is found.
     // we should always find a visible version from a version chain.
     while (true) {
       ++chain_length;
 
+      // there is no version chain with rollback segments. the tuples of the
+      // other transactions are read from copies.
+      if (concurrency::TransactionManagerFactory::IsRB() == true &&
+          transaction_manager.IsOwner(current_txn, tile_group_header,
+                                      tuple_location.offset) == false) {
+        if (CopyVisibleVersion(tile_group.get(), tuple_location.offset) ==
+            false) {
+          transaction_manager.SetTransactionResult(current_txn,
+                                                   RESULT_FAILURE);
+          return false;
+        }
+        break;
+      }
+
       auto visibility = transaction_manager.IsVisible(
           current_txn, tile_group_header, tuple_location.offset);
 
@@ -211,6 +237,21 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
           auto res =
               transaction_manager.PerformRead(current_txn, tuple_location);
           if (!res) {
+            // the version was replaced while the read waited for its lock.
+            // read the newest version instead.
+            if (transaction_manager.IsVisible(current_txn, tile_group_header,
+                                              tuple_location.offset) ==
+                VISIBILITY_INVISIBLE) {
+              tuple_location =
+                  *(tile_group_header->GetIndirection(tuple_location.offset));
+              tile_group = manager.GetTileGroup(tuple_location.block);
+              tile_group_header = tile_group.get()->GetHeader();
+              chain_length = 0;
+              head_tile_group = tile_group;
+              head_tuple_id = tuple_location.offset;
+              last_invisible_location = INVALID_ITEMPOINTER;
+              continue;
+            }
             transaction_manager.SetTransactionResult(current_txn,
                                                      RESULT_FAILURE);
             return res;
@@ -228,6 +269,13 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
         LOG_TRACE("Invisible read: %u, %u", tuple_location.block,
                   tuple_location.offset);
 
+        // start fetching the older version while this one is examined
+        ItemPointer next_location =
+            tile_group_header->GetNextItemPointer(tuple_location.offset);
+        if (next_location.block == tuple_location.block) {
+          tile_group_header->PrefetchVersion(next_location.offset);
+        }
+
         bool is_acquired = (tile_group_header->GetTransactionId(
                                 tuple_location.offset) == INITIAL_TXN_ID);
         bool is_alive =
@@ -245,11 +293,28 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
           tile_group = manager.GetTileGroup(tuple_location.block);
           tile_group_header = tile_group.get()->GetHeader();
           chain_length = 0;
+          head_tile_group = tile_group;
+          head_tuple_id = tuple_location.offset;
+          last_invisible_location = INVALID_ITEMPOINTER;
+          continue;
+        }
+
+        last_invisible_location = tuple_location;
+
+        // skip the versions that are too new for the transaction
+        ItemPointer hint_location;
+        auto hint_tile_group = GetVersionHint(
+            current_txn, tile_group_header, tuple_location.offset,
+            hint_location);
+        if (hint_tile_group != nullptr) {
+          tuple_location = hint_location;
+          tile_group = hint_tile_group;
+          tile_group_header = tile_group.get()->GetHeader();
           continue;
         }
 
         ItemPointer old_item = tuple_location;
-        tuple_location = tile_group_header->GetNextItemPointer(old_item.offset);
+        tuple_location = next_location;
 
         // there must exist a visible version.
         if (tuple_location.IsNull()) {
@@ -265,12 +330,22 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
           return false;
         }
 
-        // search for next version.
-        tile_group = manager.GetTileGroup(tuple_location.block);
-        tile_group_header = tile_group.get()->GetHeader();
+        // search for next version. the versions of a tuple often share a
+        // tile group, which saves the lookup in the catalog.
+        if (tuple_location.block != old_item.block) {
+          tile_group = manager.GetTileGroup(tuple_location.block);
+          tile_group_header = tile_group.get()->GetHeader();
+        }
         continue;
       }
     }
+
+    if (chain_length >= VERSION_HINT_CHAIN_LENGTH &&
+        last_invisible_location.IsNull() == false) {
+      head_tile_group->GetHeader()->SetVersionHint(head_tuple_id,
+                                                   last_invisible_location);
+    }
+
     LOG_TRACE("Traverse length: %d\n", (int)chain_length);
   }
 
@@ -278,6 +353,7 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
   for (auto tuples : visible_tuples) {
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tuples.first);
+    tile_group->IncrementAccessCount();
 
     std::unique_ptr<LogicalTile> logical_tile(LogicalTileFactory::GetTile());
     // Add relevant columns to logical tile
@@ -290,6 +366,18 @@ bool IndexScanExecutor::ExecPrimaryIndexLookup() {
     result_.push_back(logical_tile.release());
   }
 
+  // Add the copied versions
+  LogicalTile *old_version_tile = nullptr;
+  while ((old_version_tile = GetNextOldVersionTile(full_column_ids_)) !=
+         nullptr) {
+    std::unique_ptr<LogicalTile> logical_tile(old_version_tile);
+    if (column_ids_.size() != 0) {
+      logical_tile->ProjectColumns(full_column_ids_, column_ids_);
+    }
+
+    result_.push_back(logical_tile.release());
+  }
+
   done_ = true;
 
   LOG_TRACE("Result tiles : %lu", result_.size());
@@ -334,10 +422,22 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
 
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tuple_location.block);
+
+    // the entry was taken out of the index and its tile group dropped
+    // while we were scanning
+    if (tile_group == nullptr) {
+      continue;
+    }
     auto tile_group_header = tile_group.get()->GetHeader();
 
     size_t chain_length = 0;
 
+    // the head of the chain and the newest version that is too new for the
+    // transaction, used to leave a hint for readers walking the same way.
+    auto head_tile_group = tile_group;
+    oid_t head_tuple_id = tuple_location.offset;
+    ItemPointer last_invisible_location = INVALID_ITEMPOINTER;
+
     // the following code traverses the version chain until a certain visible
     // version is found.
     // we should always find a visible version from a version chain.
@@ -347,6 +447,20 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
     while (true) {
       ++chain_length;
 
+      // there is no version chain with rollback segments. the tuples of the
+      // other transactions are read from copies.
+      if (concurrency::TransactionManagerFactory::IsRB() == true &&
+          transaction_manager.IsOwner(current_txn, tile_group_header,
+                                      tuple_location.offset) == false) {
+        if (CopyVisibleVersion(tile_group.get(), tuple_location.offset) ==
+            false) {
+          transaction_manager.SetTransactionResult(current_txn,
+                                                   RESULT_FAILURE);
+          return false;
+        }
+        break;
+      }
+
       auto visibility = transaction_manager.IsVisible(
           current_txn, tile_group_header, tuple_location.offset);
 
@@ -396,6 +510,21 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
           auto res =
               transaction_manager.PerformRead(current_txn, tuple_location);
           if (!res) {
+            // the version was replaced while the read waited for its lock.
+            // read the newest version instead.
+            if (transaction_manager.IsVisible(current_txn, tile_group_header,
+                                              tuple_location.offset) ==
+                VISIBILITY_INVISIBLE) {
+              tuple_location =
+                  *(tile_group_header->GetIndirection(tuple_location.offset));
+              tile_group = manager.GetTileGroup(tuple_location.block);
+              tile_group_header = tile_group.get()->GetHeader();
+              chain_length = 0;
+              head_tile_group = tile_group;
+              head_tuple_id = tuple_location.offset;
+              last_invisible_location = INVALID_ITEMPOINTER;
+              continue;
+            }
             transaction_manager.SetTransactionResult(current_txn,
                                                      RESULT_FAILURE);
             return res;
@@ -413,6 +542,13 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
         LOG_TRACE("Invisible read: %u, %u", tuple_location.block,
                   tuple_location.offset);
 
+        // start fetching the older version while this one is examined
+        ItemPointer next_location =
+            tile_group_header->GetNextItemPointer(tuple_location.offset);
+        if (next_location.block == tuple_location.block) {
+          tile_group_header->PrefetchVersion(next_location.offset);
+        }
+
         bool is_acquired = (tile_group_header->GetTransactionId(
                                 tuple_location.offset) == INITIAL_TXN_ID);
         bool is_alive =
@@ -430,11 +566,28 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
           tile_group = manager.GetTileGroup(tuple_location.block);
           tile_group_header = tile_group.get()->GetHeader();
           chain_length = 0;
+          head_tile_group = tile_group;
+          head_tuple_id = tuple_location.offset;
+          last_invisible_location = INVALID_ITEMPOINTER;
+          continue;
+        }
+
+        last_invisible_location = tuple_location;
+
+        // skip the versions that are too new for the transaction
+        ItemPointer hint_location;
+        auto hint_tile_group = GetVersionHint(
+            current_txn, tile_group_header, tuple_location.offset,
+            hint_location);
+        if (hint_tile_group != nullptr) {
+          tuple_location = hint_location;
+          tile_group = hint_tile_group;
+          tile_group_header = tile_group.get()->GetHeader();
           continue;
         }
 
         ItemPointer old_item = tuple_location;
-        tuple_location = tile_group_header->GetNextItemPointer(old_item.offset);
+        tuple_location = next_location;
 
         if (tuple_location.IsNull()) {
           // For an index scan on a version chain, the result should be one of
@@ -454,11 +607,21 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
           return false;
         }
 
-        // search for next version.
-        tile_group = manager.GetTileGroup(tuple_location.block);
-        tile_group_header = tile_group.get()->GetHeader();
+        // search for next version. the versions of a tuple often share a
+        // tile group, which saves the lookup in the catalog.
+        if (tuple_location.block != old_item.block) {
+          tile_group = manager.GetTileGroup(tuple_location.block);
+          tile_group_header = tile_group.get()->GetHeader();
+        }
       }
     }
+
+    if (chain_length >= VERSION_HINT_CHAIN_LENGTH &&
+        last_invisible_location.IsNull() == false) {
+      head_tile_group->GetHeader()->SetVersionHint(head_tuple_id,
+                                                   last_invisible_location);
+    }
+
     LOG_TRACE("Traverse length: %d\n", (int)chain_length);
   }
 
@@ -466,6 +629,7 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
   for (auto tuples : visible_tuples) {
     auto &manager = catalog::Manager::GetInstance();
     auto tile_group = manager.GetTileGroup(tuples.first);
+    tile_group->IncrementAccessCount();
 
     std::unique_ptr<LogicalTile> logical_tile(LogicalTileFactory::GetTile());
     // Add relevant columns to logical tile
@@ -478,6 +642,18 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
     result_.push_back(logical_tile.release());
   }
 
+  // Add the copied versions
+  LogicalTile *old_version_tile = nullptr;
+  while ((old_version_tile = GetNextOldVersionTile(full_column_ids_)) !=
+         nullptr) {
+    std::unique_ptr<LogicalTile> logical_tile(old_version_tile);
+    if (column_ids_.size() != 0) {
+      logical_tile->ProjectColumns(full_column_ids_, column_ids_);
+    }
+
+    result_.push_back(logical_tile.release());
+  }
+
   done_ = true;
 
   LOG_TRACE("Result tiles : %lu", result_.size());
@@ -485,5 +661,66 @@ bool IndexScanExecutor::ExecSecondaryIndexLookup() {
   return true;
 }
 
+// The hint of a version points to an older version of the same chain. Since
+// the versions of a chain are committed in order, every version between them
+// is too new for a transaction that began before the hinted version was
+// committed. The hint is not maintained when versions are recycled, so it is
+// only followed if the slot still holds a committed version of the tuple.
+// The walk must also stand on a committed version, since with two-phase
+// locking the versions after a dirty one are not too new for the
+// transaction.
+// a secondary index keeps the entries of the keys the older versions had, so
+// a copied version has to hold the scanned key as well.
+bool IndexScanExecutor::IsCopyQualified(const AbstractTuple *tuple) {
+  if (index_->GetIndexType() == INDEX_CONSTRAINT_TYPE_PRIMARY_KEY) {
+    return true;
+  }
+
+  storage::Tuple key_tuple(index_->GetKeySchema(), true);
+  auto indexed_columns = index_->GetKeySchema()->GetIndexedColumns();
+
+  oid_t this_col_itr = 0;
+  for (auto col : indexed_columns) {
+    key_tuple.SetValue(this_col_itr, tuple->GetValue(col),
+                       executor_context_->GetExecutorContextPool());
+    this_col_itr++;
+  }
+
+  return index_->Compare(key_tuple, key_column_ids_, expr_types_, values_);
+}
+
+std::shared_ptr<storage::TileGroup> IndexScanExecutor::GetVersionHint(
+    concurrency::Transaction *current_txn,
+    const storage::TileGroupHeader *tile_group_header, const oid_t &tuple_id,
+    ItemPointer &hint_location) {
+  hint_location = tile_group_header->GetVersionHint(tuple_id);
+  if (hint_location.IsNull() == true) {
+    return nullptr;
+  }
+
+  auto hint_tile_group =
+      catalog::Manager::GetInstance().GetTileGroup(hint_location.block);
+  if (hint_tile_group == nullptr ||
+      hint_location.offset >= hint_tile_group->GetAllocatedTupleCount()) {
+    return nullptr;
+  }
+
+  auto hint_tile_group_header = hint_tile_group->GetHeader();
+  cid_t hint_begin_cid =
+      hint_tile_group_header->GetBeginCommitId(hint_location.offset);
+
+  if (hint_tile_group_header->GetTransactionId(hint_location.offset) !=
+          INITIAL_TXN_ID ||
+      hint_tile_group_header->GetIndirection(hint_location.offset) !=
+          tile_group_header->GetIndirection(tuple_id) ||
+      tile_group_header->GetBeginCommitId(tuple_id) == MAX_CID ||
+      hint_begin_cid <= current_txn->GetBeginCommitId() ||
+      hint_begin_cid >= tile_group_header->GetBeginCommitId(tuple_id)) {
+    return nullptr;
+  }
+
+  return hint_tile_group;
+}
+
 }  // namespace executor
 }  // namespace peloton
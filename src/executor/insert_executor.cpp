@@ -70,6 +70,12 @@ bool InsertExecutor::DExecute() {
 	         return false;
   }
 
+  // read-only transactions cannot insert
+  if (current_txn->IsDeclaredReadOnly() == true) {
+    transaction_manager.SetTransactionResult(current_txn, peloton::Result::RESULT_FAILURE);
+    return false;
+  }
+
   LOG_TRACE("Number of tuples in table before insert: %lu",
             target_table->GetTupleCount());
   auto executor_pool = executor_context_->GetExecutorContextPool();
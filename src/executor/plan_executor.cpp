@@ -44,7 +44,8 @@ void CleanExecutorTree(executor::AbstractExecutor *root);
  */
 peloton_status PlanExecutor::ExecutePlan(const planner::AbstractPlan *plan,
                                          const std::vector<Value> &params,
-                                         std::vector<ResultType> &result) {
+                                         std::vector<ResultType> &result,
+                                         bool sync_commit) {
   peloton_status p_status;
 
   if (plan == nullptr) return p_status;
@@ -63,6 +64,7 @@ peloton_status PlanExecutor::ExecutePlan(const planner::AbstractPlan *plan,
   auto txn = txn_manager.BeginTransaction();
   // }
   PL_ASSERT(txn);
+  txn->SetSyncCommit(sync_commit);
 
   LOG_TRACE("Txn ID = %lu ", txn->GetTransactionId());
   LOG_TRACE("Building the executor tree");
@@ -124,7 +124,14 @@ bool SeqScanExecutor::DExecute() {
     while (current_tile_group_offset_ < table_tile_group_count_) {
       auto tile_group =
           target_table_->GetTileGroup(current_tile_group_offset_++);
+
+      // Skip tile groups dropped by compaction
+      if (tile_group == nullptr) {
+        continue;
+      }
+
       auto tile_group_header = tile_group->GetHeader();
+      tile_group->IncrementAccessCount();
 
       oid_t active_tuple_count = tile_group->GetNextTupleSlot();
 
@@ -134,6 +141,17 @@ bool SeqScanExecutor::DExecute() {
       for (oid_t tuple_id = 0; tuple_id < active_tuple_count; tuple_id++) {
         ItemPointer location(tile_group->GetTileGroupId(), tuple_id);
 
+        // with rollback segments, the tuples of the other transactions are
+        // read from copies.
+        if (concurrency::TransactionManagerFactory::IsRB() == true &&
+            transaction_manager.IsOwner(current_txn, tile_group_header,
+                                        tuple_id) == false) {
+          if (CopyVisibleVersion(tile_group.get(), tuple_id) == false) {
+            transaction_manager.SetTransactionResult(current_txn, RESULT_FAILURE);
+            return false;
+          }
+          continue;
+        }
 
         auto visibility = transaction_manager.IsVisible(current_txn, tile_group_header, tuple_id);
 
@@ -144,6 +162,14 @@ bool SeqScanExecutor::DExecute() {
             position_list.push_back(tuple_id);
             auto res = transaction_manager.PerformRead(current_txn, location);
             if (!res) {
+              // the version was replaced while the read waited for its
+              // lock, the newest version is read in its own slot.
+              if (transaction_manager.IsVisible(current_txn, tile_group_header,
+                                                tuple_id) ==
+                  VISIBILITY_INVISIBLE) {
+                position_list.pop_back();
+                continue;
+              }
               transaction_manager.SetTransactionResult(current_txn, RESULT_FAILURE);
               return res;
             }
@@ -158,6 +184,12 @@ bool SeqScanExecutor::DExecute() {
               position_list.push_back(tuple_id);
               auto res = transaction_manager.PerformRead(current_txn, location);
               if (!res) {
+                if (transaction_manager.IsVisible(
+                        current_txn, tile_group_header, tuple_id) ==
+                    VISIBILITY_INVISIBLE) {
+                  position_list.pop_back();
+                  continue;
+                }
                 transaction_manager.SetTransactionResult(current_txn, RESULT_FAILURE);
                 return res;
               } else {
@@ -182,6 +214,13 @@ bool SeqScanExecutor::DExecute() {
       SetOutput(logical_tile.release());
       return true;
     }
+
+    // Finally, return the copied versions.
+    auto old_version_tile = GetNextOldVersionTile(column_ids_);
+    if (old_version_tile != nullptr) {
+      SetOutput(old_version_tile);
+      return true;
+    }
   }
 
   return false;
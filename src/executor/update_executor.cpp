@@ -11,6 +11,8 @@
 //===----------------------------------------------------------------------===//
 
 
+#include <numeric>
+
 #include "executor/update_executor.h"
 #include "planner/update_plan.h"
 #include "common/logger.h"
@@ -23,6 +25,7 @@
 #include "storage/data_table.h"
 #include "storage/tile_group_header.h"
 #include "storage/tile.h"
+#include "storage/tuple.h"
 #include "storage/rollback_segment.h"
 
 namespace peloton {
@@ -75,21 +78,45 @@ bool UpdateExecutor::DExecute() {
 
   auto &pos_lists = source_tile.get()->GetPositionLists();
   storage::Tile *tile = source_tile->GetBaseTile(0);
-  storage::TileGroup *tile_group = tile->GetTileGroup();
-  storage::TileGroupHeader *tile_group_header = tile_group->GetHeader();
-  auto tile_group_id = tile_group->GetTileGroupId();
+  storage::TileGroup *source_tile_group = tile->GetTileGroup();
 
   auto &transaction_manager =
       concurrency::TransactionManagerFactory::GetInstance();
 
   auto current_txn = executor_context_->GetTransaction();
 
+  // with rollback segments, the tuples the transaction does not own are read
+  // from copies, which point at their master versions.
+  bool is_copy = (concurrency::TransactionManagerFactory::IsRB() == true &&
+                  source_tile_group->GetAbstractTable() != target_table_);
 
   // Update tuples in given table
   for (oid_t visible_tuple_id : *source_tile) {
     oid_t physical_tuple_id = pos_lists[0][visible_tuple_id];
 
-    ItemPointer old_location(tile_group_id, physical_tuple_id);
+    ItemPointer old_location(source_tile_group->GetTileGroupId(),
+                             physical_tuple_id);
+
+    // a copy is updated through its master version. a copy of an older
+    // version fails to own it.
+    std::shared_ptr<storage::TileGroup> master_tile_group;
+    storage::TileGroup *tile_group = source_tile_group;
+    if (is_copy == true) {
+      old_location = source_tile_group->GetHeader()->GetNextItemPointer(
+          physical_tuple_id);
+      master_tile_group =
+          catalog::Manager::GetInstance().GetTileGroup(old_location.block);
+      if (master_tile_group == nullptr) {
+        LOG_TRACE("Fail to find the master version. Set txn failure.");
+        transaction_manager.SetTransactionResult(current_txn,
+                                                 Result::RESULT_FAILURE);
+        return false;
+      }
+      tile_group = master_tile_group.get();
+      physical_tuple_id = old_location.offset;
+    }
+    storage::TileGroupHeader *tile_group_header = tile_group->GetHeader();
+    auto tile_group_id = tile_group->GetTileGroupId();
 
     LOG_TRACE("Visible Tuple id : %u, Physical Tuple id : %u ",
               visible_tuple_id, physical_tuple_id);
@@ -98,6 +125,47 @@ bool UpdateExecutor::DExecute() {
         transaction_manager.IsOwner(current_txn, tile_group_header, physical_tuple_id);
     if (is_owner == true) {
 
+      // save the values that are about to be overwritten. the keys the
+      // transaction wrote before are removed once no version holds them.
+      if (concurrency::TransactionManagerFactory::IsRB() == true) {
+        auto &rb_txn_manager =
+            concurrency::TimestampOrderingRbTransactionManager::GetInstance();
+        auto schema = target_table_->GetSchema();
+        std::vector<oid_t> column_ids(schema->GetColumnCount());
+        std::iota(column_ids.begin(), column_ids.end(), 0);
+
+        expression::ContainerTuple<storage::TileGroup> old_tuple(
+            tile_group, physical_tuple_id);
+        storage::Tuple overwritten_tuple(schema, true);
+        overwritten_tuple.SetFromTuple(
+            &old_tuple, column_ids,
+            executor_context_->GetExecutorContextPool());
+
+        rb_txn_manager.PerformUpdateWithRb(current_txn, old_location,
+                                           project_info_->GetTargetList());
+
+        project_info_->Evaluate(&old_tuple, &old_tuple, nullptr,
+                                executor_context_);
+
+        ItemPointer *indirection =
+            tile_group_header->GetIndirection(old_location.offset);
+        bool ret = target_table_->InstallVersion(
+            &old_tuple, &(project_info_->GetTargetList()), indirection);
+
+        transaction_manager.PerformUpdate(current_txn, old_location);
+
+        if (ret == false) {
+          LOG_TRACE("Fail to update tuple. Set txn failure.");
+          transaction_manager.SetTransactionResult(current_txn,
+                                                   Result::RESULT_FAILURE);
+          return false;
+        }
+
+        rb_txn_manager.DeleteOverwrittenKeys(tile_group, physical_tuple_id,
+                                             &overwritten_tuple);
+        continue;
+      }
+
       // Make a copy of the original tuple and allocate a new tuple
       expression::ContainerTuple<storage::TileGroup> old_tuple(
           tile_group, physical_tuple_id);
@@ -123,6 +191,36 @@ bool UpdateExecutor::DExecute() {
           transaction_manager.SetTransactionResult(current_txn, Result::RESULT_FAILURE);
           return false;
         }
+
+        // with rollback segments, the old values are saved aside and the
+        // tuple is updated in place.
+        if (concurrency::TransactionManagerFactory::IsRB() == true) {
+          concurrency::TimestampOrderingRbTransactionManager::GetInstance()
+              .PerformUpdateWithRb(current_txn, old_location,
+                                   project_info_->GetTargetList());
+
+          expression::ContainerTuple<storage::TileGroup> old_tuple(
+              tile_group, physical_tuple_id);
+          project_info_->Evaluate(&old_tuple, &old_tuple, nullptr,
+                                  executor_context_);
+
+          // the tuple is in the write set now, so the abort restores it.
+          ItemPointer *indirection = tile_group_header->GetIndirection(old_location.offset);
+          bool ret = target_table_->InstallVersion(
+              &old_tuple, &(project_info_->GetTargetList()), indirection);
+
+          transaction_manager.PerformUpdate(current_txn, old_location);
+
+          if (ret == false) {
+            LOG_TRACE("Fail to update tuple. Set txn failure.");
+            transaction_manager.SetTransactionResult(current_txn, Result::RESULT_FAILURE);
+            return false;
+          }
+
+          executor_context_->num_processed += 1;  // updated one
+          continue;
+        }
+
         // if it is the latest version and not locked by other threads, then
         // insert a new version.
 
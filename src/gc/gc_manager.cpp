@@ -17,6 +17,10 @@
 #include "index/index.h"
 #include "concurrency/transaction_manager_factory.h"
 #include "catalog/manager.h"
+#include "expression/container_tuple.h"
+#include "storage/data_table.h"
+#include "storage/storage_manager.h"
+#include "storage/tuple.h"
 
 #include <list>
 
@@ -79,6 +83,26 @@ bool GCManager::ResetTuple(const TupleMetadata &tuple_metadata) {
 
   auto tile_group_header = tile_group->GetHeader();
 
+  // Unlink the version from the newer version, so that no version chain
+  // leads into a tile group that gets retired
+  ItemPointer location(tuple_metadata.tile_group_id,
+                       tuple_metadata.tuple_slot_id);
+  ItemPointer newer_location =
+      tile_group_header->GetPrevItemPointer(tuple_metadata.tuple_slot_id);
+  if (newer_location.IsNull() == false) {
+    auto newer_tile_group = manager.GetTileGroup(newer_location.block);
+    if (newer_tile_group != nullptr) {
+      auto newer_tile_group_header = newer_tile_group->GetHeader();
+      auto older_location =
+          newer_tile_group_header->GetNextItemPointer(newer_location.offset);
+      if (older_location.block == location.block &&
+          older_location.offset == location.offset) {
+        newer_tile_group_header->SetNextItemPointer(newer_location.offset,
+                                                    INVALID_ITEMPOINTER);
+      }
+    }
+  }
+
   // Reset the header
   tile_group_header->SetTransactionId(tuple_metadata.tuple_slot_id,
                                       INVALID_TXN_ID);
@@ -88,6 +112,8 @@ bool GCManager::ResetTuple(const TupleMetadata &tuple_metadata) {
                                         INVALID_ITEMPOINTER);
   tile_group_header->SetNextItemPointer(tuple_metadata.tuple_slot_id,
                                         INVALID_ITEMPOINTER);
+  tile_group_header->SetVersionHint(tuple_metadata.tuple_slot_id,
+                                    INVALID_ITEMPOINTER);
   PL_MEMSET(
       tile_group_header->GetReservedFieldRef(tuple_metadata.tuple_slot_id), 0,
       storage::TileGroupHeader::GetReservedSize());
@@ -98,30 +124,261 @@ bool GCManager::ResetTuple(const TupleMetadata &tuple_metadata) {
   return true;
 }
 
+// An update inserts an entry for each new key into the secondary indexes,
+// and every entry of a tuple points at the head of its version chain. The
+// entry of a key can therefore only be removed once no live version of the
+// tuple holds the key anymore: the versions newer than an updated version,
+// and the version that an aborted update replaced. A deleted tuple and an
+// insert that never became visible hold no live version, so all their
+// entries are removed, together with the entries of the older versions that
+// are still linked, and the head of the chain is retired.
+void GCManager::DeleteFromIndexes(const TupleMetadata &tuple_metadata) {
+  if (tuple_metadata.version_type == GC_VERSION_TYPE_INVALID) {
+    return;
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group = manager.GetTileGroup(tuple_metadata.tile_group_id);
+  if (tile_group == nullptr) {
+    return;
+  }
+
+  auto table = dynamic_cast<storage::DataTable *>(tile_group->GetAbstractTable());
+  if (table == nullptr) {
+    return;
+  }
+
+  auto tile_group_header = tile_group->GetHeader();
+  auto tuple_id = tuple_metadata.tuple_slot_id;
+  ItemPointer *index_entry_ptr = tile_group_header->GetIndirection(tuple_id);
+  if (index_entry_ptr == nullptr) {
+    return;
+  }
+
+  // the oldest live version of the tuple, if any
+  ItemPointer live_location = INVALID_ITEMPOINTER;
+  if (tuple_metadata.version_type == GC_VERSION_TYPE_UPDATE) {
+    live_location = tile_group_header->GetPrevItemPointer(tuple_id);
+  } else if (tuple_metadata.version_type == GC_VERSION_TYPE_ABORT_UPDATE) {
+    live_location = tile_group_header->GetNextItemPointer(tuple_id);
+  }
+
+  bool is_dead_tuple =
+      (tuple_metadata.version_type == GC_VERSION_TYPE_DELETE ||
+       tuple_metadata.version_type == GC_VERSION_TYPE_ABORT_INSERT);
+
+  if (is_dead_tuple == true) {
+    DeleteVersionKeys(table, tile_group.get(), tuple_id, index_entry_ptr,
+                      INVALID_ITEMPOINTER, false);
+
+    // the older versions that are not recycled yet would otherwise remove
+    // their keys through the retired head later on.
+    ItemPointer older_location =
+        tile_group_header->GetNextItemPointer(tuple_id);
+    while (older_location.IsNull() == false) {
+      auto older_tile_group = manager.GetTileGroup(older_location.block);
+      if (older_tile_group == nullptr) {
+        break;
+      }
+      auto older_tile_group_header = older_tile_group->GetHeader();
+      if (older_tile_group_header->GetIndirection(older_location.offset) !=
+          index_entry_ptr) {
+        break;
+      }
+
+      DeleteVersionKeys(table, older_tile_group.get(), older_location.offset,
+                        index_entry_ptr, INVALID_ITEMPOINTER, true);
+      older_tile_group_header->SetIndirection(older_location.offset, nullptr);
+
+      older_location =
+          older_tile_group_header->GetNextItemPointer(older_location.offset);
+    }
+
+    tile_group_header->SetIndirection(tuple_id, nullptr);
+
+    // transactions that looked up an entry before the removal may still
+    // follow the head.
+    auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+    retired_indirections_.emplace_back(txn_manager.GetCurrentCommitId(),
+                                       index_entry_ptr);
+  } else {
+    // only the secondary indexes get an entry per key of the updated versions
+    DeleteVersionKeys(table, tile_group.get(), tuple_id, index_entry_ptr,
+                      live_location, true);
+  }
+
+  // the keys are copied into the key pool, which is emptied after each
+  // version instead of growing the pools of the indexes.
+  key_pool_.Purge();
+
+  LOG_TRACE("Index entries of garbage tuple(%u, %u) in table %u are removed",
+            tuple_metadata.tile_group_id, tuple_metadata.tuple_slot_id,
+            tuple_metadata.table_id);
+}
+
+void GCManager::DeleteVersionKeys(storage::DataTable *table,
+                                  storage::TileGroup *tile_group,
+                                  const oid_t &tuple_id,
+                                  ItemPointer *index_entry_ptr,
+                                  const ItemPointer &live_location,
+                                  const bool secondary_only) {
+  auto &manager = catalog::Manager::GetInstance();
+
+  expression::ContainerTuple<storage::TileGroup> garbage_tuple(tile_group,
+                                                               tuple_id);
+
+  oid_t index_count = table->GetIndexCount();
+  for (oid_t index_itr = 0; index_itr < index_count; index_itr++) {
+    auto index = table->GetIndex(index_itr);
+    if (index == nullptr) {
+      continue;
+    }
+    if (secondary_only == true &&
+        index->GetIndexType() == INDEX_CONSTRAINT_TYPE_PRIMARY_KEY) {
+      continue;
+    }
+
+    auto index_schema = index->GetKeySchema();
+    auto indexed_columns = index_schema->GetIndexedColumns();
+    std::unique_ptr<storage::Tuple> key(new storage::Tuple(index_schema, true));
+    key->SetFromTuple(&garbage_tuple, indexed_columns, &key_pool_);
+
+    // keep the entry if a live version still has the key
+    bool key_in_use = false;
+    ItemPointer location = live_location;
+    while (location.IsNull() == false && key_in_use == false) {
+      auto live_tile_group = manager.GetTileGroup(location.block);
+      if (live_tile_group == nullptr) {
+        break;
+      }
+      auto live_tile_group_header = live_tile_group->GetHeader();
+
+      // an empty version of a delete holds no key
+      if (live_tile_group_header->GetTransactionId(location.offset) !=
+          INVALID_TXN_ID) {
+        expression::ContainerTuple<storage::TileGroup> live_tuple(
+            live_tile_group.get(), location.offset);
+        std::unique_ptr<storage::Tuple> live_key(
+            new storage::Tuple(index_schema, true));
+        live_key->SetFromTuple(&live_tuple, indexed_columns, &key_pool_);
+        key_in_use = key->EqualsNoSchemaCheck(*live_key);
+      }
+
+      location = live_tile_group_header->GetPrevItemPointer(location.offset);
+    }
+
+    if (key_in_use == false) {
+      index->DeleteEntry(key.get(), index_entry_ptr);
+    }
+  }
+}
+
 void GCManager::AddToRecycleMap(TupleMetadata tuple_metadata) {
+  // The keys are read from the version, so do it before the version is reset
+  DeleteFromIndexes(tuple_metadata);
+
   // If the tuple being reset no longer exists, just skip it
   if (ResetTuple(tuple_metadata) == false) return;
 
+  // The slot is counted before it can be handed out again
+  CountRecycledSlot(tuple_metadata);
+
   // Add to the recycle map
   std::shared_ptr<Queue<TupleMetadata>> recycle_queue;
   // if the entry for table_id exists.
   if (recycle_queue_map_.find(tuple_metadata.table_id, recycle_queue) == true) {
     // if the entry for tuple_metadata.table_id exists.
-    recycle_queue->Dequeue(tuple_metadata);
+    recycle_queue->Enqueue(tuple_metadata);
   } else {
     // if the entry for tuple_metadata.table_id does not exist.
     recycle_queue.reset(new Queue<TupleMetadata>(MAX_QUEUE_LENGTH));
     bool ret =
         recycle_queue_map_.insert(tuple_metadata.table_id, recycle_queue);
     if (ret == true) {
-      recycle_queue->Dequeue(tuple_metadata);
+      recycle_queue->Enqueue(tuple_metadata);
     } else {
       recycle_queue_map_.find(tuple_metadata.table_id, recycle_queue);
-      recycle_queue->Dequeue(tuple_metadata);
+      recycle_queue->Enqueue(tuple_metadata);
+    }
+  }
+}
+
+// A tile group that no longer takes inserts is dead once every slot of it is
+// recycled. It is dropped from its table and the catalog right away, so that
+// it can no longer be found, but transactions that began before the drop may
+// still hold a pointer into it. Its memory is therefore only released once
+// all of them have finished.
+void GCManager::CountRecycledSlot(const TupleMetadata &tuple_metadata) {
+  auto &manager = catalog::Manager::GetInstance();
+  auto tile_group = manager.GetTileGroup(tuple_metadata.tile_group_id);
+  if (tile_group == nullptr) {
+    return;
+  }
+
+  auto allocated_tuple_count = tile_group->GetAllocatedTupleCount();
+
+  {
+    std::lock_guard<std::mutex> lock(recycled_slot_mutex_);
+    auto &recycled_slot_count =
+        recycled_slot_counts_[tuple_metadata.tile_group_id];
+    recycled_slot_count++;
+
+    if (recycled_slot_count < allocated_tuple_count ||
+        tile_group->GetNextTupleSlot() < allocated_tuple_count) {
+      return;
+    }
+
+    // the slots left in the recycle queue are skipped from now on
+    recycled_slot_counts_.erase(tuple_metadata.tile_group_id);
+  }
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  retired_tile_groups_.emplace_back(txn_manager.GetCurrentCommitId(),
+                                    tile_group);
+
+  // scans that are running skip the offset of the tile group from now on
+  auto table =
+      dynamic_cast<storage::DataTable *>(tile_group->GetAbstractTable());
+  if (table != nullptr) {
+    table->DropTileGroup(tuple_metadata.tile_group_id);
+  } else {
+    manager.DropTileGroup(tuple_metadata.tile_group_id);
+  }
+
+  LOG_TRACE("Retired tile group %u in table %u", tuple_metadata.tile_group_id,
+            tuple_metadata.table_id);
+}
+
+void GCManager::ReleaseIndirections(const cid_t &max_cid) {
+  auto retired_itr = retired_indirections_.begin();
+  while (retired_itr != retired_indirections_.end()) {
+    if (retired_itr->first <= max_cid) {
+      delete retired_itr->second;
+      retired_itr = retired_indirections_.erase(retired_itr);
+    } else {
+      retired_itr++;
     }
   }
 }
 
+void GCManager::ReleaseTileGroups(const cid_t &max_cid) {
+  size_t released_count = 0;
+
+  auto retired_itr = retired_tile_groups_.begin();
+  while (retired_itr != retired_tile_groups_.end()) {
+    if (retired_itr->first <= max_cid) {
+      // The tiles are released to the storage manager once the last
+      // reference goes away
+      retired_itr = retired_tile_groups_.erase(retired_itr);
+      released_count++;
+    } else {
+      retired_itr++;
+    }
+  }
+
+  LOG_TRACE("Released %lu tile groups", released_count);
+}
+
 void GCManager::Running() {
   // Check if we can move anything from the possibly free list to the free list.
 
@@ -176,6 +433,10 @@ void GCManager::Running() {
     }
 
     LOG_TRACE("Marked %d tuples as garbage", tuple_counter);
+
+    ReleaseTileGroups(max_cid);
+    ReleaseIndirections(max_cid);
+
     if (is_running_ == false) {
       // Clear all pending garbage
       tuple_counter = 0;
@@ -199,7 +460,8 @@ void GCManager::Running() {
 void GCManager::RecycleTupleSlot(const oid_t &table_id,
                                  const oid_t &tile_group_id,
                                  const oid_t &tuple_id,
-                                 const cid_t &tuple_end_cid) {
+                                 const cid_t &tuple_end_cid,
+                                 const GCVersionType &version_type) {
   if (this->gc_type_ == GARBAGE_COLLECTION_TYPE_OFF) {
     return;
   }
@@ -209,6 +471,7 @@ void GCManager::RecycleTupleSlot(const oid_t &table_id,
   tuple_metadata.tile_group_id = tile_group_id;
   tuple_metadata.tuple_slot_id = tuple_id;
   tuple_metadata.tuple_end_cid = tuple_end_cid;
+  tuple_metadata.version_type = version_type;
 
   reclaim_queue_.Enqueue(tuple_metadata);
 
@@ -217,6 +480,17 @@ void GCManager::RecycleTupleSlot(const oid_t &table_id,
             tuple_metadata.table_id);
 }
 
+// called by transaction manager at the end of a transaction.
+void GCManager::RecycleTupleSlots(const std::vector<TupleMetadata> &garbage) {
+  if (this->gc_type_ == GARBAGE_COLLECTION_TYPE_OFF || garbage.empty()) {
+    return;
+  }
+
+  reclaim_queue_.EnqueueBulk(garbage.data(), garbage.size());
+
+  LOG_TRACE("Marked %lu tuples as possible garbage", garbage.size());
+}
+
 // this function returns a free tuple slot, if one exists
 // called by data_table.
 ItemPointer GCManager::ReturnFreeSlot(const oid_t &table_id) {
@@ -228,7 +502,18 @@ ItemPointer GCManager::ReturnFreeSlot(const oid_t &table_id) {
   // if there exists recycle_queue
   if (recycle_queue_map_.find(table_id, recycle_queue) == true) {
     TupleMetadata tuple_metadata;
-    if (recycle_queue->Dequeue(tuple_metadata) == true) {
+    while (recycle_queue->Dequeue(tuple_metadata) == true) {
+      {
+        std::lock_guard<std::mutex> lock(recycled_slot_mutex_);
+        auto count_itr =
+            recycled_slot_counts_.find(tuple_metadata.tile_group_id);
+        // the tile group of the slot has been retired
+        if (count_itr == recycled_slot_counts_.end()) {
+          continue;
+        }
+        count_itr->second--;
+      }
+
       LOG_TRACE("Reuse tuple(%u, %u) in table %u", tuple_metadata.tile_group_id,
                 tuple_metadata.tuple_slot_id, table_id);
       return ItemPointer(tuple_metadata.tile_group_id,
@@ -254,6 +539,10 @@ void GCManager::ClearGarbage() {
   }
 
   LOG_TRACE("GCManager finally recyle %d tuples", counter);
+
+  // No transaction is running anymore
+  ReleaseTileGroups(MAX_CID);
+  ReleaseIndirections(MAX_CID);
 }
 
 }  // namespace gc
@@ -85,6 +85,24 @@ class configuration {
 
   // asynchronous_mode
   AsynchronousType asynchronous_mode;
+
+  // write the log with O_DIRECT
+  bool direct_io;
+
+  // write the log and the checkpoints through io_uring
+  bool io_uring;
+
+  // number of log streams (frontend loggers)
+  int log_streams;
+
+  // ship the log to the standby at the remote endpoint
+  std::string remote_endpoint;
+
+  // port of the rpc server, a standby replays the log it receives there
+  int replication_port;
+
+  // whether commits wait for the standby
+  ReplicationType replication_type;
 };
 
 void Usage(FILE *out);
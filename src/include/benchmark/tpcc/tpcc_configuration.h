@@ -179,6 +179,9 @@ class configuration {
 
   // # of transaction
   int transaction_count;
+
+  // concurrency control protocol
+  ConcurrencyType protocol;
 };
 
 extern configuration state;
@@ -195,6 +198,8 @@ void ValidateWarehouseCount(const configuration &state);
 
 void ValidateTransactionCount(const configuration &state);
 
+void ValidateProtocol(const configuration &state);
+
 }  // namespace tpcc
 }  // namespace benchmark
 }  // namespace peloton
@@ -14,6 +14,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "benchmark/tpcc/tpcc_configuration.h"
 
@@ -174,6 +175,13 @@ std::unique_ptr<storage::Tuple> BuildStockTuple(
     const int stock_id, const int s_w_id,
     const std::unique_ptr<VarlenPool>& pool);
 
+/////////////////////////////////////////////////////////
+// Bulk Load
+/////////////////////////////////////////////////////////
+
+void BulkLoadTuples(storage::DataTable* table,
+                    const std::vector<std::unique_ptr<storage::Tuple>>& tuples);
+
 /////////////////////////////////////////////////////////
 // Utils
 /////////////////////////////////////////////////////////
@@ -13,6 +13,8 @@
 #pragma once
 
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <mutex>
 #include <atomic>
 #include <thread>
@@ -62,16 +64,46 @@ class LayoutTuner {
   // Clear list
   void ClearTables();
 
+  // Fraction of the table's tile groups that already match its default
+  // layout, as observed in the last tuning round
+  double GetConvergence(storage::DataTable* table);
+
  protected:
 
   // Update layout of table
   void UpdateDefaultPartition(storage::DataTable* table);
 
+  // Refresh the heat of all tile groups in table and return the offsets of
+  // the tile groups that must be transformed, hottest first
+  std::vector<oid_t> GetTransformCandidates(storage::DataTable* table);
+
+  // Transform the given tile groups using up to worker_count threads
+  void TransformTileGroups(storage::DataTable* table,
+                           const std::vector<oid_t> &tile_group_offsets);
+
  private:
 
+  // Access statistics of a tile group across tuning rounds
+  struct TileGroupHeat {
+    // Counter values seen in the previous round
+    size_t last_access_count = 0;
+    size_t last_write_count = 0;
+
+    // Decayed number of scans over the tile group
+    double heat = 0;
+  };
+
   // Tables whose layout must be tuned
   std::vector<storage::DataTable*> tables;
 
+  // Heat of the tile groups of each table, the ones dropped from the table
+  // are pruned every round (only touched by the tuner thread)
+  std::map<storage::DataTable*, std::unordered_map<oid_t, TileGroupHeat>>
+      tile_group_heat;
+
+  // Convergence of each table
+  std::map<storage::DataTable*, double> table_convergence;
+
   std::mutex layout_tuner_mutex;
 
   // Stop signal
@@ -99,6 +131,19 @@ class LayoutTuner {
   // Desired layout tile count
   oid_t tile_count = 2;
 
+  // Max tile groups transformed per table in each round
+  oid_t max_tile_groups_per_round = 8;
+
+  // Number of threads transforming tile groups in parallel
+  oid_t worker_count = 2;
+
+  // Weight of the old heat when folding in new accesses
+  double heat_decay = 0.5;
+
+  // Tile groups that claimed more slots than this since the previous round
+  // are still being written to, so they are not transformed yet
+  size_t write_threshold = 0;
+
 };
 
 
@@ -26,6 +26,15 @@ DECLARE_string(socket_family);
 // Enable or disable statistics collection
 DECLARE_uint64(stats_mode);
 
+// Spread tile groups over NUMA nodes
+DECLARE_bool(numa_aware);
+
+// Failed acquisitions after which writers wait for a tuple instead of aborting
+DECLARE_uint64(hot_tuple_threshold);
+
+// Concurrency control protocol
+DECLARE_uint64(concurrency_type);
+
 // Both for showing the help info
 DECLARE_bool(h);
 DECLARE_bool(help);
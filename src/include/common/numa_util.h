@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// numa_util.h
+//
+// Identification: src/include/common/numa_util.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "common/types.h"
+
+namespace peloton {
+
+// No preferred node
+#define NUMA_NODE_ANY -1
+
+//===--------------------------------------------------------------------===//
+// NUMA Utilities
+//===--------------------------------------------------------------------===//
+
+// The topology is read from sysfs once, and memory policies are set with
+// raw syscalls, so we do not depend on libnuma.
+class NumaUtil {
+ public:
+  // Number of memory nodes (1 on non-NUMA machines)
+  static int GetNodeCount();
+
+  // Node of the cpu the calling thread is running on
+  static int GetCurrentNode();
+
+  // Node that holds the tile group when tile groups are spread over nodes
+  static int GetTileGroupNode(const oid_t &tile_group_id);
+
+  // Restrict the calling thread to the cpus of the node
+  static bool PinCurrentThread(const int &numa_node);
+
+  // Map pages of their own that prefer the node, so that setting the policy
+  // affects no other allocation. Returns nullptr if there is a single node,
+  // or the pages could not be mapped.
+  static void *AllocateOnNode(const size_t &length, const int &numa_node);
+
+  // Unmap the pages of AllocateOnNode
+  static void FreeOnNode(void *address, const size_t &length);
+
+ private:
+  // cpus of each node
+  static const std::vector<std::vector<int>> &GetNodeCpus();
+};
+
+}  // End peloton namespace
@@ -136,6 +136,20 @@ class SerializeInput {
     return retval;
   }
 
+  /** Read an unsigned integer in the variable length encoding of
+   * WriteVarint. */
+  inline uint64_t ReadVarint() {
+    uint64_t value = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+      byte = static_cast<uint8_t>(ReadByte());
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      shift += 7;
+    } while ((byte & 0x80) != 0);
+    return value;
+  }
+
   /** Returns a pointer to the internal Data buffer, advancing the Read Position
    * by length. */
   const char *GetRawPointer(size_t length) {
@@ -261,6 +275,16 @@ class SerializeOutput {
     WriteByte(static_cast<int8_t>(value));
   }
 
+  /** Write an unsigned integer in seven bit groups, least significant first,
+   * so that small values take a single byte. */
+  inline void WriteVarint(uint64_t value) {
+    while (value >= 0x80) {
+      WriteByte(static_cast<int8_t>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    WriteByte(static_cast<int8_t>(value));
+  }
+
   inline size_t WriteCharAt(size_t Position, char value) {
     return WritePrimitiveAt(Position, value);
   }
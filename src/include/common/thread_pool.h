@@ -19,6 +19,7 @@
 #include <boost/function.hpp>
 
 #include "common/macros.h"
+#include "common/numa_util.h"
 
 namespace peloton {
 // a wrapper for boost worker thread pool.
@@ -33,13 +34,20 @@ class ThreadPool {
     thread_pool_.join_all();
   }
 
-  void Initialize(const size_t &pool_size) {
+  // if a numa node is given, the threads only run on the cpus of that node,
+  // so tasks working on tile groups placed on the node access local memory.
+  void Initialize(const size_t &pool_size,
+                  const int &numa_node = NUMA_NODE_ANY) {
     pool_size_ = pool_size;
     PL_ASSERT(pool_size_ != 0);
     for (size_t i = 0; i < pool_size_; ++i) {
       // add thread to thread pool.
-      thread_pool_.create_thread(
-          boost::bind(&boost::asio::io_service::run, &io_service_));
+      thread_pool_.create_thread([this, numa_node]() {
+        if (numa_node != NUMA_NODE_ANY) {
+          NumaUtil::PinCurrentThread(numa_node);
+        }
+        io_service_.run();
+      });
     }
   }
 
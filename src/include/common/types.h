@@ -74,6 +74,15 @@ enum GarbageCollectionType {
   GARBAGE_COLLECTION_TYPE_ON = 2    // turn on GC
 };
 
+// what a garbage version leaves behind in the indexes
+enum GCVersionType {
+  GC_VERSION_TYPE_INVALID = 0,       // no index entries to remove
+  GC_VERSION_TYPE_UPDATE = 1,        // old version replaced by an update
+  GC_VERSION_TYPE_DELETE = 2,        // last version of a deleted tuple
+  GC_VERSION_TYPE_ABORT_UPDATE = 3,  // new version of an aborted update
+  GC_VERSION_TYPE_ABORT_INSERT = 4   // tuple that never became visible
+};
+
 //===--------------------------------------------------------------------===//
 // Filesystem directories
 //===--------------------------------------------------------------------===//
@@ -383,7 +392,14 @@ enum ExpressionType {
 
 enum ConcurrencyType {
   CONCURRENCY_TYPE_INVALID = 0,
-  CONCURRENCY_TYPE_TIMESTAMP_ORDERING = 1  // timestamp ordering
+  CONCURRENCY_TYPE_TIMESTAMP_ORDERING = 1,    // timestamp ordering
+  CONCURRENCY_TYPE_TIMESTAMP_ORDERING_RB = 2,  // timestamp ordering with
+                                               // rollback segments
+  CONCURRENCY_TYPE_SSI = 3,  // serializable snapshot isolation
+  CONCURRENCY_TYPE_TWO_PHASE_LOCKING_NO_WAIT = 4,  // two-phase locking,
+                                                   // abort on conflict
+  CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE = 5  // two-phase locking,
+                                                   // older txns wait
 };
 
 //===--------------------------------------------------------------------===//
@@ -759,6 +775,10 @@ enum LogRecordType {
   // Record for delimiting transactions
   // includes max persistent commit_id
   LOGRECORD_TYPE_ITERATION_DELIMITER = 41,
+
+  // Record marking a full checkpoint, which recovery can start from without
+  // the checkpoints before it
+  LOGRECORD_TYPE_CHECKPOINT_FULL = 51,
 };
 
 enum CheckpointStatus {
@@ -876,6 +896,7 @@ struct TupleMetadata {
   oid_t tile_group_id = 0;
   oid_t tuple_slot_id = 0;
   cid_t tuple_end_cid = 0;
+  GCVersionType version_type = GC_VERSION_TYPE_INVALID;
 };
 
 //===--------------------------------------------------------------------===//
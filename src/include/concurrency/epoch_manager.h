@@ -13,6 +13,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <thread>
 #include <vector>
 
@@ -25,41 +29,47 @@ namespace concurrency {
 
 #define EPOCH_LENGTH 40
 
-struct Epoch {
-  std::atomic<int> txn_ref_count_;
+// The running transactions of a thread. Each slot sits on its own cache line
+// and is only touched by its thread, by a transaction that ends on another
+// thread, and once per epoch by the epoch thread, so the lock is practically
+// never contended.
+struct EpochSlot {
+  Spinlock lock_;
+  // begin cids of the running transactions that entered through this slot,
+  // in ascending order. a thread usually runs one transaction at a time, so
+  // the vector stays tiny and keeps its capacity.
+  std::vector<cid_t> running_cids_;
+  // largest begin cid that ever entered through this slot
   cid_t max_cid_;
 
-  Epoch() : txn_ref_count_(0), max_cid_(0) {}
-
-  void Init() {
-    txn_ref_count_ = 0;
-    max_cid_ = 0;
-  }
-};
+  EpochSlot() : max_cid_(0) {}
+} CACHE_ALIGNED;
 
 class EpochManager {
  public:
   EpochManager()
-      : epoch_queue_(epoch_queue_size_),
-        queue_tail_(0),
-        current_epoch_(0),
-        queue_tail_gc(true),
-        max_cid(0),
+      : next_slot_id_(0),
+        max_dead_cid_(0),
+        last_entered_cid_(0),
         finish_(false) {
-    // ts_thread_.reset(new std::thread(&EpochManager::Start, this));
-    // ts_thread_->detach();
     ts_thread_ = std::thread(&EpochManager::Start, this);
   }
 
+  // Restart the epochs from scratch. No transaction may be running.
   void Reset() {
     finish_ = true;
     ts_thread_.join();
 
-    queue_tail_ = 0;
-    current_epoch_ = 0;
-    epoch_queue_[0].Init();
-    queue_tail_gc = true;
-    max_cid = 0;
+    for (size_t slot_id = 0; slot_id < epoch_slot_count_; ++slot_id) {
+      auto &slot = epoch_slots_[slot_id];
+      slot.lock_.Lock();
+      slot.running_cids_.clear();
+      slot.max_cid_ = 0;
+      slot.lock_.Unlock();
+    }
+
+    max_dead_cid_ = 0;
+    last_entered_cid_ = 0;
 
     finish_ = false;
     ts_thread_ = std::thread(&EpochManager::Start, this);
@@ -70,73 +80,84 @@ class EpochManager {
     ts_thread_.join();
   }
 
-  //    static uint64_t GetEpoch() {
-  //
-  //      COMPILER_MEMORY_FENCE;
-  //
-  //      uint64_t ret_ts = curr_epoch_;
-  //
-  //      COMPILER_MEMORY_FENCE;
-  //
-  //      return ret_ts;
-  //    }
-
+  // Register a running transaction in the slot of the calling thread and
+  // return the slot id, which must be passed to ExitEpoch.
   size_t EnterEpoch(cid_t begin_cid) {
-    auto epoch = current_epoch_.load();
-
-    size_t epoch_idx = epoch % epoch_queue_size_;
-    epoch_queue_[epoch_idx].txn_ref_count_++;
+    size_t slot_id = GetThreadSlotId();
+    auto &slot = epoch_slots_[slot_id];
+
+    slot.lock_.Lock();
+    // begin cids mostly grow, so this is usually an append.
+    slot.running_cids_.insert(std::upper_bound(slot.running_cids_.begin(),
+                                               slot.running_cids_.end(),
+                                               begin_cid),
+                              begin_cid);
+    if (begin_cid > slot.max_cid_) {
+      slot.max_cid_ = begin_cid;
+    }
+    slot.lock_.Unlock();
 
-    // Set the max cid in the tuple
-    auto max_cid_ptr = &(epoch_queue_[epoch_idx].max_cid_);
-    AtomicMax(max_cid_ptr, begin_cid);
+    return slot_id;
+  }
 
-    return epoch;
+  // the transaction may end on another thread than the one it began on.
+  void ExitEpoch(size_t slot_id, cid_t begin_cid) {
+    PL_ASSERT(slot_id < epoch_slot_count_);
+    auto &slot = epoch_slots_[slot_id];
+
+    slot.lock_.Lock();
+    auto cid_itr = std::lower_bound(slot.running_cids_.begin(),
+                                    slot.running_cids_.end(), begin_cid);
+    PL_ASSERT(cid_itr != slot.running_cids_.end() && *cid_itr == begin_cid);
+    slot.running_cids_.erase(cid_itr);
+    slot.lock_.Unlock();
   }
 
-  void ExitEpoch(size_t epoch) {
-    PL_ASSERT(epoch >= queue_tail_);
-    PL_ASSERT(epoch <= current_epoch_);
+  // every transaction with a begin cid up to the returned cid has finished.
+  // the value is computed by the epoch thread, so it lags behind by up to
+  // two epochs.
+  cid_t GetMaxDeadTxnCid() { return max_dead_cid_.load(); }
 
-    auto epoch_idx = epoch % epoch_queue_size_;
+  // Recompute the max dead cid from the slots. Called by the epoch thread
+  // once per epoch, and directly by tests that must not wait for epochs.
+  void AdvanceEpoch() {
+    std::lock_guard<std::mutex> epoch_lock(epoch_mutex_);
 
-    epoch_queue_[epoch_idx].txn_ref_count_--;
-  }
-  // assume we store epoch_store max_store previously
-  cid_t GetMaxDeadTxnCid() {
-    // TODO:
-    // change to:
-    // increase tail
-    // return max
-    auto tail = queue_tail_.load();
-    auto head = current_epoch_.load();
-    if (head > 0) {
-      head--;
+    cid_t min_running_cid = MAX_CID;
+    cid_t max_entered_cid = 0;
+
+    size_t slot_count = next_slot_id_.load();
+    if (slot_count > epoch_slot_count_) {
+      slot_count = epoch_slot_count_;
     }
-    auto res = max_cid;
-
-    auto dead_num = 0;
-    while (tail < head) {
-      auto idx = tail % epoch_queue_size_;
-      // break when meeting running txn
-      if (epoch_queue_[idx].txn_ref_count_ > 0) {
-        break;
-      }
 
-      if (epoch_queue_[idx].max_cid_ > res) {
-        res = epoch_queue_[idx].max_cid_;
+    for (size_t slot_id = 0; slot_id < slot_count; ++slot_id) {
+      auto &slot = epoch_slots_[slot_id];
+
+      slot.lock_.Lock();
+      if (slot.running_cids_.empty() == false &&
+          slot.running_cids_.front() < min_running_cid) {
+        min_running_cid = slot.running_cids_.front();
       }
-      tail++;
-      dead_num++;
+      if (slot.max_cid_ > max_entered_cid) {
+        max_entered_cid = slot.max_cid_;
+      }
+      slot.lock_.Unlock();
     }
-    if (res > max_cid) {
-      AtomicMax(&max_cid, res);
+
+    // a transaction registers shortly after it draws its begin cid. only the
+    // cids that had entered one epoch ago are trusted to cover every
+    // transaction below them.
+    cid_t dead_cid = last_entered_cid_;
+    if (min_running_cid <= dead_cid && min_running_cid > 0) {
+      dead_cid = min_running_cid - 1;
     }
 
-    if (dead_num > 32) {
-      IncreaseTail();
+    if (dead_cid > max_dead_cid_.load()) {
+      max_dead_cid_ = dead_cid;
     }
-    return max_cid;
+
+    last_entered_cid_ = max_entered_cid;
   }
 
  private:
@@ -145,82 +166,32 @@ class EpochManager {
       // the epoch advances every 40 milliseconds.
       std::this_thread::sleep_for(std::chrono::milliseconds(EPOCH_LENGTH));
 
-      auto next_idx = (current_epoch_.load() + 1) % epoch_queue_size_;
-      auto tail_idx = queue_tail_.load() % epoch_queue_size_;
-      if (next_idx == tail_idx) {
-        // overflow
-        // in this case, just increase tail
-        IncreaseTail();
-        continue;
-      }
-
-      // we have to init it first, then increase current epoch
-      // otherwise may read dirty data
-      epoch_queue_[next_idx].Init();
-      current_epoch_++;
-
-      IncreaseTail();
+      AdvanceEpoch();
     }
   }
 
-  void IncreaseTail() {
-    bool expect = true, desired = false;
-    if (!queue_tail_gc.compare_exchange_weak(expect, desired)) {
-      // someone now is increasing tail
-      return;
-    }
-
-    auto current = current_epoch_.load();
-    auto tail = queue_tail_.load();
-
-    while (true) {
-      if (tail + 1 == current) {
-        break;
-      }
-
-      auto idx = tail % epoch_queue_size_;
-
-      // inc tail until we find an epoch that has running txn
-      if (epoch_queue_[idx].txn_ref_count_ > 0) {
-        break;
-      }
+  // threads beyond the slot count share slots.
+  size_t GetThreadSlotId() {
+    static thread_local size_t slot_id =
+        next_slot_id_.fetch_add(1) % epoch_slot_count_;
+    return slot_id;
+  }
 
-      // save max cid
-      auto max = epoch_queue_[idx].max_cid_;
-      AtomicMax(&max_cid, max);
-      tail++;
-    }
+ private:
+  // number of per-thread slots
+  static const size_t epoch_slot_count_ = 1024;
 
-    queue_tail_ = tail;
+  EpochSlot epoch_slots_[epoch_slot_count_];
 
-    expect = false;
-    desired = true;
+  std::atomic<size_t> next_slot_id_;
 
-    queue_tail_gc.compare_exchange_weak(expect, desired);
-    return;
-  }
+  // serializes the epoch thread with direct calls of AdvanceEpoch
+  std::mutex epoch_mutex_;
 
-  void AtomicMax(cid_t* addr, cid_t max) {
-    while (true) {
-      auto old = *addr;
-      if (old > max) {
-        return;
-      } else if (__sync_bool_compare_and_swap(addr, old, max)) {
-        return;
-      }
-    }
-  }
+  // only written under the epoch mutex
+  std::atomic<cid_t> max_dead_cid_;
+  cid_t last_entered_cid_;
 
- private:
-  // queue size
-  static const size_t epoch_queue_size_ = 2048;
-
-  // Epoch vector
-  std::vector<Epoch> epoch_queue_;
-  std::atomic<size_t> queue_tail_;
-  std::atomic<size_t> current_epoch_;
-  std::atomic<bool> queue_tail_gc;
-  cid_t max_cid;
   bool finish_;
 
   std::thread ts_thread_;
@@ -0,0 +1,170 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// ssi_transaction_manager.h
+//
+// Identification: src/include/concurrency/ssi_transaction_manager.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "concurrency/timestamp_ordering_transaction_manager.h"
+#include "libcuckoo/cuckoohash_map.hh"
+
+namespace peloton {
+namespace concurrency {
+
+//===--------------------------------------------------------------------===//
+// serializable snapshot isolation
+//===--------------------------------------------------------------------===//
+
+// Every transaction reads the snapshot of the transactions committed before
+// it began. Reads never block or abort writers. Writes follow
+// first-updater-wins: a transaction can only own the latest version of a
+// tuple, and only if that version is in its snapshot.
+//
+// A rw-antidependency T1 -> T2 exists when T1 read a version that a
+// concurrent T2 overwrote. A read only records the version in the context
+// of the reader, and never writes to or locks the tuple header; a writer
+// records itself on the version it overwrites. A writer finds the
+// concurrent readers of the version it owns through their contexts, and a
+// reader marks the owner or overwriter of the version it reads. Each
+// transaction keeps an in flag and its out partners. A pivot (in and out
+// edges) is aborted only if an out partner committed before it; an edge
+// into a committed pivot aborts the transaction that adds it.
+//
+// Phantoms are not tracked: a predicate read only registers on the versions
+// it returned, so a concurrent insert into a scanned range creates no edge.
+// Only inserts of the same key conflict, through IsOccupied.
+class SsiTransactionManager : public TimestampOrderingTransactionManager {
+ public:
+  SsiTransactionManager() {}
+
+  virtual ~SsiTransactionManager() {}
+
+  static SsiTransactionManager &GetInstance();
+
+  virtual bool IsOccupied(Transaction *const current_txn,
+                          const ItemPointer &position);
+
+  virtual VisibilityType IsVisible(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual bool IsOwnable(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual bool AcquireOwnership(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual bool PerformRead(Transaction *const current_txn,
+                           const ItemPointer &location);
+
+  virtual Result CommitTransaction(Transaction *const current_txn);
+
+  virtual Result AbortTransaction(Transaction *const current_txn);
+
+  virtual Transaction *BeginTransaction() {
+    Transaction *txn = TimestampOrderingTransactionManager::BeginTransaction();
+
+    std::shared_ptr<SsiTxnContext> txn_context(new SsiTxnContext(
+        txn->GetTransactionId(), txn->GetBeginCommitId()));
+    txn_table_.insert(txn->GetTransactionId(), txn_context);
+
+    return txn;
+  }
+
+ protected:
+  virtual void InitTupleReserved(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t tuple_id);
+
+ private:
+  // the conflict state of a transaction, shared with the transactions that
+  // have an edge to it until no running transaction can conflict with it
+  struct SsiTxnContext {
+    SsiTxnContext(const txn_id_t &txn_id, const cid_t &begin_cid)
+        : txn_id(txn_id),
+          begin_cid(begin_cid),
+          commit_cid(MAX_CID),
+          in_conflict(false),
+          decided(false),
+          dangerous_out(false) {}
+
+    const txn_id_t txn_id;
+    const cid_t begin_cid;
+
+    // MAX_CID while running, COMMITTING_CID while the commit id is drawn,
+    // INVALID_CID once aborted
+    std::atomic<cid_t> commit_cid;
+
+    // protects the fields below
+    Spinlock lock;
+
+    bool in_conflict;
+
+    // the commit decision is made
+    bool decided;
+
+    // an out partner committed before this transaction
+    bool dangerous_out;
+
+    std::vector<std::shared_ptr<SsiTxnContext>> out_txns;
+
+    // the versions the transaction read, kept until the context is dropped
+    std::set<ItemPointer> read_set;
+  };
+
+  // Add the version to the read set of the transaction, and mark the
+  // transaction that owns or has overwritten it. Returns false if the
+  // transaction must abort.
+  bool RegisterRead(Transaction *const current_txn,
+                    const ItemPointer &location);
+
+  std::shared_ptr<SsiTxnContext> GetTxnContext(const txn_id_t &txn_id);
+
+  // Record the rw-antidependency reader -> writer. Returns false if the
+  // writer is a committed pivot, which the caller must abort for.
+  static bool AddConflict(const std::shared_ptr<SsiTxnContext> &reader,
+                          const std::shared_ptr<SsiTxnContext> &writer);
+
+  // Wait until the commit id of the transaction is drawn, and return it
+  static cid_t WaitForCommitId(const SsiTxnContext &txn_context);
+
+  txn_id_t *GetOverwriterField(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  // Drop the contexts that no running transaction can conflict with
+  void ReclaimTxnContexts(const txn_id_t &txn_id, const cid_t &commit_cid);
+
+  // the transaction that owned the version last
+  static const int OVERWRITER_OFFSET = (LAST_READER_OFFSET + 8);
+
+  static const cid_t COMMITTING_CID = MAX_CID - 1;
+
+  // contexts of running and recently committed transactions
+  cuckoohash_map<txn_id_t, std::shared_ptr<SsiTxnContext>> txn_table_;
+
+  // committed transactions by commit id, to reclaim their contexts
+  std::mutex reclaim_mutex_;
+  std::map<cid_t, txn_id_t> committed_txns_;
+};
+}
+}
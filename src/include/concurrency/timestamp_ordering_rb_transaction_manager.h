@@ -0,0 +1,214 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// timestamp_ordering_rb_transaction_manager.h
+//
+// Identification:
+// src/include/concurrency/timestamp_ordering_rb_transaction_manager.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+
+#include "concurrency/timestamp_ordering_transaction_manager.h"
+#include "storage/rollback_segment.h"
+
+namespace peloton {
+
+namespace index {
+class Index;
+}
+
+namespace storage {
+class Tuple;
+}
+
+namespace concurrency {
+
+//===--------------------------------------------------------------------===//
+// timestamp ordering with rollback segments
+//===--------------------------------------------------------------------===//
+
+// Delta storage variant of timestamp ordering. Updates and deletes are made
+// in place on the single (master) version of a tuple. Before a transaction
+// changes a tuple, the old values of the updated columns are saved in a
+// rollback segment allocated from the transaction's RollbackSegmentPool, and
+// the segment is pushed on a per-tuple chain kept in the reserved area of the
+// tuple header. A transaction that cannot see the master version rebuilds
+// its version by applying the segments from newest to oldest.
+//
+// While a transaction updates the master version, the begin commit id of the
+// tuple is MAX_CID, and readers rebuild the committed version from the head
+// segment. A pending delete sets the end commit id to INVALID_CID, which the
+// other transactions read as MAX_CID.
+//
+// The owner writes the master version while other transactions read it, so
+// they never read it in place. They copy it instead, and a sequence number in
+// the reserved area, odd while the owner writes the master version, tells
+// them whether the copy has to be taken again.
+class TimestampOrderingRbTransactionManager
+    : public TimestampOrderingTransactionManager {
+ public:
+  TimestampOrderingRbTransactionManager() {}
+
+  virtual ~TimestampOrderingRbTransactionManager();
+
+  static TimestampOrderingRbTransactionManager &GetInstance();
+
+  virtual bool IsOccupied(Transaction *const current_txn,
+                          const ItemPointer &position);
+
+  virtual VisibilityType IsVisible(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual bool IsOwnable(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual void PerformInsert(Transaction *const current_txn,
+                             const ItemPointer &location,
+                             ItemPointer *index_entry_ptr = nullptr);
+
+  // Save the current values of the target columns in a rollback segment.
+  // Must be called by the owner before the master version is modified.
+  void PerformUpdateWithRb(Transaction *const current_txn,
+                           const ItemPointer &location,
+                           const TargetList &target_list);
+
+  // Versions are never copied in this protocol
+  virtual void PerformUpdate(Transaction *const current_txn,
+                             const ItemPointer &old_location,
+                             const ItemPointer &new_location);
+
+  virtual void PerformDelete(Transaction *const current_txn,
+                             const ItemPointer &old_location,
+                             const ItemPointer &new_location);
+
+  virtual void PerformUpdate(Transaction *const current_txn,
+                             const ItemPointer &location);
+
+  virtual void PerformDelete(Transaction *const current_txn,
+                             const ItemPointer &location);
+
+  // Copy the version of a tuple the transaction does not own that is visible
+  // to it. The read is performed on the master version first, so that no
+  // older transaction can change it during the copy. Returns false if the
+  // read fails, and sets is_visible to whether a version was copied.
+  bool ReadVisibleVersion(Transaction *const current_txn,
+                          storage::TileGroup *tile_group, const oid_t &tuple_id,
+                          storage::Tuple *tuple, VarlenPool *pool,
+                          bool &is_visible);
+
+  // Remove the secondary index entries of a version the owner overwrote,
+  // unless the master version or a version that can still be read holds
+  // the same key.
+  void DeleteOverwrittenKeys(storage::TileGroup *tile_group,
+                             const oid_t &tuple_id,
+                             const storage::Tuple *overwritten_version);
+
+  virtual Result CommitTransaction(Transaction *const current_txn);
+
+  virtual Result AbortTransaction(Transaction *const current_txn);
+
+  virtual void EndTransaction(Transaction *current_txn);
+
+ private:
+  // a committed version and the pool holding its varlen values
+  struct OverwrittenVersion {
+    cid_t commit_id;
+    ItemPointer location;
+    ItemPointer *index_entry_ptr;
+    std::unique_ptr<storage::Tuple> tuple;
+    std::unique_ptr<VarlenPool> pool;
+  };
+
+  static const int RB_SEG_OFFSET = (LAST_READER_OFFSET + 8);
+  static const int RB_SEQ_OFFSET = (RB_SEG_OFFSET + 8);
+
+  // head of the rollback segment chain of a tuple
+  char *GetRbSeg(const storage::TileGroupHeader *const tile_group_header,
+                 const oid_t &tuple_id);
+
+  void SetRbSeg(const storage::TileGroupHeader *const tile_group_header,
+                const oid_t &tuple_id, const char *rb_seg);
+
+  // sequence number of the master version, odd while the owner writes it
+  uint64_t GetMasterSeq(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  void StartMasterWrite(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  void FinishMasterWrite(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  // Copy the master version, retrying while the owner writes it. Returns the
+  // head of the segment chain read with the copy.
+  char *CopyMasterVersion(storage::TileGroup *tile_group,
+                          const oid_t &tuple_id, storage::Tuple *tuple,
+                          VarlenPool *pool, txn_id_t &tuple_txn_id,
+                          cid_t &tuple_begin_cid, cid_t &tuple_end_cid);
+
+  // Copy the master version and undo it down to the version visible to the
+  // transaction. Returns false if no version is visible.
+  bool CopyVisibleVersion(Transaction *const current_txn,
+                          storage::TileGroup *tile_group, const oid_t &tuple_id,
+                          storage::Tuple *tuple, VarlenPool *pool);
+
+  // Whether the master version, or a version rebuilt from segments newer
+  // than the given commit id, holds the key
+  bool IsKeyInUse(storage::TileGroup *tile_group, const oid_t &tuple_id,
+                  index::Index *index, const storage::Tuple *key,
+                  const cid_t &min_cid, VarlenPool *pool);
+
+  // Delete the default index entries of the keys of a version that no
+  // version ending at or after min_cid holds
+  void DeleteUnusedKeys(storage::TileGroup *tile_group, const oid_t &tuple_id,
+                        ItemPointer *index_entry_ptr,
+                        const storage::Tuple *version, const cid_t &min_cid);
+
+  // Get the rollback segment pool of the transaction, creating it on the
+  // first update
+  storage::RollbackSegmentPool *GetRbSegPool(Transaction *const current_txn);
+
+  // Restore the master version of an updated tuple from its head segment
+  void RollbackUpdate(storage::TileGroup *tile_group, const oid_t &tuple_id);
+
+  // Roll back the update, and delete the keys only the aborted version held
+  void RollbackUpdateAndKeys(storage::TileGroup *tile_group,
+                             const oid_t &tuple_id);
+
+  // Keep the version the committing update replaced if one of its keys
+  // differs from the keys of the master version
+  void CollectOverwrittenVersion(
+      storage::TileGroup *tile_group, const oid_t &tuple_id,
+      const cid_t &end_commit_id,
+      std::list<OverwrittenVersion> &overwritten_versions);
+
+  // Free the pools that no running transaction can read from anymore
+  void ReclaimRbSegPools();
+
+  // pools of ended transactions
+  std::list<storage::RollbackSegmentPool *> garbage_rb_seg_pools_;
+
+  // versions a committed update replaced with a different secondary key.
+  // their entries are removed once no running transaction can read them.
+  std::list<OverwrittenVersion> overwritten_versions_;
+
+  std::mutex garbage_rb_seg_pools_mutex_;
+};
+}
+}
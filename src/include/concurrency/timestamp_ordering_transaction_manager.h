@@ -13,12 +13,22 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 #include "concurrency/transaction_manager.h"
 #include "storage/tile_group.h"
 #include "statistics/stats_aggregator.h"
 #include "common/config.h"
 
 namespace peloton {
+
+namespace logging {
+struct LogWrite;
+}
+
 namespace concurrency {
 
 //===--------------------------------------------------------------------===//
@@ -27,7 +37,7 @@ namespace concurrency {
 
 class TimestampOrderingTransactionManager : public TransactionManager {
  public:
-  TimestampOrderingTransactionManager() {}
+  TimestampOrderingTransactionManager() : owner_waiter_count_(0) {}
 
   virtual ~TimestampOrderingTransactionManager() {}
 
@@ -109,8 +119,31 @@ class TimestampOrderingTransactionManager : public TransactionManager {
     return txn;
   }
 
+  virtual Transaction *BeginReadonlyTransaction() {
+    txn_id_t txn_id = GetNextTransactionId();
+    cid_t begin_cid = AcquireReadonlySnapshot();
+    Transaction *txn = new Transaction(txn_id, begin_cid);
+    txn->SetDeclaredReadOnly();
+
+    auto eid = EpochManagerFactory::GetInstance().EnterEpoch(begin_cid);
+    txn->SetEpochId(eid);
+
+    if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+      stats::BackendStatsContext::GetInstance()
+          .GetTxnLatencyMetric()
+          .StartTimer();
+    }
+
+    return txn;
+  }
+
   virtual void EndTransaction(Transaction *current_txn) {
-    EpochManagerFactory::GetInstance().ExitEpoch(current_txn->GetEpochId());
+    EpochManagerFactory::GetInstance().ExitEpoch(
+        current_txn->GetEpochId(), current_txn->GetBeginCommitId());
+
+    if (current_txn->IsDeclaredReadOnly() == true) {
+      ReleaseReadonlySnapshot(current_txn->GetBeginCommitId());
+    }
 
     delete current_txn;
     current_txn = nullptr;
@@ -122,7 +155,27 @@ class TimestampOrderingTransactionManager : public TransactionManager {
     }
   }
 
- private:
+  // Number of transactions waiting for the owner of a hot tuple
+  size_t GetOwnerWaiterCount() const { return owner_waiter_count_.load(); }
+
+ protected:
+  Result CommitReadonlyTransaction(Transaction *const current_txn);
+
+  // Make the versions written by the transaction visible at the commit id,
+  // and collect the writes to log if logging is on
+  void InstallWriteSet(Transaction *const current_txn,
+                       const cid_t &end_commit_id,
+                       std::vector<logging::LogWrite> &log_writes);
+
+  // Hand the versions that no transaction from their end cid on can see to
+  // the GC, in one batch
+  void RecycleVersions(const std::vector<TupleMetadata> &garbage);
+
+  static TupleMetadata GetGarbage(const oid_t &table_id,
+                                  const ItemPointer &location,
+                                  const cid_t &end_cid,
+                                  const GCVersionType &version_type);
+
   static const int LOCK_OFFSET = 0;
   static const int LAST_READER_OFFSET = (LOCK_OFFSET + 8);
 
@@ -139,9 +192,42 @@ class TimestampOrderingTransactionManager : public TransactionManager {
       const oid_t &tuple_id, const cid_t &current_cid);
 
   // Initiate reserved area of a tuple
-  void InitTupleReserved(
+  virtual void InitTupleReserved(
       const storage::TileGroupHeader *const tile_group_header,
       const oid_t tuple_id);
+
+  // A tuple is hot once transactions failed to read or own it often enough
+  bool IsHotTuple(const storage::TileGroupHeader *const tile_group_header,
+                  const oid_t &tuple_id);
+
+  // Wait until the owner of a hot tuple releases it. Returns false if the
+  // owner must not be waited for or does not finish in time.
+  bool WaitForOwner(Transaction *const current_txn,
+                    const storage::TileGroupHeader *const tile_group_header,
+                    const oid_t &tuple_id);
+
+  // Wake the transactions waiting for the tuples the transaction owned
+  void WakeOwnerWaiters(Transaction *const current_txn);
+
+  // transactions waiting for an owner sleep in the queue of the tuple's
+  // bucket until an owner in the bucket finishes
+  struct OwnerWaitQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+
+  OwnerWaitQueue &GetOwnerWaitQueue(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  static const size_t OWNER_WAIT_QUEUE_COUNT = 64;
+
+  // upper bound on the time a transaction waits for an owner
+  static const size_t HOT_TUPLE_WAIT_MS = 10;
+
+  OwnerWaitQueue owner_wait_queues_[OWNER_WAIT_QUEUE_COUNT];
+
+  std::atomic<size_t> owner_waiter_count_;
 };
 }
 }
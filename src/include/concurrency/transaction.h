@@ -25,6 +25,11 @@
 #include "common/exception.h"
 
 namespace peloton {
+
+namespace storage {
+class RollbackSegmentPool;
+}
+
 namespace concurrency {
 
 //===--------------------------------------------------------------------===//
@@ -106,6 +111,27 @@ class Transaction : public Printable {
     return is_written_ == false && insert_count_ == 0;
   }
 
+  // A declared read-only transaction reads at a snapshot of committed data
+  // and is not allowed to write
+  inline bool IsDeclaredReadOnly() const { return declared_read_only_; }
+
+  inline void SetDeclaredReadOnly() { declared_read_only_ = true; }
+
+  // An asynchronous commit returns before the log of the transaction is
+  // flushed. The log manager bounds how far the flushed log may lag behind.
+  inline bool IsSyncCommit() const { return sync_commit_; }
+
+  inline void SetSyncCommit(bool sync_commit) { sync_commit_ = sync_commit; }
+
+  // Pool of the rollback segments created by the transaction (delta storage)
+  inline storage::RollbackSegmentPool *GetRbSegPool() const {
+    return rb_seg_pool_;
+  }
+
+  inline void SetRbSegPool(storage::RollbackSegmentPool *rb_seg_pool) {
+    rb_seg_pool_ = rb_seg_pool;
+  }
+
  private:
   //===--------------------------------------------------------------------===//
   // Data members
@@ -130,6 +156,14 @@ class Transaction : public Printable {
 
   bool is_written_;
   size_t insert_count_;
+
+  bool declared_read_only_ = false;
+
+  bool sync_commit_ = true;
+
+  // owned by the transaction manager, which reclaims it after the
+  // transaction ends
+  storage::RollbackSegmentPool *rb_seg_pool_ = nullptr;
 };
 
 }  // End concurrency namespace
@@ -16,12 +16,14 @@
 #include <atomic>
 #include <unordered_map>
 #include <list>
+#include <set>
 #include <utility>
 
 #include "storage/tile_group_header.h"
 #include "concurrency/transaction.h"
 #include "concurrency/epoch_manager.h"
 #include "common/logger.h"
+#include "common/platform.h"
 
 namespace peloton {
 
@@ -46,6 +48,8 @@ class TransactionManager {
     next_txn_id_ = ATOMIC_VAR_INIT(START_TXN_ID);
     next_cid_ = ATOMIC_VAR_INIT(START_CID);
     maximum_grant_cid_ = ATOMIC_VAR_INIT(MAX_CID);
+    replayed_cid_ = ATOMIC_VAR_INIT(INVALID_CID);
+    min_readonly_snapshot_ = ATOMIC_VAR_INIT(MAX_CID);
   }
 
   virtual ~TransactionManager() {}
@@ -134,8 +138,18 @@ class TransactionManager {
 
   void SetMaxGrantCid(cid_t cid) { maximum_grant_cid_ = cid; }
 
+  // a standby has replayed the log of its primary up to the commit id, and
+  // its read-only transactions read at it. invalid unless a standby.
+  void SetReplayedCid(cid_t cid) { replayed_cid_ = cid; }
+
+  cid_t GetReplayedCid() const { return replayed_cid_.load(); }
+
   virtual Transaction *BeginTransaction() = 0;
 
+  // Begin a transaction that only reads. It reads at a snapshot of committed
+  // data, so its reads are neither tracked nor validated.
+  virtual Transaction *BeginReadonlyTransaction() = 0;
+
   virtual void EndTransaction(Transaction *current_txn) = 0;
 
   virtual Result CommitTransaction(Transaction *const current_txn) = 0;
@@ -149,9 +163,18 @@ class TransactionManager {
 
   // this function generates the maximum commit id of committed transactions.
   // please note that this function only returns a "safe" value instead of a
-  // precise value.
+  // precise value. it never exceeds the snapshot of a running read-only
+  // transaction, so the versions it reads are kept.
   cid_t GetMaxCommittedCid() {
-    return EpochManagerFactory::GetInstance().GetMaxDeadTxnCid();
+    cid_t max_committed_cid =
+        EpochManagerFactory::GetInstance().GetMaxDeadTxnCid();
+
+    cid_t min_snapshot_cid = min_readonly_snapshot_.load();
+    if (min_snapshot_cid < max_committed_cid) {
+      max_committed_cid = min_snapshot_cid;
+    }
+
+    return max_committed_cid;
   }
 
   void SetDirtyRange(std::pair<cid_t, cid_t> dirty_range) {
@@ -159,6 +182,31 @@ class TransactionManager {
   }
 
  protected:
+  // Take a snapshot at which every transaction has finished, or on a standby
+  // the replayed commit id, and keep it until the read-only transaction ends
+  cid_t AcquireReadonlySnapshot() {
+    readonly_snapshots_lock_.Lock();
+    cid_t snapshot_cid = replayed_cid_.load();
+    if (snapshot_cid == INVALID_CID) {
+      snapshot_cid = EpochManagerFactory::GetInstance().GetMaxDeadTxnCid();
+    }
+    readonly_snapshots_.insert(snapshot_cid);
+    min_readonly_snapshot_ = *readonly_snapshots_.begin();
+    readonly_snapshots_lock_.Unlock();
+    return snapshot_cid;
+  }
+
+  void ReleaseReadonlySnapshot(const cid_t &snapshot_cid) {
+    readonly_snapshots_lock_.Lock();
+    auto snapshot_itr = readonly_snapshots_.find(snapshot_cid);
+    PL_ASSERT(snapshot_itr != readonly_snapshots_.end());
+    readonly_snapshots_.erase(snapshot_itr);
+    min_readonly_snapshot_ = (readonly_snapshots_.empty() == true)
+                                 ? MAX_CID
+                                 : *readonly_snapshots_.begin();
+    readonly_snapshots_lock_.Unlock();
+  }
+
   inline bool CidIsInDirtyRange(cid_t cid) {
     return ((cid > dirty_range_.first) & (cid <= dirty_range_.second));
   }
@@ -171,6 +219,15 @@ class TransactionManager {
   std::atomic<txn_id_t> next_txn_id_;
   std::atomic<cid_t> next_cid_;
   std::atomic<cid_t> maximum_grant_cid_;
+  std::atomic<cid_t> replayed_cid_;
+
+  // snapshots of the running read-only transactions
+  std::multiset<cid_t> readonly_snapshots_;
+  Spinlock readonly_snapshots_lock_;
+
+  // the oldest of the snapshots, or MAX_CID if there is none. it is updated
+  // under the lock and read without it.
+  std::atomic<cid_t> min_readonly_snapshot_;
 };
 }  // End storage namespace
 }  // End peloton namespace
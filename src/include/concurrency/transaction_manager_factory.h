@@ -14,6 +14,9 @@
 #pragma once
 
 #include "concurrency/timestamp_ordering_transaction_manager.h"
+#include "concurrency/timestamp_ordering_rb_transaction_manager.h"
+#include "concurrency/ssi_transaction_manager.h"
+#include "concurrency/two_phase_locking_transaction_manager.h"
 
 namespace peloton {
 namespace concurrency {
@@ -25,6 +28,16 @@ class TransactionManagerFactory {
       case CONCURRENCY_TYPE_TIMESTAMP_ORDERING:
         return TimestampOrderingTransactionManager::GetInstance();
 
+      case CONCURRENCY_TYPE_TIMESTAMP_ORDERING_RB:
+        return TimestampOrderingRbTransactionManager::GetInstance();
+
+      case CONCURRENCY_TYPE_SSI:
+        return SsiTransactionManager::GetInstance();
+
+      case CONCURRENCY_TYPE_TWO_PHASE_LOCKING_NO_WAIT:
+      case CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE:
+        return TwoPhaseLockingTransactionManager::GetInstance(protocol_);
+
       default:
         return TimestampOrderingTransactionManager::GetInstance();
     }
@@ -38,6 +51,11 @@ class TransactionManagerFactory {
 
   static ConcurrencyType GetProtocol() { return protocol_; }
 
+  // Whether updates are made in place with rollback segments
+  static bool IsRB() {
+    return protocol_ == CONCURRENCY_TYPE_TIMESTAMP_ORDERING_RB;
+  }
+
   static IsolationLevelType GetIsolationLevel() { return isolation_level_; }
 
  private:
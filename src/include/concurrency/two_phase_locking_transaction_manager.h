@@ -0,0 +1,130 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// two_phase_locking_transaction_manager.h
+//
+// Identification: src/include/concurrency/two_phase_locking_transaction_manager.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "concurrency/timestamp_ordering_transaction_manager.h"
+
+namespace peloton {
+namespace concurrency {
+
+//===--------------------------------------------------------------------===//
+// two-phase locking
+//===--------------------------------------------------------------------===//
+
+// Every transaction reads the latest committed version of a tuple under a
+// shared lock and writes it under an exclusive lock. Both are held until the
+// transaction commits or aborts (strict two-phase locking), and the commit id
+// is drawn at commit time, so versions are committed in lock order.
+//
+// The lock of a version lives in its reserved field. The transaction id is
+// the exclusive lock, as in timestamp ordering, and the number of shared
+// holders and the oldest of them follow the last reader field. A conflicting
+// request either aborts right away (no-wait) or, if it is older than every
+// holder, sleeps in the wait queue of the version until a holder leaves
+// (wait-die). Younger transactions never wait for older ones, so waiting
+// transactions cannot form a cycle. A read that waited for a writer that
+// then committed fails without aborting the transaction; the version is no
+// longer visible, and the scan reads the newest version instead.
+class TwoPhaseLockingTransactionManager
+    : public TimestampOrderingTransactionManager {
+ public:
+  TwoPhaseLockingTransactionManager(const ConcurrencyType &protocol)
+      : protocol_(protocol) {}
+
+  virtual ~TwoPhaseLockingTransactionManager() {}
+
+  static TwoPhaseLockingTransactionManager &GetInstance(
+      const ConcurrencyType &protocol);
+
+  virtual bool IsOccupied(Transaction *const current_txn,
+                          const ItemPointer &position);
+
+  virtual VisibilityType IsVisible(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual bool IsOwnable(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual bool AcquireOwnership(
+      Transaction *const current_txn,
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t &tuple_id);
+
+  virtual void YieldOwnership(Transaction *const current_txn,
+                              const oid_t &tile_group_id,
+                              const oid_t &tuple_id);
+
+  virtual bool PerformRead(Transaction *const current_txn,
+                           const ItemPointer &location);
+
+  virtual Result CommitTransaction(Transaction *const current_txn);
+
+  virtual Result AbortTransaction(Transaction *const current_txn);
+
+ protected:
+  virtual void InitTupleReserved(
+      const storage::TileGroupHeader *const tile_group_header,
+      const oid_t tuple_id);
+
+ private:
+  // Whether the transaction holds the shared lock of the version
+  static bool HoldsReadLock(Transaction *const current_txn,
+                            const oid_t &tile_group_id, const oid_t &tuple_id);
+
+  // Take the shared or exclusive lock of the latest committed version. Under
+  // wait-die the request waits as long as it is older than every conflicting
+  // holder. Returns false if the request dies, or if the version is deleted
+  // or replaced first.
+  bool LockVersion(Transaction *const current_txn,
+                   const storage::TileGroupHeader *const tile_group_header,
+                   const oid_t &tuple_id, const bool &exclusive);
+
+  // Wake the transactions waiting for the lock of the version
+  void WakeLockWaiters(const storage::TileGroupHeader *const tile_group_header,
+                       const oid_t &tuple_id);
+
+  // Release the shared locks the transaction still holds
+  void ReleaseReadLocks(Transaction *const current_txn);
+
+  // the shared lock of a version. the oldest holder is kept since the count
+  // was last zero, so it may have left already; wait-die then lets fewer
+  // requests wait, which is still safe.
+  struct ReadLock {
+    uint64_t holder_count;
+    txn_id_t oldest_holder;
+  };
+
+  ReadLock *GetReadLock(const storage::TileGroupHeader *const tile_group_header,
+                        const oid_t &tuple_id);
+
+  static void AddReadLockHolder(ReadLock *read_lock, const txn_id_t &txn_id);
+
+  static void RemoveReadLockHolder(ReadLock *read_lock);
+
+  // the spinlock of timestamp ordering guards the shared lock.
+  static const int READ_LOCK_OFFSET = (LAST_READER_OFFSET + 8);
+
+  // a waiting transaction checks the lock again at least this often
+  static const size_t LOCK_RECHECK_MS = 10;
+
+  // no-wait or wait-die
+  ConcurrencyType protocol_;
+};
+}
+}
@@ -39,6 +39,10 @@ class Queue {
   // Enqueues one item, allocating extra space if necessary
   void Enqueue(ValueType& item);
 
+  // Enqueues count items at once, which is cheaper than enqueuing them
+  // one by one
+  void EnqueueBulk(const ValueType* items, const size_t& count);
+
   // Dequeues one item, returning true if an item was found
   // or false if the queue appeared empty
   bool Dequeue(ValueType& item);
@@ -13,11 +13,21 @@
 
 #pragma once
 
+#include <memory>
+
 #include "planner/abstract_scan_plan.h"
 #include "common/types.h"
 #include "executor/abstract_executor.h"
 
 namespace peloton {
+
+class AbstractTuple;
+
+namespace storage {
+class DataTable;
+class TileGroup;
+}
+
 namespace executor {
 
 /**
@@ -35,11 +45,33 @@ class AbstractScanExecutor : public AbstractExecutor {
   explicit AbstractScanExecutor(const planner::AbstractPlan *node,
                                 ExecutorContext *executor_context);
 
+  ~AbstractScanExecutor();
+
  protected:
   bool DInit();
 
   virtual bool DExecute() = 0;
 
+  //===--------------------------------------------------------------------===//
+  // Old Versions
+  //===--------------------------------------------------------------------===//
+
+  // With rollback segments, the owner of a tuple writes it in place, so the
+  // other transactions read the tuples they do not own from copies. Copy the
+  // version visible to the transaction and keep it if it satisfies the
+  // predicate. Returns false if the read fails.
+  bool CopyVisibleVersion(storage::TileGroup *tile_group,
+                          const oid_t &tuple_id);
+
+  // Whether a copied version qualifies for the scan beyond the predicate
+  virtual bool IsCopyQualified(UNUSED_ATTRIBUTE const AbstractTuple *tuple) {
+    return true;
+  }
+
+  // Wrap the copies made since the last call, or return nullptr once all
+  // of them have been returned. Call it after the scan is over.
+  LogicalTile *GetNextOldVersionTile(const std::vector<oid_t> &column_ids);
+
  protected:
   //===--------------------------------------------------------------------===//
   // Plan Info
@@ -50,6 +82,14 @@ class AbstractScanExecutor : public AbstractExecutor {
 
   /** @brief Columns from tile group to be added to logical tile output. */
   std::vector<oid_t> column_ids_;
+
+ private:
+  /** @brief Copied versions, created on the first one. */
+  std::unique_ptr<storage::DataTable> old_version_table_;
+
+  oid_t old_version_tile_group_offset_ = 0;
+
+  oid_t old_version_tuple_offset_ = 0;
 };
 
 }  // namespace executor
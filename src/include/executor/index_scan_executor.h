@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "executor/abstract_scan_executor.h"
@@ -20,12 +21,22 @@
 
 namespace peloton {
 
+namespace concurrency {
+class Transaction;
+}
+
 namespace storage {
 class AbstractTable;
+class TileGroup;
+class TileGroupHeader;
 }
 
 namespace executor {
 
+// a reader that walks at least this many versions leaves a hint at the head
+// of the chain
+#define VERSION_HINT_CHAIN_LENGTH 4
+
 class IndexScanExecutor : public AbstractScanExecutor {
   IndexScanExecutor(const IndexScanExecutor &) = delete;
   IndexScanExecutor &operator=(const IndexScanExecutor &) = delete;
@@ -41,6 +52,8 @@ class IndexScanExecutor : public AbstractScanExecutor {
 
   bool DExecute();
 
+  bool IsCopyQualified(const AbstractTuple *tuple);
+
  private:
   //===--------------------------------------------------------------------===//
   // Helper
@@ -48,6 +61,13 @@ class IndexScanExecutor : public AbstractScanExecutor {
   bool ExecPrimaryIndexLookup();
   bool ExecSecondaryIndexLookup();
 
+  // Return the tile group of the hinted version of the chain if every version
+  // from the given one down to it is too new for the transaction
+  std::shared_ptr<storage::TileGroup> GetVersionHint(
+      concurrency::Transaction *current_txn,
+      const storage::TileGroupHeader *tile_group_header,
+      const oid_t &tuple_id, ItemPointer &hint_location);
+
   //===--------------------------------------------------------------------===//
   // Executor State
   //===--------------------------------------------------------------------===//
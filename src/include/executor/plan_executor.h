@@ -80,10 +80,13 @@ class PlanExecutor {
    *        Before ExecutePlan, a node first receives value list, so we should
    * pass
    *        value list directly rather than passing Postgres's ParamListInfo
+   *        The transaction of the plan commits asynchronously unless
+   *        sync_commit is set
    */
   static peloton_status ExecutePlan(const planner::AbstractPlan *plan,
                                     const std::vector<Value> &params,
-									std::vector<ResultType> &result);
+                                    std::vector<ResultType> &result,
+                                    bool sync_commit = true);
 
   /*
    * @brief When a peloton node recvs a query plan, this function is invoked
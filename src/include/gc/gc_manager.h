@@ -13,6 +13,9 @@
 
 #pragma once
 
+#include <list>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <map>
@@ -20,10 +23,17 @@
 
 #include "common/types.h"
 #include "common/logger.h"
+#include "common/pool.h"
 #include "container/queue.h"
 #include "libcuckoo/cuckoohash_map.hh"
 
 namespace peloton {
+
+namespace storage {
+class DataTable;
+class TileGroup;
+}
+
 namespace gc {
 
 //===--------------------------------------------------------------------===//
@@ -55,7 +65,10 @@ class GCManager {
   GCManager &operator=(GCManager &&) = delete;
 
   GCManager(const GarbageCollectionType type)
-      : is_running_(true), gc_type_(type), reclaim_queue_(MAX_QUEUE_LENGTH) {
+      : is_running_(true),
+        gc_type_(type),
+        reclaim_queue_(MAX_QUEUE_LENGTH),
+        key_pool_(BACKEND_TYPE_MM) {
     StartGC();
   }
 
@@ -68,8 +81,13 @@ class GCManager {
 
   void StopGC();
 
-  void RecycleTupleSlot(const oid_t &table_id, const oid_t &tile_group_id,
-                        const oid_t &tuple_id, const cid_t &tuple_end_cid);
+  void RecycleTupleSlot(
+      const oid_t &table_id, const oid_t &tile_group_id,
+      const oid_t &tuple_id, const cid_t &tuple_end_cid,
+      const GCVersionType &version_type = GC_VERSION_TYPE_INVALID);
+
+  // Hand over all the garbage of a transaction at once
+  void RecycleTupleSlots(const std::vector<TupleMetadata> &garbage);
 
   ItemPointer ReturnFreeSlot(const oid_t &table_id);
 
@@ -78,6 +96,18 @@ class GCManager {
 
   bool ResetTuple(const TupleMetadata &);
 
+  // Remove the index entries of a garbage version whose keys are not held by
+  // any live version of the tuple
+  void DeleteFromIndexes(const TupleMetadata &tuple_metadata);
+
+  // Remove the entries of the version's keys that no version from the live
+  // location on holds
+  void DeleteVersionKeys(storage::DataTable *table,
+                         storage::TileGroup *tile_group, const oid_t &tuple_id,
+                         ItemPointer *index_entry_ptr,
+                         const ItemPointer &live_location,
+                         const bool secondary_only);
+
  private:
   //===--------------------------------------------------------------------===//
   // Private methods
@@ -86,6 +116,16 @@ class GCManager {
 
   void AddToRecycleMap(TupleMetadata tuple_metadata);
 
+  // Count the recycled slot and retire its tile group once every slot of it
+  // is recycled
+  void CountRecycledSlot(const TupleMetadata &tuple_metadata);
+
+  // Free the retired tile groups that no running transaction can reach
+  void ReleaseTileGroups(const cid_t &max_cid);
+
+  // Free the chain heads of dead tuples that no running transaction can reach
+  void ReleaseIndirections(const cid_t &max_cid);
+
   //===--------------------------------------------------------------------===//
   // Data members
   //===--------------------------------------------------------------------===//
@@ -100,6 +140,25 @@ class GCManager {
   // TODO: use shared pointer to reduce memory copy
   cuckoohash_map<oid_t, std::shared_ptr<Queue<TupleMetadata>>>
       recycle_queue_map_;
+
+  // number of slots in the recycle queues, per tile group. a tile group
+  // without an entry has been retired.
+  std::unordered_map<oid_t, size_t> recycled_slot_counts_;
+
+  // protects the recycled slot counts
+  std::mutex recycled_slot_mutex_;
+
+  // tile groups dropped from the catalog, with the commit id at the time of
+  // the drop. only touched by the gc thread.
+  std::list<std::pair<cid_t, std::shared_ptr<storage::TileGroup>>>
+      retired_tile_groups_;
+
+  // chain heads of dead tuples, with the commit id at the time their index
+  // entries were removed. only touched by the gc thread.
+  std::list<std::pair<cid_t, ItemPointer *>> retired_indirections_;
+
+  // holds the keys built while removing index entries
+  VarlenPool key_pool_;
 };
 
 }  // namespace gc
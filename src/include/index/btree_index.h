@@ -52,6 +52,8 @@ class BTreeIndex : public Index {
 
   bool DeleteEntry(const storage::Tuple *key, const ItemPointer &location);
 
+  bool DeleteEntry(const storage::Tuple *key, ItemPointer *location_ptr);
+
   bool CondInsertEntry(const storage::Tuple *key, ItemPointer *location,
                        std::function<bool(const ItemPointer &)> predicate);
 
@@ -209,6 +209,11 @@ class Index : public Printable {
   virtual bool DeleteEntry(const storage::Tuple *key,
                            const ItemPointer &location) = 0;
 
+  // designed for secondary indexes. the location_ptr is shared with the
+  // other entries of the tuple, so it is not freed.
+  virtual bool DeleteEntry(const storage::Tuple *key,
+                           ItemPointer *location_ptr) = 0;
+
   // First retrieve all Key-Value pairs of the given key
   // Return false if any of those k-v pairs satisfy the predicate
   // If not any of those k-v pair satisfy the predicate, insert the k-v pair
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// async_file_writer.h
+//
+// Identification: src/include/logging/async_file_writer.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/types.h>
+#include <cstdint>
+#include <map>
+
+struct io_uring;
+
+namespace peloton {
+namespace logging {
+
+// number of requests a writer keeps in flight
+#define ASYNC_FILE_WRITER_QUEUE_DEPTH 64
+
+//===--------------------------------------------------------------------===//
+// Async File Writer
+//===--------------------------------------------------------------------===//
+
+// Writes and syncs files through io_uring, with up to the queue depth of
+// requests in flight. Each request gets a ticket, and Reap returns the ticket
+// up to which every request has completed. A request fails if it returns an
+// error or writes less than it was asked to, and the tickets never complete
+// past the first failed one.
+//
+// Without io_uring (not built with liburing, or the kernel refuses to set up
+// a ring) the writer is not available, and a request runs synchronously when
+// it is queued.
+class AsyncFileWriter {
+ public:
+  AsyncFileWriter(unsigned int queue_depth = ASYNC_FILE_WRITER_QUEUE_DEPTH);
+
+  // waits for the requests in flight
+  ~AsyncFileWriter();
+
+  // whether the requests go through io_uring
+  bool IsAvailable() const { return ring_ != nullptr; }
+
+  // queue a write of the data at the offset of the file. the data must stay
+  // valid until the write completes. writes run alongside each other.
+  uint64_t Write(int fd, const char *data, size_t size, off_t offset);
+
+  // queue an fdatasync of the file. it starts once every request queued
+  // before it has completed.
+  uint64_t Sync(int fd);
+
+  // queue a write followed by an fdatasync of the file that starts once the
+  // write has completed, but does not wait for the other requests in flight.
+  // returns the ticket of the sync, which Reap still only reports once the
+  // earlier requests have completed too.
+  uint64_t WriteAndSync(int fd, const char *data, size_t size, off_t offset);
+
+  // hand the queued requests to the kernel
+  void Submit();
+
+  // collect the completed requests, or wait for all of them, and return the
+  // ticket up to which every request has completed
+  uint64_t Reap(bool wait_all);
+
+  uint64_t GetLastTicket() const { return last_ticket_; }
+
+  // number of requests that failed so far
+  size_t GetFailedCount() const { return failed_count_; }
+
+  // ticket of the first request that failed, or 0
+  uint64_t GetFailedTicket() const { return failed_ticket_; }
+
+ private:
+  // get a free submission entry for a request whose result must be the
+  // given size, waiting for a completion if the queue depth is reached
+  void *GetSubmissionEntry(uint64_t ticket, size_t size);
+
+  // wait for completions until the given number of entries is free, so that
+  // linked requests are submitted together
+  void ReserveSubmissionEntries(size_t count);
+
+  void RecordFailure(uint64_t ticket);
+
+  // wait for a completion, or only collect one if wait is not set. returns
+  // false if there was nothing to collect.
+  bool CompleteRequest(bool wait);
+
+  struct io_uring *ring_ = nullptr;
+
+  unsigned int queue_depth_;
+
+  uint64_t last_ticket_ = 0;
+
+  // tickets of the requests in flight, and the result each of them expects
+  std::map<uint64_t, size_t> inflight_;
+
+  size_t failed_count_ = 0;
+
+  uint64_t failed_ticket_ = 0;
+};
+
+}  // namespace logging
+}  // namespace peloton
@@ -49,6 +49,11 @@ class BackendLogger : public Logger {
   // Log the given record
   virtual void Log(LogRecord *record);
 
+  // Log the records of a transaction in order, taking the buffer lock once.
+  // Returns false if a record does not fit in a log buffer; the records after
+  // it are dropped, so the transaction has no commit record.
+  virtual bool Log(const std::vector<std::unique_ptr<LogRecord>> &records);
+
   // Construct a log record with tuple information
   virtual LogRecord *GetTupleRecord(LogRecordType log_record_type,
                                     txn_id_t txn_id, oid_t table_oid,
@@ -96,6 +101,10 @@ class BackendLogger : public Logger {
   VarlenPool *GetVarlenPool() { return backend_pool.get(); }
 
  protected:
+  // Append a serialized record to the current buffer. must be called with the
+  // buffer lock held, which is dropped while waiting for an empty buffer.
+  bool AppendRecord(LogRecord *record);
+
   // the lock for the buffer being used currently
   Spinlock log_buffer_lock;
 
@@ -13,17 +13,45 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
+#include "logging/async_file_writer.h"
 #include "logging/checkpoint.h"
 
 namespace peloton {
 namespace logging {
 
+// size of the chunks a checkpoint is written in through io_uring
+#define CHECKPOINT_WRITE_CHUNK_SIZE (1024 * 1024)
+
 class LogRecord;
 class BackendLogger;
 
+// every this many checkpoints one is full, the ones in between are
+// incremental
+#define CHECKPOINT_FULL_INTERVAL 8
+
+// names the chain of checkpoints, it does not take the checkpoint file prefix
+#define CHECKPOINT_MANIFEST_FILE_NAME "manifest"
+
+// A checkpoint of the chain that recovery assembles the database from. A
+// full checkpoint holds every tile group, an incremental one the tile groups
+// that changed since the checkpoint before it.
+struct CheckpointImage {
+  int version = -1;
+
+  cid_t commit_id = INVALID_CID;
+
+  bool full = true;
+
+  // the tile groups an incremental checkpoint holds
+  std::vector<oid_t> tile_group_ids;
+};
+
 //===--------------------------------------------------------------------===//
 // Simple Checkpoint
 //===--------------------------------------------------------------------===//
@@ -56,19 +84,53 @@ class SimpleCheckpoint : public Checkpoint {
     start_commit_id_ = start_commit_id;
   }
 
+  // the latest full checkpoint and the incremental ones after it
+  const std::vector<CheckpointImage> &GetCheckpointChain() const {
+    return checkpoint_chain_;
+  }
+
  private:
   void CreateFile();
 
   void Persist();
 
-  void Cleanup();
+  // free the chunks that are written, or wait for all of them
+  void ReleaseChunks(bool wait_all);
+
+  // returns false if the checkpoint could not be persisted
+  bool Cleanup();
 
   void InitVersionNumber();
 
+  // read the checkpoint of the version into the database, and return its
+  // commit id
+  cid_t RecoverImage(int version);
+
+  // whether the checkpoint of the version is full and written to its end
+  bool IsFullImage(int version);
+
+  std::string GetManifestFileName();
+
+  // the manifest names the chain of checkpoints, and the tile groups of the
+  // latest one
+  bool PersistManifest();
+
+  bool ReadManifest();
+
   std::vector<std::shared_ptr<LogRecord>> records_;
 
   FileHandle file_handle_ = INVALID_FILE_HANDLE;
 
+  // writes the checkpoint when io_uring is enabled, so the chunks of a tile
+  // group are written while the next one is scanned
+  std::unique_ptr<AsyncFileWriter> async_writer_;
+
+  // chunks in flight, with the ticket of their write
+  std::deque<std::pair<uint64_t, char *>> submitted_chunks_;
+
+  // end of the data queued to the checkpoint file
+  size_t file_offset_ = 0;
+
   std::unique_ptr<BackendLogger> logger_;
 
   // Keep tracking max oid for setting next_oid in manager
@@ -77,6 +139,24 @@ class SimpleCheckpoint : public Checkpoint {
 
   // commit id of current checkpoint
   cid_t start_commit_id_ = 0;
+
+  // whether the current checkpoint is full
+  bool full_checkpoint_ = true;
+
+  std::vector<CheckpointImage> checkpoint_chain_;
+
+  // the tile groups of the tables, and the ones the current checkpoint
+  // holds
+  std::vector<oid_t> live_tile_group_ids_;
+  std::vector<oid_t> checkpointed_tile_group_ids_;
+
+  // while recovering, the tile groups taken from a later checkpoint of the
+  // chain, and the ones the latest checkpoint has
+  std::unordered_set<oid_t> covered_tile_groups_;
+  std::unordered_set<oid_t> live_tile_groups_;
+  bool filter_live_tile_groups_ = false;
+
+  std::unordered_set<oid_t> recovered_tile_groups_;
 };
 
 }  // namespace logging
@@ -40,8 +40,10 @@ class FrontendLogger : public Logger {
 
   ~FrontendLogger();
 
+  // the logger id numbers the log stream of the frontend logger
   static FrontendLogger *GetFrontendLogger(LoggingType logging_type,
-                                           bool test_mode = false);
+                                           bool test_mode = false,
+                                           int logger_id = 0);
 
   void MainLoop(void);
 
@@ -67,8 +69,6 @@ class FrontendLogger : public Logger {
 
   void SetTestMode(bool test_mode) { this->test_mode_ = test_mode; }
 
-  void ReplayLog(const char *, size_t len);
-
   cid_t GetMaxFlushedCommitId();
 
   void SetMaxFlushedCommitId(cid_t cid);
@@ -111,6 +111,10 @@ class FrontendLogger : public Logger {
 
   void SetNoWrite(bool no_write) { no_write_ = no_write; }
 
+  void SetDirectIO(bool direct_io) { direct_io_ = direct_io; }
+
+  void SetIoUring(bool io_uring) { io_uring_ = io_uring; }
+
  protected:
   // Associated backend loggers
   std::vector<BackendLogger *> backend_loggers;
@@ -137,6 +141,12 @@ class FrontendLogger : public Logger {
 
   bool no_write_ = false;
 
+  // write the log with O_DIRECT into preallocated segments (wal only)
+  bool direct_io_ = false;
+
+  // submit the direct i/o writes and syncs through io_uring (wal only)
+  bool io_uring_ = false;
+
   bool test_mode_ = false;
 
   bool is_distinguished_logger = false;
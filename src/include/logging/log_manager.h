@@ -13,8 +13,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <map>
+#include <string>
 #include <vector>
 
 #include "logging/logger.h"
@@ -22,6 +25,8 @@
 #include "frontend_logger.h"
 #include "concurrency/transaction.h"
 #include "loggers/wal_frontend_logger.h"
+#include "log_replayer.h"
+#include "log_shipper.h"
 
 #define DEFAULT_NUM_FRONTEND_LOGGERS 1
 
@@ -31,6 +36,11 @@
 extern LoggingType peloton_logging_mode;
 
 namespace peloton {
+
+namespace storage {
+class Tuple;
+}
+
 namespace logging {
 
 //===--------------------------------------------------------------------===//
@@ -43,6 +53,22 @@ namespace logging {
 
 #define LOG_FILE_LEN 1024 * UINT64_C(128)  // 128 MB
 
+// bounds on how far the flushed log may lag behind asynchronous commits
+#define DEFAULT_MAX_COMMIT_LAG_MICROS 10000  // 10 ms
+#define DEFAULT_MAX_COMMIT_LAG_BYTES 1024 * UINT64_C(1024)  // 1 MB
+
+// A version written by a committing transaction. The old version is invalid
+// for an insert and the new version is invalid for a delete.
+struct LogWrite {
+  LogWrite(LogRecordType type, const ItemPointer &old_version,
+           const ItemPointer &new_version)
+      : type(type), old_version(old_version), new_version(new_version) {}
+
+  LogRecordType type;
+  ItemPointer old_version;
+  ItemPointer new_version;
+};
+
 /**
  * Global Log Manager
  */
@@ -72,11 +98,14 @@ class LogManager {
     for (auto &frontend_logger : frontend_loggers) {
       frontend_logger->Reset();
     }
+    persistent_flushed_commit_id_ = INVALID_CID;
   }
 
   // reset log status to invalid
   void ResetLogStatus() {
     this->recovery_to_logging_counter = 0;
+    recovery_failed_ = false;
+    log_failed_ = false;
     SetLoggingStatus(LOGGING_STATUS_TYPE_INVALID);
   }
 
@@ -105,15 +134,36 @@ class LogManager {
   // method for frontend to inform waiting backends of a flush to disk
   void FrontendLoggerFlushed();
 
-  // wait for the flush of a frontend logger (for worker thread)
-  void WaitForFlush(cid_t cid);
+  // wait for the flush of a frontend logger (for worker thread). returns
+  // false if the log failed before the commit was flushed.
+  bool WaitForFlush(cid_t cid);
+
+  // whether a committer is waiting in WaitForFlush. if not, the frontend
+  // loggers may defer their flush up to the maximum commit lag.
+  inline bool HasFlushWaiters() const { return flush_waiter_count_ > 0; }
 
   // get the current persistent flushed commit
   cid_t GetPersistentFlushedCommitId();
 
+  // publish the persistent flushed commit for the committers, and return it
+  cid_t UpdatePersistentFlushedCommitId();
+
   // called by frontends when recovery is complete.(for a particular frontend)
   void NotifyRecoveryDone();
 
+  // called by a frontend whose log or checkpoint can not be replayed. the
+  // frontends then terminate instead of entering logging mode.
+  void SetRecoveryFailed() { recovery_failed_ = true; }
+
+  bool IsRecoveryFailed() const { return recovery_failed_; }
+
+  // called by a frontend logger that could not write or sync its log. the
+  // flushed commit id no longer rises, and the committers waiting for it
+  // fail.
+  void SetLogFailed();
+
+  bool IsLogFailed() const { return log_failed_; }
+
   //===--------------------------------------------------------------------===//
   // Accessors
   //===--------------------------------------------------------------------===//
@@ -129,6 +179,19 @@ class LogManager {
   // get the status of sychronus commit
   bool GetSyncCommit(void) const { return syncronization_commit; }
 
+  // the log is flushed at least this often while it holds asynchronous
+  // commits
+  void SetMaxCommitLagMicros(size_t max_lag) {
+    max_commit_lag_micros_ = max_lag;
+  }
+
+  size_t GetMaxCommitLagMicros(void) const { return max_commit_lag_micros_; }
+
+  // the log is flushed once this much of it is unflushed
+  void SetMaxCommitLagBytes(size_t max_lag) { max_commit_lag_bytes_ = max_lag; }
+
+  size_t GetMaxCommitLagBytes(void) const { return max_commit_lag_bytes_; }
+
   // returns true if a frontend logger is active
   bool ContainsFrontendLogger(void);
 
@@ -146,6 +209,14 @@ class LogManager {
 
   std::string GetLogDirectoryName(void);
 
+  // directories of the log streams, one per log device. the streams are
+  // spread over them, and all of them use the log directory if none is set.
+  void SetLogStreamDirectoryNames(const std::vector<std::string> &log_dirs) {
+    log_stream_directory_names_ = log_dirs;
+  }
+
+  std::string GetLogStreamDirectoryName(unsigned int stream_id);
+
   bool HasPelotonFrontendLogger() const {
     return (peloton_logging_mode == LOGGING_TYPE_NVM_WBL);
   }
@@ -169,8 +240,9 @@ class LogManager {
   // remove all frontend loggers (used for testing)
   void DropFrontendLoggers();
 
-  // perpare to log must be called before a commit id is generated for a
-  // transaction
+  // hold the commit id the frontend logger reports durable at the ones it
+  // has seen, until the backend logger logs its next commit. a committing
+  // transaction calls it before its writes become visible.
   void PrepareLogging();
 
   // log the beginning of a commited transaction
@@ -189,7 +261,26 @@ class LogManager {
   // commit a transaction and wait until stable
   void LogCommitTransaction(cid_t commit_id);
 
-  // used by the checkpointer to truncate unneeded log files
+  // log the begin, the writes and the commit of a transaction as one batch
+  // and, unless the transaction commits asynchronously, wait until stable.
+  // the writes are already installed and visible to other transactions, the
+  // committing transaction calls PrepareLogging before it installs them.
+  // returns false if the transaction could not be logged, its writes are
+  // then not durable.
+  bool LogTransaction(cid_t commit_id, const std::vector<LogWrite> &writes,
+                      bool sync_commit = true);
+
+  // wbl: called by a committing transaction before it installs its commit
+  // id. waits until a durable group commit has the tile groups it writes in
+  // its dirty map.
+  void RegisterDirtyTileGroups(concurrency::Transaction *txn);
+
+  // release the tile groups registered by the thread, once the transaction
+  // is logged with the commit id or aborted (invalid commit id)
+  void ReleaseDirtyTileGroups(cid_t commit_id);
+
+  // used by the checkpointer to recycle the log segments its checkpoint
+  // covers, the frontend loggers do it on their next flush while logging
   void TruncateLogs(txn_id_t commit_id);
 
   // called if a transaction aborts before starting a commit
@@ -241,10 +332,58 @@ class LogManager {
 
   inline bool GetNoWrite() const { return no_write_; }
 
+  // write ahead log segments are preallocated, written with O_DIRECT and
+  // recycled after truncation
+  inline void SetDirectIO(bool direct_io) { direct_io_ = direct_io; }
+
+  inline bool GetDirectIO() const { return direct_io_; }
+
+  // log segments written with direct i/o, and checkpoint files, are written
+  // through io_uring when it is available
+  inline void SetIoUring(bool io_uring) { io_uring_ = io_uring; }
+
+  inline bool GetIoUring() const { return io_uring_; }
+
+  //===--------------------------------------------------------------------===//
+  // Replication
+  //===--------------------------------------------------------------------===//
+
+  // ship the write ahead log to the standby at the address. the rpc server
+  // of the primary needs the logging service registered to take the answers
+  // of the standby.
+  bool StartReplication(const std::string &standby_address,
+                        ReplicationType replication_type);
+
+  void StopReplication();
+
+  bool IsReplicating() const { return replicating_; }
+
+  // ship a batch of the log stream written by a frontend logger
+  void ShipLog(int logger_id, const std::string &log);
+
+  // the standby has replayed the log stream up to the sequence number
+  void AcknowledgeShippedLog(int logger_id, int64_t sequence_number);
+
+  // replay the log shipped by a primary, which makes this a standby
+  LogReplayer &GetLogReplayer();
+
+  // the standby takes over as a primary
+  void PromoteStandby();
+
  private:
   LogManager();
   ~LogManager();
 
+  // build the record of a write. the tuple holds the data of the record, if
+  // any, and must outlive it.
+  LogRecord *BuildTupleRecord(BackendLogger *logger, cid_t commit_id,
+                              const LogWrite &write,
+                              std::unique_ptr<storage::Tuple> &tuple);
+
+  // wait for the flush of a commit by a committer already counted as a
+  // flush waiter. returns false if the log failed.
+  bool AwaitFlush(cid_t cid);
+
   //===--------------------------------------------------------------------===//
   // Data members
   //===--------------------------------------------------------------------===//
@@ -295,11 +434,24 @@ class LogManager {
   bool syncronization_commit =
       true;  // default should be true because it is safest
 
+  size_t max_commit_lag_micros_ = DEFAULT_MAX_COMMIT_LAG_MICROS;
+
+  size_t max_commit_lag_bytes_ = DEFAULT_MAX_COMMIT_LAG_BYTES;
+
+  // number of committers in WaitForFlush
+  std::atomic<int> flush_waiter_count_{0};
+
+  // persistent flushed commit of all the frontend loggers, published as they
+  // flush
+  std::atomic<cid_t> persistent_flushed_commit_id_{INVALID_CID};
+
   // name of log file (for wbl)
   std::string log_file_name;
 
   std::string log_directory_name;
 
+  std::vector<std::string> log_stream_directory_names_;
+
   // round robin counter for frontend logger assignment
   int frontend_logger_assign_counter;
 
@@ -311,10 +463,27 @@ class LogManager {
   // and cid
   int update_managers_count = 0;
 
-  bool replicating_ = false;
+  std::atomic<bool> replicating_{false};
+
+  // whether a frontend failed to replay its log
+  std::atomic<bool> recovery_failed_{false};
+
+  // whether a frontend failed to write its log
+  std::atomic<bool> log_failed_{false};
+
+  // ships the log while replicating, and replays it on a standby
+  std::mutex replication_mutex_;
+
+  std::shared_ptr<LogShipper> log_shipper_;
+
+  std::unique_ptr<LogReplayer> log_replayer_;
 
   bool no_write_ = false;
 
+  bool direct_io_ = false;
+
+  bool io_uring_ = false;
+
   // max oid after recovery
   oid_t max_oid = 0;
 
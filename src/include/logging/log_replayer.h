@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_replayer.h
+//
+// Identification: src/include/logging/log_replayer.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "common/types.h"
+
+namespace peloton {
+namespace logging {
+
+class WriteAheadFrontendLogger;
+
+// a batch further ahead of the last replayed one is not kept, the primary
+// sends it again
+#define LOG_REPLAY_MAX_PENDING_BATCHES 64
+
+//===--------------------------------------------------------------------===//
+// Log Replayer
+//===--------------------------------------------------------------------===//
+
+// Replays the log shipped by a primary on a standby. The batches of each log
+// stream are replayed in the order of their sequence numbers, a batch that
+// arrives early is kept until the ones before it are replayed.
+//
+// The standby serves read-only transactions at the commit id up to which
+// every log stream has been replayed, and takes over as a primary once it is
+// promoted.
+class LogReplayer {
+ public:
+  LogReplayer();
+
+  ~LogReplayer();
+
+  // replay the batch of the log stream, and return the last sequence number
+  // of the stream replayed in order. the log streams of the primary that
+  // have not shipped a batch yet hold back the replayed commit id.
+  int64_t Replay(int logger_id, int64_t sequence_number,
+                 const std::string &log, int logger_count);
+
+  // every transaction up to the commit id has been replayed
+  cid_t GetReplayedCommitId();
+
+  // abort the transactions that did not commit, and let the standby take
+  // over as a primary
+  void Promote();
+
+ private:
+  struct LogStream {
+    std::unique_ptr<WriteAheadFrontendLogger> frontend_logger;
+
+    int64_t replayed_sequence_number = 0;
+
+    cid_t replayed_commit_id = INVALID_CID;
+
+    // batches that arrived before the ones they follow
+    std::map<int64_t, std::string> pending_batches;
+  };
+
+  // the commit id replayed by all the log streams
+  cid_t ComputeReplayedCommitId();
+
+  std::mutex replay_mutex_;
+
+  std::map<int, LogStream> log_streams_;
+
+  cid_t replayed_commit_id_ = INVALID_CID;
+
+  bool promoted_ = false;
+};
+
+}  // namespace logging
+}  // namespace peloton
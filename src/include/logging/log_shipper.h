@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_shipper.h
+//
+// Identification: src/include/logging/log_shipper.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "common/types.h"
+
+namespace peloton {
+
+namespace networking {
+class RpcChannel;
+class RpcController;
+class PelotonLoggingService_Stub;
+}
+
+namespace logging {
+
+// a semi-synchronous standby is waited for at most this long per batch, and
+// a batch the standby has not answered for as long is sent again
+#define LOG_SHIPPING_TIMEOUT_MICROS 1000000
+
+// a synchronous standby is given up on after this long, the log is shipped
+// to it asynchronously from then on
+#define LOG_SHIPPING_SYNC_TIMEOUT_MICROS 10000000
+
+// shipping stops once the standby has not answered this many batches of a
+// stream
+#define LOG_SHIPPING_MAX_UNACKNOWLEDGED_BATCHES 64
+
+// the rpc layer stages a message on the stack, so a flush of a log stream is
+// shipped in batches of about this size
+#define LOG_SHIPPING_BATCH_SIZE (1 << 20)
+
+//===--------------------------------------------------------------------===//
+// Log Shipper
+//===--------------------------------------------------------------------===//
+
+// Ships the log of a primary to a standby over the rpc layer, one batch per
+// flush of each log stream. The batches of a stream are numbered, and the
+// standby answers with the last one it replayed in order.
+//
+// The answers come back through the logging service registered with the rpc
+// server of the primary. An asynchronous standby is not waited for, a
+// synchronous one has replayed a batch before its commits are acknowledged,
+// and a semi-synchronous one is waited for up to the shipping timeout. A
+// synchronous standby that does not answer within the sync timeout is
+// shipped to asynchronously from then on.
+//
+// The batches are kept until the standby answers them, and the ones it has
+// not answered within the shipping timeout are sent again.
+class LogShipper {
+ public:
+  // the standby holds back its snapshot until every log stream has shipped
+  LogShipper(const std::string &standby_address,
+             ReplicationType replication_type, int logger_count);
+
+  virtual ~LogShipper();
+
+  // ship a batch of the log stream, and wait for the standby as the
+  // replication type asks
+  void Ship(int logger_id, const std::string &log);
+
+  // the standby has replayed the batches of the stream up to the sequence
+  // number
+  void Acknowledge(int logger_id, int64_t sequence_number);
+
+  int64_t GetShippedSequenceNumber(int logger_id);
+
+  int64_t GetAcknowledgedSequenceNumber(int logger_id);
+
+  // stop shipping, and wake up the frontend loggers waiting for the standby
+  void Stop();
+
+  // shipping stops once a batch could not be sent, as the standby misses it
+  // for good
+  bool IsStopped() const { return stopped_; }
+
+  ReplicationType GetReplicationType() const { return replication_type_; }
+
+ protected:
+  // send a batch over the rpc layer. returns false if it could not be sent.
+  virtual bool SendBatch(int logger_id, int64_t sequence_number,
+                         const std::string &log);
+
+  int64_t resend_timeout_micros_ = LOG_SHIPPING_TIMEOUT_MICROS;
+
+  int64_t sync_timeout_micros_ = LOG_SHIPPING_SYNC_TIMEOUT_MICROS;
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct ShippedBatch {
+    std::string log;
+
+    Clock::time_point sent_time;
+  };
+
+  // drop the batches of the stream the standby answered, and send the ones
+  // it has not answered within the shipping timeout again. called with the
+  // ship mutex held.
+  void ResendBatches(int logger_id);
+
+  std::atomic<ReplicationType> replication_type_;
+
+  int logger_count_;
+
+  std::unique_ptr<networking::RpcChannel> channel_;
+
+  std::unique_ptr<networking::RpcController> controller_;
+
+  std::unique_ptr<networking::PelotonLoggingService_Stub> stub_;
+
+  // the rpc layer is not thread safe, the log streams ship one at a time
+  std::mutex ship_mutex_;
+
+  std::map<int, int64_t> shipped_sequence_numbers_;
+
+  std::map<int, std::map<int64_t, ShippedBatch>> unacknowledged_batches_;
+
+  std::mutex ack_mutex_;
+
+  std::condition_variable ack_cv_;
+
+  std::map<int, int64_t> acknowledged_sequence_numbers_;
+
+  std::atomic<bool> stopped_{false};
+};
+
+}  // namespace logging
+}  // namespace peloton
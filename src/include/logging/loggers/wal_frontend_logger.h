@@ -16,12 +16,17 @@
 #include "logging/frontend_logger.h"
 #include "logging/records/tuple_record.h"
 #include "logging/log_file.h"
+#include "logging/async_file_writer.h"
 #include "executor/executors.h"
 
 #include <dirent.h>
+#include <atomic>
 #include <vector>
 #include <set>
+#include <deque>
+#include <memory>
 #include <chrono>
+#include <string>
 
 extern int peloton_flush_frequency_micros;
 
@@ -40,6 +45,20 @@ typedef std::chrono::high_resolution_clock Clock;
 typedef std::chrono::microseconds Micros;
 
 typedef std::chrono::time_point<Clock> TimePoint;
+
+// block size that direct i/o writes are aligned to
+#define WAL_DIRECT_IO_ALIGNMENT 4096
+
+// truncated segments kept around for reuse in direct i/o mode
+#define WAL_MAX_FREE_SEGMENTS 4
+
+// follows the header of a segment written with direct i/o, whose records are
+// kept in checksummed frames
+#define WAL_SEGMENT_MAGIC 0x50454c4f544f4e57ULL
+
+// names the first segment recovery needs, it must not take the log file prefix
+#define WAL_MANIFEST_FILE_NAME "wal_manifest"
+
 //===--------------------------------------------------------------------===//
 // Write Ahead Frontend Logger
 //===--------------------------------------------------------------------===//
@@ -48,7 +67,8 @@ class WriteAheadFrontendLogger : public FrontendLogger {
  public:
   WriteAheadFrontendLogger(void);
 
-  WriteAheadFrontendLogger(bool for_testing);
+  // each logger id writes a log stream of its own directory
+  WriteAheadFrontendLogger(bool for_testing, int logger_id = 0);
 
   WriteAheadFrontendLogger(std::string log_dir);
 
@@ -60,19 +80,44 @@ class WriteAheadFrontendLogger : public FrontendLogger {
   // Recovery
   //===--------------------------------------------------------------------===//
 
+  // the first frontend logger of the log manager replays the streams of all
+  // of them, a logger of its own only replays its stream
   void DoRecovery(void);
 
+  // replay the committed transactions of the log streams in commit id order,
+  // from the calling thread
+  static void RecoverStreams(
+      const std::vector<WriteAheadFrontendLogger *> &streams);
+
   void RecoverIndex();
 
   void StartTransactionRecovery(cid_t commit_id);
 
-  void CommitTransactionRecovery(cid_t commit_id);
+  bool CommitTransactionRecovery(cid_t commit_id);
+
+  //===--------------------------------------------------------------------===//
+  // Replication
+  //===--------------------------------------------------------------------===//
+
+  // replay a batch of the log shipped by a primary, and return the commit id
+  // up to which every transaction has been replayed
+  cid_t ReplayLog(const char *data, size_t len);
+
+  // keep the indexes up to date with the replayed transactions, instead of
+  // rebuilding them once recovery is done
+  void SetReplayIndexes(bool replay_indexes) {
+    replay_indexes_ = replay_indexes;
+  }
+
+  oid_t GetMaxOid() const { return max_oid; }
+
+  cid_t GetMaxCid() const { return max_cid; }
 
   void InsertTuple(TupleRecord *recovery_txn);
 
   void DeleteTuple(TupleRecord *recovery_txn);
 
-  void UpdateTuple(TupleRecord *recovery_txn);
+  bool UpdateTuple(TupleRecord *recovery_txn);
 
   void AbortActiveTransactions();
 
@@ -86,8 +131,30 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   LogRecordType GetNextLogRecordTypeForRecovery();
 
+  // whether records of the type are read by recovery and replay
+  static bool IsReplayedLogRecordType(LogRecordType record_type);
+
+  // read the record of the type off the file, and replay the transactions it
+  // commits within the commit id range. if a set is given, the commit ids are
+  // collected into it instead and the transactions are left to the caller.
+  // returns false if the record is torn.
+  bool ReplayLogRecord(LogRecordType record_type, FileHandle &file_handle,
+                       cid_t start_commit_id, cid_t max_commit_id,
+                       std::set<cid_t> *committed = nullptr);
+
+  // recycle the segments a checkpoint up to the commit id covers. must be
+  // called on the thread that writes the log.
   void TruncateLog(cid_t);
 
+  // truncate the log the next time the frontend logger thread flushes it
+  void RequestTruncation(cid_t truncate_log_id);
+
+  // recovery starts at the segment of the manifest, the checkpoint up to the
+  // commit id of the manifest covers the ones before it
+  int GetManifestStartSegment() const { return manifest_start_segment_; }
+
+  cid_t GetManifestCommitId() const { return manifest_commit_id_; }
+
   void InitLogDirectory();
 
   std::string GetFileNameFromVersion(int);
@@ -104,6 +171,14 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   void InitSelf();
 
+  // append to the current log file. in direct i/o mode the data is staged
+  // in an aligned buffer until the next sync.
+  void WriteLogFile(const char *data, size_t size);
+
+  // make everything written so far durable. returns false if the write or
+  // the sync failed.
+  bool SyncLogFile();
+
   static constexpr auto wal_directory_path = "wal_log";
 
  private:
@@ -115,6 +190,65 @@ class WriteAheadFrontendLogger : public FrontendLogger {
   void InsertIndexEntry(storage::Tuple *tuple, storage::DataTable *table,
                         ItemPointer target_location);
 
+  // the recovered version at the location
+  std::unique_ptr<storage::Tuple> GetRecoveredTuple(
+      storage::DataTable *table, const ItemPointer &location);
+
+  // index the version a transaction inserted, or move the index entry of the
+  // old version it updated to the new one
+  void ReplayIndexUpdate(cid_t commit_id, oid_t db_id, oid_t table_id,
+                         const ItemPointer &old_location,
+                         const ItemPointer &new_location);
+
+  // open the first segment that holds commits past the checkpoint. returns
+  // false if the checkpoint does not reach the truncated log.
+  bool OpenLogForRecovery(cid_t start_commit_id);
+
+  // read the stream up to its next delimiter, keeping the transactions it
+  // commits in the recovered commits. returns false at the end of the stream
+  // or at a torn record.
+  bool ReadRecoveryEpoch(cid_t start_commit_id, cid_t max_commit_id);
+
+  //===--------------------------------------------------------------------===//
+  // Log file writes
+  //===--------------------------------------------------------------------===//
+
+  // whether the log written so far has to be made durable now
+  bool IsFlushDue();
+
+  // collect the flushes submitted through io_uring, or wait for all of them.
+  // returns true if a flush completed.
+  bool ReapLogFlushes(bool wait_all);
+
+  // grow the aligned staging buffer to hold at least the given size
+  void ReserveDirectBuffer(size_t size);
+
+  // open a preallocated segment for direct i/o, reusing a free one if any
+  bool OpenSegment(const std::string &file_name, int segment);
+
+  // copy the records of the valid frames of a direct i/o segment, read past
+  // its header, into a temporary file. returns nullptr for other log files.
+  FILE *ReadSegmentFrames(FILE *file, int segment);
+
+  // write the max log id and max delimiter into the header of a segment
+  void WriteSegmentHeader(const std::string &file_name);
+
+  std::string GetFreeFileNameFromVersion(int version);
+
+  //===--------------------------------------------------------------------===//
+  // Log manifest
+  //===--------------------------------------------------------------------===//
+
+  std::string GetManifestFileName();
+
+  bool PersistManifest(int start_segment, cid_t commit_id);
+
+  bool ReadManifest();
+
+  // remove the segments before the one of the manifest, once a checkpoint
+  // is known to cover them
+  void RemoveTruncatedSegments();
+
   //===--------------------------------------------------------------------===//
   // Member Variables
   //===--------------------------------------------------------------------===//
@@ -125,6 +259,10 @@ class WriteAheadFrontendLogger : public FrontendLogger {
   // Txn table during recovery
   std::map<txn_id_t, std::vector<TupleRecord *>> recovery_txn_table;
 
+  // transactions of the table that have been read up to their commit, but
+  // not replayed yet
+  std::set<cid_t> recovered_commits_;
+
   // Keep tracking max oid for setting next_oid in manager
   // For active processing after recovery
   oid_t max_oid = 0;
@@ -139,7 +277,7 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   int log_file_counter_;
 
-  int log_file_cursor_;
+  int log_file_cursor_ = 0;
 
   // for recovery from in memory buffer instead of file.
   char *input_log_buffer;
@@ -154,7 +292,7 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   CopySerializeOutput output_buffer;
 
-  int logger_id;
+  int logger_id = 0;
 
   cid_t max_delimiter_file = 0;
 
@@ -162,7 +300,64 @@ class WriteAheadFrontendLogger : public FrontendLogger {
 
   TimePoint last_flush = Clock::now();
 
+  // aligned staging buffer of the direct i/o mode, and the file offset its
+  // first byte is written at
+  char *direct_buffer_ = nullptr;
+
+  size_t direct_buffer_capacity_ = 0;
+
+  size_t direct_buffer_size_ = 0;
+
+  size_t direct_file_offset_ = 0;
+
+  // number of the segment being written, stamped on each of its frames
+  int direct_segment_ = 0;
+
+  // bytes written since the last sync
+  size_t unsynced_bytes_ = 0;
+
+  // commit ids of the last delimiters written to the file and shipped. a
+  // flush that is deferred writes and ships none again.
+  cid_t max_written_delimiter_ = INVALID_CID;
+
+  cid_t max_shipped_delimiter_ = INVALID_CID;
+
+  // submits the writes and syncs of direct i/o segments through io_uring
+  std::unique_ptr<AsyncFileWriter> async_writer_;
+
+  // staging buffers handed to the writer, and the ticket that completes them
+  std::deque<std::pair<uint64_t, char *>> submitted_buffers_;
+
+  // flushes in flight, and the commit id each of them makes durable
+  std::deque<std::pair<uint64_t, cid_t>> pending_flushes_;
+
+  // truncated segments waiting to be reused
+  std::vector<std::string> free_segments_;
+
+  std::string LOG_FREE_FILE_PREFIX = "peloton_free_log_";
+
+  // checkpoint commit id the frontend logger thread truncates the log to
+  std::atomic<cid_t> truncate_commit_id_{INVALID_CID};
+
+  // first segment recovery needs, and the checkpoint commit id that covers
+  // the segments before it
+  int manifest_start_segment_ = 0;
+
+  cid_t manifest_commit_id_ = INVALID_CID;
+
+  // segments before the one of the manifest found on startup
+  std::vector<std::string> truncated_segments_;
+
   Micros flush_frequency{peloton_flush_frequency_micros};
+
+  // records written since the last batch was shipped to the standby
+  std::string shipped_log_;
+
+  // largest delimiter replayed, every commit up to it has been replayed
+  cid_t max_replayed_delimiter_ = INVALID_CID;
+
+  // whether the replayed transactions update the indexes
+  bool replay_indexes_ = false;
 };
 
 }  // namespace logging
@@ -13,15 +13,18 @@
 
 #pragma once
 
-#include <unordered_set>
+#include <vector>
 
 #include "common/types.h"
 #include "logging/backend_logger.h"
+#include "logging/records/log_record_pool.h"
 #include "concurrency/transaction_manager_factory.h"
 
 namespace peloton {
 namespace logging {
 
+struct LogWrite;
+
 //===--------------------------------------------------------------------===//
 // WBL Backend Logger
 //===--------------------------------------------------------------------===//
@@ -40,6 +43,12 @@ class WriteBehindBackendLogger : public BackendLogger {
 
   void Log(LogRecord *record);
 
+  bool Log(const std::vector<std::unique_ptr<LogRecord>> &records);
+
+  // log the writes of a committing transaction, staging their records in
+  // the record pool instead of building one on the heap per write
+  void LogTransaction(cid_t commit_id, const std::vector<LogWrite> &writes);
+
   LogRecord *GetTupleRecord(LogRecordType log_record_type, txn_id_t txn_id,
                             oid_t table_oid, oid_t db_oid,
                             ItemPointer insert_location,
@@ -52,7 +61,14 @@ class WriteBehindBackendLogger : public BackendLogger {
  private:
   void SyncDataForCommit();
 
-  std::unordered_set<oid_t> tile_groups_to_sync_;
+  static LogRecordType GetWriteBehindRecordType(LogRecordType log_record_type);
+
+  // the tuple records of the transaction, until its commit syncs their tile
+  // groups
+  LogRecordPool record_pool_;
+
+  // kept across commits, so that it does not allocate once it has grown
+  std::vector<oid_t> tile_groups_to_sync_;
 };
 
 }  // namespace logging
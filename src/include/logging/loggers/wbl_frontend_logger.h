@@ -13,7 +13,12 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <mutex>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "logging/frontend_logger.h"
 #include "logging/records/transaction_record.h"
@@ -28,10 +33,20 @@ class TileGroupHeader;
 
 namespace logging {
 
+// a dirty map larger than this (and twice the tile groups it needs) is
+// rewritten without the tile groups that are no longer dirty
+#define WBL_DIRTY_MAP_SLACK 64
+
 //===--------------------------------------------------------------------===//
 // Write Behind Frontend Logger
 //===--------------------------------------------------------------------===//
 
+// Every group commit names a version of the dirty map, the tile groups that
+// may hold commit ids of its dirty range. A transaction registers the tile
+// groups it writes before it installs its commit id, and waits until a
+// durable group commit covers them. Recovery then only undoes the dirty
+// range in those tile groups.
+
 class WriteBehindFrontendLogger : public FrontendLogger {
  public:
   WriteBehindFrontendLogger(void);
@@ -52,13 +67,60 @@ class WriteBehindFrontendLogger : public FrontendLogger {
 
   std::string GetLogFileName();
 
+  // wait until the dirty map of a durable group commit has the tile groups
+  void RegisterDirtyTileGroups(const std::vector<oid_t> &tile_group_ids);
+
+  // the tile groups were committed into with the commit id (or not at all
+  // if it is invalid), they stay in the dirty map until it is persistent
+  void ReleaseDirtyTileGroups(const std::vector<oid_t> &tile_group_ids,
+                              cid_t commit_id);
+
+  // a transaction committed without registering its tile groups. the group
+  // commits name no dirty map until the commit id is persistent.
+  void ReportUnregisteredCommit(cid_t commit_id);
+
+  // version of the dirty map named by the last group commit
+  cid_t GetDirtyMapVersion() const { return dirty_map_version_; }
+
   static constexpr auto wbl_log_path = "wbl.log";
 
  private:
+  // the dirty map versions alternate between two files, so the version a
+  // durable group commit names is never overwritten
+  std::string GetDirtyMapFileName(cid_t version);
+
+  // write a new version of the dirty map if a tile group is missing from it,
+  // and return the version the group commit names
+  cid_t PersistDirtyMap(cid_t persistent_commit_id);
+
+  bool ReadDirtyMap(cid_t version, std::vector<oid_t> &tile_group_ids);
+
+  // undo the commits of the dirty range in the tile groups. returns false if
+  // a tile group is not there.
+  bool UndoDirtyTileGroups(const std::vector<oid_t> &tile_group_ids,
+                           cid_t persistent_commit_id,
+                           cid_t max_possible_dirty_commit_id);
+
+  // point the index entry back at the newest version that is not undone,
+  // and hand the undone versions to the garbage collector like an abort
+  // does. returns false if a version is not there.
+  bool UndoVersionChain(ItemPointer *index_entry_ptr,
+                        const std::set<ItemPointer> &empty_versions,
+                        cid_t persistent_commit_id,
+                        cid_t max_possible_dirty_commit_id);
+
   //===--------------------------------------------------------------------===//
   // Member Variables
   //===--------------------------------------------------------------------===//
 
+  struct DirtyTileGroup {
+    // transactions that registered the tile group and did not commit yet
+    size_t pending_count = 0;
+
+    // highest commit id installed in the tile group
+    cid_t max_commit_id = INVALID_CID;
+  };
+
   CopySerializeOutput output_buffer;
 
   // File pointer and descriptor
@@ -73,6 +135,27 @@ class WriteBehindFrontendLogger : public FrontendLogger {
 
   // Keep tracking latest cid for setting next commit in txn manager
   cid_t max_commit_id_seen = INVALID_CID;
+
+  // protects the dirty map
+  std::mutex dirty_map_mutex_;
+  std::condition_variable dirty_map_cv_;
+
+  // the tile groups that may be committed into or hold a commit id that is
+  // not persistent yet
+  std::unordered_map<oid_t, DirtyTileGroup> dirty_tile_groups_;
+
+  // the dirty map named by the last durable group commit
+  std::unordered_set<oid_t> persisted_tile_groups_;
+
+  // the dirty map written for the group commit in progress, if any
+  std::unordered_set<oid_t> next_tile_groups_;
+
+  bool next_dirty_map_ = false;
+
+  cid_t dirty_map_version_ = 0;
+
+  // highest commit id of a transaction that did not register its tile groups
+  cid_t unregistered_commit_id_ = INVALID_CID;
 };
 
 }  // namespace logging
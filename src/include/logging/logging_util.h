@@ -28,7 +28,8 @@ namespace logging {
 
 class LoggingUtil {
  public:
-  static void FFlushFsync(FileHandle &file_handle);
+  // returns false if the file could not be flushed or synced
+  static bool FFlushFsync(FileHandle &file_handle);
 
   static bool InitFileHandle(const char *name, FileHandle &file_handle,
                              const char *mode);
@@ -49,7 +50,8 @@ class LoggingUtil {
   static bool ReadTupleRecordHeader(TupleRecord &tuple_record,
                                     FileHandle &file_handle);
 
-  static storage::Tuple *ReadTupleRecordBody(catalog::Schema *schema,
+  static storage::Tuple *ReadTupleRecordBody(TupleRecord &tuple_record,
+                                             catalog::Schema *schema,
                                              VarlenPool *pool,
                                              FileHandle &file_handle);
 
@@ -59,6 +61,10 @@ class LoggingUtil {
 
   static bool CreateDirectory(const char *dir_name, int mode);
 
+  // returns false if the entries of the directory could not be synced, so a
+  // file renamed into it may still be missing after a crash
+  static bool FsyncDirectory(const char *dir_name);
+
   static bool RemoveDirectory(const char *dir_name, bool only_remove_file);
 
   // Wrappers
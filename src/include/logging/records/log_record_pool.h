@@ -13,42 +13,66 @@
 
 #pragma once
 
-#include <map>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "logging/records/tuple_record.h"
 
 namespace peloton {
 namespace logging {
+
+// number of tuple records in a chunk of the pool
+#define LOG_RECORD_POOL_CHUNK_SIZE 256
+
 //===--------------------------------------------------------------------===//
 // Log record pool
 //===--------------------------------------------------------------------===//
 
+// An arena of the tuple records a backend logger stages for its transaction.
+// The records are built in place in chunks that are kept when the pool is
+// cleared, so once the pool has grown to the largest transaction staging a
+// record allocates nothing. A pool belongs to the thread of its backend
+// logger and takes no lock.
 class LogRecordPool {
-  friend class WriteBehindFrontendLogger;
-
  public:
+  LogRecordPool() {}
+
+  LogRecordPool(const LogRecordPool &) = delete;
+  LogRecordPool &operator=(const LogRecordPool &) = delete;
+
+  ~LogRecordPool();
+
   //===--------------------------------------------------------------------===//
   // Accessor
   //===--------------------------------------------------------------------===//
-  void Clear();
 
-  bool IsEmpty() const { return txn_log_table.empty(); }
+  // build a record in the pool, which owns it until the pool is cleared
+  TupleRecord *CreateTupleRecord(LogRecordType log_record_type, cid_t cid,
+                                 oid_t table_oid, ItemPointer insert_location,
+                                 ItemPointer delete_location,
+                                 oid_t db_oid);
 
-  int CreateTxnLogList(txn_id_t txn_id);
+  // destroy the records, and keep the chunks for the next transaction
+  void Clear();
 
-  int AddLogRecord(std::unique_ptr<TupleRecord> record);
+  bool IsEmpty() const { return record_count_ == 0; }
 
-  void RemoveTxnLogRecordList(txn_id_t txn_id);
+  size_t GetRecordCount() const { return record_count_; }
 
-  bool ExistsTxnLogRecordList(txn_id_t txn_id);
+  TupleRecord *GetRecord(size_t record_idx) const;
 
  private:
+  typedef std::aligned_storage<sizeof(TupleRecord), alignof(TupleRecord)>::type
+      RecordSlot;
+
   //===--------------------------------------------------------------------===//
   // Member Variables
   //===--------------------------------------------------------------------===//
-  // Transient record for fast access to log records
-  std::map<txn_id_t, std::vector<std::unique_ptr<TupleRecord>>> txn_log_table;
+
+  std::vector<std::unique_ptr<RecordSlot[]>> chunks_;
+
+  size_t record_count_ = 0;
 };
 
 }  // namespace logging
@@ -13,6 +13,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "logging/log_record.h"
 #include "storage/tuple.h"
 #include "common/serializer.h"
@@ -21,6 +23,12 @@
 namespace peloton {
 namespace logging {
 
+// Flags of the tuple record header. The locations that are not present are
+// invalid.
+#define TUPLE_RECORD_INSERT_LOCATION 0x1
+#define TUPLE_RECORD_DELETE_LOCATION 0x2
+#define TUPLE_RECORD_PARTIAL_IMAGE 0x4
+
 //===--------------------------------------------------------------------===//
 // TupleRecord
 //===--------------------------------------------------------------------===//
@@ -80,6 +88,21 @@ class TupleRecord : public LogRecord, Printable {
 
   storage::Tuple *GetTuple();
 
+  // An update may carry only the columns it changed. The other columns are
+  // taken from the old version when the record is replayed.
+  void SetColumnIds(const std::vector<oid_t> &column_ids) {
+    this->column_ids = column_ids;
+    partial_image = (column_ids.empty() == false);
+  }
+
+  const std::vector<oid_t> &GetColumnIds() const { return column_ids; }
+
+  bool IsPartialImage() const { return partial_image; }
+
+  // Deserialize the body written after the header
+  storage::Tuple *DeserializeBody(CopySerializeInputBE &input,
+                                  catalog::Schema *schema, VarlenPool *pool);
+
   static size_t GetTupleRecordSize(void);
 
   // Get a string representation for debugging
@@ -107,6 +130,12 @@ class TupleRecord : public LogRecord, Printable {
 
   // database id
   oid_t db_oid = DEFAULT_DB_ID;
+
+  // whether the body only holds the columns that were changed
+  bool partial_image = false;
+
+  // the columns in the body of a partial after-image
+  std::vector<oid_t> column_ids;
 };
 
 }  // namespace logging
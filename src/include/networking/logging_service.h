@@ -0,0 +1,36 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// logging_service.h
+//
+// Identification: src/include/networking/logging_service.h
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#pragma once
+
+#include "peloton/proto/logging_service.pb.h"
+
+//===--------------------------------------------------------------------===//
+// Implements PelotonLoggingService
+//===--------------------------------------------------------------------===//
+
+namespace peloton {
+namespace networking {
+
+// A standby replays the log a primary ships to it, and the primary takes the
+// answers of the standby. Both register the service with their rpc server.
+class LoggingService : public PelotonLoggingService {
+ public:
+  virtual void LogRecordReplay(::google::protobuf::RpcController* controller,
+                               const LogRecordReplayRequest* request,
+                               LogRecordReplayResponse* response,
+                               ::google::protobuf::Closure* done);
+};
+
+}  // namespace networking
+}  // namespace peloton
@@ -19,6 +19,7 @@
 #include <set>
 
 #include "common/platform.h"
+#include "common/value.h"
 #include "storage/abstract_table.h"
 #include "container/lock_free_array.h"
 #include "index/index.h"
@@ -117,6 +118,18 @@ class DataTable : public AbstractTable {
   // designed for tables without primary key. e.g., output table used by aggregate_executor.
   ItemPointer InsertTuple(const Tuple *tuple);
 
+  //===--------------------------------------------------------------------===//
+  // BULK LOAD
+  //===--------------------------------------------------------------------===//
+
+  // Load a batch of tuples given column-at-a-time (one vector of values per
+  // column, all of the same length). Full tile groups are built directly,
+  // every tuple becomes visible at a single commit id, and index keys are
+  // sorted before they are inserted. Foreign keys are not checked.
+  // Returns false if the batch is malformed or violates the primary key; the
+  // tile groups and index entries of a failed load are removed again.
+  bool BulkLoad(const std::vector<std::vector<Value>> &column_batches);
+
   //===--------------------------------------------------------------------===//
   // TILE GROUP
   //===--------------------------------------------------------------------===//
@@ -136,9 +149,24 @@ class DataTable : public AbstractTable {
 
   size_t GetTileGroupCount() const;
 
+  // Remove the tile group from the table and the catalog. Its offset stays
+  // taken, so GetTileGroup returns nullptr for it from now on.
+  void DropTileGroup(const oid_t &tile_group_id);
+
   // Get a tile group with given layout
   TileGroup *GetTileGroupWithLayout(const column_map_type &partitioning);
 
+  //===--------------------------------------------------------------------===//
+  // COMPACTION
+  //===--------------------------------------------------------------------===//
+
+  // Move the live tuples of full tile groups whose occupancy is below the
+  // threshold into the active tile group, and drop the tile groups compacted
+  // in earlier calls once none of their versions is visible anymore.
+  // The offset of a dropped tile group stays reserved, so GetTileGroup()
+  // returns nullptr for it. Returns the number of tile groups dropped.
+  size_t CompactTileGroups(const double &occupancy_threshold);
+
   //===--------------------------------------------------------------------===//
   // INDEX
   //===--------------------------------------------------------------------===//
@@ -206,6 +234,8 @@ class DataTable : public AbstractTable {
 
   void SetDefaultLayout(const column_map_type &layout);
 
+  const column_map_type &GetDefaultLayout() const;
+
   //===--------------------------------------------------------------------===//
   // INDEX TUNER
   //===--------------------------------------------------------------------===//
@@ -262,6 +292,49 @@ class DataTable : public AbstractTable {
   // Drop all tile groups of the table. Used by recovery
   void DropTileGroups();
 
+  // Transform the tile group, once no other thread is transforming it
+  storage::TileGroup *TransformTileGroupById(const oid_t &tile_group_id,
+                                             const double &theta);
+
+  // Fraction of the slots in the tile group holding a live tuple
+  double GetTileGroupOccupancy(const TileGroup *tile_group) const;
+
+  // Move every live tuple of the tile group into the active tile group
+  // within one transaction
+  bool MigrateTileGroup(const std::shared_ptr<TileGroup> &tile_group);
+
+  // Drop a compacted tile group if none of its versions can be seen
+  bool DropCompactedTileGroup(const oid_t &tile_group_id,
+                              const cid_t &max_committed_cid);
+
+  // Copy a range of the column batches into a new tile group
+  std::shared_ptr<TileGroup> BuildTileGroup(
+      const std::vector<std::vector<Value>> &column_batches,
+      const size_t &begin_offset, const size_t &tuple_count);
+
+  // Build the keys of all loaded tuples for the index, and their key order
+  void BuildBulkIndexKeys(const std::shared_ptr<index::Index> &index,
+                          const std::vector<std::vector<Value>> &column_batches,
+                          std::vector<std::unique_ptr<storage::Tuple>> &keys,
+                          std::vector<size_t> &key_order);
+
+  // Insert the keys into the index in key order. inserted_count is set to
+  // the number of entries inserted, also on failure.
+  bool BulkInsertInIndex(
+      const std::shared_ptr<index::Index> &index,
+      const std::vector<std::unique_ptr<storage::Tuple>> &keys,
+      const std::vector<size_t> &key_order,
+      const std::vector<ItemPointer *> &index_entry_ptrs,
+      concurrency::Transaction *transaction, size_t &inserted_count);
+
+  // Remove the first inserted_count entries (in key order) from the index
+  void BulkDeleteFromIndex(
+      const std::shared_ptr<index::Index> &index,
+      const std::vector<std::unique_ptr<storage::Tuple>> &keys,
+      const std::vector<size_t> &key_order,
+      const std::vector<ItemPointer *> &index_entry_ptrs,
+      const size_t &inserted_count);
+
   //===--------------------------------------------------------------------===//
   // INDEX HELPERS
   //===--------------------------------------------------------------------===//
@@ -291,6 +364,17 @@ class DataTable : public AbstractTable {
   // data table mutex
   std::mutex data_table_mutex_;
 
+  // tile groups whose tuples were migrated, waiting to be dropped
+  std::vector<oid_t> compacted_tile_groups_;
+
+  // serializes compaction rounds
+  std::mutex compaction_mutex_;
+
+  // tile groups being transformed, and the mutex that guards them
+  std::set<oid_t> transforming_tile_group_ids_;
+
+  std::mutex transform_mutex_;
+
   // INDEXES
   LockFreeArray<std::shared_ptr<index::Index>> indexes_;
 
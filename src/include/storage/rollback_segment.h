@@ -55,18 +55,21 @@ class RollbackSegmentPool {
  public:
   /**
     * Data layout:
-    * | next_seg_ptr (8 bytes) | timestamp (8 bytes) | column_count (8 bytes)
-    * | id_offset_pairs (column_count * 16 bytes) | segment data
+    * | next_seg_ptr (8 bytes) | timestamp (8 bytes) | begin_timestamp (8 bytes)
+    * | column_count (8 bytes) | id_offset_pairs (column_count * 16 bytes)
+    * | segment data
     *
     * Rollback segment is variable length byte buffer
     * - The first 8 byte field is a pointer to the next rollback segment on the
     *  singly linked rollback segment list
     * - The next 8 byte field is the timestamp of a rollback segment. This is
     *  the *END* timestamp of the rollback segment, meaning that any transaction
-    *  that has a smaller timestamp may be able to read it. The begin timestamp
-    *  of a rollback segment is JUST the end timestamp of next rollback segment
-    *  on the rollback segment chain. Everytime the timestamp of a rollback
-    *  segment is copied from the coressponding tuple
+    *  that has a smaller timestamp may be able to read it. It stays MAX_CID
+    *  until the transaction that created the segment commits.
+    * - The next 8 byte field is the begin timestamp of the rollback segment,
+    *  copied from the tuple when the segment is created. Readers check it
+    *  before following the next pointer, so they never touch an older
+    *  segment whose pool may already have been reclaimed.
     * - The next 8 byte field is the number of columns in the rollback segment
     * - The next column_count * 16 bytes is a serious of pairs, the pairs map
     *  column id of the original tuple to the offset of value in the data area
@@ -75,7 +78,10 @@ class RollbackSegmentPool {
     */
   static const size_t next_ptr_offset_ = 0;
   static const size_t timestamp_offset_ = next_ptr_offset_ + sizeof(void *);
-  static const size_t col_count_offset_ = timestamp_offset_ + sizeof(cid_t);
+  static const size_t begin_timestamp_offset_ =
+      timestamp_offset_ + sizeof(cid_t);
+  static const size_t col_count_offset_ =
+      begin_timestamp_offset_ + sizeof(cid_t);
   static const size_t pairs_start_offset = col_count_offset_ + sizeof(size_t);
 
   RollbackSegmentPool(BackendType backend_type)
@@ -99,12 +105,15 @@ class RollbackSegmentPool {
 
   // The semantics of timestamp on rollback segment:
   //    The timestamp of a rollback segment stands for its "end timestamp".
-  //    The "start timestamp" of a rollback segment should be discovered from
-  //    the next rollback segment
+  //    The "start timestamp" is kept in its own field
   inline static cid_t GetTimeStamp(char *rb_seg) {
     return *(reinterpret_cast<cid_t *>(rb_seg + timestamp_offset_));
   }
 
+  inline static cid_t GetBeginTimeStamp(char *rb_seg) {
+    return *(reinterpret_cast<cid_t *>(rb_seg + begin_timestamp_offset_));
+  }
+
   inline static size_t GetColCount(const char *rb_seg) {
     return *(reinterpret_cast<const size_t *>(rb_seg + col_count_offset_));
   }
@@ -144,6 +153,10 @@ class RollbackSegmentPool {
     *(reinterpret_cast<cid_t *>(rb_seg + timestamp_offset_)) = ts;
   }
 
+  inline static void SetBeginTimeStamp(char *rb_seg, cid_t ts) {
+    *(reinterpret_cast<cid_t *>(rb_seg + begin_timestamp_offset_)) = ts;
+  }
+
   inline void SetPoolTimestamp(const cid_t ts) { timestamp_ = ts; }
 
   // FIXME: should set timestamp_ as the next commit id here
@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 
 #include "common/types.h"
@@ -40,12 +41,20 @@ class StorageManager {
 
   void Sync(BackendType type, void *address, size_t length);
 
+  // Allocate memory on the given NUMA node, or return nullptr if the
+  // backend or the machine cannot place it
+  void *AllocateOnNumaNode(BackendType type, size_t size, int numa_node);
+
+  void ReleaseOnNumaNode(BackendType type, void *address, size_t size);
+
   size_t GetMsyncCount() const { return msync_count; }
 
   size_t GetClflushCount() const { return clflush_count; }
 
   size_t GetAllocationCount() const { return allocation_count; }
 
+  size_t GetReleaseCount() const { return release_count; }
+
  private:
   // data file address
   void *data_file_address;
@@ -65,6 +74,9 @@ class StorageManager {
   size_t clflush_count = 0;
 
   size_t allocation_count = 0;
+
+  // tiles of dropped tile groups are released from other threads
+  std::atomic<size_t> release_count = ATOMIC_VAR_INIT(0);
 };
 
 }  // End storage namespace
@@ -18,6 +18,7 @@
 #include "common/serializer.h"
 #include "common/pool.h"
 #include "common/printable.h"
+#include "common/numa_util.h"
 
 #include <mutex>
 
@@ -169,6 +170,10 @@ class Tile : public Printable {
   // Sync the contents
   void Sync();
 
+  // Place the contents on the given NUMA node. Must be called before the
+  // tile group is visible to other threads.
+  void MoveToNumaNode(int numa_node);
+
  protected:
   //===--------------------------------------------------------------------===//
   // Data members
@@ -189,6 +194,9 @@ class Tile : public Printable {
   // set of fixed-length tuple slots
   char *data;
 
+  // NUMA node data was allocated on (NUMA_NODE_ANY if not placed)
+  int numa_node = NUMA_NODE_ANY;
+
   // relevant tile group
   TileGroup *tile_group;
 
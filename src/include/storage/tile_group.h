@@ -172,6 +172,53 @@ class TileGroup : public Printable {
   // Sync the contents
   void Sync();
 
+  // Place the header and the tiles on the given NUMA node
+  void SetNumaNode(int numa_node);
+
+  // NUMA node holding the tile group (NUMA_NODE_ANY if not placed)
+  int GetNumaNode() const { return numa_node; }
+
+  //===--------------------------------------------------------------------===//
+  // Access Heat
+  //===--------------------------------------------------------------------===//
+
+  // Record a scan over this tile group
+  void IncrementAccessCount() {
+    access_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t GetAccessCount() const {
+    return access_count.load(std::memory_order_relaxed);
+  }
+
+  // Record a new tuple slot being claimed in this tile group
+  void IncrementWriteCount() {
+    write_count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  size_t GetWriteCount() const {
+    return write_count.load(std::memory_order_relaxed);
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Checkpoint
+  //===--------------------------------------------------------------------===//
+
+  // Record a change of the committed versions since the last checkpoint.
+  // The flag is only written when it is not set yet, so commits into a
+  // dirty tile group do not bounce its cache line.
+  void SetCheckpointDirty() {
+    if (checkpoint_dirty.load(std::memory_order_relaxed) == false) {
+      checkpoint_dirty.store(true, std::memory_order_release);
+    }
+  }
+
+  // Clear the flag before the tile group is checkpointed, and return whether
+  // it was set
+  bool ClearCheckpointDirty() {
+    return checkpoint_dirty.exchange(false, std::memory_order_acq_rel);
+  }
+
  protected:
   //===--------------------------------------------------------------------===//
   // Data members
@@ -208,6 +255,18 @@ class TileGroup : public Printable {
   // column to tile mapping :
   // <column offset> to <tile offset, tile column offset>
   column_map_type column_map;
+
+  // NUMA node the memory was placed on
+  int numa_node;
+
+  // access heat counters used by the layout tuner.
+  // they are only hints, hence relaxed ordering.
+  std::atomic<size_t> access_count{0};
+  std::atomic<size_t> write_count{0};
+
+  // whether the tile group changed since the last checkpoint. a new tile
+  // group is in no checkpoint yet.
+  std::atomic<bool> checkpoint_dirty{true};
 };
 
 }  // End storage namespace
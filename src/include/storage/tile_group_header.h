@@ -23,6 +23,7 @@
 #include "common/types.h"
 #include "common/macros.h"
 #include "common/platform.h"
+#include "common/numa_util.h"
 
 namespace peloton {
 namespace storage {
@@ -39,11 +40,19 @@ class TileGroup;
  * It is shared by all tiles in a tile group.
  *
  *  Layout :
- *  
+ *
+ *  The fields checked for visibility are stored column-wise, so that a scan
+ *  over the header touches one cache line per field for every 8 slots.
+ *  The remaining fields are stored row-wise after them.
+ *
  *  -----------------------------------------------------------------------------
- *  | TxnID (8 bytes)  | BeginTimeStamp (8 bytes) | EndTimeStamp (8 bytes) |
+ *  | TxnID (8 bytes) x tuple count |
+ *  | BeginTimeStamp (8 bytes) x tuple count |
+ *  | EndTimeStamp (8 bytes) x tuple count |
  *  | NextItemPointer (8 bytes) | PrevItemPointer (8 bytes) |
- *  | Indirection (8 bytes) | ReservedField (24 bytes)
+ *  | Indirection (8 bytes) | VersionHint (8 bytes) |
+ *  | ReservedField (32 bytes) | x tuple count
+ *  | AbortCount (4 bytes) x tuple count |
  *  -----------------------------------------------------------------------------
  *
  *  FIELD DESCRIPTIONS: 
@@ -54,11 +63,13 @@ class TileGroup;
  *  NextItemPointer: the pointer pointing to the next (older) version in the version chain. 
  *  PrevItemPointer: the pointer pointing to the prev (newer) version in the version chain.
  *  Indirection: the pointer pointing to the index entry that holds the address of the version chain header.
+ *  VersionHint: an older version of the chain that readers with an older snapshot can jump to.
  *  ReservedField: unused space for future usage.
+ *  AbortCount: how often a transaction failed to read or own the tuple.
  *
  */
 
-#define TUPLE_HEADER_LOCATION data + (tuple_slot_id * header_entry_size)
+#define TUPLE_HEADER_LOCATION cold_data + (tuple_slot_id * cold_entry_size)
 
 class TileGroupHeader : public Printable {
   TileGroupHeader() = delete;
@@ -70,6 +81,9 @@ class TileGroupHeader : public Printable {
     // check for self-assignment
     if (&other == this) return *this;
 
+    // the column-wise layout depends on the slot count
+    PL_ASSERT(num_tuple_slots == other.num_tuple_slots);
+
     header_size = other.header_size;
 
     // copy over all the data
@@ -136,15 +150,15 @@ class TileGroupHeader : public Printable {
   // but the current transaction reads the txn_id.
   // the returned value seems to be uncertain.
   inline txn_id_t GetTransactionId(const oid_t &tuple_slot_id) const {
-    return *((txn_id_t *)(TUPLE_HEADER_LOCATION));
+    return txn_ids[tuple_slot_id];
   }
 
   inline cid_t GetBeginCommitId(const oid_t &tuple_slot_id) const {
-    return *((cid_t *)(TUPLE_HEADER_LOCATION + begin_cid_offset));
+    return begin_cids[tuple_slot_id];
   }
 
   inline cid_t GetEndCommitId(const oid_t &tuple_slot_id) const {
-    return *((cid_t *)(TUPLE_HEADER_LOCATION + end_cid_offset));
+    return end_cids[tuple_slot_id];
   }
 
   inline ItemPointer GetNextItemPointer(const oid_t &tuple_slot_id) const {
@@ -159,11 +173,21 @@ class TileGroupHeader : public Printable {
     return *(ItemPointer **)(TUPLE_HEADER_LOCATION + indirection_offset);
   }
 
-  // constraint: at most 24 bytes.
+  inline ItemPointer GetVersionHint(const oid_t &tuple_slot_id) const {
+    return *((ItemPointer *)(TUPLE_HEADER_LOCATION + version_hint_offset));
+  }
+
+  inline uint32_t GetAbortCount(const oid_t &tuple_slot_id) const {
+    return abort_counts[tuple_slot_id];
+  }
+
+  // constraint: at most 32 bytes.
   inline char *GetReservedFieldRef(const oid_t &tuple_slot_id) const {
     return (char *)(TUPLE_HEADER_LOCATION + reserved_field_offset);
   }
 
+  inline TileGroup *GetTileGroup() const { return tile_group; }
+
   // Setters
 
   inline void SetTileGroup(TileGroup *tile_group) {
@@ -171,17 +195,17 @@ class TileGroupHeader : public Printable {
   }
   inline void SetTransactionId(const oid_t &tuple_slot_id,
                                const txn_id_t &transaction_id) const {
-    *((txn_id_t *)(TUPLE_HEADER_LOCATION)) = transaction_id;
+    txn_ids[tuple_slot_id] = transaction_id;
   }
 
   inline void SetBeginCommitId(const oid_t &tuple_slot_id,
                                const cid_t &begin_cid) {
-    *((cid_t *)(TUPLE_HEADER_LOCATION + begin_cid_offset)) = begin_cid;
+    begin_cids[tuple_slot_id] = begin_cid;
   }
 
   inline void SetEndCommitId(const oid_t &tuple_slot_id,
                              const cid_t &end_cid) const {
-    *((cid_t *)(TUPLE_HEADER_LOCATION + end_cid_offset)) = end_cid;
+    end_cids[tuple_slot_id] = end_cid;
   }
 
   inline void SetNextItemPointer(const oid_t &tuple_slot_id,
@@ -199,20 +223,48 @@ class TileGroupHeader : public Printable {
     *((const ItemPointer **)(TUPLE_HEADER_LOCATION + indirection_offset)) = indirection;
   }
 
+  inline void SetVersionHint(const oid_t &tuple_slot_id,
+                             const ItemPointer &item) const {
+    *((ItemPointer *)(TUPLE_HEADER_LOCATION + version_hint_offset)) = item;
+  }
+
+  inline void SetAbortCount(const oid_t &tuple_slot_id,
+                            const uint32_t &abort_count) const {
+    abort_counts[tuple_slot_id] = abort_count;
+  }
+
+  // the counter is only a contention hint, so it saturates instead of
+  // wrapping around.
+  inline void IncrementAbortCount(const oid_t &tuple_slot_id) const {
+    uint32_t *abort_count_ptr = &abort_counts[tuple_slot_id];
+    if (*abort_count_ptr != UINT32_MAX) {
+      __sync_fetch_and_add(abort_count_ptr, 1);
+    }
+  }
+
   inline txn_id_t SetAtomicTransactionId(const oid_t &tuple_slot_id,
                                          const txn_id_t &old_txn_id,
                                          const txn_id_t &new_txn_id) const {
-    txn_id_t *txn_id_ptr = (txn_id_t *)(TUPLE_HEADER_LOCATION);
+    txn_id_t *txn_id_ptr = &txn_ids[tuple_slot_id];
     return __sync_val_compare_and_swap(txn_id_ptr, old_txn_id, new_txn_id);
   }
 
   inline bool SetAtomicTransactionId(const oid_t &tuple_slot_id,
                                      const txn_id_t &transaction_id) const {
-    txn_id_t *txn_id_ptr = (txn_id_t *)(TUPLE_HEADER_LOCATION);
+    txn_id_t *txn_id_ptr = &txn_ids[tuple_slot_id];
     return __sync_bool_compare_and_swap(txn_id_ptr, INITIAL_TXN_ID,
                                         transaction_id);
   }
 
+  // bring the fields of a version into the cache ahead of its visibility
+  // check
+  inline void PrefetchVersion(const oid_t &tuple_slot_id) const {
+    __builtin_prefetch(&txn_ids[tuple_slot_id]);
+    __builtin_prefetch(&begin_cids[tuple_slot_id]);
+    __builtin_prefetch(&end_cids[tuple_slot_id]);
+    __builtin_prefetch(TUPLE_HEADER_LOCATION);
+  }
+
   void PrintVisibility(txn_id_t txn_id, cid_t at_cid);
 
   // Getter for spin lock
@@ -222,6 +274,10 @@ class TileGroupHeader : public Printable {
   // Sync the contents
   void Sync();
 
+  // Place the contents on the given NUMA node. Must be called before the
+  // tile group is visible to other threads.
+  void MoveToNumaNode(int numa_node);
+
   //===--------------------------------------------------------------------===//
   // Utilities
   //===--------------------------------------------------------------------===//
@@ -232,18 +288,22 @@ class TileGroupHeader : public Printable {
   static inline size_t GetReservedSize() { return reserved_size; }
 
   // header entry size is the size of the layout described above
-  static const size_t reserved_size = 24;
-  static const size_t header_entry_size = sizeof(txn_id_t) + 2 * sizeof(cid_t) +
-                                          2 * sizeof(ItemPointer) + sizeof(ItemPointer*) + reserved_size;
-  static const size_t txn_id_offset = 0;
-  static const size_t begin_cid_offset = txn_id_offset + sizeof(txn_id_t);
-  static const size_t end_cid_offset = begin_cid_offset + sizeof(cid_t);
-  static const size_t next_pointer_offset = end_cid_offset + sizeof(cid_t);
+  static const size_t reserved_size = 32;
+  static const size_t hot_entry_size = sizeof(txn_id_t) + 2 * sizeof(cid_t);
+  static const size_t cold_entry_size = 3 * sizeof(ItemPointer) + sizeof(ItemPointer*) + reserved_size;
+  static const size_t header_entry_size =
+      hot_entry_size + cold_entry_size + sizeof(uint32_t);
+  // offsets within a cold entry
+  static const size_t next_pointer_offset = 0;
   static const size_t prev_pointer_offset = next_pointer_offset + sizeof(ItemPointer);
   static const size_t indirection_offset = prev_pointer_offset + sizeof(ItemPointer);
-  static const size_t reserved_field_offset = indirection_offset + sizeof(ItemPointer);
+  static const size_t version_hint_offset = indirection_offset + sizeof(ItemPointer*);
+  static const size_t reserved_field_offset = version_hint_offset + sizeof(ItemPointer);
 
  private:
+  // point the fields into data
+  void SetFieldPointers();
+
   //===--------------------------------------------------------------------===//
   // Data members
   //===--------------------------------------------------------------------===//
@@ -251,6 +311,9 @@ class TileGroupHeader : public Printable {
   // Backend
   BackendType backend_type;
 
+  // NUMA node data was allocated on (NUMA_NODE_ANY if not placed)
+  int numa_node;
+
   // Associated tile_group
   TileGroup *tile_group;
 
@@ -259,6 +322,17 @@ class TileGroupHeader : public Printable {
   // set of fixed-length tuple slots
   char *data;
 
+  // column-wise visibility fields, pointing into data
+  txn_id_t *txn_ids;
+  cid_t *begin_cids;
+  cid_t *end_cids;
+
+  // row-wise remaining fields, pointing into data
+  char *cold_data;
+
+  // contention counters, pointing into data after the row-wise fields
+  uint32_t *abort_counts;
+
   // number of tuple slots allocated
   oid_t num_tuple_slots;
 
@@ -179,6 +179,15 @@ class Tuple : public AbstractTuple {
   void SerializeWithHeaderTo(SerializeOutput &output);
 
   void DeserializeFrom(SerializeInputBE &input, VarlenPool *pool);
+
+  // Serialize only the given columns, each preceded by its id
+  void SerializeColumnsTo(SerializeOutput &output,
+                          const std::vector<oid_t> &column_ids);
+
+  // Deserialize the columns written by SerializeColumnsTo, and return their
+  // ids. The other columns are left untouched.
+  void DeserializeColumnsFrom(SerializeInputBE &input, VarlenPool *pool,
+                              std::vector<oid_t> &column_ids);
   void DeserializeWithHeaderFrom(SerializeInputBE &input);
 
   size_t HashCode(size_t seed) const;
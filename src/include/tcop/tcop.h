@@ -42,18 +42,21 @@ class TrafficCop {
   ~TrafficCop();
 
   // PortalExec - Execute query string
+  // The transaction commits asynchronously unless sync_commit is set
   Result ExecuteStatement(const std::string& query,
                           std::vector<ResultType> &result,
                           std::vector<FieldInfoType> &tuple_descriptor,
                           int &rows_changed,
-                          std::string &error_message);
+                          std::string &error_message,
+                          bool sync_commit = true);
 
   // ExecPrepStmt - Execute a statement from a prepared and bound statement
   Result ExecuteStatement(const std::shared_ptr<Statement>& statement,
                           const bool unnamed,
                           std::vector<ResultType> &result,
                           int &rows_change,
-                          std::string &error_message);
+                          std::string &error_message,
+                          bool sync_commit = true);
 
   // InitBindPrepStmt - Prepare and bind a query from a query string
   std::shared_ptr<Statement> PrepareStatement(const std::string& statement_name,
@@ -82,6 +82,10 @@ class PacketManager {
   std::string skipped_query_string_;
   std::string skipped_query_type_;
 
+  // whether the transactions of the session wait for their log to be
+  // flushed (synchronous_commit)
+  bool sync_commit_ = true;
+
   static const std::unordered_map<std::string, std::string>
       parameter_status_map;
 
@@ -125,6 +129,11 @@ class PacketManager {
    */
   bool HardcodedExecuteFilter(std::string query_type);
 
+  /* Applies the SET of a session setting. Only synchronous_commit is
+   * supported, returns false for other settings
+   */
+  bool ApplySessionSetting(const std::string& query);
+
   /* Execute a Simple query protocol message */
   void ExecQueryMessage(Packet* pkt, ResponseBuffer& responses);
 
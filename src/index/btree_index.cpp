@@ -147,6 +147,47 @@ bool BTREE_TEMPLATE_TYPE::DeleteEntry(const storage::Tuple *key,
   return true;
 }
 
+BTREE_TEMPLATE_ARGUMENT
+bool BTREE_TEMPLATE_TYPE::DeleteEntry(const storage::Tuple *key,
+                                      ItemPointer *location_ptr) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+  size_t delete_count = 0;
+
+  {
+    index_lock.WriteLock();
+
+    // Delete every < key, location_ptr > pair, without freeing the pointer
+    bool try_again = true;
+    while (try_again == true) {
+      // Unset try again
+      try_again = false;
+
+      // Lookup matching entries
+      auto entries = container.equal_range(index_key);
+      for (auto iterator = entries.first; iterator != entries.second;
+           iterator++) {
+        if (iterator->second == location_ptr) {
+          container.erase(iterator);
+          // erase() may invalidate iterators
+          try_again = true;
+          delete_count++;
+
+          break;
+        }
+      }
+    }
+
+    index_lock.Unlock();
+  }
+
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance().IncrementIndexDeletes(
+        delete_count, metadata);
+  }
+  return delete_count > 0;
+}
+
 BTREE_TEMPLATE_ARGUMENT
 bool BTREE_TEMPLATE_TYPE::CondInsertEntry(
     const storage::Tuple *key, ItemPointer *location,
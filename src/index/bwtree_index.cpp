@@ -127,6 +127,26 @@ bool BWTREE_INDEX_TYPE::DeleteEntry(const storage::Tuple *key,
   return ret;
 }
 
+/*
+ * DeleteEntry() - Removes a key-value pair whose value is the given pointer
+ *
+ * The pointer is shared by the other entries of the tuple, so it is not freed
+ */
+BWTREE_TEMPLATE_ARGUMENTS
+bool BWTREE_INDEX_TYPE::DeleteEntry(const storage::Tuple *key,
+                                    ItemPointer *location_ptr) {
+  KeyType index_key;
+  index_key.SetFromKey(key);
+
+  bool ret = container.Delete(index_key, location_ptr);
+
+  if (FLAGS_stats_mode != STATS_TYPE_INVALID) {
+    stats::BackendStatsContext::GetInstance().IncrementIndexDeletes(
+        ret == true ? 1 : 0, metadata);
+  }
+  return ret;
+}
+
 BWTREE_TEMPLATE_ARGUMENTS
 bool BWTREE_INDEX_TYPE::CondInsertEntry(
     const storage::Tuple *key, ItemPointer *location,
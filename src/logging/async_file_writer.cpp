@@ -0,0 +1,229 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// async_file_writer.cpp
+//
+// Identification: src/logging/async_file_writer.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+#ifdef PELOTON_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include "common/logger.h"
+#include "common/macros.h"
+#include "logging/async_file_writer.h"
+
+namespace peloton {
+namespace logging {
+
+AsyncFileWriter::AsyncFileWriter(unsigned int queue_depth)
+    : queue_depth_(queue_depth) {
+#ifdef PELOTON_HAVE_LIBURING
+  ring_ = new struct io_uring;
+  int ret = io_uring_queue_init(queue_depth_, ring_, 0);
+  if (ret < 0) {
+    LOG_ERROR("Could not set up io_uring: %s", strerror(-ret));
+    delete ring_;
+    ring_ = nullptr;
+  }
+#endif
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+#ifdef PELOTON_HAVE_LIBURING
+  if (ring_ != nullptr) {
+    Reap(true);
+    io_uring_queue_exit(ring_);
+    delete ring_;
+  }
+#endif
+}
+
+uint64_t AsyncFileWriter::Write(int fd, const char *data, size_t size,
+                                off_t offset) {
+  uint64_t ticket = ++last_ticket_;
+
+#ifdef PELOTON_HAVE_LIBURING
+  if (ring_ != nullptr) {
+    auto sqe = (struct io_uring_sqe *)GetSubmissionEntry(ticket, size);
+    io_uring_prep_write(sqe, fd, data, size, offset);
+    return ticket;
+  }
+#endif
+
+  while (size > 0) {
+    ssize_t ret = pwrite(fd, data, size, offset);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      LOG_ERROR("Could not write file: %s", strerror(errno));
+      RecordFailure(ticket);
+      break;
+    }
+    data += ret;
+    size -= ret;
+    offset += ret;
+  }
+
+  return ticket;
+}
+
+uint64_t AsyncFileWriter::Sync(int fd) {
+  uint64_t ticket = ++last_ticket_;
+
+#ifdef PELOTON_HAVE_LIBURING
+  if (ring_ != nullptr) {
+    auto sqe = (struct io_uring_sqe *)GetSubmissionEntry(ticket, 0);
+    io_uring_prep_fsync(sqe, fd, IORING_FSYNC_DATASYNC);
+    sqe->flags |= IOSQE_IO_DRAIN;
+    return ticket;
+  }
+#endif
+
+  if (fdatasync(fd) != 0) {
+    LOG_ERROR("Could not sync file: %s", strerror(errno));
+    RecordFailure(ticket);
+  }
+
+  return ticket;
+}
+
+uint64_t AsyncFileWriter::WriteAndSync(int fd, const char *data, size_t size,
+                                       off_t offset) {
+#ifdef PELOTON_HAVE_LIBURING
+  if (ring_ != nullptr) {
+    ReserveSubmissionEntries(2);
+
+    uint64_t ticket = ++last_ticket_;
+    auto sqe = (struct io_uring_sqe *)GetSubmissionEntry(ticket, size);
+    io_uring_prep_write(sqe, fd, data, size, offset);
+    // a failed write cancels the sync, which then fails too
+    sqe->flags |= IOSQE_IO_LINK;
+
+    ticket = ++last_ticket_;
+    sqe = (struct io_uring_sqe *)GetSubmissionEntry(ticket, 0);
+    io_uring_prep_fsync(sqe, fd, IORING_FSYNC_DATASYNC);
+    return ticket;
+  }
+#endif
+
+  Write(fd, data, size, offset);
+  return Sync(fd);
+}
+
+void AsyncFileWriter::Submit() {
+#ifdef PELOTON_HAVE_LIBURING
+  if (ring_ != nullptr) {
+    int ret = io_uring_submit(ring_);
+    if (ret < 0) {
+      LOG_ERROR("Could not submit to io_uring: %s", strerror(-ret));
+    }
+  }
+#endif
+}
+
+uint64_t AsyncFileWriter::Reap(bool wait_all) {
+  if (inflight_.empty() == false) {
+    Submit();
+
+    while (inflight_.empty() == false) {
+      if (CompleteRequest(wait_all) == false) {
+        break;
+      }
+    }
+  }
+
+  uint64_t completed_ticket = last_ticket_;
+  if (inflight_.empty() == false) {
+    completed_ticket = inflight_.begin()->first - 1;
+  }
+
+  // the requests after a failed one are not durable either
+  if (failed_ticket_ != 0 && completed_ticket >= failed_ticket_) {
+    completed_ticket = failed_ticket_ - 1;
+  }
+  return completed_ticket;
+}
+
+void AsyncFileWriter::RecordFailure(uint64_t ticket) {
+  failed_count_++;
+  if (failed_ticket_ == 0 || ticket < failed_ticket_) {
+    failed_ticket_ = ticket;
+  }
+}
+
+void AsyncFileWriter::ReserveSubmissionEntries(
+    UNUSED_ATTRIBUTE size_t count) {
+#ifdef PELOTON_HAVE_LIBURING
+  PL_ASSERT(count <= queue_depth_);
+  // the submission queue holds the queue depth, and the completion queue
+  // twice as much, so neither overflows
+  while (inflight_.size() + count > queue_depth_) {
+    Submit();
+    CompleteRequest(true);
+  }
+#endif
+}
+
+void *AsyncFileWriter::GetSubmissionEntry(UNUSED_ATTRIBUTE uint64_t ticket,
+                                          UNUSED_ATTRIBUTE size_t size) {
+#ifdef PELOTON_HAVE_LIBURING
+  ReserveSubmissionEntries(1);
+
+  auto sqe = io_uring_get_sqe(ring_);
+  PL_ASSERT(sqe != nullptr);
+  io_uring_sqe_set_data(sqe, (void *)ticket);
+  inflight_[ticket] = size;
+  return sqe;
+#else
+  return nullptr;
+#endif
+}
+
+bool AsyncFileWriter::CompleteRequest(UNUSED_ATTRIBUTE bool wait) {
+#ifdef PELOTON_HAVE_LIBURING
+  struct io_uring_cqe *cqe = nullptr;
+  int ret;
+  do {
+    ret = wait ? io_uring_wait_cqe(ring_, &cqe)
+               : io_uring_peek_cqe(ring_, &cqe);
+  } while (ret == -EINTR);
+
+  if (ret < 0) {
+    if (ret != -EAGAIN) {
+      LOG_ERROR("Could not reap io_uring: %s", strerror(-ret));
+    }
+    return false;
+  }
+
+  uint64_t ticket = (uint64_t)io_uring_cqe_get_data(cqe);
+  auto request = inflight_.find(ticket);
+  PL_ASSERT(request != inflight_.end());
+  if (cqe->res < 0) {
+    LOG_ERROR("io_uring request %lu failed: %s", ticket, strerror(-cqe->res));
+    RecordFailure(ticket);
+  } else if ((size_t)cqe->res != request->second) {
+    // a short write leaves the rest of the data unwritten
+    LOG_ERROR("io_uring request %lu wrote %d of %lu bytes", ticket, cqe->res,
+              request->second);
+    RecordFailure(ticket);
+  }
+  io_uring_cqe_seen(ring_, cqe);
+
+  inflight_.erase(request);
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace logging
+}  // namespace peloton
@@ -70,6 +70,36 @@ void BackendLogger::Log(LogRecord *record) {
   record->Serialize(output_buffer);
 
   this->log_buffer_lock.Lock();
+  AppendRecord(record);
+  this->log_buffer_lock.Unlock();
+}
+
+/**
+ * @brief log the log records of a transaction
+ * @param log records
+ * @return false if a record does not fit in a log buffer
+ */
+bool BackendLogger::Log(
+    const std::vector<std::unique_ptr<LogRecord>> &records) {
+  // every record keeps its own copy of the serialized message
+  for (auto &record : records) {
+    record->Serialize(output_buffer);
+  }
+
+  bool logged = true;
+  this->log_buffer_lock.Lock();
+  for (auto &record : records) {
+    if (AppendRecord(record.get()) == false) {
+      logged = false;
+      break;
+    }
+  }
+  this->log_buffer_lock.Unlock();
+
+  return logged;
+}
+
+bool BackendLogger::AppendRecord(LogRecord *record) {
   if (!log_buffer_) {
     LOG_TRACE("Acquire the first log buffer in backend logger");
     this->log_buffer_lock.Unlock();
@@ -98,7 +128,6 @@ void BackendLogger::Log(LogRecord *record) {
   if (!log_buffer_->WriteRecord(record)) {
     LOG_TRACE("Log buffer is full - Attempt to acquire a new one");
     // put back a buffer
-    max_log_id_buffer = 0;  // reset
     persist_buffer_pool_->Put(std::move(log_buffer_));
     this->log_buffer_lock.Unlock();
 
@@ -108,16 +137,19 @@ void BackendLogger::Log(LogRecord *record) {
     this->log_buffer_lock.Lock();
     log_buffer_ = std::move(new_buff);
 
+    // the record that did not fit sets the max log id of the new buffer
+    log_buffer_->SetMaxLogId(cur_log_id);
+    max_log_id_buffer = cur_log_id;
+
     // write to the new log buffer
     auto success = log_buffer_->WriteRecord(record);
     if (!success) {
       LOG_ERROR("Write record to log buffer failed");
-      this->log_buffer_lock.Unlock();
-      return;
+      return false;
     }
   }
 
-  this->log_buffer_lock.Unlock();
+  return true;
 }
 
 // used by the frontend logger to collect data on the current state of the
@@ -14,6 +14,8 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
 
 #include "logging/checkpoint/simple_checkpoint.h"
 #include "logging/loggers/wal_frontend_logger.h"
@@ -61,6 +63,12 @@ SimpleCheckpoint::~SimpleCheckpoint() {
 }
 
 void SimpleCheckpoint::DoCheckpoint() {
+  // a full checkpoint starts a new chain
+  full_checkpoint_ = checkpoint_chain_.empty() ||
+                     checkpoint_chain_.size() >= CHECKPOINT_FULL_INTERVAL;
+  live_tile_group_ids_.clear();
+  checkpointed_tile_group_ids_.clear();
+
   // TODO split checkpoint file into multiple files in the future
   // Create a new file for checkpoint
   CreateFile();
@@ -85,6 +93,15 @@ void SimpleCheckpoint::DoCheckpoint() {
   begin_record->Serialize(begin_output_buffer);
   records_.push_back(begin_record);
 
+  // recovery can start from a full checkpoint without the manifest
+  if (full_checkpoint_) {
+    std::shared_ptr<LogRecord> full_record(new TransactionRecord(
+        LOGRECORD_TYPE_CHECKPOINT_FULL, start_commit_id_));
+    CopySerializeOutput full_output_buffer;
+    full_record->Serialize(full_output_buffer);
+    records_.push_back(full_record);
+  }
+
   auto catalog = catalog::Catalog::GetInstance();
   auto database_count = catalog->GetDatabaseCount();
 
@@ -115,8 +132,9 @@ void SimpleCheckpoint::DoCheckpoint() {
   // TODO Add delimiter record for checkpoint recovery as well
   Persist();
 
-  Cleanup();
-  most_recent_checkpoint_cid = start_commit_id_;
+  if (Cleanup()) {
+    most_recent_checkpoint_cid = start_commit_id_;
+  }
 }
 
 cid_t SimpleCheckpoint::DoRecovery() {
@@ -124,8 +142,74 @@ cid_t SimpleCheckpoint::DoRecovery() {
   if (checkpoint_version < 0) {
     return 0;
   }
+
+  // without a manifest, recovery starts from the latest full checkpoint, as
+  // the incremental ones after it do not say which tile groups are gone
+  if (ReadManifest() == false) {
+    int full_version = checkpoint_version;
+    while (full_version >= 0 && IsFullImage(full_version) == false) {
+      full_version--;
+    }
+    if (full_version < 0) {
+      LOG_ERROR("No full checkpoint to recover from");
+      LogManager::GetInstance().SetRecoveryFailed();
+      return 0;
+    }
+
+    LOG_TRACE("Recovering from full checkpoint %d", full_version);
+    CheckpointImage image;
+    image.version = full_version;
+    checkpoint_chain_.assign(1, image);
+    live_tile_group_ids_.clear();
+  }
+
+  // every tile group is taken from the latest checkpoint that holds it, if
+  // the latest checkpoint still has it
+  covered_tile_groups_.clear();
+  live_tile_groups_.clear();
+  live_tile_groups_.insert(live_tile_group_ids_.begin(),
+                           live_tile_group_ids_.end());
+  recovered_tile_groups_.clear();
+
+  cid_t commit_id = 0;
+  for (auto image_itr = checkpoint_chain_.rbegin();
+       image_itr != checkpoint_chain_.rend(); image_itr++) {
+    filter_live_tile_groups_ = (image_itr != checkpoint_chain_.rbegin());
+    cid_t image_commit_id = RecoverImage(image_itr->version);
+    if (image_itr == checkpoint_chain_.rbegin()) {
+      commit_id = image_commit_id;
+    }
+    covered_tile_groups_.insert(image_itr->tile_group_ids.begin(),
+                                image_itr->tile_group_ids.end());
+  }
+  covered_tile_groups_.clear();
+  live_tile_groups_.clear();
+
+  // the recovered tile groups are as the chain has them
+  auto &manager = catalog::Manager::GetInstance();
+  for (auto tile_group_id : recovered_tile_groups_) {
+    auto tile_group = manager.GetTileGroup(tile_group_id);
+    if (tile_group != nullptr) {
+      tile_group->ClearCheckpointDirty();
+    }
+  }
+  recovered_tile_groups_.clear();
+
+  // After finishing recovery, set the next oid with maximum oid
+  // observed during the recovery
+  if (max_oid_ > manager.GetNextOid()) {
+    manager.SetNextOid(max_oid_);
+  }
+
+  // FIXME this is not thread safe for concurrent checkpoint recovery
+  concurrency::TransactionManagerFactory::GetInstance().SetNextCid(commit_id);
+  CheckpointManager::GetInstance().SetRecoveredCid(commit_id);
+  return commit_id;
+}
+
+cid_t SimpleCheckpoint::RecoverImage(int version) {
   // we open checkpoint file in read + binary mode
-  std::string file_name = ConcatFileName(checkpoint_dir, checkpoint_version);
+  std::string file_name = ConcatFileName(checkpoint_dir, version);
   bool success =
       LoggingUtil::InitFileHandle(file_name.c_str(), file_handle_, "rb");
   if (!success) {
@@ -150,13 +234,23 @@ cid_t SimpleCheckpoint::DoRecovery() {
         should_stop = true;
         break;
       }
+      case LOGRECORD_TYPE_CHECKPOINT_FULL: {
+        TransactionRecord full_rec(record_type);
+        if (LoggingUtil::ReadTransactionRecordHeader(full_rec, file_handle_) ==
+            false) {
+          LOG_ERROR("Failed to read checkpoint full entry");
+          should_stop = true;
+        }
+        break;
+      }
       case LOGRECORD_TYPE_TRANSACTION_BEGIN: {
         LOG_TRACE("Read checkpoint begin entry");
         TransactionRecord txn_rec(record_type);
         if (LoggingUtil::ReadTransactionRecordHeader(txn_rec, file_handle_) ==
             false) {
           LOG_ERROR("Failed to read checkpoint begin entry");
-          return false;
+          should_stop = true;
+          break;
         }
         commit_id = txn_rec.GetTransactionId();
         break;
@@ -169,17 +263,75 @@ cid_t SimpleCheckpoint::DoRecovery() {
     }
   }
 
-  // After finishing recovery, set the next oid with maximum oid
-  // observed during the recovery
-  auto &manager = catalog::Manager::GetInstance();
-  if (max_oid_ > manager.GetNextOid()) {
-    manager.SetNextOid(max_oid_);
+  fclose(file_handle_.file);
+  file_handle_ = INVALID_FILE_HANDLE;
+  return commit_id;
+}
+
+bool SimpleCheckpoint::IsFullImage(int version) {
+  std::string file_name = ConcatFileName(checkpoint_dir, version);
+  // the checkpoints of the chains before the latest one are gone
+  FILE *file = fopen(file_name.c_str(), "rb");
+  if (file == NULL) {
+    return false;
+  }
+  FileHandle file_handle;
+  file_handle.file = file;
+  file_handle.fd = fileno(file);
+  file_handle.size = LoggingUtil::GetLogFileSize(file_handle);
+
+  // the begin entry is followed by the full entry, and the commit entry ends
+  // the checkpoint
+  bool full = false;
+  bool complete = false;
+  bool should_stop = false;
+  while (!should_stop) {
+    auto record_type = LoggingUtil::GetNextLogRecordType(file_handle);
+    switch (record_type) {
+      case LOGRECORD_TYPE_TRANSACTION_BEGIN:
+      case LOGRECORD_TYPE_CHECKPOINT_FULL:
+      case LOGRECORD_TYPE_TRANSACTION_COMMIT: {
+        TransactionRecord txn_rec(record_type);
+        if (LoggingUtil::ReadTransactionRecordHeader(txn_rec, file_handle) ==
+            false) {
+          should_stop = true;
+          break;
+        }
+        if (record_type == LOGRECORD_TYPE_CHECKPOINT_FULL) {
+          full = true;
+        } else if (record_type == LOGRECORD_TYPE_TRANSACTION_COMMIT) {
+          complete = true;
+          should_stop = true;
+        }
+        break;
+      }
+      case LOGRECORD_TYPE_WAL_TUPLE_INSERT: {
+        if (full == false) {
+          should_stop = true;
+          break;
+        }
+        TupleRecord tuple_record(record_type);
+        if (LoggingUtil::ReadTupleRecordHeader(tuple_record, file_handle) ==
+            false) {
+          should_stop = true;
+          break;
+        }
+        LoggingUtil::SkipTupleRecordBody(file_handle);
+        break;
+      }
+      default: {
+        should_stop = true;
+        break;
+      }
+    }
   }
 
-  // FIXME this is not thread safe for concurrent checkpoint recovery
-  concurrency::TransactionManagerFactory::GetInstance().SetNextCid(commit_id);
-  CheckpointManager::GetInstance().SetRecoveredCid(commit_id);
-  return commit_id;
+  fclose(file_handle.file);
+  if (full == false || complete == false) {
+    LOG_TRACE("Checkpoint %d is not a full one", version);
+    return false;
+  }
+  return true;
 }
 
 void SimpleCheckpoint::InsertTuple(cid_t commit_id) {
@@ -191,6 +343,15 @@ void SimpleCheckpoint::InsertTuple(cid_t commit_id) {
     return;
   }
 
+  // the tile group is taken from a later checkpoint, or is no longer there
+  auto record_tile_group_id = tuple_record.GetInsertLocation().block;
+  if (covered_tile_groups_.count(record_tile_group_id) != 0 ||
+      (filter_live_tile_groups_ &&
+       live_tile_groups_.count(record_tile_group_id) == 0)) {
+    LoggingUtil::SkipTupleRecordBody(file_handle_);
+    return;
+  }
+
   auto table = LoggingUtil::GetTable(tuple_record);
   if (!table) {
     // the table was deleted
@@ -200,7 +361,7 @@ void SimpleCheckpoint::InsertTuple(cid_t commit_id) {
 
   // Read off the tuple record body from the log
   std::unique_ptr<storage::Tuple> tuple(LoggingUtil::ReadTupleRecordBody(
-      table->GetSchema(), pool.get(), file_handle_));
+      tuple_record, table->GetSchema(), pool.get(), file_handle_));
   // Check for torn log write
   if (tuple == nullptr) {
     LOG_ERROR("Torn checkpoint write.");
@@ -209,6 +370,7 @@ void SimpleCheckpoint::InsertTuple(cid_t commit_id) {
   auto target_location = tuple_record.GetInsertLocation();
   auto tile_group_id = target_location.block;
   RecoverTuple(tuple.get(), table, target_location, commit_id);
+  recovered_tile_groups_.insert(tile_group_id);
   if (max_oid_ < target_location.block) {
     max_oid_ = tile_group_id;
   }
@@ -233,6 +395,23 @@ void SimpleCheckpoint::Scan(storage::DataTable *target_table,
     // Retrieve a tile group
     auto tile_group = target_table->GetTileGroup(current_tile_group_offset);
 
+    // Skip tile groups dropped by compaction
+    if (tile_group == nullptr) {
+      current_tile_group_offset++;
+      continue;
+    }
+
+    // an incremental checkpoint skips the tile groups that did not change
+    // since the checkpoint before it
+    auto tile_group_id = tile_group->GetTileGroupId();
+    live_tile_group_ids_.push_back(tile_group_id);
+    if (tile_group->ClearCheckpointDirty() == false &&
+        full_checkpoint_ == false) {
+      current_tile_group_offset++;
+      continue;
+    }
+    checkpointed_tile_group_ids_.push_back(tile_group_id);
+
     // Retrieve a logical tile
     std::unique_ptr<executor::LogicalTile> logical_tile(
         scanner.Scan(tile_group, column_ids, start_commit_id_));
@@ -243,11 +422,8 @@ void SimpleCheckpoint::Scan(storage::DataTable *target_table,
       continue;
     }
 
-    auto tile_group_id = logical_tile->GetColumnInfo(0)
-                             .base_tile->GetTileGroup()
-                             ->GetTileGroupId();
-
     // Go over the logical tile
+    auto &position_list = logical_tile->GetPositionLists()[0];
     for (oid_t tuple_id : *logical_tile) {
       expression::ContainerTuple<executor::LogicalTile> cur_tuple(
           logical_tile.get(), tuple_id);
@@ -260,7 +436,9 @@ void SimpleCheckpoint::Scan(storage::DataTable *target_table,
           tuple->SetValue(column_id, cur_tuple.GetValue(column_id),
                           this->pool.get());
         }
-        ItemPointer location(tile_group_id, tuple_id);
+        // log the physical slot, as the WAL records that update this version
+        // refer to it
+        ItemPointer location(tile_group_id, position_list[tuple_id]);
         // TODO is it possible to avoid `new` for checkpoint?
         std::shared_ptr<LogRecord> record(logger_->GetTupleRecord(
             LOGRECORD_TYPE_TUPLE_INSERT, INITIAL_TXN_ID, target_table->GetOid(),
@@ -269,7 +447,7 @@ void SimpleCheckpoint::Scan(storage::DataTable *target_table,
         CopySerializeOutput output_buffer;
         record->Serialize(output_buffer);
         LOG_TRACE("Insert a new record for checkpoint (%u, %u)", tile_group_id,
-                  tuple_id);
+                  location.offset);
         records_.push_back(record);
       }
     }
@@ -292,12 +470,22 @@ void SimpleCheckpoint::CreateFile() {
   if (disable_file_access) return;
   // open checkpoint file and file descriptor
   std::string file_name = ConcatFileName(checkpoint_dir, ++checkpoint_version);
+  // not appending, the writes through io_uring carry their offsets
   bool success =
-      LoggingUtil::InitFileHandle(file_name.c_str(), file_handle_, "ab");
+      LoggingUtil::InitFileHandle(file_name.c_str(), file_handle_, "wb");
   if (!success) {
     PL_ASSERT(false);
     return;
   }
+  file_offset_ = 0;
+
+  if (LogManager::GetInstance().GetIoUring() && async_writer_ == nullptr) {
+    async_writer_.reset(new AsyncFileWriter());
+    if (async_writer_->IsAvailable() == false) {
+      LOG_TRACE("io_uring is not available, writing the checkpoint");
+      async_writer_.reset();
+    }
+  }
   LOG_TRACE("Created a new checkpoint file: %s", file_name.c_str());
 }
 
@@ -308,6 +496,50 @@ void SimpleCheckpoint::Persist() {
   PL_ASSERT(file_handle_.fd != INVALID_FILE_DESCRIPTOR);
 
   LOG_TRACE("Persisting %lu checkpoint entries", records_.size());
+
+  if (async_writer_ != nullptr) {
+    // copy the records into chunks and queue them without waiting
+    char *chunk = nullptr;
+    size_t chunk_size = 0;
+    size_t chunk_capacity = 0;
+
+    for (auto record : records_) {
+      PL_ASSERT(record);
+      PL_ASSERT(record->GetMessageLength() > 0);
+      size_t length = record->GetMessageLength();
+
+      if (chunk != nullptr && chunk_size + length > chunk_capacity) {
+        auto ticket = async_writer_->Write(file_handle_.fd, chunk, chunk_size,
+                                           file_offset_);
+        submitted_chunks_.emplace_back(ticket, chunk);
+        file_offset_ += chunk_size;
+        chunk = nullptr;
+      }
+
+      if (chunk == nullptr) {
+        chunk_capacity = std::max(length, (size_t)CHECKPOINT_WRITE_CHUNK_SIZE);
+        chunk = (char *)malloc(chunk_capacity);
+        chunk_size = 0;
+      }
+
+      PL_MEMCPY(chunk + chunk_size, record->GetMessage(), length);
+      chunk_size += length;
+      record.reset();
+    }
+
+    if (chunk != nullptr) {
+      auto ticket = async_writer_->Write(file_handle_.fd, chunk, chunk_size,
+                                         file_offset_);
+      submitted_chunks_.emplace_back(ticket, chunk);
+      file_offset_ += chunk_size;
+    }
+
+    async_writer_->Submit();
+    ReleaseChunks(false);
+    records_.clear();
+    return;
+  }
+
   // write all the record in the queue and free them
   for (auto record : records_) {
     PL_ASSERT(record);
@@ -319,7 +551,18 @@ void SimpleCheckpoint::Persist() {
   records_.clear();
 }
 
-void SimpleCheckpoint::Cleanup() {
+void SimpleCheckpoint::ReleaseChunks(bool wait_all) {
+  auto completed_ticket = async_writer_->Reap(wait_all);
+
+  // nothing is in flight after waiting, even past a failed write
+  while (submitted_chunks_.empty() == false &&
+         (wait_all || submitted_chunks_.front().first <= completed_ticket)) {
+    free(submitted_chunks_.front().second);
+    submitted_chunks_.pop_front();
+  }
+}
+
+bool SimpleCheckpoint::Cleanup() {
   // Clean up the record queue
   for (auto record : records_) {
     record.reset();
@@ -327,20 +570,74 @@ void SimpleCheckpoint::Cleanup() {
   records_.clear();
 
   if (!disable_file_access) {
+    bool persisted;
+    // the chunks are synced behind their writes
+    if (async_writer_ != nullptr) {
+      async_writer_->Sync(file_handle_.fd);
+      async_writer_->Submit();
+      ReleaseChunks(true);
+      persisted = (async_writer_->GetFailedTicket() == 0);
+    } else {
+      persisted = LoggingUtil::FFlushFsync(file_handle_);
+    }
+
     // Close and sync the current one
     fclose(file_handle_.file);
 
-    // Remove previous version
-    if (checkpoint_version > 0 && !disable_file_access) {
+    // the dirty flags are cleared, so the next checkpoint has to be full
+    if (persisted == false) {
+      LOG_ERROR("Failed to persist checkpoint %d", checkpoint_version);
+      auto file_name = ConcatFileName(checkpoint_dir, checkpoint_version);
+      if (remove(file_name.c_str()) != 0) {
+        LOG_TRACE("Failed to remove file %s", file_name.c_str());
+      }
+      checkpoint_chain_.clear();
+      // the failed tickets stay with the writer
+      async_writer_.reset();
+      return false;
+    }
+  }
+
+  // the checkpoint joins the chain, a full one replaces it
+  std::vector<CheckpointImage> previous_chain;
+  if (full_checkpoint_) {
+    previous_chain.swap(checkpoint_chain_);
+  }
+  CheckpointImage image;
+  image.version = checkpoint_version;
+  image.commit_id = start_commit_id_;
+  image.full = full_checkpoint_;
+  if (full_checkpoint_ == false) {
+    image.tile_group_ids.swap(checkpointed_tile_group_ids_);
+  }
+  checkpoint_chain_.push_back(std::move(image));
+
+  if (!disable_file_access) {
+    if (PersistManifest() == false) {
+      // the dirty flags are cleared, so only a full checkpoint is complete
+      LOG_ERROR("Failed to write the checkpoint manifest");
+      checkpoint_chain_.clear();
+      return false;
+    }
+
+    // Remove the previous chain
+    for (auto &previous_image : previous_chain) {
       auto previous_version =
-          ConcatFileName(checkpoint_dir, checkpoint_version - 1).c_str();
-      if (remove(previous_version) != 0) {
-        LOG_TRACE("Failed to remove file %s", previous_version);
+          ConcatFileName(checkpoint_dir, previous_image.version);
+      if (remove(previous_version.c_str()) != 0) {
+        LOG_TRACE("Failed to remove file %s", previous_version.c_str());
       }
     }
   }
+
+  LOG_TRACE("Checkpoint %d holds %lu of %lu tile groups", checkpoint_version,
+            full_checkpoint_ ? live_tile_group_ids_.size()
+                             : checkpoint_chain_.back().tile_group_ids.size(),
+            live_tile_group_ids_.size());
+
   // Truncate logs
   LogManager::GetInstance().TruncateLogs(start_commit_id_);
+  return true;
 }
 
 void SimpleCheckpoint::InitVersionNumber() {
@@ -367,5 +664,115 @@ void SimpleCheckpoint::InitVersionNumber() {
   LOG_TRACE("set checkpoint version to: %d", checkpoint_version);
 }
 
+//===--------------------------------------------------------------------===//
+// Manifest
+//===--------------------------------------------------------------------===//
+
+// The manifest is the header, the tile groups of the latest checkpoint, and
+// each checkpoint of the chain followed by the tile groups it holds.
+struct CheckpointManifestHeader {
+  uint64_t checkpoint_count;
+  uint64_t live_tile_group_count;
+};
+
+struct CheckpointManifestEntry {
+  int64_t version;
+  cid_t commit_id;
+  uint64_t full;
+  uint64_t tile_group_count;
+};
+
+std::string SimpleCheckpoint::GetManifestFileName() {
+  return checkpoint_dir + "/" + CHECKPOINT_MANIFEST_FILE_NAME;
+}
+
+bool SimpleCheckpoint::PersistManifest() {
+  // the manifest is replaced at once, recovery sees the old or the new chain
+  auto file_name = GetManifestFileName();
+  auto temp_file_name = file_name + ".tmp";
+  FILE *manifest_file = fopen(temp_file_name.c_str(), "wb");
+  if (manifest_file == NULL) {
+    LOG_ERROR("Unable to open the checkpoint manifest");
+    return false;
+  }
+
+  CheckpointManifestHeader header;
+  header.checkpoint_count = checkpoint_chain_.size();
+  header.live_tile_group_count = live_tile_group_ids_.size();
+  bool success =
+      fwrite(&header, sizeof(header), 1, manifest_file) == 1 &&
+      fwrite(live_tile_group_ids_.data(), sizeof(oid_t),
+             live_tile_group_ids_.size(),
+             manifest_file) == live_tile_group_ids_.size();
+
+  for (auto &image : checkpoint_chain_) {
+    CheckpointManifestEntry entry;
+    entry.version = image.version;
+    entry.commit_id = image.commit_id;
+    entry.full = image.full;
+    entry.tile_group_count = image.tile_group_ids.size();
+    success = success && fwrite(&entry, sizeof(entry), 1, manifest_file) == 1 &&
+              fwrite(image.tile_group_ids.data(), sizeof(oid_t),
+                     image.tile_group_ids.size(),
+                     manifest_file) == image.tile_group_ids.size();
+  }
+
+  success = success && fflush(manifest_file) == 0 &&
+            fsync(fileno(manifest_file)) == 0;
+  fclose(manifest_file);
+
+  // the chain before it is removed once the rename is durable
+  return success && rename(temp_file_name.c_str(), file_name.c_str()) == 0 &&
+         LoggingUtil::FsyncDirectory(checkpoint_dir.c_str());
+}
+
+bool SimpleCheckpoint::ReadManifest() {
+  FILE *manifest_file = fopen(GetManifestFileName().c_str(), "rb");
+  if (manifest_file == NULL) {
+    LOG_TRACE("No checkpoint manifest");
+    return false;
+  }
+
+  CheckpointManifestHeader header;
+  bool success = fread(&header, sizeof(header), 1, manifest_file) == 1;
+  if (success) {
+    live_tile_group_ids_.resize(header.live_tile_group_count);
+    success = fread(live_tile_group_ids_.data(), sizeof(oid_t),
+                    live_tile_group_ids_.size(),
+                    manifest_file) == live_tile_group_ids_.size();
+  }
+
+  checkpoint_chain_.clear();
+  for (uint64_t image_itr = 0; success && image_itr < header.checkpoint_count;
+       image_itr++) {
+    CheckpointManifestEntry entry;
+    success = fread(&entry, sizeof(entry), 1, manifest_file) == 1;
+    if (success == false) {
+      break;
+    }
+
+    CheckpointImage image;
+    image.version = entry.version;
+    image.commit_id = entry.commit_id;
+    image.full = entry.full;
+    image.tile_group_ids.resize(entry.tile_group_count);
+    success = fread(image.tile_group_ids.data(), sizeof(oid_t),
+                    image.tile_group_ids.size(),
+                    manifest_file) == image.tile_group_ids.size();
+    checkpoint_chain_.push_back(std::move(image));
+  }
+  fclose(manifest_file);
+
+  // the chain starts with a full checkpoint
+  if (success == false || checkpoint_chain_.empty() ||
+      checkpoint_chain_.front().full == false) {
+    LOG_ERROR("The checkpoint manifest is not valid");
+    checkpoint_chain_.clear();
+    live_tile_group_ids_.clear();
+    return false;
+  }
+  return true;
+}
+
 }  // namespace logging
 }  // namespace peloton
@@ -50,12 +50,13 @@ FrontendLogger::~FrontendLogger() {
  * @param logging type can be write ahead logging or write behind logging
  */
 FrontendLogger *FrontendLogger::GetFrontendLogger(LoggingType logging_type,
-                                                  bool test_mode) {
+                                                  bool test_mode,
+                                                  int logger_id) {
   FrontendLogger *frontend_logger = nullptr;
 
   LOG_TRACE("Logging_type is %d", (int)logging_type);
   if (IsBasedOnWriteAheadLogging(logging_type) == true) {
-    frontend_logger = new WriteAheadFrontendLogger(test_mode);
+    frontend_logger = new WriteAheadFrontendLogger(test_mode, logger_id);
   } else if (IsBasedOnWriteBehindLogging(logging_type) == true) {
     frontend_logger = new WriteBehindFrontendLogger();
   } else {
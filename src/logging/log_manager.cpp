@@ -10,12 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sched.h>
 #include <condition_variable>
 #include <memory>
+#include <set>
+#include <vector>
 
 #include "concurrency/transaction_manager_factory.h"
 #include "logging/log_manager.h"
+#include "logging/loggers/wbl_backend_logger.h"
+#include "logging/loggers/wbl_frontend_logger.h"
 #include "logging/records/transaction_record.h"
+#include "logging/records/tuple_record.h"
 #include "common/logger.h"
 #include "common/macros.h"
 #include "executor/executor_context.h"
@@ -23,6 +29,7 @@
 #include "catalog/catalog.h"
 #include "storage/tuple.h"
 #include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
 #include "storage/data_table.h"
 #include "storage/database.h"
 
@@ -32,6 +39,9 @@ namespace logging {
 // Each thread gets a backend logger
 thread_local static BackendLogger *backend_logger = nullptr;
 
+// the tile groups registered by the committing transaction of the thread
+thread_local static std::vector<oid_t> dirty_tile_groups;
+
 LogManager::LogManager() {
   Configure(peloton_logging_mode, false, DEFAULT_NUM_FRONTEND_LOGGERS,
             LOGGER_MAPPING_TYPE_ROUND_ROBIN);
@@ -68,6 +78,7 @@ void LogManager::StartStandbyMode() {
     frontend_loggers[0].get()->SetIsDistinguishedLogger(true);
 
   // Toggle status in log manager map
+  log_failed_ = false;
   SetLoggingStatus(LOGGING_STATUS_TYPE_STANDBY);
 
   // Launch the frontend logger's main loop
@@ -101,7 +112,16 @@ void LogManager::StartRecoveryMode() {
 
 void LogManager::TerminateLoggingMode() {
   LOG_TRACE("TRACKING: LogManager::TerminateLoggingMode()");
-  SetLoggingStatus(LOGGING_STATUS_TYPE_TERMINATE);
+  {
+    std::lock_guard<std::mutex> wait_lock(logging_status_mutex);
+
+    // the frontend loggers may have terminated by themselves after a failed
+    // recovery
+    if (logging_status != LOGGING_STATUS_TYPE_SLEEP) {
+      logging_status = LOGGING_STATUS_TYPE_TERMINATE;
+      logging_status_cv.notify_all();
+    }
+  }
 
   // We set the frontend logger status to Terminate
   // And, then we wait for the transition to sleep mode
@@ -150,7 +170,6 @@ bool LogManager::EndLogging() {
 
 void LogManager::PrepareLogging() {
   if (this->IsInLoggingMode()) {
-    this->GetBackendLogger();
     auto logger = this->GetBackendLogger();
     int frontend_logger_id = logger->GetFrontendLoggerID();
     LOG_TRACE("Got frontend_logger_id as %d", (int)frontend_logger_id);
@@ -176,38 +195,13 @@ void LogManager::LogBeginTransaction(cid_t commit_id) {
 void LogManager::LogUpdate(cid_t commit_id, const ItemPointer &old_version,
                            const ItemPointer &new_version) {
   if (this->IsInLoggingMode()) {
-    auto &manager = catalog::Manager::GetInstance();
-    auto catalog = catalog::Catalog::GetInstance();
-
-    auto new_tuple_tile_group = manager.GetTileGroup(new_version.block);
-
     auto logger = this->GetBackendLogger();
 
-    std::unique_ptr<LogRecord> record;
     std::unique_ptr<storage::Tuple> tuple;
-    auto schema = catalog->GetTableWithOid(
-                               new_tuple_tile_group->GetDatabaseId(),
-                               new_tuple_tile_group->GetTableId())->GetSchema();
-    // Can we avoid allocate tuple in head each time?
-    if (IsBasedOnWriteAheadLogging(logging_type_) || replicating_) {
-      tuple.reset(new storage::Tuple(schema, true));
-      for (oid_t col = 0; col < schema->GetColumnCount(); col++) {
-        tuple->SetValue(col,
-                        new_tuple_tile_group->GetValue(new_version.offset, col),
-                        logger->GetVarlenPool());
-      }
-      record.reset(
-          logger->GetTupleRecord(LOGRECORD_TYPE_TUPLE_UPDATE, commit_id,
-                                 new_tuple_tile_group->GetTableId(),
-                                 new_tuple_tile_group->GetDatabaseId(),
-                                 new_version, old_version, tuple.get()));
-    } else {
-      // if wbl without replication, do not include tuple data
-      record.reset(logger->GetTupleRecord(
-          LOGRECORD_TYPE_TUPLE_UPDATE, commit_id,
-          new_tuple_tile_group->GetTableId(),
-          new_tuple_tile_group->GetDatabaseId(), new_version, old_version));
-    }
+    std::unique_ptr<LogRecord> record(BuildTupleRecord(
+        logger, commit_id,
+        LogWrite(LOGRECORD_TYPE_TUPLE_UPDATE, old_version, new_version),
+        tuple));
 
     logger->Log(record.get());
   }
@@ -216,37 +210,14 @@ void LogManager::LogUpdate(cid_t commit_id, const ItemPointer &old_version,
 void LogManager::LogInsert(cid_t commit_id, const ItemPointer &new_location) {
   if (this->IsInLoggingMode()) {
     auto logger = this->GetBackendLogger();
-    auto &manager = catalog::Manager::GetInstance();
-    auto catalog = catalog::Catalog::GetInstance();
-
-    auto new_tuple_tile_group = manager.GetTileGroup(new_location.block);
 
-    auto tile_group = manager.GetTileGroup(new_location.block);
-    std::unique_ptr<LogRecord> record;
     std::unique_ptr<storage::Tuple> tuple;
-    if (IsBasedOnWriteAheadLogging(logging_type_)) {
-      auto schema =
-          catalog->GetTableWithOid(tile_group->GetDatabaseId(),
-                                   tile_group->GetTableId())->GetSchema();
-      tuple.reset(new storage::Tuple(schema, true));
-      for (oid_t col = 0; col < schema->GetColumnCount(); col++) {
-        tuple->SetValue(
-            col, new_tuple_tile_group->GetValue(new_location.offset, col),
-            logger->GetVarlenPool());
-      }
-
-      record.reset(logger->GetTupleRecord(
-          LOGRECORD_TYPE_TUPLE_INSERT, commit_id, tile_group->GetTableId(),
-          new_tuple_tile_group->GetDatabaseId(), new_location,
-          INVALID_ITEMPOINTER, tuple.get()));
+    std::unique_ptr<LogRecord> record(BuildTupleRecord(
+        logger, commit_id,
+        LogWrite(LOGRECORD_TYPE_TUPLE_INSERT, INVALID_ITEMPOINTER,
+                 new_location),
+        tuple));
 
-    } else {
-      // do not construct the tuple for the wbl case
-      record.reset(logger->GetTupleRecord(LOGRECORD_TYPE_TUPLE_INSERT,
-                                          commit_id, tile_group->GetTableId(),
-                                          new_tuple_tile_group->GetDatabaseId(),
-                                          new_location, INVALID_ITEMPOINTER));
-    }
     logger->Log(record.get());
   }
 }
@@ -255,12 +226,13 @@ void LogManager::LogDelete(cid_t commit_id,
                            const ItemPointer &delete_location) {
   if (this->IsInLoggingMode()) {
     auto logger = this->GetBackendLogger();
-    auto &manager = catalog::Manager::GetInstance();
-    auto tile_group = manager.GetTileGroup(delete_location.block);
 
-    std::unique_ptr<LogRecord> record(logger->GetTupleRecord(
-        LOGRECORD_TYPE_TUPLE_DELETE, commit_id, tile_group->GetTableId(),
-        tile_group->GetDatabaseId(), INVALID_ITEMPOINTER, delete_location));
+    std::unique_ptr<storage::Tuple> tuple;
+    std::unique_ptr<LogRecord> record(BuildTupleRecord(
+        logger, commit_id,
+        LogWrite(LOGRECORD_TYPE_TUPLE_DELETE, delete_location,
+                 INVALID_ITEMPOINTER),
+        tuple));
 
     logger->Log(record.get());
   }
@@ -270,14 +242,247 @@ void LogManager::LogCommitTransaction(cid_t commit_id) {
   if (this->IsInLoggingMode()) {
     auto logger = this->GetBackendLogger();
     TransactionRecord record(LOGRECORD_TYPE_TRANSACTION_COMMIT, commit_id);
+    // counted as a waiter before the frontend loggers can collect the commit,
+    // so that they do not defer its flush
+    if (syncronization_commit) {
+      flush_waiter_count_++;
+    }
     logger->Log(&record);
     if (syncronization_commit) {
-      WaitForFlush(commit_id);
+      AwaitFlush(commit_id);
+      flush_waiter_count_--;
     }
     logger->GetVarlenPool()->Purge();
   }
 }
 
+// the records of the transaction reach the log buffer under a single
+// acquisition of its lock.
+bool LogManager::LogTransaction(cid_t commit_id,
+                                const std::vector<LogWrite> &writes,
+                                bool sync_commit) {
+  if (this->IsInLoggingMode() == false || writes.empty() == true) {
+    DoneLogging();
+    ReleaseDirtyTileGroups(commit_id);
+    return true;
+  }
+
+  auto logger = this->GetBackendLogger();
+  bool logged = true;
+
+  // a synchronous committer is counted as a waiter before the frontend
+  // loggers can collect its commit, so that they do not defer its flush
+  bool wait_for_flush = syncronization_commit && sync_commit;
+  if (wait_for_flush) {
+    flush_waiter_count_++;
+  }
+
+  if (IsBasedOnWriteBehindLogging(logging_type_)) {
+    // a commit path that did not register the tile groups it wrote leaves
+    // the dirty map incomplete until the commit is persistent
+    if (dirty_tile_groups.empty() == true) {
+      auto frontend_logger = reinterpret_cast<WriteBehindFrontendLogger *>(
+          frontend_loggers[logger->GetFrontendLoggerID()].get());
+      frontend_logger->ReportUnregisteredCommit(commit_id);
+    }
+
+    // the write behind log carries no tuple data, its records are staged in
+    // the record pool of the backend logger
+    static_cast<WriteBehindBackendLogger *>(logger)->LogTransaction(commit_id,
+                                                                    writes);
+  } else {
+    std::vector<std::unique_ptr<LogRecord>> records;
+    std::vector<std::unique_ptr<storage::Tuple>> tuples(writes.size());
+    records.reserve(writes.size() + 2);
+
+    records.emplace_back(
+        new TransactionRecord(LOGRECORD_TYPE_TRANSACTION_BEGIN, commit_id));
+    for (size_t write_itr = 0; write_itr < writes.size(); ++write_itr) {
+      records.emplace_back(BuildTupleRecord(logger, commit_id,
+                                            writes[write_itr],
+                                            tuples[write_itr]));
+    }
+    records.emplace_back(
+        new TransactionRecord(LOGRECORD_TYPE_TRANSACTION_COMMIT, commit_id));
+
+    logged = logger->Log(records);
+  }
+  ReleaseDirtyTileGroups(commit_id);
+
+  if (logged == false) {
+    // the records logged so far have no commit record, recovery skips them.
+    // the frontend logger no longer waits for this transaction.
+    LOG_ERROR("Failed to log transaction %lu", commit_id);
+    DoneLogging();
+  } else if (wait_for_flush) {
+    // an asynchronous commit is made durable by the frontend loggers within
+    // the maximum commit lag
+    logged = AwaitFlush(commit_id);
+  }
+  if (wait_for_flush) {
+    flush_waiter_count_--;
+  }
+  logger->GetVarlenPool()->Purge();
+
+  return logged;
+}
+
+void LogManager::RegisterDirtyTileGroups(concurrency::Transaction *txn) {
+  if (this->IsInLoggingMode() == false ||
+      IsBasedOnWriteBehindLogging(logging_type_) == false) {
+    return;
+  }
+
+  // a registration the thread did not release
+  ReleaseDirtyTileGroups(INVALID_CID);
+
+  // the tile groups of the written versions, and of the versions the
+  // updates and deletes install
+  auto &manager = catalog::Manager::GetInstance();
+  std::set<oid_t> tile_group_ids;
+  for (auto &tile_group_entry : txn->GetRWSet()) {
+    auto tile_group_header =
+        manager.GetTileGroup(tile_group_entry.first)->GetHeader();
+
+    for (auto &tuple_entry : tile_group_entry.second) {
+      if (tuple_entry.second == concurrency::RW_TYPE_READ) {
+        continue;
+      }
+      tile_group_ids.insert(tile_group_entry.first);
+
+      if (tuple_entry.second == concurrency::RW_TYPE_UPDATE ||
+          tuple_entry.second == concurrency::RW_TYPE_DELETE) {
+        auto new_version =
+            tile_group_header->GetPrevItemPointer(tuple_entry.first);
+        if (new_version.IsNull() == false) {
+          tile_group_ids.insert(new_version.block);
+        }
+      }
+    }
+  }
+
+  if (tile_group_ids.empty() == true) {
+    return;
+  }
+
+  dirty_tile_groups.assign(tile_group_ids.begin(), tile_group_ids.end());
+
+  auto logger = this->GetBackendLogger();
+  auto frontend_logger = reinterpret_cast<WriteBehindFrontendLogger *>(
+      frontend_loggers[logger->GetFrontendLoggerID()].get());
+  frontend_logger->RegisterDirtyTileGroups(dirty_tile_groups);
+}
+
+void LogManager::ReleaseDirtyTileGroups(cid_t commit_id) {
+  if (dirty_tile_groups.empty() == true) {
+    return;
+  }
+
+  if (frontend_loggers.size() != 0 &&
+      IsBasedOnWriteBehindLogging(logging_type_) == true) {
+    auto logger = this->GetBackendLogger();
+    auto frontend_logger = reinterpret_cast<WriteBehindFrontendLogger *>(
+        frontend_loggers[logger->GetFrontendLoggerID()].get());
+    frontend_logger->ReleaseDirtyTileGroups(dirty_tile_groups, commit_id);
+  }
+
+  dirty_tile_groups.clear();
+}
+
+// whether a column of an update keeps its value. values of the types that do
+// not compare count as changed.
+static bool IsSameValue(const Value &old_value, const Value &new_value) {
+  if (old_value.IsNull() || new_value.IsNull()) {
+    return old_value.IsNull() && new_value.IsNull();
+  }
+
+  switch (old_value.GetValueType()) {
+    case VALUE_TYPE_BOOLEAN:
+      return old_value.IsTrue() == new_value.IsTrue();
+    case VALUE_TYPE_TINYINT:
+    case VALUE_TYPE_SMALLINT:
+    case VALUE_TYPE_INTEGER:
+    case VALUE_TYPE_BIGINT:
+    case VALUE_TYPE_DECIMAL:
+    case VALUE_TYPE_DATE:
+    case VALUE_TYPE_TIMESTAMP:
+    case VALUE_TYPE_VARCHAR:
+    case VALUE_TYPE_VARBINARY:
+      return old_value.CompareWithoutNull(new_value) == VALUE_COMPARE_EQUAL;
+    default:
+      // a double may compare equal with another bit pattern (0.0 and -0.0)
+      return false;
+  }
+}
+
+LogRecord *LogManager::BuildTupleRecord(
+    BackendLogger *logger, cid_t commit_id, const LogWrite &write,
+    std::unique_ptr<storage::Tuple> &tuple) {
+  auto &manager = catalog::Manager::GetInstance();
+
+  // a delete only refers to the deleted version
+  if (write.type == LOGRECORD_TYPE_TUPLE_DELETE) {
+    auto tile_group = manager.GetTileGroup(write.old_version.block);
+    return logger->GetTupleRecord(write.type, commit_id,
+                                  tile_group->GetTableId(),
+                                  tile_group->GetDatabaseId(),
+                                  INVALID_ITEMPOINTER, write.old_version);
+  }
+
+  auto tile_group = manager.GetTileGroup(write.new_version.block);
+
+  // wbl does not include the tuple data, unless the log is replicated
+  bool include_data = IsBasedOnWriteAheadLogging(logging_type_);
+  if (write.type == LOGRECORD_TYPE_TUPLE_UPDATE) {
+    include_data = include_data || replicating_;
+  }
+
+  if (include_data == false) {
+    return logger->GetTupleRecord(
+        write.type, commit_id, tile_group->GetTableId(),
+        tile_group->GetDatabaseId(), write.new_version, write.old_version);
+  }
+
+  auto schema = catalog::Catalog::GetInstance()
+                    ->GetTableWithOid(tile_group->GetDatabaseId(),
+                                      tile_group->GetTableId())
+                    ->GetSchema();
+  auto column_count = schema->GetColumnCount();
+  tuple.reset(new storage::Tuple(schema, true));
+
+  // an update of a wal only carries the columns it changed
+  std::vector<oid_t> column_ids;
+  if (write.type == LOGRECORD_TYPE_TUPLE_UPDATE &&
+      IsBasedOnWriteAheadLogging(logging_type_)) {
+    auto old_tile_group = manager.GetTileGroup(write.old_version.block);
+    for (oid_t col = 0; col < column_count; col++) {
+      auto value = tile_group->GetValue(write.new_version.offset, col);
+      if (IsSameValue(old_tile_group->GetValue(write.old_version.offset, col),
+                      value) == false) {
+        tuple->SetValue(col, value, logger->GetVarlenPool());
+        column_ids.push_back(col);
+      }
+    }
+  } else {
+    for (oid_t col = 0; col < column_count; col++) {
+      tuple->SetValue(col, tile_group->GetValue(write.new_version.offset, col),
+                      logger->GetVarlenPool());
+    }
+  }
+
+  auto record = logger->GetTupleRecord(
+      write.type, commit_id, tile_group->GetTableId(),
+      tile_group->GetDatabaseId(), write.new_version, write.old_version,
+      tuple.get());
+
+  // the full image is as small if every column changed
+  if (column_ids.empty() == false && column_ids.size() < column_count) {
+    static_cast<TupleRecord *>(record)->SetColumnIds(column_ids);
+  }
+
+  return record;
+}
+
 /**
  * @brief Return the backend logger based on logging type
     and store it into the vector
@@ -300,6 +505,14 @@ BackendLogger *LogManager::GetBackendLogger(unsigned int hint_idx) {
           backend_logger);
       backend_logger->SetFrontendLoggerID(i % num_frontend_loggers_);
 
+    } else if (logger_mapping_strategy_ == LOGGER_MAPPING_TYPE_AFFINITY) {
+      // the workers of a core share a log stream, and fall back to round
+      // robin if the core is unknown
+      int cpu = sched_getcpu();
+      unsigned int logger_idx = (cpu < 0 ? i : cpu) % num_frontend_loggers_;
+      frontend_loggers[logger_idx].get()->AddBackendLogger(backend_logger);
+      backend_logger->SetFrontendLoggerID(logger_idx);
+
     } else if (logger_mapping_strategy_ == LOGGER_MAPPING_TYPE_MANUAL) {
       // manual mapping with hint
       PL_ASSERT(hint_idx < frontend_loggers.size());
@@ -319,8 +532,10 @@ void LogManager::InitFrontendLoggers() {
   if (frontend_loggers.size() == 0) {
     for (unsigned int i = 0; i < num_frontend_loggers_; i++) {
       std::unique_ptr<FrontendLogger> frontend_logger(
-          FrontendLogger::GetFrontendLogger(logging_type_, test_mode_));
+          FrontendLogger::GetFrontendLogger(logging_type_, test_mode_, i));
       frontend_logger->SetNoWrite(no_write_);
+      frontend_logger->SetDirectIO(direct_io_);
+      frontend_logger->SetIoUring(io_uring_);
 
       if (frontend_logger.get() != nullptr) {
         frontend_loggers.push_back(std::move(frontend_logger));
@@ -423,6 +638,14 @@ void LogManager::DropFrontendLoggers() {
   frontend_loggers.clear();
 }
 
+std::string LogManager::GetLogStreamDirectoryName(unsigned int stream_id) {
+  if (log_stream_directory_names_.empty()) {
+    return log_directory_name;
+  }
+  return log_stream_directory_names_[stream_id %
+                                     log_stream_directory_names_.size()];
+}
+
 void LogManager::TruncateLogs(txn_id_t commit_id) {
   int num_loggers;
 
@@ -430,8 +653,20 @@ void LogManager::TruncateLogs(txn_id_t commit_id) {
 
   for (int i = 0; i < num_loggers; i++) {
     FrontendLogger *frontend_logger = this->frontend_loggers[i].get();
-    reinterpret_cast<WriteAheadFrontendLogger *>(frontend_logger)
-        ->TruncateLog(commit_id);
+    // only the write ahead log is kept in segments
+    if (IsBasedOnWriteAheadLogging(frontend_logger->GetLoggingType()) ==
+        false) {
+      continue;
+    }
+
+    auto wal_frontend_logger =
+        reinterpret_cast<WriteAheadFrontendLogger *>(frontend_logger);
+    if (logging_status == LOGGING_STATUS_TYPE_LOGGING) {
+      // the segments are recycled by the thread that writes them
+      wal_frontend_logger->RequestTruncation(commit_id);
+    } else {
+      wal_frontend_logger->TruncateLog(commit_id);
+    }
   }
 }
 
@@ -469,28 +704,74 @@ cid_t LogManager::GetPersistentFlushedCommitId() {
   return persistent_flushed_commit_id;
 }
 
+cid_t LogManager::UpdatePersistentFlushedCommitId() {
+  cid_t flushed_commit_id = GetPersistentFlushedCommitId();
+
+  // the frontend loggers publish concurrently, keep the highest
+  cid_t published_commit_id = persistent_flushed_commit_id_;
+  while (published_commit_id < flushed_commit_id &&
+         persistent_flushed_commit_id_.compare_exchange_weak(
+             published_commit_id, flushed_commit_id) == false) {
+  }
+
+  return std::max(published_commit_id, flushed_commit_id);
+}
+
 void LogManager::FrontendLoggerFlushed() {
+  UpdatePersistentFlushedCommitId();
   {
     std::unique_lock<std::mutex> wait_lock(flush_notify_mutex);
     flush_notify_cv.notify_all();
   }
 }
 
-void LogManager::WaitForFlush(cid_t cid) {
+bool LogManager::WaitForFlush(cid_t cid) {
+  // a commit that a flush already covers does not wait for the frontend
+  // loggers
+  if (persistent_flushed_commit_id_ >= cid) {
+    return true;
+  }
+
+  flush_waiter_count_++;
+  bool flushed = AwaitFlush(cid);
+  flush_waiter_count_--;
+  return flushed;
+}
+
+bool LogManager::AwaitFlush(cid_t cid) {
   LOG_TRACE("Waiting for flush with %d", (int)cid);
-  {
-    std::unique_lock<std::mutex> wait_lock(flush_notify_mutex);
 
-    while (this->GetPersistentFlushedCommitId() < cid) {
-      LOG_TRACE(
-          "Logs up to %lu cid is flushed. %lu cid is not flushed yet. Wait...",
-          this->GetPersistentFlushedCommitId(), cid);
-      flush_notify_cv.wait(wait_lock);
+  if (persistent_flushed_commit_id_ >= cid) {
+    return true;
+  }
+
+  std::unique_lock<std::mutex> wait_lock(flush_notify_mutex);
+
+  while (persistent_flushed_commit_id_ < cid &&
+         UpdatePersistentFlushedCommitId() < cid) {
+    if (log_failed_) {
+      LOG_ERROR("The log failed before commit id %lu was flushed", cid);
+      return false;
     }
     LOG_TRACE(
-        "Flushes done! Can return! Got persistent flushed commit id as %d",
-        (int)this->GetPersistentFlushedCommitId());
+        "Logs up to %lu cid is flushed. %lu cid is not flushed yet. Wait...",
+        this->GetPersistentFlushedCommitId(), cid);
+    flush_notify_cv.wait(wait_lock);
   }
+  LOG_TRACE("Flushes done! Can return! Got persistent flushed commit id as %d",
+            (int)this->GetPersistentFlushedCommitId());
+  return true;
+}
+
+void LogManager::SetLogFailed() {
+  if (log_failed_.exchange(true)) {
+    return;
+  }
+  LOG_ERROR("A frontend logger failed to write the log");
+
+  // wake the committers up to fail them
+  std::unique_lock<std::mutex> wait_lock(flush_notify_mutex);
+  flush_notify_cv.notify_all();
 }
 
 void LogManager::NotifyRecoveryDone() {
@@ -500,6 +781,11 @@ void LogManager::NotifyRecoveryDone() {
   LOG_TRACE("%d loggers have done recovery so far.",
             (int)recovery_to_logging_counter);
   if (i == num_frontend_loggers_) {
+    if (recovery_failed_) {
+      LOG_ERROR("Recovery failed, terminating the frontend loggers");
+      SetLoggingStatus(LOGGING_STATUS_TYPE_TERMINATE);
+      return;
+    }
     LOG_TRACE(
         "This was the last one! Recover Index and change to LOGGING mode.");
     frontend_loggers[0].get()->RecoverIndex();
@@ -527,5 +813,70 @@ void LogManager::UpdateCatalogAndTxnManagers(oid_t new_oid, cid_t new_cid) {
   }
 }
 
+//===--------------------------------------------------------------------===//
+// Replication
+//===--------------------------------------------------------------------===//
+
+bool LogManager::StartReplication(const std::string &standby_address,
+                                  ReplicationType replication_type) {
+  // the write behind log holds no records to replay
+  if (IsBasedOnWriteAheadLogging(logging_type_) == false) {
+    LOG_ERROR("Only the write ahead log can be replicated");
+    return false;
+  }
+
+  std::lock_guard<std::mutex> replication_lock(replication_mutex_);
+  log_shipper_.reset(new LogShipper(standby_address, replication_type,
+                                    num_frontend_loggers_));
+  replicating_ = true;
+  return true;
+}
+
+void LogManager::StopReplication() {
+  std::lock_guard<std::mutex> replication_lock(replication_mutex_);
+  replicating_ = false;
+  if (log_shipper_ != nullptr) {
+    log_shipper_->Stop();
+    log_shipper_.reset();
+  }
+}
+
+void LogManager::ShipLog(int logger_id, const std::string &log) {
+  std::shared_ptr<LogShipper> log_shipper;
+  {
+    std::lock_guard<std::mutex> replication_lock(replication_mutex_);
+    log_shipper = log_shipper_;
+  }
+
+  if (log_shipper != nullptr) {
+    log_shipper->Ship(logger_id, log);
+  }
+}
+
+void LogManager::AcknowledgeShippedLog(int logger_id,
+                                       int64_t sequence_number) {
+  std::shared_ptr<LogShipper> log_shipper;
+  {
+    std::lock_guard<std::mutex> replication_lock(replication_mutex_);
+    log_shipper = log_shipper_;
+  }
+
+  if (log_shipper != nullptr) {
+    log_shipper->Acknowledge(logger_id, sequence_number);
+  }
+}
+
+LogReplayer &LogManager::GetLogReplayer() {
+  std::lock_guard<std::mutex> replication_lock(replication_mutex_);
+  if (log_replayer_ == nullptr) {
+    log_replayer_.reset(new LogReplayer());
+  }
+  return *log_replayer_;
+}
+
+void LogManager::PromoteStandby() {
+  GetLogReplayer().Promote();
+}
+
 }  // namespace logging
 }  // namespace peloton
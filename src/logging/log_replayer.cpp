@@ -0,0 +1,159 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_replayer.cpp
+//
+// Identification: src/logging/log_replayer.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+
+#include "catalog/manager.h"
+#include "common/logger.h"
+#include "concurrency/transaction_manager_factory.h"
+#include "logging/checkpoint_manager.h"
+#include "logging/log_replayer.h"
+#include "logging/loggers/wal_frontend_logger.h"
+
+namespace peloton {
+namespace logging {
+
+LogReplayer::LogReplayer() {
+  // the standby reads what it recovered until the first batch is replayed
+  replayed_commit_id_ = CheckpointManager::GetInstance().GetRecoveredCid();
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  txn_manager.SetReplayedCid(replayed_commit_id_);
+}
+
+LogReplayer::~LogReplayer() {}
+
+int64_t LogReplayer::Replay(int logger_id, int64_t sequence_number,
+                            const std::string &log, int logger_count) {
+  std::lock_guard<std::mutex> replay_lock(replay_mutex_);
+
+  // a stream that has not shipped yet is at the recovered commit id
+  for (int stream_id = 0; stream_id < logger_count; stream_id++) {
+    log_streams_[stream_id];
+  }
+
+  auto &log_stream = log_streams_[logger_id];
+  if (promoted_) {
+    return log_stream.replayed_sequence_number;
+  }
+
+  if (log_stream.frontend_logger == nullptr) {
+    // the replayed log is not written again
+    log_stream.frontend_logger.reset(
+        new WriteAheadFrontendLogger(true, logger_id));
+    // the standby scans the indexes, and keeps them once it is promoted
+    log_stream.frontend_logger->SetReplayIndexes(true);
+  }
+
+  if (sequence_number <= log_stream.replayed_sequence_number) {
+    LOG_TRACE("Batch %ld of log stream %d is replayed already",
+              sequence_number, logger_id);
+    return log_stream.replayed_sequence_number;
+  }
+
+  if (sequence_number >
+      log_stream.replayed_sequence_number + LOG_REPLAY_MAX_PENDING_BATCHES) {
+    LOG_TRACE("Batch %ld of log stream %d is too far ahead", sequence_number,
+              logger_id);
+    return log_stream.replayed_sequence_number;
+  }
+
+  log_stream.pending_batches[sequence_number] = log;
+
+  // replay the batches that follow the last replayed one
+  auto batch_itr = log_stream.pending_batches.begin();
+  while (batch_itr != log_stream.pending_batches.end() &&
+         batch_itr->first == log_stream.replayed_sequence_number + 1) {
+    auto &batch = batch_itr->second;
+    log_stream.replayed_commit_id =
+        log_stream.frontend_logger->ReplayLog(batch.data(), batch.size());
+    log_stream.replayed_sequence_number = batch_itr->first;
+    batch_itr = log_stream.pending_batches.erase(batch_itr);
+  }
+
+  // publish the new snapshot of the read-only transactions
+  cid_t replayed_commit_id = ComputeReplayedCommitId();
+  if (replayed_commit_id > replayed_commit_id_) {
+    replayed_commit_id_ = replayed_commit_id;
+    auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+    txn_manager.SetReplayedCid(replayed_commit_id_);
+  }
+
+  return log_stream.replayed_sequence_number;
+}
+
+cid_t LogReplayer::GetReplayedCommitId() {
+  std::lock_guard<std::mutex> replay_lock(replay_mutex_);
+  return replayed_commit_id_;
+}
+
+void LogReplayer::Promote() {
+  std::lock_guard<std::mutex> replay_lock(replay_mutex_);
+  if (promoted_) {
+    return;
+  }
+  promoted_ = true;
+
+  oid_t max_oid = 0;
+  cid_t max_cid = 0;
+  for (auto &log_stream_entry : log_streams_) {
+    auto &log_stream = log_stream_entry.second;
+    if (log_stream.frontend_logger == nullptr) {
+      continue;
+    }
+
+    if (log_stream.pending_batches.empty() == false) {
+      LOG_ERROR("Log stream %d misses the batch after %ld",
+                log_stream_entry.first, log_stream.replayed_sequence_number);
+    }
+
+    // the transactions of the batches shipped before the failure
+    log_stream.frontend_logger->AbortActiveTransactions();
+
+    max_oid = std::max(max_oid, log_stream.frontend_logger->GetMaxOid());
+    max_cid = std::max(max_cid, log_stream.frontend_logger->GetMaxCid());
+  }
+
+  auto &manager = catalog::Manager::GetInstance();
+  if (max_oid > manager.GetCurrentOid()) {
+    manager.SetNextOid(max_oid);
+  }
+
+  // new transactions read and commit after every replayed transaction
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  if (max_cid + 1 > txn_manager.GetCurrentCommitId()) {
+    txn_manager.SetNextCid(max_cid + 1);
+  }
+  txn_manager.SetReplayedCid(INVALID_CID);
+
+  LOG_INFO("Promoted the standby at commit id %lu", max_cid);
+}
+
+cid_t LogReplayer::ComputeReplayedCommitId() {
+  cid_t recovered_commit_id =
+      CheckpointManager::GetInstance().GetRecoveredCid();
+
+  cid_t replayed_commit_id = MAX_CID;
+  for (auto &log_stream_entry : log_streams_) {
+    auto &log_stream = log_stream_entry.second;
+    replayed_commit_id =
+        std::min(replayed_commit_id,
+                 std::max(recovered_commit_id, log_stream.replayed_commit_id));
+  }
+
+  if (replayed_commit_id == MAX_CID) {
+    return recovered_commit_id;
+  }
+  return replayed_commit_id;
+}
+
+}  // namespace logging
+}  // namespace peloton
@@ -0,0 +1,199 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_shipper.cpp
+//
+// Identification: src/logging/log_shipper.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>
+
+#include "common/logger.h"
+#include "logging/log_shipper.h"
+#include "networking/rpc_channel.h"
+#include "networking/rpc_controller.h"
+#include "peloton/proto/logging_service.pb.h"
+
+namespace peloton {
+namespace logging {
+
+LogShipper::LogShipper(const std::string &standby_address,
+                       ReplicationType replication_type, int logger_count)
+    : replication_type_(replication_type),
+      logger_count_(logger_count),
+      channel_(new networking::RpcChannel(standby_address)),
+      controller_(new networking::RpcController()),
+      stub_(new networking::PelotonLoggingService_Stub(channel_.get())) {}
+
+LogShipper::~LogShipper() { Stop(); }
+
+void LogShipper::Stop() {
+  {
+    std::lock_guard<std::mutex> ack_lock(ack_mutex_);
+    stopped_ = true;
+  }
+  ack_cv_.notify_all();
+}
+
+void LogShipper::Ship(int logger_id, const std::string &log) {
+  int64_t sequence_number;
+
+  {
+    std::lock_guard<std::mutex> ship_lock(ship_mutex_);
+    if (stopped_) {
+      return;
+    }
+
+    // the batches the standby missed go before the new one
+    ResendBatches(logger_id);
+    if (stopped_) {
+      return;
+    }
+
+    auto &unacknowledged_batches = unacknowledged_batches_[logger_id];
+    if (unacknowledged_batches.size() >=
+        LOG_SHIPPING_MAX_UNACKNOWLEDGED_BATCHES) {
+      LOG_ERROR("The standby has not answered %lu batches of log stream %d",
+                unacknowledged_batches.size(), logger_id);
+      Stop();
+      return;
+    }
+
+    sequence_number = shipped_sequence_numbers_[logger_id] + 1;
+    if (SendBatch(logger_id, sequence_number, log) == false) {
+      Stop();
+      return;
+    }
+
+    shipped_sequence_numbers_[logger_id] = sequence_number;
+    auto &batch = unacknowledged_batches[sequence_number];
+    batch.log = log;
+    batch.sent_time = Clock::now();
+  }
+
+  ReplicationType replication_type = replication_type_;
+  if (replication_type == ASYNC_REPLICATION) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> ack_lock(ack_mutex_);
+  auto replayed = [&] {
+    return stopped_ ||
+           acknowledged_sequence_numbers_[logger_id] >= sequence_number;
+  };
+  auto resend_timeout = std::chrono::microseconds(resend_timeout_micros_);
+
+  if (replication_type == SEMISYNC_REPLICATION) {
+    if (ack_cv_.wait_for(ack_lock, resend_timeout, replayed) == false) {
+      LOG_TRACE("The standby lags behind batch %ld of log stream %d",
+                sequence_number, logger_id);
+    }
+    return;
+  }
+
+  // the batches the standby missed are sent again while it is waited for
+  auto deadline =
+      Clock::now() + std::chrono::microseconds(sync_timeout_micros_);
+  while (ack_cv_.wait_for(ack_lock, resend_timeout, replayed) == false) {
+    if (Clock::now() >= deadline) {
+      LOG_ERROR("The standby did not replay batch %ld of log stream %d, "
+                "shipping the log asynchronously",
+                sequence_number, logger_id);
+      replication_type_ = ASYNC_REPLICATION;
+      return;
+    }
+
+    ack_lock.unlock();
+    {
+      std::lock_guard<std::mutex> ship_lock(ship_mutex_);
+      if (stopped_ == false) {
+        ResendBatches(logger_id);
+      }
+    }
+    ack_lock.lock();
+  }
+}
+
+bool LogShipper::SendBatch(int logger_id, int64_t sequence_number,
+                           const std::string &log) {
+  networking::LogRecordReplayRequest request;
+  networking::LogRecordReplayResponse response;
+  request.set_log(log);
+  switch (replication_type_) {
+    case SYNC_REPLICATION:
+      request.set_sync_type(networking::SYNC);
+      break;
+    case SEMISYNC_REPLICATION:
+      request.set_sync_type(networking::SEMISYNC);
+      break;
+    default:
+      request.set_sync_type(networking::ASYNC);
+      break;
+  }
+  request.set_sequence_number(sequence_number);
+  request.set_logger_id(logger_id);
+  request.set_logger_count(logger_count_);
+
+  // the response is handled by the logging service of the rpc server
+  controller_->Reset();
+  stub_->LogRecordReplay(controller_.get(), &request, &response, NULL);
+  if (controller_->Failed()) {
+    LOG_ERROR("Unable to ship the log to the standby: %s",
+              controller_->ErrorText().c_str());
+    return false;
+  }
+  return true;
+}
+
+void LogShipper::ResendBatches(int logger_id) {
+  int64_t acknowledged = GetAcknowledgedSequenceNumber(logger_id);
+  auto &unacknowledged_batches = unacknowledged_batches_[logger_id];
+  unacknowledged_batches.erase(
+      unacknowledged_batches.begin(),
+      unacknowledged_batches.upper_bound(acknowledged));
+
+  auto now = Clock::now();
+  auto resend_timeout = std::chrono::microseconds(resend_timeout_micros_);
+  for (auto &batch_entry : unacknowledged_batches) {
+    auto &batch = batch_entry.second;
+    if (now - batch.sent_time < resend_timeout) {
+      continue;
+    }
+
+    LOG_TRACE("Sending batch %ld of log stream %d again", batch_entry.first,
+              logger_id);
+    if (SendBatch(logger_id, batch_entry.first, batch.log) == false) {
+      Stop();
+      return;
+    }
+    batch.sent_time = now;
+  }
+}
+
+void LogShipper::Acknowledge(int logger_id, int64_t sequence_number) {
+  {
+    std::lock_guard<std::mutex> ack_lock(ack_mutex_);
+    auto &acknowledged = acknowledged_sequence_numbers_[logger_id];
+    if (sequence_number > acknowledged) {
+      acknowledged = sequence_number;
+    }
+  }
+  ack_cv_.notify_all();
+}
+
+int64_t LogShipper::GetShippedSequenceNumber(int logger_id) {
+  std::lock_guard<std::mutex> ship_lock(ship_mutex_);
+  return shipped_sequence_numbers_[logger_id];
+}
+
+int64_t LogShipper::GetAcknowledgedSequenceNumber(int logger_id) {
+  std::lock_guard<std::mutex> ack_lock(ack_mutex_);
+  return acknowledged_sequence_numbers_[logger_id];
+}
+
+}  // namespace logging
+}  // namespace peloton
@@ -15,6 +15,8 @@
 #include <sys/mman.h>
 #include <algorithm>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "catalog/catalog.h"
 #include "catalog/manager.h"
@@ -25,6 +27,7 @@
 #include "concurrency/transaction_manager.h"
 
 #include "logging/log_manager.h"
+#include "logging/log_shipper.h"
 #include "logging/records/transaction_record.h"
 #include "logging/records/tuple_record.h"
 #include "logging/loggers/wal_frontend_logger.h"
@@ -36,13 +39,13 @@
 #include "storage/database.h"
 #include "storage/data_table.h"
 #include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
 #include "storage/tuple.h"
 #include "common/logger.h"
 #include "index/index.h"
 #include "executor/executor_context.h"
 #include "planner/seq_scan_plan.h"
-
-int logger_id_counter = 0;
+#include "murmur3/MurmurHash3.h"
 
 //#define LOG_FILE_SWITCH_LIMIT (1024)
 
@@ -59,8 +62,10 @@ WriteAheadFrontendLogger::WriteAheadFrontendLogger()
 /**
  * @brief Open logfile and file descriptor
  */
-WriteAheadFrontendLogger::WriteAheadFrontendLogger(bool for_testing) {
+WriteAheadFrontendLogger::WriteAheadFrontendLogger(bool for_testing,
+                                                   int logger_id) {
   test_mode_ = for_testing;
+  SetLoggerID(logger_id);
   logging_type = LOGGING_TYPE_NVM_WAL;
 
   // allocate pool
@@ -84,7 +89,6 @@ WriteAheadFrontendLogger::WriteAheadFrontendLogger(std::string log_dir)
 }
 
 void WriteAheadFrontendLogger::InitSelf() {
-  SetLoggerID(__sync_fetch_and_add(&logger_id_counter, 1));
   InitLogDirectory();
   InitLogFilesList();
   UpdateMaxDelimiterForRecovery();
@@ -98,6 +102,16 @@ void WriteAheadFrontendLogger::InitSelf() {
  * @brief close logfile
  */
 WriteAheadFrontendLogger::~WriteAheadFrontendLogger() {
+  // close the segment written with direct i/o
+  if (direct_io_ && cur_file_handle.file == nullptr &&
+      cur_file_handle.fd != -1) {
+    SyncLogFile();
+    ReapLogFlushes(true);
+    if (close(cur_file_handle.fd) != 0) {
+      LOG_ERROR("Error occured while closing LogFile");
+    }
+  }
+
   // close the log file
   if (cur_file_handle.file != nullptr) {
     int ret = fclose(cur_file_handle.file);
@@ -109,12 +123,20 @@ WriteAheadFrontendLogger::~WriteAheadFrontendLogger() {
   for (auto log_file : log_files_) delete log_file;
   // clean up pool
   delete recovery_pool;
+
+  free(direct_buffer_);
 }
 
 /**
  * @brief flush all the log records to the file
  */
 void WriteAheadFrontendLogger::FlushLogRecords(void) {
+  // recycle the segments the latest checkpoint covers
+  cid_t truncate_commit_id = truncate_commit_id_.exchange(INVALID_CID);
+  if (truncate_commit_id != INVALID_CID) {
+    TruncateLog(truncate_commit_id);
+  }
+
   size_t global_queue_size = global_queue.size();
 
   bool will_write_to_file;
@@ -136,14 +158,27 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
                                   this->max_collected_commit_id);
   delimiter_rec.Serialize(output_buffer);
 
+  auto &log_manager = LogManager::GetInstance();
+  bool replicating = log_manager.IsReplicating();
+
   // First, write all the record in the queue
   for (oid_t global_queue_itr = 0; global_queue_itr < global_queue_size;
        global_queue_itr++) {
     auto &log_buffer = global_queue[global_queue_itr];
 
     if (!test_mode_ && !no_write_) {
-      fwrite(log_buffer->GetData(), sizeof(char), log_buffer->GetSize(),
-             cur_file_handle.file);
+      WriteLogFile(log_buffer->GetData(), log_buffer->GetSize());
+    }
+
+    if (replicating) {
+      // a batch holds whole log buffers, and so whole records
+      if (shipped_log_.empty() == false &&
+          shipped_log_.size() + log_buffer->GetSize() >
+              LOG_SHIPPING_BATCH_SIZE) {
+        log_manager.ShipLog(logger_id, shipped_log_);
+        shipped_log_.clear();
+      }
+      shipped_log_.append(log_buffer->GetData(), log_buffer->GetSize());
     }
 
     LOG_TRACE("Log buffer get max log id returned %d",
@@ -160,32 +195,65 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
     backend_logger->GrantEmptyBuffer(std::move(log_buffer));
   }
 
+  // ship the records, and the delimiter of the commits they complete, to the
+  // standby. a synchronous standby has replayed them once this returns.
+  if (replicating) {
+    // a deferred flush ships no delimiter again
+    if (max_collected_commit_id != max_flushed_commit_id &&
+        max_collected_commit_id != max_shipped_delimiter_) {
+      shipped_log_.append(delimiter_rec.GetMessage(),
+                          delimiter_rec.GetMessageLength());
+      max_shipped_delimiter_ = max_collected_commit_id;
+    }
+    if (shipped_log_.empty() == false) {
+      log_manager.ShipLog(logger_id, shipped_log_);
+      shipped_log_.clear();
+    }
+  }
+
   bool flushed = false;
 
   if (max_collected_commit_id != max_flushed_commit_id) {
     if (!test_mode_) {
       PL_ASSERT(cur_file_handle.fd != -1);
       if (cur_file_handle.fd != -1) {
-        if (!no_write_) {
-          fwrite(delimiter_rec.GetMessage(), sizeof(char),
-                 delimiter_rec.GetMessageLength(), cur_file_handle.file);
+        // a deferred flush writes no delimiter again, unless the log moved
+        // on to a new file since
+        if (max_collected_commit_id != max_written_delimiter_) {
+          if (!no_write_) {
+            WriteLogFile(delimiter_rec.GetMessage(),
+                         delimiter_rec.GetMessageLength());
+          }
+          max_written_delimiter_ = max_collected_commit_id;
+          LOG_TRACE("Wrote delimiter to log file with commit_id %ld",
+                    this->max_collected_commit_id);
         }
-        LOG_TRACE("Wrote delimiter to log file with commit_id %ld",
-                  this->max_collected_commit_id);
 
         // by moving the fflush and sync here, we ensure that this file will
-        // have at least 1 delimiter
-        if (Clock::now() > last_flush + flush_frequency) {
-          if (!no_write_) {
-            LoggingUtil::FFlushFsync(cur_file_handle);
+        // have at least 1 delimiter. a flush in flight may already cover the
+        // delimiter.
+        bool flush_pending = (pending_flushes_.empty() == false &&
+                              pending_flushes_.back().second ==
+                                  max_collected_commit_id);
+        if (flush_pending == false && IsFlushDue()) {
+          // the flushed commit id does not rise past a failed sync
+          if (!no_write_ && SyncLogFile() == false) {
+            log_manager.SetLogFailed();
           }
           last_flush = Clock::now();
-          if (this->max_collected_commit_id > max_flushed_commit_id) {
-            max_flushed_commit_id = this->max_collected_commit_id;
+          if (async_writer_ != nullptr && !no_write_) {
+            // the flush completes while the next records are collected
+            pending_flushes_.emplace_back(async_writer_->GetLastTicket(),
+                                          this->max_collected_commit_id);
+          } else {
+            if (this->max_collected_commit_id > max_flushed_commit_id &&
+                log_manager.IsLogFailed() == false) {
+              max_flushed_commit_id = this->max_collected_commit_id;
+            }
+            flushed = true;
           }
 
           fsync_count++;
-          flushed = true;
         }
 
         if (this->max_collected_commit_id > max_delimiter_file) {
@@ -196,9 +264,11 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
         if (FileSwitchCondIsTrue()) should_create_new_file = true;
       }
     } else {
-      if (Clock::now() > last_flush + flush_frequency) {
+      // the test mode defers the flush of asynchronous commits as well
+      if (IsFlushDue()) {
         last_flush = Clock::now();
-        if (this->max_collected_commit_id > max_flushed_commit_id) {
+        if (this->max_collected_commit_id > max_flushed_commit_id &&
+            log_manager.IsLogFailed() == false) {
           max_flushed_commit_id = this->max_collected_commit_id;
         }
 
@@ -207,13 +277,20 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
     }
   }
 
+  // wait for the flushes in flight before the logger stops
+  bool stopping = (log_manager.GetLoggingStatus() !=
+                   LOGGING_STATUS_TYPE_LOGGING);
+  if (ReapLogFlushes(stopping)) {
+    flushed = true;
+  }
+
   /* For now, fflush after every iteration of collecting buffers */
   // Clean up the frontend logger's queue
   global_queue.clear();
 
   if (flushed) {
     // signal that we have flushed
-    LogManager::GetInstance().FrontendLoggerFlushed();
+    log_manager.FrontendLoggerFlushed();
   }
 }
 
@@ -225,160 +302,368 @@ void WriteAheadFrontendLogger::FlushLogRecords(void) {
  * @brief Recovery system based on log file
  */
 void WriteAheadFrontendLogger::DoRecovery() {
+  auto &frontend_loggers = LogManager::GetInstance().GetFrontendLoggersList();
+  std::vector<WriteAheadFrontendLogger *> streams;
+  bool is_managed = false;
+  for (auto &frontend_logger : frontend_loggers) {
+    if (frontend_logger.get() == this) {
+      is_managed = true;
+    }
+  }
+
+  if (is_managed == false) {
+    streams.push_back(this);
+  } else if (frontend_loggers[0].get() == this) {
+    for (auto &frontend_logger : frontend_loggers) {
+      streams.push_back(
+          reinterpret_cast<WriteAheadFrontendLogger *>(frontend_logger.get()));
+    }
+  } else {
+    // the first frontend logger replays this stream
+    return;
+  }
+
+  RecoverStreams(streams);
+}
+
+/**
+ * @brief Merge the log streams in commit id order. A transaction may update
+ * a tuple that a transaction of another stream inserted, so no stream can be
+ * replayed on its own. A stream only holds commits past a delimiter after
+ * it, so the commits up to the lowest delimiter read from the streams that
+ * have not ended can be replayed.
+ */
+void WriteAheadFrontendLogger::RecoverStreams(
+    const std::vector<WriteAheadFrontendLogger *> &streams) {
   // FIXME GetNextCommitId() increments next_cid!!!
   cid_t start_commit_id = CheckpointManager::GetInstance().GetRecoveredCid();
   auto &log_manager = logging::LogManager::GetInstance();
-  int num_inserts = 0;
-  cid_t global_max_flushed_id_for_recovery;
-  log_file_cursor_ = 0;
-
-  global_max_flushed_id_for_recovery =
+  cid_t global_max_flushed_id_for_recovery =
       log_manager.GetGlobalMaxFlushedIdForRecovery();
   LOG_TRACE("Got start_commit_id as %d, global max flushed as %d",
             (int)start_commit_id, (int)global_max_flushed_id_for_recovery);
 
+  bool failed = false;
+  std::vector<bool> ended(streams.size(), false);
+  for (auto stream : streams) {
+    if (stream->OpenLogForRecovery(start_commit_id) == false) {
+      failed = true;
+      break;
+    }
+  }
+
+  while (failed == false) {
+    // read ahead the streams that hold back the replay
+    cid_t lowest_delimiter = MAX_CID;
+    for (size_t stream_itr = 0; stream_itr < streams.size(); stream_itr++) {
+      if (ended[stream_itr] == false) {
+        lowest_delimiter = std::min(
+            lowest_delimiter, streams[stream_itr]->max_replayed_delimiter_);
+      }
+    }
+    if (lowest_delimiter == MAX_CID) {
+      break;
+    }
+
+    for (size_t stream_itr = 0; stream_itr < streams.size(); stream_itr++) {
+      auto stream = streams[stream_itr];
+      if (ended[stream_itr] == false &&
+          stream->max_replayed_delimiter_ == lowest_delimiter) {
+        ended[stream_itr] = (stream->ReadRecoveryEpoch(
+                                 start_commit_id,
+                                 global_max_flushed_id_for_recovery) == false);
+      }
+    }
+
+    cid_t replayable_commit_id = MAX_CID;
+    for (size_t stream_itr = 0; stream_itr < streams.size(); stream_itr++) {
+      if (ended[stream_itr] == false) {
+        replayable_commit_id = std::min(
+            replayable_commit_id, streams[stream_itr]->max_replayed_delimiter_);
+      }
+    }
+
+    // replay the commits no stream can precede any more, oldest first
+    while (failed == false) {
+      WriteAheadFrontendLogger *next_stream = nullptr;
+      for (auto stream : streams) {
+        if (stream->recovered_commits_.empty() == false &&
+            *stream->recovered_commits_.begin() <= replayable_commit_id &&
+            (next_stream == nullptr ||
+             *stream->recovered_commits_.begin() <
+                 *next_stream->recovered_commits_.begin())) {
+          next_stream = stream;
+        }
+      }
+      if (next_stream == nullptr) {
+        break;
+      }
+
+      cid_t commit_id = *next_stream->recovered_commits_.begin();
+      next_stream->recovered_commits_.erase(
+          next_stream->recovered_commits_.begin());
+      if (next_stream->CommitTransactionRecovery(commit_id) == false) {
+        log_manager.SetRecoveryFailed();
+        failed = true;
+      }
+    }
+  }
+
+  for (auto stream : streams) {
+    // Finally, abort ACTIVE transactions in recovery_txn_table
+    stream->recovered_commits_.clear();
+    stream->AbortActiveTransactions();
+
+    // After finishing recovery, set the next oid with maximum oid
+    // observed during the recovery
+    if (failed == false) {
+      log_manager.UpdateCatalogAndTxnManagers(stream->max_oid,
+                                              stream->max_cid);
+    }
+
+    stream->cur_file_handle = INVALID_FILE_HANDLE;
+  }
+}
+
+bool WriteAheadFrontendLogger::OpenLogForRecovery(cid_t start_commit_id) {
+  log_file_cursor_ = 0;
+
+  // the commits between the checkpoint and the truncation are gone
+  if (start_commit_id < manifest_commit_id_) {
+    LOG_ERROR("The log before segment %d was truncated up to commit id %lu, "
+              "but the checkpoint only covers commit id %lu",
+              manifest_start_segment_, manifest_commit_id_, start_commit_id);
+    LogManager::GetInstance().SetRecoveryFailed();
+    return false;
+  }
+  RemoveTruncatedSegments();
+
+  // the segments the checkpoint covers hold no commit to replay
+  while (log_file_cursor_ < (int)log_files_.size() &&
+         log_files_[log_file_cursor_]->GetMaxLogId() <= start_commit_id) {
+    LOG_TRACE("Skip log file %d",
+              log_files_[log_file_cursor_]->GetLogNumber());
+    log_file_cursor_++;
+  }
+
   // open first file
   OpenNextLogFile();
+  return true;
+}
 
-  // Go over the log file if needed
-  bool reached_end_of_log = false;
+bool WriteAheadFrontendLogger::ReadRecoveryEpoch(cid_t start_commit_id,
+                                                 cid_t max_commit_id) {
+  cid_t delimiter = max_replayed_delimiter_;
 
   // Go over each log record in the log file
-  while (reached_end_of_log == false) {
+  while (max_replayed_delimiter_ == delimiter) {
     // Read the first byte to identify log record type
     // If that is not possible, then wrap up recovery
     auto record_type = GetNextLogRecordTypeForRecovery();
-    cid_t log_id = INVALID_CID;
-    TupleRecord *tuple_record;
+    if (IsReplayedLogRecordType(record_type) == false) {
+      return false;
+    }
 
-    switch (record_type) {
-      case LOGRECORD_TYPE_TRANSACTION_BEGIN:
-      case LOGRECORD_TYPE_TRANSACTION_COMMIT:
-      case LOGRECORD_TYPE_ITERATION_DELIMITER: {
-        // Check for torn log write
-        TransactionRecord txn_rec(record_type);
-        if (LoggingUtil::ReadTransactionRecordHeader(
-                txn_rec, cur_file_handle) == false) {
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
-        }
-        log_id = txn_rec.GetTransactionId();
-        if (log_id <= start_commit_id ||
-            log_id > global_max_flushed_id_for_recovery) {
-          LOG_TRACE("SKIP");
-          continue;
-        }
-        break;
+    // Check for torn log write
+    if (ReplayLogRecord(record_type, cur_file_handle, start_commit_id,
+                        max_commit_id, &recovered_commits_) == false) {
+      cur_file_handle = INVALID_FILE_HANDLE;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool WriteAheadFrontendLogger::IsReplayedLogRecordType(
+    LogRecordType record_type) {
+  switch (record_type) {
+    case LOGRECORD_TYPE_TRANSACTION_BEGIN:
+    case LOGRECORD_TYPE_TRANSACTION_COMMIT:
+    case LOGRECORD_TYPE_ITERATION_DELIMITER:
+    case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
+    case LOGRECORD_TYPE_WAL_TUPLE_UPDATE:
+    case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * @brief Read the record of the given type off the file, and replay the
+ * transaction it commits. Records outside the commit id range are skipped.
+ * @return false if the record is torn
+ */
+bool WriteAheadFrontendLogger::ReplayLogRecord(LogRecordType record_type,
+                                               FileHandle &file_handle,
+                                               cid_t start_commit_id,
+                                               cid_t max_commit_id,
+                                               std::set<cid_t> *committed) {
+  cid_t log_id = INVALID_CID;
+  TupleRecord *tuple_record = nullptr;
+
+  switch (record_type) {
+    case LOGRECORD_TYPE_TRANSACTION_BEGIN:
+    case LOGRECORD_TYPE_TRANSACTION_COMMIT:
+    case LOGRECORD_TYPE_ITERATION_DELIMITER: {
+      TransactionRecord txn_rec(record_type);
+      if (LoggingUtil::ReadTransactionRecordHeader(txn_rec, file_handle) ==
+          false) {
+        return false;
+      }
+      log_id = txn_rec.GetTransactionId();
+      if (log_id <= start_commit_id || log_id > max_commit_id) {
+        LOG_TRACE("SKIP");
+        return true;
+      }
+      break;
+    }
+    case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
+    case LOGRECORD_TYPE_WAL_TUPLE_UPDATE: {
+      tuple_record = new TupleRecord(record_type);
+      if (LoggingUtil::ReadTupleRecordHeader(*tuple_record, file_handle) ==
+          false) {
+        LOG_ERROR("Could not read tuple record header.");
+        delete tuple_record;
+        return false;
       }
-      case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
-      case LOGRECORD_TYPE_WAL_TUPLE_UPDATE: {
-        tuple_record = new TupleRecord(record_type);
-        // Check for torn log write
-        if (LoggingUtil::ReadTupleRecordHeader(*tuple_record,
-                                               cur_file_handle) == false) {
-          LOG_ERROR("Could not read tuple record header.");
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
-        }
 
-        log_id = tuple_record->GetTransactionId();
-        auto table = LoggingUtil::GetTable(*tuple_record);
+      log_id = tuple_record->GetTransactionId();
+      auto table = LoggingUtil::GetTable(*tuple_record);
 
-        if (!table || log_id <= start_commit_id ||
-            log_id > global_max_flushed_id_for_recovery) {
-          LoggingUtil::SkipTupleRecordBody(cur_file_handle);
-          LOG_TRACE("Skip a tuple, log id is %d", (int)log_id);
-          delete tuple_record;
-          continue;
-        }
+      if (!table || log_id <= start_commit_id || log_id > max_commit_id) {
+        LoggingUtil::SkipTupleRecordBody(file_handle);
+        LOG_TRACE("Skip a tuple, log id is %d", (int)log_id);
+        delete tuple_record;
+        return true;
+      }
 
-        if (recovery_txn_table.find(log_id) == recovery_txn_table.end()) {
-          LOG_ERROR("Insert txd id %d not found in recovery txn table",
-                    (int)log_id);
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
-        }
+      if (recovery_txn_table.find(log_id) == recovery_txn_table.end()) {
+        LOG_ERROR("Insert txd id %d not found in recovery txn table",
+                  (int)log_id);
+        delete tuple_record;
+        return false;
+      }
 
-        // Read off the tuple record body from the log
-        tuple_record->SetTuple(LoggingUtil::ReadTupleRecordBody(
-            table->GetSchema(), recovery_pool, cur_file_handle));
-        num_inserts++;
-        break;
+      // Read off the tuple record body from the log
+      tuple_record->SetTuple(LoggingUtil::ReadTupleRecordBody(
+          *tuple_record, table->GetSchema(), recovery_pool, file_handle));
+      break;
+    }
+    case LOGRECORD_TYPE_WAL_TUPLE_DELETE: {
+      tuple_record = new TupleRecord(record_type);
+      if (LoggingUtil::ReadTupleRecordHeader(*tuple_record, file_handle) ==
+          false) {
+        delete tuple_record;
+        return false;
       }
-      case LOGRECORD_TYPE_WAL_TUPLE_DELETE: {
-        tuple_record = new TupleRecord(record_type);
-        // Check for torn log write
-        if (LoggingUtil::ReadTupleRecordHeader(*tuple_record,
-                                               cur_file_handle) == false) {
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
-        }
 
-        log_id = tuple_record->GetTransactionId();
-        if (log_id <= start_commit_id ||
-            log_id > global_max_flushed_id_for_recovery) {
-          delete tuple_record;
-          continue;
-        }
-        if (recovery_txn_table.find(log_id) == recovery_txn_table.end()) {
-          LOG_TRACE("Delete txd id %d not found in recovery txn table",
-                    (int)log_id);
-          cur_file_handle = INVALID_FILE_HANDLE;
-          return;
-        }
-        break;
+      log_id = tuple_record->GetTransactionId();
+      if (log_id <= start_commit_id || log_id > max_commit_id) {
+        delete tuple_record;
+        return true;
       }
-      default:
-        reached_end_of_log = true;
-        break;
+      if (recovery_txn_table.find(log_id) == recovery_txn_table.end()) {
+        LOG_TRACE("Delete txd id %d not found in recovery txn table",
+                  (int)log_id);
+        delete tuple_record;
+        return false;
+      }
+      break;
     }
-    if (!reached_end_of_log) {
-      switch (record_type) {
-        case LOGRECORD_TYPE_TRANSACTION_BEGIN:
-          PL_ASSERT(log_id != INVALID_CID);
-          StartTransactionRecovery(log_id);
-          break;
-
-        case LOGRECORD_TYPE_TRANSACTION_COMMIT:
-          PL_ASSERT(log_id != INVALID_CID);
-
-          // Now directly commit this transaction. This is safe because we
-          // reject commit ids that appear
-          // after the persistent commit id before coming here (in the switch
-          // case above).
-          CommitTransactionRecovery(log_id);
-          break;
-
-        case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
-        case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
-        case LOGRECORD_TYPE_WAL_TUPLE_UPDATE:
-          recovery_txn_table[tuple_record->GetTransactionId()]
-              .push_back(tuple_record);
-          break;
-        case LOGRECORD_TYPE_ITERATION_DELIMITER: {
-          // Do nothing if we hit the delimiter, because the delimiters help
-          // us only to find
-          // the max persistent commit id, and should be ignored during actual
-          // recovery
-          break;
-        }
+    default:
+      return false;
+  }
+
+  switch (record_type) {
+    case LOGRECORD_TYPE_TRANSACTION_BEGIN:
+      PL_ASSERT(log_id != INVALID_CID);
+      StartTransactionRecovery(log_id);
+      break;
+
+    case LOGRECORD_TYPE_TRANSACTION_COMMIT:
+      PL_ASSERT(log_id != INVALID_CID);
 
-        default:
-          reached_end_of_log = true;
-          break;
+      // the caller replays the transaction in commit id order
+      if (committed != nullptr) {
+        committed->insert(log_id);
+        break;
+      }
+
+      // Now directly commit this transaction. This is safe because we
+      // reject commit ids that appear
+      // after the persistent commit id before coming here (in the switch
+      // case above).
+      if (CommitTransactionRecovery(log_id) == false) {
+        LogManager::GetInstance().SetRecoveryFailed();
+        return false;
       }
+      break;
+
+    case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
+    case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
+    case LOGRECORD_TYPE_WAL_TUPLE_UPDATE:
+      recovery_txn_table[tuple_record->GetTransactionId()]
+          .push_back(tuple_record);
+      break;
+
+    case LOGRECORD_TYPE_ITERATION_DELIMITER: {
+      // the delimiters help us only to find the max persistent commit id
+      // during recovery. a replica replays every commit up to it.
+      if (log_id > max_replayed_delimiter_) {
+        max_replayed_delimiter_ = log_id;
+      }
+      break;
     }
+
+    default:
+      break;
   }
 
-  // Finally, abort ACTIVE transactions in recovery_txn_table
-  AbortActiveTransactions();
+  return true;
+}
+
+/**
+ * @brief Replay a batch of the log shipped by the frontend logger of a
+ * primary. A batch holds whole records, and the transactions that begin in
+ * it may commit in a later batch.
+ * @return the commit id up to which every transaction has been replayed
+ */
+cid_t WriteAheadFrontendLogger::ReplayLog(const char *data, size_t len) {
+  if (len == 0) {
+    return max_replayed_delimiter_;
+  }
+
+  FILE *file = fmemopen((void *)data, len, "rb");
+  if (file == nullptr) {
+    LOG_ERROR("Unable to open the shipped log");
+    return max_replayed_delimiter_;
+  }
+  FileHandle file_handle(file, INVALID_FILE_DESCRIPTOR, len);
+
+  // commits covered by the checkpoint the replica started from are skipped
+  cid_t start_commit_id = CheckpointManager::GetInstance().GetRecoveredCid();
+
+  while (LoggingUtil::IsFileTruncated(file_handle, 1) == false) {
+    char buffer;
+    if (fread((void *)&buffer, 1, sizeof(char), file) != sizeof(char)) {
+      break;
+    }
+
+    CopySerializeInputBE input(&buffer, sizeof(char));
+    auto record_type = (LogRecordType)(input.ReadEnumInSingleByte());
+    if (IsReplayedLogRecordType(record_type) == false ||
+        ReplayLogRecord(record_type, file_handle, start_commit_id, MAX_CID) ==
+            false) {
+      LOG_ERROR("Shipped log is corrupted");
+      break;
+    }
+  }
 
-  // After finishing recovery, set the next oid with maximum oid
-  // observed during the recovery
-  log_manager.UpdateCatalogAndTxnManagers(max_oid, max_cid);
+  fclose(file);
 
-  LOG_TRACE("This thread did %d inserts", (int)num_inserts);
-  cur_file_handle = INVALID_FILE_HANDLE;
+  return max_replayed_delimiter_;
 }
 
 void WriteAheadFrontendLogger::RecoverIndex() {
@@ -427,6 +712,12 @@ bool WriteAheadFrontendLogger::RecoverTableIndexHelper(
     // Retrieve a tile group
     auto tile_group = target_table->GetTileGroup(current_tile_group_offset);
 
+    // Skip tile groups dropped by compaction
+    if (tile_group == nullptr) {
+      current_tile_group_offset++;
+      continue;
+    }
+
     // Retrieve a logical tile
     std::unique_ptr<executor::LogicalTile> logical_tile(
         scanner.Scan(tile_group, column_ids, start_cid));
@@ -474,6 +765,18 @@ void WriteAheadFrontendLogger::InsertIndexEntry(storage::Tuple *tuple,
   LOG_TRACE("Insert tuple (%u, %u) into %u indexes", target_location.block,
             target_location.offset, index_count);
 
+  if (index_count == 0) {
+    return;
+  }
+
+  // the indexes share the entry, and an update of the version moves it to
+  // the new version as it does for a transaction
+  ItemPointer *index_entry_ptr = new ItemPointer(target_location);
+  catalog::Manager::GetInstance()
+      .GetTileGroup(target_location.block)
+      ->GetHeader()
+      ->SetIndirection(target_location.offset, index_entry_ptr);
+
   for (int index_itr = index_count - 1; index_itr >= 0; --index_itr) {
     auto index = table->GetIndex(index_itr);
     auto index_schema = index->GetKeySchema();
@@ -481,12 +784,86 @@ void WriteAheadFrontendLogger::InsertIndexEntry(storage::Tuple *tuple,
     std::unique_ptr<storage::Tuple> key(new storage::Tuple(index_schema, true));
     key->SetFromTuple(tuple, indexed_columns, index->GetPool());
 
-    index->InsertEntry(key.get(), new ItemPointer(target_location));
+    index->InsertEntry(key.get(), index_entry_ptr);
     // Increase the indexes' number of tuples by 1 as well
     index->IncreaseNumberOfTuplesBy(1);
   }
 }
 
+std::unique_ptr<storage::Tuple> WriteAheadFrontendLogger::GetRecoveredTuple(
+    storage::DataTable *table, const ItemPointer &location) {
+  auto tile_group =
+      catalog::Manager::GetInstance().GetTileGroup(location.block);
+  auto schema = table->GetSchema();
+  std::unique_ptr<storage::Tuple> tuple(new storage::Tuple(schema, true));
+  for (oid_t column_id = 0; column_id < schema->GetColumnCount();
+       column_id++) {
+    tuple->SetValue(column_id, tile_group->GetValue(location.offset, column_id),
+                    recovery_pool);
+  }
+  return tuple;
+}
+
+void WriteAheadFrontendLogger::ReplayIndexUpdate(
+    cid_t commit_id, oid_t db_id, oid_t table_id,
+    const ItemPointer &old_location, const ItemPointer &new_location) {
+  auto db = catalog::Catalog::GetInstance()->GetDatabaseWithOid(db_id);
+  PL_ASSERT(db);
+  auto table = db->GetTableWithOid(table_id);
+  if (table == nullptr || table->GetIndexCount() == 0) {
+    return;
+  }
+
+  // a later commit was replayed into the slot first
+  auto &manager = catalog::Manager::GetInstance();
+  auto new_tile_group_header =
+      manager.GetTileGroup(new_location.block)->GetHeader();
+  if (new_tile_group_header->GetBeginCommitId(new_location.offset) !=
+      commit_id) {
+    return;
+  }
+
+  auto new_tuple = GetRecoveredTuple(table, new_location);
+
+  ItemPointer *index_entry_ptr = nullptr;
+  if (old_location.IsNull() == false) {
+    index_entry_ptr = manager.GetTileGroup(old_location.block)
+                          ->GetHeader()
+                          ->GetIndirection(old_location.offset);
+  }
+
+  // an insert, or an update of a version that was never indexed
+  if (index_entry_ptr == nullptr) {
+    InsertIndexEntry(new_tuple.get(), table, new_location);
+    return;
+  }
+
+  new_tile_group_header->SetIndirection(new_location.offset, index_entry_ptr);
+  UNUSED_ATTRIBUTE auto res =
+      AtomicUpdateItemPointer(index_entry_ptr, new_location);
+  PL_ASSERT(res == true);
+
+  // the entries of changed keys are added, the old ones are left to the
+  // garbage collector as they are on the primary
+  auto old_tuple = GetRecoveredTuple(table, old_location);
+  int index_count = table->GetIndexCount();
+  for (int index_itr = index_count - 1; index_itr >= 0; --index_itr) {
+    auto index = table->GetIndex(index_itr);
+    auto index_schema = index->GetKeySchema();
+    auto indexed_columns = index_schema->GetIndexedColumns();
+    std::unique_ptr<storage::Tuple> old_key(
+        new storage::Tuple(index_schema, true));
+    old_key->SetFromTuple(old_tuple.get(), indexed_columns, index->GetPool());
+    std::unique_ptr<storage::Tuple> new_key(
+        new storage::Tuple(index_schema, true));
+    new_key->SetFromTuple(new_tuple.get(), indexed_columns, index->GetPool());
+
+    if (old_key->EqualsNoSchemaCheck(*new_key) == false) {
+      index->InsertEntry(new_key.get(), index_entry_ptr);
+    }
+  }
+}
+
 /**
  * @brief Add new txn to recovery table
  */
@@ -514,16 +891,23 @@ void WriteAheadFrontendLogger::StartTransactionRecovery(cid_t commit_id) {
  * them later
  * @param recovery txn
  */
-void WriteAheadFrontendLogger::CommitTransactionRecovery(cid_t commit_id) {
+bool WriteAheadFrontendLogger::CommitTransactionRecovery(cid_t commit_id) {
   std::vector<TupleRecord *> &tuple_records = recovery_txn_table[commit_id];
+  bool replayed = true;
   for (auto it = tuple_records.begin(); it != tuple_records.end(); it++) {
     TupleRecord *curr = *it;
+    // the records after a failed one are only cleaned up
+    if (replayed == false) {
+      delete curr->GetTuple();
+      delete curr;
+      continue;
+    }
     switch (curr->GetType()) {
       case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
         InsertTuple(curr);
         break;
       case LOGRECORD_TYPE_WAL_TUPLE_UPDATE:
-        UpdateTuple(curr);
+        replayed = UpdateTuple(curr);
         break;
       case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
         DeleteTuple(curr);
@@ -533,8 +917,11 @@ void WriteAheadFrontendLogger::CommitTransactionRecovery(cid_t commit_id) {
     }
     delete curr;
   }
-  max_cid = commit_id + 1;
+  if (commit_id + 1 > max_cid) {
+    max_cid = commit_id + 1;
+  }
   recovery_txn_table.erase(commit_id);
+  return replayed;
 }
 
 void InsertTupleHelper(oid_t &max_tg, cid_t commit_id, oid_t db_id,
@@ -646,6 +1033,11 @@ void WriteAheadFrontendLogger::InsertTuple(TupleRecord *record) {
   InsertTupleHelper(max_oid, record->GetTransactionId(),
                     record->GetDatabaseOid(), record->GetTableId(),
                     record->GetInsertLocation(), record->GetTuple());
+  if (replay_indexes_) {
+    ReplayIndexUpdate(record->GetTransactionId(), record->GetDatabaseOid(),
+                      record->GetTableId(), INVALID_ITEMPOINTER,
+                      record->GetInsertLocation());
+  }
 }
 
 /**
@@ -661,13 +1053,52 @@ void WriteAheadFrontendLogger::DeleteTuple(TupleRecord *record) {
 /**
  * @brief read tuple record from log file and add them tuples to recovery txn
  * @param recovery txn
+ * @return false if the old version of a partial update is missing
  */
+bool WriteAheadFrontendLogger::UpdateTuple(TupleRecord *record) {
+  // the columns left out of a partial after-image keep the values of the old
+  // version, which has been recovered at its logged location
+  if (record->IsPartialImage() && record->GetTuple() != nullptr) {
+    auto old_location = record->GetDeleteLocation();
+    auto old_tile_group =
+        catalog::Manager::GetInstance().GetTileGroup(old_location.block);
+    // the after-image can not be completed, so the database can not be
+    // recovered to a consistent state
+    if (old_tile_group == nullptr ||
+        old_location.offset >= old_tile_group->GetAllocatedTupleCount() ||
+        old_tile_group->GetHeader()->GetBeginCommitId(old_location.offset) ==
+            MAX_CID) {
+      LOG_ERROR("Old version of a partial update (%u, %u) is missing",
+                old_location.block, old_location.offset);
+      delete record->GetTuple();
+      return false;
+    }
+    auto tuple = record->GetTuple();
+    auto &column_ids = record->GetColumnIds();
+    oid_t column_count = tuple->GetSchema()->GetColumnCount();
+    for (oid_t column_id = 0, next_changed = 0; column_id < column_count;
+         column_id++) {
+      if (next_changed < column_ids.size() &&
+          column_ids[next_changed] == column_id) {
+        next_changed++;
+        continue;
+      }
+      tuple->SetValue(
+          column_id, old_tile_group->GetValue(old_location.offset, column_id),
+          recovery_pool);
+    }
+  }
 
-void WriteAheadFrontendLogger::UpdateTuple(TupleRecord *record) {
   UpdateTupleHelper(max_oid, record->GetTransactionId(),
                     record->GetDatabaseOid(), record->GetTableId(),
                     record->GetDeleteLocation(), record->GetInsertLocation(),
                     record->GetTuple());
+  if (replay_indexes_) {
+    ReplayIndexUpdate(record->GetTransactionId(), record->GetDatabaseOid(),
+                      record->GetTableId(), record->GetDeleteLocation(),
+                      record->GetInsertLocation());
+  }
+  return true;
 }
 
 //===--------------------------------------------------------------------===//
@@ -676,50 +1107,31 @@ void WriteAheadFrontendLogger::UpdateTuple(TupleRecord *record) {
 
 LogRecordType WriteAheadFrontendLogger::GetNextLogRecordTypeForRecovery() {
   char buffer;
-  bool is_truncated = false;
   int ret;
 
-  if (cur_file_handle.file == nullptr || cur_file_handle.fd == -1)
-    return LOGRECORD_TYPE_INVALID;
-
   LOG_TRACE("Inside GetNextLogRecordForRecovery");
 
-  LOG_TRACE("File is at position %d", (int)ftell(cur_file_handle.file));
-
-  // Check if the log record type is broken
-  if (LoggingUtil::IsFileTruncated(cur_file_handle, 1)) {
-    LOG_TRACE("Log file is truncated, should open next log file");
-    is_truncated = true;
-  }
-
-  // Otherwise, read the log record type
-  if (!is_truncated) {
-    ret = fread((void *)&buffer, 1, sizeof(char), cur_file_handle.file);
-    if (ret <= 0) {
-      LOG_TRACE("Failed an fread");
-    }
-  }
-  if (is_truncated || ret <= 0) {
-    LOG_TRACE("Call OpenNextLogFile");
-    OpenNextLogFile();
-    if (cur_file_handle.fd == -1) return LOGRECORD_TYPE_INVALID;
+  while (true) {
+    if (cur_file_handle.file == nullptr || cur_file_handle.fd == -1)
+      return LOGRECORD_TYPE_INVALID;
 
-    LOG_TRACE("Open succeeded. log_file_fd is %d", (int)cur_file_handle.fd);
+    LOG_TRACE("File is at position %d", (int)ftell(cur_file_handle.file));
 
+    // Check if the log record type is broken
     if (LoggingUtil::IsFileTruncated(cur_file_handle, 1)) {
-      LOG_ERROR("Log file is truncated");
-      return LOGRECORD_TYPE_INVALID;
+      LOG_TRACE("Log file is truncated, should open next log file");
+    } else {
+      // Otherwise, read the log record type
+      ret = fread((void *)&buffer, 1, sizeof(char), cur_file_handle.file);
+      if (ret > 0 && buffer != LOGRECORD_TYPE_INVALID) {
+        LOG_TRACE("fread succeeded.");
+        break;
+      }
+      LOG_TRACE("Failed an fread or reached the end of the file");
     }
 
-    LOG_TRACE("File is not truncated.");
-    ret = fread((void *)&buffer, 1, sizeof(char), cur_file_handle.file);
-    if (ret <= 0) {
-      LOG_ERROR("Could not read from log file");
-      return LOGRECORD_TYPE_INVALID;
-    }
-    LOG_TRACE("fread succeeded.");
-  } else {
-    LOG_TRACE("fread succeeded.");
+    LOG_TRACE("Call OpenNextLogFile");
+    OpenNextLogFile();
   }
 
   CopySerializeInputBE input(&buffer, sizeof(char));
@@ -746,9 +1158,13 @@ void WriteAheadFrontendLogger::InitLogFilesList() {
   std::pair<cid_t, cid_t> extracted_values;
   FileHandle temp_file_handle;
   int max_version = 0;
+  int min_new_version = 0;
 
   // TODO need a better regular expression to match file name
-  std::string base_name = "peloton_log_";
+  std::string base_name = LOG_FILE_PREFIX;
+
+  // the segments before the one of the manifest are not read
+  ReadManifest();
 
   LOG_TRACE("Trying to read log directory");
 
@@ -759,15 +1175,35 @@ void WriteAheadFrontendLogger::InitLogFilesList() {
 
   // XXX readdir is not thread safe???
   while ((file = readdir(dirp)) != NULL) {
+    if (strncmp(file->d_name, LOG_FREE_FILE_PREFIX.c_str(),
+                LOG_FREE_FILE_PREFIX.length()) == 0) {
+      // a truncated segment left for reuse. its number is not taken again,
+      // so its old frames are never read as the ones of a new segment.
+      free_segments_.push_back(peloton_log_directory + "/" + file->d_name);
+      version_number = LoggingUtil::ExtractNumberFromFileName(file->d_name);
+      if (version_number >= min_new_version) {
+        min_new_version = version_number + 1;
+      }
+      continue;
+    }
+
     if (strncmp(file->d_name, base_name.c_str(), base_name.length()) == 0) {
       // found a log file!
       LOG_TRACE("Found a log file with name %s", file->d_name);
 
       version_number = LoggingUtil::ExtractNumberFromFileName(file->d_name);
-      if (version_number > max_version) max_version = version_number;
-
       std::string file_name_with_dir = GetFileNameFromVersion(version_number);
 
+      if (version_number < manifest_start_segment_) {
+        // truncated after the manifest was written, but before it was gone.
+        // it is removed once a checkpoint is known to cover it.
+        LOG_TRACE("Found truncated log file %s", file->d_name);
+        truncated_segments_.push_back(file_name_with_dir);
+        continue;
+      }
+
+      if (version_number > max_version) max_version = version_number;
+
       fp = fopen(file_name_with_dir.c_str(), "rb+");
       temp_max_log_id_file = UINT64_MAX;
       temp_max_delimiter_file = 0;
@@ -793,7 +1229,14 @@ void WriteAheadFrontendLogger::InitLogFilesList() {
 
       if (temp_max_log_id_file == 0 || temp_max_log_id_file == UINT64_MAX ||
           temp_max_delimiter_file == 0) {
-        extracted_values = ExtractMaxLogIdAndMaxDelimFromLogFileRecords(fp);
+        auto records = ReadSegmentFrames(fp, version_number);
+        if (records != nullptr) {
+          extracted_values =
+              ExtractMaxLogIdAndMaxDelimFromLogFileRecords(records);
+          fclose(records);
+        } else {
+          extracted_values = ExtractMaxLogIdAndMaxDelimFromLogFileRecords(fp);
+        }
 
         temp_max_log_id_file = extracted_values.first;
         temp_max_delimiter_file = extracted_values.second;
@@ -864,6 +1307,14 @@ void WriteAheadFrontendLogger::InitLogFilesList() {
   } else {
     this->log_file_counter_ = 0;
   }
+  if (this->log_file_counter_ < min_new_version) {
+    this->log_file_counter_ = min_new_version;
+  }
+
+  // a new segment must not be taken for one the manifest skips
+  if (this->log_file_counter_ < manifest_start_segment_) {
+    this->log_file_counter_ = manifest_start_segment_;
+  }
 }
 
 void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
@@ -883,19 +1334,29 @@ void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
     LogFile *cur_log_file_object = log_files_[file_list_size - 1];
 
     if (file_list_size != 0) {
-      // TODO check return values of all these operations!
-      fseek(cur_file_handle.file, 0, SEEK_SET);
+      if (direct_io_) {
+        if (SyncLogFile() == false) {
+          LogManager::GetInstance().SetLogFailed();
+        }
+        if (async_writer_ != nullptr) {
+          async_writer_->Reap(true);
+        }
+        WriteSegmentHeader(cur_log_file_object->GetLogFileName());
+      } else {
+        // TODO check return values of all these operations!
+        fseek(cur_file_handle.file, 0, SEEK_SET);
+
+        fwrite((void *)&(max_log_id_file), sizeof(max_log_id_file), 1,
+               cur_file_handle.file);
 
-      fwrite((void *)&(max_log_id_file), sizeof(max_log_id_file), 1,
-             cur_file_handle.file);
+        fwrite((void *)&(max_delimiter_file), sizeof(max_delimiter_file), 1,
+               cur_file_handle.file);
+      }
 
       cur_log_file_object->SetMaxLogId(max_log_id_file);
 
       LOG_TRACE("MaxLogID of the last closed file is %d", (int)max_log_id_file);
 
-      fwrite((void *)&(max_delimiter_file), sizeof(max_delimiter_file), 1,
-             cur_file_handle.file);
-
       cur_log_file_object->SetMaxDelimiter(max_delimiter_file);
 
       LOG_TRACE("MaxDelimiter of the last closed file is %d",
@@ -904,16 +1365,25 @@ void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
       max_log_id_file = 0;     // reset
       max_delimiter_file = 0;  // reset
 
-      fstat(cur_file_handle.fd, &log_stats);
+      if (direct_io_) {
+        // the preallocated segment is larger than what was written
+        cur_file_handle.size = direct_file_offset_ + direct_buffer_size_;
+      } else {
+        fstat(cur_file_handle.fd, &log_stats);
 
-      cur_file_handle.size = log_stats.st_size;
+        cur_file_handle.size = log_stats.st_size;
+      }
 
       LOG_TRACE("The log file to be closed has size %d",
                 (int)cur_file_handle.size);
 
       cur_log_file_object->SetLogFileSize(cur_file_handle.size);
 
-      fclose(cur_file_handle.file);
+      if (direct_io_) {
+        close(cur_file_handle.fd);
+      } else {
+        fclose(cur_file_handle.file);
+      }
 
       cur_log_file_object->SetFilePtr(nullptr);  // invalidate
       cur_log_file_object->SetLogFileFD(-1);     // invalidate
@@ -924,24 +1394,35 @@ void WriteAheadFrontendLogger::CreateNewLogFile(bool close_old_file) {
 
   new_file_name = this->GetFileNameFromVersion(new_file_num);
 
-  FILE *new_log_file = fopen(new_file_name.c_str(), "wb");
+  // every file holds the delimiter of its commits
+  max_written_delimiter_ = INVALID_CID;
 
-  if (new_log_file == NULL) {
-    LOG_ERROR("new_log_file is NULL");
-    return;
-  }
+  if (direct_io_) {
+    if (OpenSegment(new_file_name, new_file_num) == false) {
+      return;
+    }
+  } else {
+    FILE *new_log_file = fopen(new_file_name.c_str(), "wb");
 
-  // now set the first 8 bytes to 0 - this is for the max_log id in this file
-  fwrite((void *)&default_commit_id, sizeof(default_commit_id), 1,
-         new_log_file);
+    if (new_log_file == NULL) {
+      LOG_ERROR("new_log_file is NULL");
+      return;
+    }
 
-  // now set the next 8 bytes to 0 - this is for the max delimiter in this file
-  fwrite((void *)&default_delimiter, sizeof(default_delimiter), 1,
-         new_log_file);
+    // now set the first 8 bytes to 0 - this is for the max_log id in this
+    // file
+    fwrite((void *)&default_commit_id, sizeof(default_commit_id), 1,
+           new_log_file);
 
-  cur_file_handle.file = new_log_file;
-  cur_file_handle.fd = fileno(cur_file_handle.file);
-  cur_file_handle.size = 0;
+    // now set the next 8 bytes to 0 - this is for the max delimiter in this
+    // file
+    fwrite((void *)&default_delimiter, sizeof(default_delimiter), 1,
+           new_log_file);
+
+    cur_file_handle.file = new_log_file;
+    cur_file_handle.fd = fileno(cur_file_handle.file);
+    cur_file_handle.size = 0;
+  }
 
   if (cur_file_handle.fd == -1) {
     LOG_ERROR("cur_file_handle.fd is -1");
@@ -963,8 +1444,13 @@ bool WriteAheadFrontendLogger::FileSwitchCondIsTrue() {
   struct stat stat_buf;
   if (cur_file_handle.fd == -1) return false;
 
-  fstat(cur_file_handle.fd, &stat_buf);
-  cur_file_handle.size = stat_buf.st_size;
+  if (direct_io_) {
+    // the size of a preallocated segment does not grow with the log
+    cur_file_handle.size = direct_file_offset_ + direct_buffer_size_;
+  } else {
+    fstat(cur_file_handle.fd, &stat_buf);
+    cur_file_handle.size = stat_buf.st_size;
+  }
 
   return cur_file_handle.size >
          LogManager::GetInstance().GetLogFileSizeLimit() * 1024;
@@ -981,13 +1467,15 @@ void WriteAheadFrontendLogger::OpenNextLogFile() {
 
   if (this->log_file_cursor_ >= (int)this->log_files_.size()) {
     LOG_TRACE("Cursor has reached the end. No more log files to read from.");
-    fclose(cur_file_handle.file);
+    if (cur_file_handle.file != nullptr) {
+      fclose(cur_file_handle.file);
+    }
     cur_file_handle = INVALID_FILE_HANDLE;
     return;
   }
 
-  if (log_file_cursor_ != 0)  // close old file
-  {
+  // close old file, recovery may have skipped the first ones
+  if (log_file_cursor_ != 0 && cur_file_handle.file != nullptr) {
     LOG_TRACE("Closing last opened file");
     fclose(cur_file_handle.file);
   }
@@ -1036,6 +1524,15 @@ void WriteAheadFrontendLogger::OpenNextLogFile() {
   LOG_TRACE("On startup: MaxDelimiter of this file is %d",
             (int)temp_max_delimiter_file);
 
+  // the records of a direct i/o segment are read off its valid frames
+  auto records = ReadSegmentFrames(
+      cur_file_handle.file, log_files_[log_file_cursor_]->GetLogNumber());
+  if (records != nullptr) {
+    fclose(cur_file_handle.file);
+    cur_file_handle.file = records;
+    cur_file_handle.fd = fileno(records);
+  }
+
   struct stat stat_buf;
 
   fstat(cur_file_handle.fd, &stat_buf);
@@ -1048,14 +1545,56 @@ void WriteAheadFrontendLogger::OpenNextLogFile() {
 void WriteAheadFrontendLogger::TruncateLog(cid_t truncate_log_id) {
   int return_val;
 
+  // the checkpoint covers the segments the manifest was past on startup
+  if (truncate_log_id >= manifest_commit_id_) {
+    RemoveTruncatedSegments();
+  }
+
+  if (log_files_.empty()) {
+    return;
+  }
+
+  // the manifest moves past the covered segments before they are gone, so
+  // recovery never looks for one of them
+  int start_segment = log_files_.back()->GetLogNumber();
+  for (int i = 0; i < (int)log_files_.size() - 1; i++) {
+    if (truncate_log_id < log_files_[i]->GetMaxLogId()) {
+      start_segment = log_files_[i]->GetLogNumber();
+      break;
+    }
+  }
+
+  if (start_segment > manifest_start_segment_) {
+    if (PersistManifest(start_segment, truncate_log_id) == false) {
+      LOG_ERROR("Failed to write the log manifest, keeping the log files");
+      return;
+    }
+    manifest_start_segment_ = start_segment;
+    manifest_commit_id_ = truncate_log_id;
+  }
+
   // delete stale log files except the one currently being used
   for (int i = 0; i < (int)log_files_.size() - 1; i++) {
     if (truncate_log_id >= log_files_[i]->GetMaxLogId()) {
-      // XXX Do we need directory prefix before log file name?
-      return_val = remove(log_files_[i]->GetLogFileName().c_str());
-      if (return_val != 0) {
-        LOG_ERROR("Couldn't delete log file: %s error: %s",
-                  log_files_[i]->GetLogFileName().c_str(), strerror(errno));
+      if (direct_io_ && free_segments_.size() < WAL_MAX_FREE_SEGMENTS) {
+        // keep the preallocated segment around for the next log file
+        auto free_file_name =
+            GetFreeFileNameFromVersion(log_files_[i]->GetLogNumber());
+        return_val = rename(log_files_[i]->GetLogFileName().c_str(),
+                            free_file_name.c_str());
+        if (return_val != 0) {
+          LOG_ERROR("Couldn't recycle log file: %s error: %s",
+                    log_files_[i]->GetLogFileName().c_str(), strerror(errno));
+        } else {
+          free_segments_.push_back(free_file_name);
+        }
+      } else {
+        // XXX Do we need directory prefix before log file name?
+        return_val = remove(log_files_[i]->GetLogFileName().c_str());
+        if (return_val != 0) {
+          LOG_ERROR("Couldn't delete log file: %s error: %s",
+                    log_files_[i]->GetLogFileName().c_str(), strerror(errno));
+        }
       }
       // remove entry from list anyway
       delete log_files_[i];
@@ -1065,11 +1604,27 @@ void WriteAheadFrontendLogger::TruncateLog(cid_t truncate_log_id) {
   }
 }
 
+void WriteAheadFrontendLogger::RemoveTruncatedSegments() {
+  for (auto &file_name : truncated_segments_) {
+    LOG_TRACE("Removing truncated log file %s", file_name.c_str());
+    if (remove(file_name.c_str()) != 0) {
+      LOG_ERROR("Couldn't delete log file: %s error: %s", file_name.c_str(),
+                strerror(errno));
+    }
+  }
+  truncated_segments_.clear();
+}
+
 void WriteAheadFrontendLogger::InitLogDirectory() {
   // Get log directory
   auto &log_manager = logging::LogManager::GetInstance();
   peloton_log_directory =
-      log_manager.GetLogDirectoryName() + wal_directory_path;
+      log_manager.GetLogStreamDirectoryName(logger_id) + wal_directory_path;
+
+  // the first stream keeps the directory of a single stream
+  if (logger_id > 0) {
+    peloton_log_directory += std::to_string(logger_id);
+  }
 
   auto success =
       LoggingUtil::CreateDirectory(peloton_log_directory.c_str(), 0700);
@@ -1085,6 +1640,75 @@ std::string WriteAheadFrontendLogger::GetFileNameFromVersion(int version) {
          std::to_string(version) + LOG_FILE_SUFFIX;
 }
 
+std::string WriteAheadFrontendLogger::GetFreeFileNameFromVersion(int version) {
+  return std::string(peloton_log_directory.c_str()) + "/" +
+         LOG_FREE_FILE_PREFIX + std::to_string(version) + LOG_FILE_SUFFIX;
+}
+
+void WriteAheadFrontendLogger::RequestTruncation(cid_t truncate_log_id) {
+  truncate_commit_id_ = truncate_log_id;
+}
+
+//===--------------------------------------------------------------------===//
+// Log manifest
+//===--------------------------------------------------------------------===//
+
+// The manifest is the first segment recovery needs, and the checkpoint commit
+// id that covers the segments before it.
+struct WalManifest {
+  int64_t start_segment;
+  cid_t commit_id;
+};
+
+std::string WriteAheadFrontendLogger::GetManifestFileName() {
+  return peloton_log_directory + "/" + WAL_MANIFEST_FILE_NAME;
+}
+
+bool WriteAheadFrontendLogger::PersistManifest(int start_segment,
+                                               cid_t commit_id) {
+  // the manifest is replaced at once, recovery sees the old or the new one
+  auto file_name = GetManifestFileName();
+  auto temp_file_name = file_name + ".tmp";
+  FILE *manifest_file = fopen(temp_file_name.c_str(), "wb");
+  if (manifest_file == NULL) {
+    LOG_ERROR("Unable to open the log manifest");
+    return false;
+  }
+
+  WalManifest manifest;
+  manifest.start_segment = start_segment;
+  manifest.commit_id = commit_id;
+  bool success = fwrite(&manifest, sizeof(manifest), 1, manifest_file) == 1 &&
+                 fflush(manifest_file) == 0 &&
+                 fsync(fileno(manifest_file)) == 0;
+  fclose(manifest_file);
+
+  // the segments before it are removed once the rename is durable
+  return success && rename(temp_file_name.c_str(), file_name.c_str()) == 0 &&
+         LoggingUtil::FsyncDirectory(peloton_log_directory.c_str());
+}
+
+bool WriteAheadFrontendLogger::ReadManifest() {
+  FILE *manifest_file = fopen(GetManifestFileName().c_str(), "rb");
+  if (manifest_file == NULL) {
+    LOG_TRACE("No log manifest");
+    return false;
+  }
+
+  WalManifest manifest;
+  bool success = fread(&manifest, sizeof(manifest), 1, manifest_file) == 1;
+  fclose(manifest_file);
+
+  if (success == false) {
+    LOG_ERROR("Failed to read the log manifest");
+    return false;
+  }
+
+  manifest_start_segment_ = manifest.start_segment;
+  manifest_commit_id_ = manifest.commit_id;
+  return true;
+}
+
 std::pair<cid_t, cid_t>
 WriteAheadFrontendLogger::ExtractMaxLogIdAndMaxDelimFromLogFileRecords(
     FILE *log_file) {
@@ -1150,7 +1774,7 @@ WriteAheadFrontendLogger::ExtractMaxLogIdAndMaxDelimFromLogFileRecords(
 
         // Read off the tuple record body from the log
         auto record_body = LoggingUtil::ReadTupleRecordBody(
-            table->GetSchema(), recovery_pool, file_handle);
+            *tuple_record, table->GetSchema(), recovery_pool, file_handle);
         delete tuple_record;
         delete record_body;
 
@@ -1179,11 +1803,343 @@ WriteAheadFrontendLogger::ExtractMaxLogIdAndMaxDelimFromLogFileRecords(
   return std::pair<cid_t, cid_t>(max_log_id_so_far, max_delim_so_far);
 }
 
-void WriteAheadFrontendLogger::SetLoggerID(int id) {
-  logger_id = id;
-  peloton_log_directory += std::to_string(id);
+//===--------------------------------------------------------------------===//
+// Log file writes
+//===--------------------------------------------------------------------===//
+
+// Each sync of a direct i/o segment writes the staged records as a frame at
+// the next block boundary. The frame carries the number of its segment, so
+// the frames left over from an earlier use of a recycled segment are told
+// apart, and a checksum of its records, so a torn write is detected.
+struct WalSegmentFrame {
+  int64_t segment;
+  uint32_t size;
+  uint32_t checksum;
+};
+
+static size_t AlignToBlock(size_t size) {
+  return (size + WAL_DIRECT_IO_ALIGNMENT - 1) / WAL_DIRECT_IO_ALIGNMENT *
+         WAL_DIRECT_IO_ALIGNMENT;
+}
+
+static uint32_t GetFrameChecksum(const char *data, size_t size, int segment) {
+  return (uint32_t)MurmurHash3_x64_128(data, (int)size, (uint32_t)segment);
+}
+
+void WriteAheadFrontendLogger::WriteLogFile(const char *data, size_t size) {
+  unsynced_bytes_ += size;
+
+  if (direct_io_ == false) {
+    fwrite(data, sizeof(char), size, cur_file_handle.file);
+    return;
+  }
+
+  ReserveDirectBuffer(direct_buffer_size_ + size);
+  PL_MEMCPY(direct_buffer_ + direct_buffer_size_, data, size);
+  direct_buffer_size_ += size;
+}
+
+bool WriteAheadFrontendLogger::SyncLogFile() {
+  unsynced_bytes_ = 0;
+
+  if (direct_io_ == false) {
+    return LoggingUtil::FFlushFsync(cur_file_handle);
+  }
+
+  // nothing was staged since the last frame
+  if (direct_buffer_size_ <= sizeof(WalSegmentFrame)) {
+    return true;
+  }
+
+  // the staged records follow the room left for the frame header. the frame
+  // is padded up to the next block, and the next frame starts there, so a
+  // block that holds synced records is never written again.
+  WalSegmentFrame frame;
+  frame.segment = direct_segment_;
+  frame.size = direct_buffer_size_ - sizeof(frame);
+  frame.checksum = GetFrameChecksum(direct_buffer_ + sizeof(frame),
+                                    frame.size, direct_segment_);
+  PL_MEMCPY(direct_buffer_, &frame, sizeof(frame));
+
+  size_t write_size = AlignToBlock(direct_buffer_size_);
+  ReserveDirectBuffer(write_size);
+  memset(direct_buffer_ + direct_buffer_size_, 0,
+         write_size - direct_buffer_size_);
+
+  if (async_writer_ != nullptr) {
+    // the writer owns the staged blocks until the write completes
+    char *buffer = direct_buffer_;
+    size_t capacity = direct_buffer_capacity_;
+
+    direct_buffer_ = nullptr;
+    direct_buffer_capacity_ = 0;
+    ReserveDirectBuffer(capacity);
+    direct_buffer_size_ = sizeof(WalSegmentFrame);
+
+    // the sync only waits for this write, so the next frame can be written
+    // while it runs
+    auto ticket = async_writer_->WriteAndSync(cur_file_handle.fd, buffer,
+                                              write_size, direct_file_offset_);
+    async_writer_->Submit();
+    submitted_buffers_.emplace_back(ticket, buffer);
+
+    direct_file_offset_ += write_size;
+    // a failure is reported when the flush is reaped
+    return true;
+  }
+
+  ssize_t ret = pwrite(cur_file_handle.fd, direct_buffer_, write_size,
+                       direct_file_offset_);
+  if (ret != (ssize_t)write_size) {
+    LOG_ERROR("Could not write log segment: %s", strerror(errno));
+    return false;
+  }
+
+  direct_buffer_size_ = sizeof(WalSegmentFrame);
+  direct_file_offset_ += write_size;
+
+  // the segment is preallocated, so only the data has to reach the disk
+  if (fdatasync(cur_file_handle.fd) != 0) {
+    LOG_ERROR("Could not sync log segment: %s", strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+// with only asynchronous commits in the log, nobody waits for the flush, so
+// it is deferred until the log lags behind by the maximum commit lag.
+bool WriteAheadFrontendLogger::IsFlushDue() {
+  auto &log_manager = LogManager::GetInstance();
+
+  // flush everything before the logger stops
+  if (log_manager.GetLoggingStatus() != LOGGING_STATUS_TYPE_LOGGING) {
+    return true;
+  }
+
+  auto now = Clock::now();
+  if (now <= last_flush + flush_frequency) {
+    return false;
+  }
+
+  if (log_manager.HasFlushWaiters()) {
+    return true;
+  }
+
+  return now > last_flush + Micros(log_manager.GetMaxCommitLagMicros()) ||
+         unsynced_bytes_ >= log_manager.GetMaxCommitLagBytes();
+}
+
+bool WriteAheadFrontendLogger::ReapLogFlushes(bool wait_all) {
+  if (async_writer_ == nullptr) {
+    return false;
+  }
+
+  auto completed_ticket = async_writer_->Reap(wait_all);
+
+  // the tickets stop completing at a failed write or sync, which fails the
+  // log. the buffers are released once nothing is in flight.
+  if (async_writer_->GetFailedTicket() != 0) {
+    LogManager::GetInstance().SetLogFailed();
+  }
+
+  while (submitted_buffers_.empty() == false &&
+         (wait_all || submitted_buffers_.front().first <= completed_ticket)) {
+    free(submitted_buffers_.front().second);
+    submitted_buffers_.pop_front();
+  }
+
+  bool flushed = false;
+  while (pending_flushes_.empty() == false &&
+         pending_flushes_.front().first <= completed_ticket) {
+    if (pending_flushes_.front().second > max_flushed_commit_id) {
+      max_flushed_commit_id = pending_flushes_.front().second;
+    }
+    pending_flushes_.pop_front();
+    flushed = true;
+  }
+
+  return flushed;
+}
+
+void WriteAheadFrontendLogger::ReserveDirectBuffer(size_t size) {
+  if (size <= direct_buffer_capacity_) {
+    return;
+  }
+
+  size_t capacity = AlignToBlock(std::max(direct_buffer_capacity_ * 2, size));
+
+  void *buffer = nullptr;
+  if (posix_memalign(&buffer, WAL_DIRECT_IO_ALIGNMENT, capacity) != 0) {
+    throw std::bad_alloc();
+  }
+
+  if (direct_buffer_ != nullptr) {
+    PL_MEMCPY(buffer, direct_buffer_, direct_buffer_size_);
+    free(direct_buffer_);
+  }
+
+  direct_buffer_ = (char *)buffer;
+  direct_buffer_capacity_ = capacity;
 }
 
+bool WriteAheadFrontendLogger::OpenSegment(const std::string &file_name,
+                                           int segment) {
+  std::string segment_name = file_name;
+  bool recycled = false;
+
+  if (io_uring_ && async_writer_ == nullptr) {
+    async_writer_.reset(new AsyncFileWriter());
+    if (async_writer_->IsAvailable() == false) {
+      LOG_ERROR("io_uring is not available, writing the log synchronously");
+      async_writer_.reset();
+      io_uring_ = false;
+    }
+  }
+
+  if (free_segments_.empty() == false) {
+    segment_name = free_segments_.back();
+    free_segments_.pop_back();
+    recycled = true;
+  }
+
+  int fd = open(segment_name.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0600);
+  if (fd == -1 && errno == EINVAL) {
+    // the file system does not support direct i/o, the writes stay aligned
+    LOG_ERROR("Could not open log segment with O_DIRECT, using the page cache");
+    fd = open(segment_name.c_str(), O_RDWR | O_CREAT, 0600);
+  }
+
+  if (fd == -1) {
+    LOG_ERROR("Could not open log segment %s: %s", segment_name.c_str(),
+              strerror(errno));
+    return false;
+  }
+
+  // allocate the whole segment up front, so that appending to it does not
+  // change the file size that every fdatasync would have to write back
+  size_t segment_size =
+      AlignToBlock(LogManager::GetInstance().GetLogFileSizeLimit() * 1024);
+  if (fallocate(fd, 0, 0, segment_size) != 0) {
+    LOG_ERROR("Could not preallocate log segment: %s", strerror(errno));
+  }
+
+  cur_file_handle.file = nullptr;
+  cur_file_handle.fd = fd;
+  cur_file_handle.size = 0;
+
+  // the max log id and max delimiter of the header are filled in when the
+  // segment is closed. the first block is synced right away, which also
+  // clears the header of a recycled segment before the segment takes the
+  // name of a log file.
+  ReserveDirectBuffer(WAL_DIRECT_IO_ALIGNMENT);
+  memset(direct_buffer_, 0, WAL_DIRECT_IO_ALIGNMENT);
+  uint64_t header[3] = {INVALID_CID, INVALID_CID, WAL_SEGMENT_MAGIC};
+  PL_MEMCPY(direct_buffer_, header, sizeof(header));
+  if (pwrite(fd, direct_buffer_, WAL_DIRECT_IO_ALIGNMENT, 0) !=
+          WAL_DIRECT_IO_ALIGNMENT ||
+      fdatasync(fd) != 0) {
+    LOG_ERROR("Could not write log segment header: %s", strerror(errno));
+    close(fd);
+    cur_file_handle = INVALID_FILE_HANDLE;
+    return false;
+  }
+
+  // the frames start at the second block
+  direct_segment_ = segment;
+  direct_buffer_size_ = sizeof(WalSegmentFrame);
+  direct_file_offset_ = WAL_DIRECT_IO_ALIGNMENT;
+
+  if (recycled) {
+    if (rename(segment_name.c_str(), file_name.c_str()) != 0) {
+      LOG_ERROR("Could not recycle log segment %s: %s", segment_name.c_str(),
+                strerror(errno));
+      close(fd);
+      cur_file_handle = INVALID_FILE_HANDLE;
+      return false;
+    }
+    LOG_TRACE("Recycled log segment %s", segment_name.c_str());
+  }
+
+  return true;
+}
+
+void WriteAheadFrontendLogger::WriteSegmentHeader(
+    const std::string &file_name) {
+  // the header is smaller than a block, so it goes through the page cache
+  int fd = open(file_name.c_str(), O_WRONLY);
+  if (fd == -1) {
+    LOG_ERROR("Could not open log segment %s: %s", file_name.c_str(),
+              strerror(errno));
+    return;
+  }
+
+  cid_t header[2] = {max_log_id_file, max_delimiter_file};
+  if (pwrite(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+      fdatasync(fd) != 0) {
+    LOG_ERROR("Could not write log segment header: %s", strerror(errno));
+  }
+
+  close(fd);
+}
+
+FILE *WriteAheadFrontendLogger::ReadSegmentFrames(FILE *file, int segment) {
+  // the magic follows the max log id and max delimiter of the header
+  long header_end = ftell(file);
+  uint64_t magic = 0;
+  if (fread(&magic, sizeof(magic), 1, file) != 1 ||
+      magic != WAL_SEGMENT_MAGIC) {
+    fseek(file, header_end, SEEK_SET);
+    return nullptr;
+  }
+
+  FILE *records = tmpfile();
+  if (records == nullptr) {
+    LOG_ERROR("Could not read log segment %d: %s", segment, strerror(errno));
+    // nothing is replayed from the segment
+    fseek(file, 0, SEEK_END);
+    return nullptr;
+  }
+
+  struct stat stat_buf;
+  fstat(fileno(file), &stat_buf);
+  size_t file_size = stat_buf.st_size;
+
+  // the frames end at the first one that was left by an earlier use of the
+  // segment, or that is torn
+  std::vector<char> data;
+  size_t offset = WAL_DIRECT_IO_ALIGNMENT;
+  while (true) {
+    WalSegmentFrame frame;
+    if (fseek(file, offset, SEEK_SET) != 0 ||
+        fread(&frame, sizeof(frame), 1, file) != 1) {
+      break;
+    }
+    if (frame.segment != segment || frame.size == 0 ||
+        offset + sizeof(frame) + frame.size > file_size) {
+      break;
+    }
+
+    data.resize(frame.size);
+    if (fread(data.data(), 1, frame.size, file) != frame.size) {
+      break;
+    }
+    if (GetFrameChecksum(data.data(), frame.size, segment) != frame.checksum) {
+      LOG_TRACE("Torn frame at offset %lu of log segment %d", offset, segment);
+      break;
+    }
+
+    fwrite(data.data(), 1, frame.size, records);
+    offset += AlignToBlock(sizeof(frame) + frame.size);
+  }
+
+  fflush(records);
+  rewind(records);
+  return records;
+}
+
+// must be set before the log directory is initialized
+void WriteAheadFrontendLogger::SetLoggerID(int id) { logger_id = id; }
+
 void WriteAheadFrontendLogger::UpdateMaxDelimiterForRecovery() {
   // this method must update the max delimiter id to be used for recovery
   int num_log_files = log_files_.size();
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 
+#include <algorithm>
 #include <iostream>
 
 #include "logging/records/tuple_record.h"
@@ -25,15 +26,40 @@ namespace peloton {
 namespace logging {
 
 void WriteBehindBackendLogger::Log(LogRecord *record) {
-  // if we are committing, sync all data before taking the lock
-  if (record->GetType() == LOGRECORD_TYPE_TRANSACTION_COMMIT) {
-    auto &log_manager = LogManager::GetInstance();
-    auto no_write = log_manager.GetNoWrite();
+  switch (record->GetType()) {
+    case LOGRECORD_TYPE_WBL_TUPLE_DELETE:
+    case LOGRECORD_TYPE_WAL_TUPLE_DELETE:
+    case LOGRECORD_TYPE_WBL_TUPLE_INSERT:
+    case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
+    case LOGRECORD_TYPE_WBL_TUPLE_UPDATE:
+    case LOGRECORD_TYPE_WAL_TUPLE_UPDATE: {
+      // the record pool belongs to this thread, so the buffer lock is not
+      // taken for a tuple record
+      auto tuple_record = static_cast<TupleRecord *>(record);
+      record_pool_.CreateTupleRecord(
+          tuple_record->GetType(), tuple_record->GetTransactionId(),
+          tuple_record->GetTableId(), tuple_record->GetInsertLocation(),
+          tuple_record->GetDeleteLocation(), tuple_record->GetDatabaseOid());
+      return;
+    }
+    // if we are committing, sync all data before taking the lock
+    case LOGRECORD_TYPE_TRANSACTION_COMMIT: {
+      auto &log_manager = LogManager::GetInstance();
+      auto no_write = log_manager.GetNoWrite();
 
-    if(no_write == false) {
-      SyncDataForCommit();
+      if (no_write == false) {
+        SyncDataForCommit();
+      }
+      record_pool_.Clear();
+      break;
     }
+    case LOGRECORD_TYPE_TRANSACTION_ABORT:
+      record_pool_.Clear();
+      break;
+    default:
+      break;
   }
+
   log_buffer_lock.Lock();
   switch (record->GetType()) {
     case LOGRECORD_TYPE_TRANSACTION_COMMIT:
@@ -48,26 +74,6 @@ void WriteBehindBackendLogger::Log(LogRecord *record) {
       }
       break;
     }
-    case LOGRECORD_TYPE_WBL_TUPLE_DELETE:
-    case LOGRECORD_TYPE_WAL_TUPLE_DELETE: {
-      tile_groups_to_sync_.insert(
-          ((TupleRecord *)record)->GetDeleteLocation().block);
-      break;
-    }
-    case LOGRECORD_TYPE_WBL_TUPLE_INSERT:
-    case LOGRECORD_TYPE_WAL_TUPLE_INSERT: {
-      tile_groups_to_sync_.insert(
-          ((TupleRecord *)record)->GetInsertLocation().block);
-      break;
-    }
-    case LOGRECORD_TYPE_WBL_TUPLE_UPDATE:
-    case LOGRECORD_TYPE_WAL_TUPLE_UPDATE: {
-      tile_groups_to_sync_.insert(
-          ((TupleRecord *)record)->GetDeleteLocation().block);
-      tile_groups_to_sync_.insert(
-          ((TupleRecord *)record)->GetInsertLocation().block);
-      break;
-    }
     default:
       LOG_INFO("Invalid log record type");
       break;
@@ -76,54 +82,91 @@ void WriteBehindBackendLogger::Log(LogRecord *record) {
   log_buffer_lock.Unlock();
 }
 
+// the tile groups of the writes must be known before the commit record
+// syncs them, so the records go one by one.
+bool WriteBehindBackendLogger::Log(
+    const std::vector<std::unique_ptr<LogRecord>> &records) {
+  for (auto &record : records) {
+    Log(record.get());
+  }
+  return true;
+}
+
+void WriteBehindBackendLogger::LogTransaction(
+    cid_t commit_id, const std::vector<LogWrite> &writes) {
+  TransactionRecord record_begin(LOGRECORD_TYPE_TRANSACTION_BEGIN, commit_id);
+  Log(&record_begin);
+
+  // an insert has no old version and a delete has no new version
+  auto &manager = catalog::Manager::GetInstance();
+  for (auto &write : writes) {
+    auto &location = (write.type == LOGRECORD_TYPE_TUPLE_DELETE)
+                         ? write.old_version
+                         : write.new_version;
+    auto tile_group = manager.GetTileGroup(location.block);
+    record_pool_.CreateTupleRecord(GetWriteBehindRecordType(write.type),
+                                   commit_id, tile_group->GetTableId(),
+                                   write.new_version, write.old_version,
+                                   tile_group->GetDatabaseId());
+  }
+
+  TransactionRecord record_commit(LOGRECORD_TYPE_TRANSACTION_COMMIT,
+                                  commit_id);
+  Log(&record_commit);
+}
+
 void WriteBehindBackendLogger::SyncDataForCommit() {
   auto &manager = catalog::Manager::GetInstance();
 
+  // Collect the modified tile groups of the staged records, once each
+  tile_groups_to_sync_.clear();
+  for (size_t record_idx = 0; record_idx < record_pool_.GetRecordCount();
+       record_idx++) {
+    auto record = record_pool_.GetRecord(record_idx);
+    if (record->GetInsertLocation().IsNull() == false) {
+      tile_groups_to_sync_.push_back(record->GetInsertLocation().block);
+    }
+    if (record->GetDeleteLocation().IsNull() == false) {
+      tile_groups_to_sync_.push_back(record->GetDeleteLocation().block);
+    }
+  }
+  std::sort(tile_groups_to_sync_.begin(), tile_groups_to_sync_.end());
+  tile_groups_to_sync_.erase(
+      std::unique(tile_groups_to_sync_.begin(), tile_groups_to_sync_.end()),
+      tile_groups_to_sync_.end());
+
   // Sync the tiles in the modified tile groups and their headers
   for (oid_t tile_group_id : tile_groups_to_sync_) {
     auto tile_group = manager.GetTileGroup(tile_group_id);
     tile_group->Sync();
     tile_group->GetHeader()->Sync();
   }
+}
 
-  // Clear the list of tile groups
-  tile_groups_to_sync_.clear();
+LogRecordType WriteBehindBackendLogger::GetWriteBehindRecordType(
+    LogRecordType log_record_type) {
+  switch (log_record_type) {
+    case LOGRECORD_TYPE_TUPLE_INSERT:
+      return LOGRECORD_TYPE_WBL_TUPLE_INSERT;
+    case LOGRECORD_TYPE_TUPLE_DELETE:
+      return LOGRECORD_TYPE_WBL_TUPLE_DELETE;
+    case LOGRECORD_TYPE_TUPLE_UPDATE:
+      return LOGRECORD_TYPE_WBL_TUPLE_UPDATE;
+    default:
+      PL_ASSERT(false);
+      return LOGRECORD_TYPE_INVALID;
+  }
 }
 
 LogRecord *WriteBehindBackendLogger::GetTupleRecord(
     LogRecordType log_record_type, txn_id_t txn_id, oid_t table_oid,
     oid_t db_oid, ItemPointer insert_location, ItemPointer delete_location,
     UNUSED_ATTRIBUTE const void *data) {
-  // Figure the log record type
-  LogRecord *tuple_record;
-
-  switch (log_record_type) {
-    case LOGRECORD_TYPE_TUPLE_INSERT: {
-      log_record_type = LOGRECORD_TYPE_WBL_TUPLE_INSERT;
-      break;
-    }
-
-    case LOGRECORD_TYPE_TUPLE_DELETE: {
-      log_record_type = LOGRECORD_TYPE_WBL_TUPLE_DELETE;
-      break;
-    }
-
-    case LOGRECORD_TYPE_TUPLE_UPDATE: {
-      log_record_type = LOGRECORD_TYPE_WBL_TUPLE_UPDATE;
-      break;
-    }
-
-    default: {
-      PL_ASSERT(false);
-      break;
-    }
-  }
   // Don't make use of "data" in case of peloton log records
   // Build the tuple log record
-  tuple_record =
-      new TupleRecord(log_record_type, txn_id, table_oid, insert_location,
-                      delete_location, nullptr, db_oid);
-
+  LogRecord *tuple_record = new TupleRecord(
+      GetWriteBehindRecordType(log_record_type), txn_id, table_oid,
+      insert_location, delete_location, nullptr, db_oid);
 
   return tuple_record;
 }
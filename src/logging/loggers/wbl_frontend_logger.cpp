@@ -25,6 +25,7 @@
 #include "logging/loggers/wbl_backend_logger.h"
 #include "logging/logging_util.h"
 #include "logging/log_manager.h"
+#include "gc/gc_manager_factory.h"
 
 #define POSSIBLY_DIRTY_GRANT_SIZE 10000000;  // ten million seems reasonable
 
@@ -34,6 +35,13 @@ namespace logging {
 struct WriteBehindLogRecord {
   cid_t persistent_commit_id;
   cid_t max_possible_dirty_commit_id;
+  // 0 if no dirty map was written
+  cid_t dirty_map_version;
+};
+
+struct WriteBehindDirtyMapHeader {
+  cid_t version;
+  uint64_t tile_group_count;
 };
 
 // TODO for now, these helper routines are defined here, and also use
@@ -88,8 +96,10 @@ void WriteBehindFrontendLogger::FlushLogRecords(void) {
       txn_manager.GetCurrentCommitId() + POSSIBLY_DIRTY_GRANT_SIZE;
   // get current highest dispense commit id
   record.max_possible_dirty_commit_id = new_grant;
+  record.dirty_map_version = PersistDirtyMap(record.persistent_commit_id);
   if (!no_write_) {
-    if (!fwrite(&record, sizeof(WriteBehindLogRecord), 1, log_file)) {
+    if (!fwrite(&record, sizeof(WriteBehindLogRecord), 1, log_file) ||
+        fflush(log_file) != 0) {
       LOG_ERROR("Unable to write log record");
     }
   }
@@ -99,6 +109,17 @@ void WriteBehindFrontendLogger::FlushLogRecords(void) {
     LOG_ERROR("Unable to fsync log");
   }
 
+  // the group commit is durable, and so is the dirty map it names
+  {
+    std::lock_guard<std::mutex> dirty_map_lock(dirty_map_mutex_);
+    if (next_dirty_map_) {
+      persisted_tile_groups_.swap(next_tile_groups_);
+      next_tile_groups_.clear();
+      next_dirty_map_ = false;
+    }
+  }
+  dirty_map_cv_.notify_all();
+
   // inform backend loggers they can proceed if waiting for sync
   max_flushed_commit_id = max_collected_commit_id;
   auto &manager = LogManager::GetInstance();
@@ -156,10 +177,26 @@ void WriteBehindFrontendLogger::DoRecovery() {
   txn_manager.SetNextCid(most_recent_log_record.max_possible_dirty_commit_id +
                          1);
 
-  // set the dirty span of the transaction manager
+  // the next dirty map goes to the file the last group commit does not name
+  dirty_map_version_ = most_recent_log_record.dirty_map_version;
+
+  // undo the dirty range in the tile groups of the dirty map
+  auto persistent_commit_id = most_recent_log_record.persistent_commit_id;
+  auto max_possible_dirty_commit_id =
+      most_recent_log_record.max_possible_dirty_commit_id;
+  std::vector<oid_t> tile_group_ids;
+  if (dirty_map_version_ != 0 &&
+      ReadDirtyMap(dirty_map_version_, tile_group_ids) &&
+      UndoDirtyTileGroups(tile_group_ids, persistent_commit_id,
+                          max_possible_dirty_commit_id)) {
+    LOG_INFO("Undid the dirty range in %lu tile groups",
+             tile_group_ids.size());
+    return;
+  }
+
+  // otherwise, the dirty range is skipped whenever a tuple is read
   txn_manager.SetDirtyRange(
-      std::make_pair(most_recent_log_record.persistent_commit_id,
-                     most_recent_log_record.max_possible_dirty_commit_id));
+      std::make_pair(persistent_commit_id, max_possible_dirty_commit_id));
 
   // for now assume that the maximum tile group oid and table tile group
   // membership info are already set
@@ -174,5 +211,294 @@ void WriteBehindFrontendLogger::SetLoggerID(UNUSED_ATTRIBUTE int id) {
   // do nothing
 }
 
+//===--------------------------------------------------------------------===//
+// Dirty Map
+//===--------------------------------------------------------------------===//
+
+void WriteBehindFrontendLogger::RegisterDirtyTileGroups(
+    const std::vector<oid_t> &tile_group_ids) {
+  auto &log_manager = LogManager::GetInstance();
+  std::unique_lock<std::mutex> dirty_map_lock(dirty_map_mutex_);
+
+  for (auto tile_group_id : tile_group_ids) {
+    dirty_tile_groups_[tile_group_id].pending_count++;
+  }
+
+  // a tile group must also be in the dirty map being written, it may have
+  // been dropped from it
+  dirty_map_cv_.wait(dirty_map_lock, [&] {
+    if (log_manager.IsInLoggingMode() == false) {
+      return true;
+    }
+    for (auto tile_group_id : tile_group_ids) {
+      if (persisted_tile_groups_.count(tile_group_id) == 0 ||
+          (next_dirty_map_ && next_tile_groups_.count(tile_group_id) == 0)) {
+        return false;
+      }
+    }
+    return true;
+  });
+}
+
+void WriteBehindFrontendLogger::ReleaseDirtyTileGroups(
+    const std::vector<oid_t> &tile_group_ids, cid_t commit_id) {
+  std::lock_guard<std::mutex> dirty_map_lock(dirty_map_mutex_);
+
+  for (auto tile_group_id : tile_group_ids) {
+    auto tile_group_itr = dirty_tile_groups_.find(tile_group_id);
+    if (tile_group_itr == dirty_tile_groups_.end()) {
+      continue;
+    }
+
+    auto &dirty_tile_group = tile_group_itr->second;
+    PL_ASSERT(dirty_tile_group.pending_count > 0);
+    dirty_tile_group.pending_count--;
+    if (commit_id != INVALID_CID &&
+        commit_id > dirty_tile_group.max_commit_id) {
+      dirty_tile_group.max_commit_id = commit_id;
+    }
+  }
+}
+
+void WriteBehindFrontendLogger::ReportUnregisteredCommit(cid_t commit_id) {
+  std::lock_guard<std::mutex> dirty_map_lock(dirty_map_mutex_);
+  if (commit_id > unregistered_commit_id_) {
+    unregistered_commit_id_ = commit_id;
+  }
+}
+
+std::string WriteBehindFrontendLogger::GetDirtyMapFileName(cid_t version) {
+  return GetLogFileName() + ".dirty" + std::to_string(version % 2);
+}
+
+cid_t WriteBehindFrontendLogger::PersistDirtyMap(cid_t persistent_commit_id) {
+  std::lock_guard<std::mutex> dirty_map_lock(dirty_map_mutex_);
+
+  // recovery undoes the whole heap while an unregistered commit is dirty
+  cid_t named_version = dirty_map_version_;
+  if (unregistered_commit_id_ > persistent_commit_id) {
+    named_version = 0;
+  }
+
+  // a tile group is clean once nothing is committing into it and its commit
+  // ids are persistent
+  bool missing = false;
+  for (auto tile_group_itr = dirty_tile_groups_.begin();
+       tile_group_itr != dirty_tile_groups_.end();) {
+    auto &dirty_tile_group = tile_group_itr->second;
+    if (dirty_tile_group.pending_count == 0 &&
+        dirty_tile_group.max_commit_id <= persistent_commit_id) {
+      tile_group_itr = dirty_tile_groups_.erase(tile_group_itr);
+      continue;
+    }
+    if (persisted_tile_groups_.count(tile_group_itr->first) == 0) {
+      missing = true;
+    }
+    tile_group_itr++;
+  }
+
+  // a larger dirty map only undoes more tile groups, so it is kept until a
+  // tile group is missing or it grows too stale
+  if (missing == false &&
+      persisted_tile_groups_.size() <=
+          2 * dirty_tile_groups_.size() + WBL_DIRTY_MAP_SLACK) {
+    return named_version;
+  }
+
+  std::vector<oid_t> tile_group_ids;
+  tile_group_ids.reserve(dirty_tile_groups_.size());
+  for (auto &dirty_tile_group : dirty_tile_groups_) {
+    tile_group_ids.push_back(dirty_tile_group.first);
+  }
+
+  WriteBehindDirtyMapHeader header;
+  header.version = dirty_map_version_ + 1;
+  header.tile_group_count = tile_group_ids.size();
+
+  if (!no_write_) {
+    FILE *dirty_map_file =
+        fopen(GetDirtyMapFileName(header.version).c_str(), "wb");
+    if (dirty_map_file == NULL) {
+      LOG_ERROR("Unable to open the dirty map");
+      return named_version;
+    }
+
+    bool success =
+        fwrite(&header, sizeof(header), 1, dirty_map_file) == 1 &&
+        fwrite(tile_group_ids.data(), sizeof(oid_t), tile_group_ids.size(),
+               dirty_map_file) == tile_group_ids.size() &&
+        fflush(dirty_map_file) == 0 && fsync(fileno(dirty_map_file)) == 0;
+    fclose(dirty_map_file);
+
+    if (success == false) {
+      LOG_ERROR("Unable to write the dirty map");
+      return named_version;
+    }
+  }
+
+  next_tile_groups_.clear();
+  next_tile_groups_.insert(tile_group_ids.begin(), tile_group_ids.end());
+  next_dirty_map_ = true;
+  dirty_map_version_ = header.version;
+
+  return (named_version == 0) ? 0 : dirty_map_version_;
+}
+
+bool WriteBehindFrontendLogger::ReadDirtyMap(
+    cid_t version, std::vector<oid_t> &tile_group_ids) {
+  FILE *dirty_map_file = fopen(GetDirtyMapFileName(version).c_str(), "rb");
+  if (dirty_map_file == NULL) {
+    LOG_ERROR("Unable to open the dirty map");
+    return false;
+  }
+
+  // the file holds the version the group commit names, or one that was not
+  // completely written
+  WriteBehindDirtyMapHeader header;
+  bool success = fread(&header, sizeof(header), 1, dirty_map_file) == 1 &&
+                 header.version == version;
+  if (success) {
+    tile_group_ids.resize(header.tile_group_count);
+    success = fread(tile_group_ids.data(), sizeof(oid_t),
+                    tile_group_ids.size(),
+                    dirty_map_file) == tile_group_ids.size();
+  }
+  fclose(dirty_map_file);
+
+  if (success == false) {
+    LOG_ERROR("The dirty map %lu is not valid", version);
+    tile_group_ids.clear();
+  }
+  return success;
+}
+
+bool WriteBehindFrontendLogger::UndoDirtyTileGroups(
+    const std::vector<oid_t> &tile_group_ids, cid_t persistent_commit_id,
+    cid_t max_possible_dirty_commit_id) {
+  auto &manager = catalog::Manager::GetInstance();
+  bool complete = true;
+
+  // the chains that hold undone versions, and the empty versions of deletes
+  std::unordered_set<ItemPointer *> index_entry_ptrs;
+  std::set<ItemPointer> empty_versions;
+
+  for (auto tile_group_id : tile_group_ids) {
+    auto tile_group = manager.GetTileGroup(tile_group_id);
+    if (tile_group == nullptr) {
+      complete = false;
+      continue;
+    }
+
+    auto tile_group_header = tile_group->GetHeader();
+    auto tuple_count = tile_group_header->GetCurrentNextTupleSlot();
+    for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+      auto begin_cid = tile_group_header->GetBeginCommitId(tuple_id);
+      auto end_cid = tile_group_header->GetEndCommitId(tuple_id);
+
+      if (begin_cid > persistent_commit_id &&
+          begin_cid <= max_possible_dirty_commit_id) {
+        // the version of a commit that is not durable
+        if (tile_group_header->GetTransactionId(tuple_id) == INVALID_TXN_ID) {
+          empty_versions.insert(ItemPointer(tile_group_id, tuple_id));
+        }
+        tile_group_header->SetTransactionId(tuple_id, INVALID_TXN_ID);
+
+        auto index_entry_ptr = tile_group_header->GetIndirection(tuple_id);
+        if (index_entry_ptr != nullptr) {
+          index_entry_ptrs.insert(index_entry_ptr);
+        }
+      } else if (end_cid > persistent_commit_id &&
+                 end_cid <= max_possible_dirty_commit_id) {
+        // the version it replaced or deleted is the latest again
+        tile_group_header->SetEndCommitId(tuple_id, MAX_CID);
+        tile_group_header->SetTransactionId(tuple_id, INITIAL_TXN_ID);
+      }
+    }
+
+    tile_group_header->Sync();
+  }
+
+  for (auto index_entry_ptr : index_entry_ptrs) {
+    if (UndoVersionChain(index_entry_ptr, empty_versions,
+                         persistent_commit_id,
+                         max_possible_dirty_commit_id) == false) {
+      complete = false;
+    }
+  }
+
+  return complete;
+}
+
+bool WriteBehindFrontendLogger::UndoVersionChain(
+    ItemPointer *index_entry_ptr, const std::set<ItemPointer> &empty_versions,
+    cid_t persistent_commit_id, cid_t max_possible_dirty_commit_id) {
+  auto &manager = catalog::Manager::GetInstance();
+
+  // the undone versions are the newest ones of the chain
+  std::vector<ItemPointer> undone_versions;
+  ItemPointer live_location = *index_entry_ptr;
+  while (live_location.IsNull() == false) {
+    auto tile_group = manager.GetTileGroup(live_location.block);
+    if (tile_group == nullptr) {
+      return false;
+    }
+    auto tile_group_header = tile_group->GetHeader();
+    auto begin_cid = tile_group_header->GetBeginCommitId(live_location.offset);
+    if (begin_cid <= persistent_commit_id ||
+        begin_cid > max_possible_dirty_commit_id) {
+      break;
+    }
+    undone_versions.push_back(live_location);
+    live_location = tile_group_header->GetNextItemPointer(live_location.offset);
+  }
+
+  if (undone_versions.empty() == true) {
+    return true;
+  }
+
+  // the index entries lead to the version that is the latest again
+  if (live_location.IsNull() == false) {
+    auto live_tile_group_header =
+        manager.GetTileGroup(live_location.block)->GetHeader();
+    live_tile_group_header->SetPrevItemPointer(live_location.offset,
+                                               INVALID_ITEMPOINTER);
+    live_tile_group_header->Sync();
+    *index_entry_ptr = live_location;
+  }
+
+  // the keys only the undone versions hold are removed from the indexes,
+  // the same as for an aborted update. the newest version of an undone
+  // insert takes the entries of its older versions along, so they follow it.
+  auto &gc_manager = gc::GCManagerFactory::GetInstance();
+  bool dead_tuple_recycled = false;
+  for (auto &undone_version : undone_versions) {
+    auto tile_group = manager.GetTileGroup(undone_version.block);
+    auto tile_group_header = tile_group->GetHeader();
+
+    // an empty version of a delete holds no key
+    GCVersionType version_type = GC_VERSION_TYPE_INVALID;
+    bool empty_version = (empty_versions.count(undone_version) != 0);
+    if (live_location.IsNull() == false) {
+      tile_group_header->SetNextItemPointer(undone_version.offset,
+                                            live_location);
+      if (empty_version == false) {
+        version_type = GC_VERSION_TYPE_ABORT_UPDATE;
+      }
+    } else if (empty_version == false && dead_tuple_recycled == false) {
+      version_type = GC_VERSION_TYPE_ABORT_INSERT;
+      dead_tuple_recycled = true;
+    }
+    tile_group_header->SetPrevItemPointer(undone_version.offset,
+                                          INVALID_ITEMPOINTER);
+    tile_group_header->Sync();
+
+    gc_manager.RecycleTupleSlot(tile_group->GetTableId(), undone_version.block,
+                                undone_version.offset, INVALID_CID,
+                                version_type);
+  }
+
+  return true;
+}
+
 }  // namespace logging
 }  // namespace peloton
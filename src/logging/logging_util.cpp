@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <dirent.h>
 #include <cstring>
 
@@ -24,19 +26,37 @@ namespace logging {
 //===--------------------------------------------------------------------===//
 // LoggingUtil
 //===--------------------------------------------------------------------===//
-void LoggingUtil::FFlushFsync(FileHandle &file_handle) {
+bool LoggingUtil::FFlushFsync(FileHandle &file_handle) {
   // First, flush
   PL_ASSERT(file_handle.fd != -1);
-  if (file_handle.fd == -1) return;
+  if (file_handle.fd == -1) return false;
   int ret = fflush(file_handle.file);
   if (ret != 0) {
     LOG_ERROR("Error occured in fflush(%d)", ret);
+    return false;
   }
   // Finally, sync
   ret = fsync(file_handle.fd);
   if (ret != 0) {
     LOG_ERROR("Error occured in fsync(%d)", ret);
+    return false;
+  }
+  return true;
+}
+
+bool LoggingUtil::FsyncDirectory(const char *dir_name) {
+  int fd = open(dir_name, O_RDONLY | O_DIRECTORY);
+  if (fd == -1) {
+    LOG_ERROR("Unable to open directory %s: %s", dir_name, strerror(errno));
+    return false;
+  }
+  int ret = fsync(fd);
+  close(fd);
+  if (ret != 0) {
+    LOG_ERROR("Error occured in fsync of directory %s", dir_name);
+    return false;
   }
+  return true;
 }
 
 bool LoggingUtil::InitFileHandle(const char *name, FileHandle &file_handle,
@@ -192,7 +212,8 @@ bool LoggingUtil::ReadTupleRecordHeader(TupleRecord &tuple_record,
   return true;
 }
 
-storage::Tuple *LoggingUtil::ReadTupleRecordBody(catalog::Schema *schema,
+storage::Tuple *LoggingUtil::ReadTupleRecordBody(TupleRecord &tuple_record,
+                                                 catalog::Schema *schema,
                                                  VarlenPool *pool,
                                                  FileHandle &file_handle) {
   // Check if the frame is broken
@@ -212,10 +233,7 @@ storage::Tuple *LoggingUtil::ReadTupleRecordBody(catalog::Schema *schema,
   CopySerializeInputBE tuple_body(body, body_size);
 
   // We create a tuple based on the message
-  storage::Tuple *tuple = new storage::Tuple(schema, true);
-  tuple->DeserializeFrom(tuple_body, pool);
-
-  return tuple;
+  return tuple_record.DeserializeBody(tuple_body, schema, pool);
 }
 
 void LoggingUtil::SkipTupleRecordBody(FileHandle &file_handle) {
@@ -11,60 +11,50 @@
 //===----------------------------------------------------------------------===//
 
 
+#include <new>
+
 #include "logging/records/log_record_pool.h"
 
 namespace peloton {
 namespace logging {
 
-void LogRecordPool::Clear() {
-  // Clean up
-  txn_log_table.clear();
-}
-
-int LogRecordPool::CreateTxnLogList(txn_id_t txn_id) {
-  // Create a new transaction log list if not already found
-  auto existing_list = ExistsTxnLogRecordList(txn_id);
-
-  if (existing_list == false) {
-    txn_log_table.insert(
-        std::pair<txn_id_t, std::vector<std::unique_ptr<TupleRecord>>>(
-            txn_id, std::vector<std::unique_ptr<TupleRecord>>()));
+LogRecordPool::~LogRecordPool() { Clear(); }
+
+TupleRecord *LogRecordPool::CreateTupleRecord(LogRecordType log_record_type,
+                                              cid_t cid, oid_t table_oid,
+                                              ItemPointer insert_location,
+                                              ItemPointer delete_location,
+                                              oid_t db_oid) {
+  // Grow the pool by a chunk if the staged records fill it
+  auto chunk_idx = record_count_ / LOG_RECORD_POOL_CHUNK_SIZE;
+  if (chunk_idx == chunks_.size()) {
+    chunks_.emplace_back(new RecordSlot[LOG_RECORD_POOL_CHUNK_SIZE]);
   }
 
-  return 0;
-}
-
-int LogRecordPool::AddLogRecord(std::unique_ptr<TupleRecord> record) {
-  // Get the record transaction id
-  auto record_transaction_id = record->GetTransactionId();
-
-  // Locate the transaction log list
-  auto existing_list = ExistsTxnLogRecordList(record_transaction_id);
+  auto slot =
+      &chunks_[chunk_idx][record_count_ % LOG_RECORD_POOL_CHUNK_SIZE];
+  auto record =
+      new (slot) TupleRecord(log_record_type, cid, table_oid, insert_location,
+                             delete_location, nullptr, db_oid);
+  record_count_++;
 
-  // Add to the transaction log list if found
-  if (existing_list != false) {
-    txn_log_table.at(record_transaction_id).push_back(std::move(record));
-    return 0;
-  }
-
-  return -1;
+  return record;
 }
 
-void LogRecordPool::RemoveTxnLogRecordList(txn_id_t txn_id) {
-  // Locate the transaction log list
-  if (txn_log_table.find(txn_id) != txn_log_table.end()) {
-    // Erase transaction log record list and its contents
-    txn_log_table.erase(txn_id);
+void LogRecordPool::Clear() {
+  // Clean up the records, the chunks are reused
+  for (size_t record_idx = 0; record_idx < record_count_; record_idx++) {
+    GetRecord(record_idx)->~TupleRecord();
   }
+  record_count_ = 0;
 }
 
-bool LogRecordPool::ExistsTxnLogRecordList(txn_id_t txn_id) {
-  // Locate the transaction log list
-  if (txn_log_table.find(txn_id) != txn_log_table.end()) {
-    return true;
-  } else {
-    return false;
-  }
-}
-}
+TupleRecord *LogRecordPool::GetRecord(size_t record_idx) const {
+  PL_ASSERT(record_idx < record_count_);
+  auto &chunk = chunks_[record_idx / LOG_RECORD_POOL_CHUNK_SIZE];
+  return reinterpret_cast<TupleRecord *>(
+      &chunk[record_idx % LOG_RECORD_POOL_CHUNK_SIZE]);
 }
+
+}  // namespace logging
+}  // namespace peloton
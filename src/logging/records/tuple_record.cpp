@@ -35,7 +35,11 @@ bool TupleRecord::Serialize(CopySerializeOutput &output) {
     case LOGRECORD_TYPE_WAL_TUPLE_INSERT:
     case LOGRECORD_TYPE_WAL_TUPLE_UPDATE: {
       storage::Tuple *tuple = (storage::Tuple *)data;
-      tuple->SerializeTo(output);
+      if (IsPartialImage()) {
+        tuple->SerializeColumnsTo(output, column_ids);
+      } else {
+        tuple->SerializeTo(output);
+      }
       break;
     }
 
@@ -75,13 +79,31 @@ void TupleRecord::SerializeHeader(CopySerializeOutput &output) {
   // then reserve 4 bytes for the header size
   output.WriteInt(0);
 
-  output.WriteLong(db_oid);
-  output.WriteLong(table_oid);
-  output.WriteLong(cid);
-  output.WriteLong(insert_location.block);
-  output.WriteLong(insert_location.offset);
-  output.WriteLong(delete_location.block);
-  output.WriteLong(delete_location.offset);
+  // oids and ids are mostly small, so they are written as varints, and the
+  // invalid location of an insert or a delete is left out.
+  int8_t flags = 0;
+  if (insert_location.IsNull() == false) {
+    flags |= TUPLE_RECORD_INSERT_LOCATION;
+  }
+  if (delete_location.IsNull() == false) {
+    flags |= TUPLE_RECORD_DELETE_LOCATION;
+  }
+  if (IsPartialImage()) {
+    flags |= TUPLE_RECORD_PARTIAL_IMAGE;
+  }
+  output.WriteByte(flags);
+
+  output.WriteVarint(db_oid);
+  output.WriteVarint(table_oid);
+  output.WriteVarint(cid);
+  if (flags & TUPLE_RECORD_INSERT_LOCATION) {
+    output.WriteVarint(insert_location.block);
+    output.WriteVarint(insert_location.offset);
+  }
+  if (flags & TUPLE_RECORD_DELETE_LOCATION) {
+    output.WriteVarint(delete_location.block);
+    output.WriteVarint(delete_location.offset);
+  }
 
   output.WriteIntAt(
       start, static_cast<int32_t>(output.Position() - start - sizeof(int32_t)));
@@ -93,24 +115,50 @@ void TupleRecord::SerializeHeader(CopySerializeOutput &output) {
  */
 void TupleRecord::DeserializeHeader(CopySerializeInputBE &input) {
   input.ReadInt();
-  db_oid = (oid_t)(input.ReadLong());
+  int8_t flags = input.ReadByte();
+  db_oid = (oid_t)(input.ReadVarint());
   PL_ASSERT(db_oid);
-  table_oid = (oid_t)(input.ReadLong());
+  table_oid = (oid_t)(input.ReadVarint());
   PL_ASSERT(table_oid);
-  cid = (txn_id_t)(input.ReadLong());
+  cid = (txn_id_t)(input.ReadVarint());
   PL_ASSERT(cid);
-  insert_location.block = (oid_t)(input.ReadLong());
-  insert_location.offset = (oid_t)(input.ReadLong());
-  delete_location.block = (oid_t)(input.ReadLong());
-  delete_location.offset = (oid_t)(input.ReadLong());
+  insert_location = INVALID_ITEMPOINTER;
+  if (flags & TUPLE_RECORD_INSERT_LOCATION) {
+    insert_location.block = (oid_t)(input.ReadVarint());
+    insert_location.offset = (oid_t)(input.ReadVarint());
+  }
+  delete_location = INVALID_ITEMPOINTER;
+  if (flags & TUPLE_RECORD_DELETE_LOCATION) {
+    delete_location.block = (oid_t)(input.ReadVarint());
+    delete_location.offset = (oid_t)(input.ReadVarint());
+  }
+  // the ids are read along with the body
+  column_ids.clear();
+  partial_image = (flags & TUPLE_RECORD_PARTIAL_IMAGE) != 0;
+}
+
+/**
+ * @brief Deserialize the tuple in the body
+ * @param input
+ */
+storage::Tuple *TupleRecord::DeserializeBody(CopySerializeInputBE &input,
+                                             catalog::Schema *schema,
+                                             VarlenPool *pool) {
+  storage::Tuple *tuple = new storage::Tuple(schema, true);
+  if (partial_image) {
+    tuple->DeserializeColumnsFrom(input, pool, column_ids);
+  } else {
+    tuple->DeserializeFrom(input, pool);
+  }
+  return tuple;
 }
 
 // Used for write behind logging
 size_t TupleRecord::GetTupleRecordSize(void) {
-  // log_record_type + header_legnth + db_oid + table_oid + txn_id +
-  // insert_location + delete_location
-  return sizeof(char) + sizeof(int) + sizeof(oid_t) + sizeof(oid_t) +
-         sizeof(txn_id_t) + sizeof(ItemPointer) * 2;
+  // upper bound of log_record_type + header_legnth + flags + db_oid +
+  // table_oid + txn_id + insert_location + delete_location, as the varint of
+  // an oid takes up to 5 bytes and the one of an id up to 10 bytes
+  return sizeof(char) + sizeof(int) + sizeof(char) + 5 * 2 + 10 + 5 * 4;
 }
 
 void TupleRecord::SetTuple(storage::Tuple *tuple) { this->tuple = tuple; }
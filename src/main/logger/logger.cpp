@@ -61,10 +61,17 @@ void RunBenchmark() {
   peloton_flush_mode = state.flush_mode;
   peloton_pcommit_latency = state.pcommit_latency;
 
+  //===--------------------------------------------------------------------===//
+  // Standby
+  //===--------------------------------------------------------------------===//
+  if (state.replication_port != 0 && state.remote_endpoint.empty()) {
+    // Replay the log shipped by the primary
+    SetupLoggingOnFollower();
+  }
   //===--------------------------------------------------------------------===//
   // WAL
   //===--------------------------------------------------------------------===//
-  if (IsBasedOnWriteAheadLogging(peloton_logging_mode)) {
+  else if (IsBasedOnWriteAheadLogging(peloton_logging_mode)) {
     // Prepare a simple log file
     PrepareLogFile();
 
@@ -34,12 +34,18 @@ void Usage(FILE* out) {
           "   -a --asynchronous-mode :  Asynchronous mode \n"
           "   -e --experiment-type   :  Experiment Type \n"
           "   -f --data-file-size    :  Data file size (MB) \n"
+          "   -g --replication-type  :  Replication type \n"
           "   -l --logging-type      :  Logging type \n"
           "   -n --nvm-latency       :  NVM latency \n"
+          "   -o --direct-io         :  Direct I/O log segments \n"
           "   -p --pcommit-latency   :  pcommit latency \n"
+          "   -q --io-uring          :  io_uring log and checkpoint writes \n"
+          "   -r --log-streams       :  Number of log streams \n"
           "   -v --flush-mode        :  Flush mode \n"
           "   -w --commit-interval   :  Group commit interval \n"
-          "   -y --benchmark-type    :  Benchmark type \n");
+          "   -x --replication-port  :  Replication port \n"
+          "   -y --benchmark-type    :  Benchmark type \n"
+          "   -z --remote-endpoint   :  Standby to ship the log to \n");
 }
 
 static struct option opts[] = {
@@ -49,7 +55,10 @@ static struct option opts[] = {
     {"replication-type", optional_argument, NULL, 'g'},
     {"logging-type", optional_argument, NULL, 'l'},
     {"nvm-latency", optional_argument, NULL, 'n'},
+    {"direct-io", no_argument, NULL, 'o'},
     {"pcommit-latency", optional_argument, NULL, 'p'},
+    {"io-uring", no_argument, NULL, 'q'},
+    {"log-streams", optional_argument, NULL, 'r'},
     {"skew", optional_argument, NULL, 's'},
     {"flush-mode", optional_argument, NULL, 'v'},
     {"commit-interval", optional_argument, NULL, 'w'},
@@ -167,6 +176,33 @@ static void ValidateWaitTimeout(const configuration& state) {
   LOG_INFO("wait_timeout :: %d", state.wait_timeout);
 }
 
+static void ValidateLogStreams(const configuration& state) {
+  if (state.log_streams <= 0) {
+    LOG_ERROR("Invalid log_streams :: %d", state.log_streams);
+    exit(EXIT_FAILURE);
+  }
+
+  LOG_INFO("log_streams :: %d", state.log_streams);
+}
+
+static void ValidateReplication(const configuration& state) {
+  // the primary takes the answers of the standby on its replication port
+  if (state.remote_endpoint.empty() == false && state.replication_port <= 0) {
+    LOG_ERROR("Invalid replication_port :: %d", state.replication_port);
+    exit(EXIT_FAILURE);
+  }
+
+  if (state.replication_type < ASYNC_REPLICATION ||
+      state.replication_type > SEMISYNC_REPLICATION) {
+    LOG_ERROR("Invalid replication_type :: %d", state.replication_type);
+    exit(EXIT_FAILURE);
+  }
+
+  LOG_INFO("replication :: %s port %d type %d",
+           state.remote_endpoint.c_str(), state.replication_port,
+           state.replication_type);
+}
+
 static void ValidateFlushMode(const configuration& state) {
   if (state.flush_mode <= 0 || state.flush_mode >= 3) {
     LOG_ERROR("Invalid flush_mode :: %d", state.flush_mode);
@@ -266,6 +302,12 @@ void ParseArguments(int argc, char* argv[], configuration& state) {
   state.pcommit_latency = 0;
   state.asynchronous_mode = ASYNCHRONOUS_TYPE_SYNC;
   state.checkpoint_type = CHECKPOINT_TYPE_INVALID;
+  state.direct_io = false;
+  state.io_uring = false;
+  state.log_streams = 1;
+  state.remote_endpoint = "";
+  state.replication_port = 0;
+  state.replication_type = ASYNC_REPLICATION;
 
   // Default YCSB Values
   ycsb::state.scale_factor = 1;
@@ -284,11 +326,12 @@ void ParseArguments(int argc, char* argv[], configuration& state) {
   // Parse args
   while (1) {
     int idx = 0;
-    // logger - a:e:f:g:hl:n:p:v:w:y:
+    // logger - a:e:f:g:hil:n:op:qr:v:w:x:y:z:
     // ycsb   - b:c:d:k:t:u:
     // tpcc   - b:d:k:t:
-    int c = getopt_long(argc, argv, "a:e:f:hil:n:p:v:w:y:b:c:d:k:u:t:",
-                        opts, &idx);
+    int c = getopt_long(argc, argv,
+                        "a:e:f:g:hil:n:op:qr:v:w:x:y:z:b:c:d:k:u:t:", opts,
+                        &idx);
 
     if (c == -1) break;
 
@@ -302,6 +345,9 @@ void ParseArguments(int argc, char* argv[], configuration& state) {
       case 'f':
         state.data_file_size = atoi(optarg);
         break;
+      case 'g':
+        state.replication_type = (ReplicationType)atoi(optarg);
+        break;
       case 'i':
         state.checkpoint_type = CHECKPOINT_TYPE_NORMAL;
         break;
@@ -311,18 +357,33 @@ void ParseArguments(int argc, char* argv[], configuration& state) {
       case 'n':
         state.nvm_latency = atoi(optarg);
         break;
+      case 'o':
+        state.direct_io = true;
+        break;
       case 'p':
         state.pcommit_latency = atoi(optarg);
         break;
+      case 'q':
+        state.io_uring = true;
+        break;
+      case 'r':
+        state.log_streams = atoi(optarg);
+        break;
       case 'v':
         state.flush_mode = atoi(optarg);
         break;
       case 'w':
         state.wait_timeout = atoi(optarg);
         break;
+      case 'x':
+        state.replication_port = atoi(optarg);
+        break;
       case 'y':
         state.benchmark_type = (BenchmarkType)atoi(optarg);
         break;
+      case 'z':
+        state.remote_endpoint = optarg;
+        break;
 
       // YCSB
       case 'b':
@@ -377,6 +438,8 @@ void ParseArguments(int argc, char* argv[], configuration& state) {
   ValidateDataFileSize(state);
   ValidateLogFileDir(state);
   ValidateWaitTimeout(state);
+  ValidateLogStreams(state);
+  ValidateReplication(state);
   ValidateFlushMode(state);
   ValidateNVMLatency(state);
   ValidatePCOMMITLatency(state);
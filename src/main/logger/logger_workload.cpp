@@ -38,6 +38,8 @@
 
 #include "logging/loggers/wbl_frontend_logger.h"
 #include "logging/checkpoint_manager.h"
+#include "networking/logging_service.h"
+#include "networking/rpc_server.h"
 
 //===--------------------------------------------------------------------===//
 // GUC Variables
@@ -154,9 +156,13 @@ void StartLogging(std::thread& log_thread, std::thread& checkpoint_thread) {
       // Do any recovery
       log_manager.StartRecoveryMode();
 
-      // Wait for logging mode
-      log_manager.WaitForModeTransition(peloton::LOGGING_STATUS_TYPE_LOGGING,
-                                        true);
+      // Wait for logging mode, or for the loggers to give up on recovery
+      log_manager.WaitForModeTransition(peloton::LOGGING_STATUS_TYPE_RECOVERY,
+                                        false);
+      if (log_manager.IsRecoveryFailed()) {
+        LOG_ERROR("Could not recover the database from the log");
+        return;
+      }
 
       // Done recovery
       log_manager.DoneRecovery();
@@ -248,6 +254,49 @@ void CleanUpLogDirectory() {
   RemoveDirectory(wal_directory_path.c_str());
 }
 
+// the rpc server runs the event loop of its thread until the process exits.
+// it takes the log on a standby, and the answers of the standby on a primary.
+static void StartReplicationServer() {
+  static networking::RpcServer rpc_server(state.replication_port);
+  static networking::LoggingService logging_service;
+
+  rpc_server.RegisterService(&logging_service);
+  std::thread server_thread(&networking::RpcServer::Start, &rpc_server);
+  server_thread.detach();
+}
+
+/**
+ * @brief replay the log shipped by the primary until it is done
+ */
+bool SetupLoggingOnFollower() {
+  if (IsBasedOnWriteAheadLogging(peloton_logging_mode) == false) {
+    LOG_ERROR("Only the write ahead log can be replicated");
+    return false;
+  }
+
+  // the standby starts from the database the primary loaded
+  ResetSystem();
+
+  auto& log_manager = logging::LogManager::GetInstance();
+  auto& log_replayer = log_manager.GetLogReplayer();
+  StartReplicationServer();
+
+  int duration = 0;
+  if (state.benchmark_type == BENCHMARK_TYPE_YCSB) {
+    duration = ycsb::state.duration;
+  } else if (state.benchmark_type == BENCHMARK_TYPE_TPCC) {
+    duration = tpcc::state.duration;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration));
+
+  // take over once the primary is done
+  log_manager.PromoteStandby();
+
+  WriteOutput(log_replayer.GetReplayedCommitId());
+
+  return true;
+}
+
 /**
  * @brief writing a simple log file
  */
@@ -260,6 +309,10 @@ bool PrepareLogFile() {
   log_manager.SetLogDirectoryName(state.log_file_dir);
   log_manager.SetLogFileName(state.log_file_dir + "/" +
                              logging::WriteBehindFrontendLogger::wbl_log_path);
+  log_manager.SetDirectIO(state.direct_io);
+  log_manager.SetIoUring(state.io_uring);
+  log_manager.Configure(peloton_logging_mode, false, state.log_streams,
+                        LOGGER_MAPPING_TYPE_AFFINITY);
 
   auto& checkpoint_manager = logging::CheckpointManager::GetInstance();
 
@@ -303,6 +356,13 @@ bool PrepareLogFile() {
   // Initializing logging module
   StartLogging(logging_thread, checkpoint_thread);
 
+  // Ship the log to the standby
+  if (state.remote_endpoint.empty() == false) {
+    StartReplicationServer();
+    log_manager.StartReplication(state.remote_endpoint,
+                                 state.replication_type);
+  }
+
   // Build the log
   BuildLog();
 
@@ -320,6 +380,7 @@ bool PrepareLogFile() {
       logging_thread.join();
     }
   }
+  log_manager.StopReplication();
 
   // Pick metrics based on benchmark type
   double throughput = 0;
@@ -17,6 +17,7 @@
 #include "common/init.h"
 #include "common/config.h"
 #include "common/macros.h"
+#include "concurrency/transaction_manager_factory.h"
 #include "wire/libevent_server.h"
 #include "wire/socket_base.h"
 
@@ -33,6 +34,10 @@ int main(int argc, char *argv[]) {
     ::google::HandleCommandLineHelpFlags();
   }
 
+  // Pick the concurrency control protocol
+  peloton::concurrency::TransactionManagerFactory::Configure(
+      static_cast<peloton::ConcurrencyType>(FLAGS_concurrency_type));
+
   // Setup
   peloton::PelotonInit::Initialize();
 
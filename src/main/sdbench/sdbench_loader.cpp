@@ -77,36 +77,28 @@ void LoadTable() {
   const oid_t col_count = state.column_count + 1;
   const int tuple_count = state.scale_factor * state.tuples_per_tilegroup;
 
-  auto table_schema = sdbench_table->GetSchema();
-
   /////////////////////////////////////////////////////////
   // Load in the data
   /////////////////////////////////////////////////////////
 
-  // Insert tuples into tile_group.
-  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
-  const bool allocate = true;
-  auto txn = txn_manager.BeginTransaction();
-  std::unique_ptr<VarlenPool> pool(new VarlenPool(BACKEND_TYPE_MM));
+  // Build the table column at a time and bulk load it
+  std::vector<std::vector<Value>> column_batches(col_count);
+  for (oid_t col_itr = 0; col_itr < col_count; col_itr++) {
+    column_batches[col_itr].reserve(tuple_count);
+  }
 
   int rowid;
   for (rowid = 0; rowid < tuple_count; rowid++) {
     int populate_value = rowid;
 
-    storage::Tuple tuple(table_schema, allocate);
-
     for (oid_t col_itr = 0; col_itr < col_count; col_itr++) {
       auto value = ValueFactory::GetIntegerValue(populate_value);
-      tuple.SetValue(col_itr, value, pool.get());
+      column_batches[col_itr].push_back(value);
     }
-
-    ItemPointer tuple_slot_id = sdbench_table->InsertTuple(&tuple);
-    PL_ASSERT(tuple_slot_id.block != INVALID_OID);
-    PL_ASSERT(tuple_slot_id.offset != INVALID_OID);
-    txn->RecordInsert(tuple_slot_id);
   }
 
-  txn_manager.CommitTransaction(txn);
+  UNUSED_ATTRIBUTE bool status = sdbench_table->BulkLoad(column_batches);
+  PL_ASSERT(status == true);
 }
 
 void CreateAndLoadTable(LayoutType layout_type) {
@@ -20,6 +20,7 @@
 #include "benchmark/tpcc/tpcc_workload.h"
 
 #include "common/logger.h"
+#include "concurrency/transaction_manager_factory.h"
 
 namespace peloton {
 namespace benchmark {
@@ -41,6 +42,8 @@ static void WriteOutput(double stat) {
 
 // Main Entry Point
 void RunBenchmark() {
+  concurrency::TransactionManagerFactory::Configure(state.protocol);
+
   // Create the database
   CreateTPCCDatabase();
 
@@ -29,6 +29,7 @@ void Usage(FILE *out) {
           "   -d --duration          :  execution duration \n"
           "   -k --warehouse_count   :  warehouse count \n"
           "   -t --transaction-count :  # of transactions \n"
+          "   -p --protocol          :  concurrency control protocol \n"
   );
 }
 
@@ -37,6 +38,7 @@ static struct option opts[] = {
     { "duration", optional_argument, NULL, 'd' },
     { "warehouse_count", optional_argument, NULL, 'k' },
     { "transaction_count", optional_argument, NULL, 't'},
+    { "protocol", optional_argument, NULL, 'p'},
     { NULL, 0, NULL, 0}
 };
 
@@ -76,17 +78,31 @@ void ValidateTransactionCount(const configuration &state) {
   LOG_INFO("%s : %d", "transaction_count", state.transaction_count);
 }
 
+void ValidateProtocol(const configuration &state) {
+  if (state.protocol != CONCURRENCY_TYPE_TIMESTAMP_ORDERING &&
+      state.protocol != CONCURRENCY_TYPE_TIMESTAMP_ORDERING_RB &&
+      state.protocol != CONCURRENCY_TYPE_SSI &&
+      state.protocol != CONCURRENCY_TYPE_TWO_PHASE_LOCKING_NO_WAIT &&
+      state.protocol != CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE) {
+    LOG_ERROR("Invalid protocol :: %d", state.protocol);
+    exit(EXIT_FAILURE);
+  }
+
+  LOG_INFO("%s : %d", "protocol", state.protocol);
+}
+
 void ParseArguments(int argc, char *argv[], configuration &state) {
   // Default Values
   state.duration = 1000;
   state.backend_count = 2;
   state.warehouse_count = 2;  // 10
   state.transaction_count = 0;
+  state.protocol = CONCURRENCY_TYPE_TIMESTAMP_ORDERING;
 
   // Parse args
   while (1) {
     int idx = 0;
-    int c = getopt_long(argc, argv, "ah:b:d:k:t:", opts, &idx);
+    int c = getopt_long(argc, argv, "ah:b:d:k:t:p:", opts, &idx);
 
     if (c == -1) break;
 
@@ -103,6 +119,9 @@ void ParseArguments(int argc, char *argv[], configuration &state) {
       case 't':
         state.transaction_count = atoi(optarg);
         break;
+      case 'p':
+        state.protocol = static_cast<ConcurrencyType>(atoi(optarg));
+        break;
 
       case 'h':
         Usage(stderr);
@@ -127,6 +146,7 @@ void ParseArguments(int argc, char *argv[], configuration &state) {
   ValidateWarehouseCount(state);
   ValidateDuration(state);
   ValidateTransactionCount(state);
+  ValidateProtocol(state);
 
 }
 
@@ -1955,7 +1955,8 @@ bool RunStockLevel() {
    */
 
   auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
-  auto txn = txn_manager.BeginTransaction();
+  // the stock level query may read a slightly stale snapshot
+  auto txn = txn_manager.BeginReadonlyTransaction();
 
   std::unique_ptr<executor::ExecutorContext> context(
       new executor::ExecutorContext(txn));
@@ -120,37 +120,27 @@ void LoadYCSBDatabase() {
   const oid_t col_count = state.column_count + 1;
   const int tuple_count = state.scale_factor * DEFAULT_TUPLES_PER_TILEGROUP;
 
-  // Pick the user table
-  auto table_schema = user_table->GetSchema();
-  std::string field_raw_value(ycsb_field_length - 1, 'o');
-
   /////////////////////////////////////////////////////////
   // Load in the data
   /////////////////////////////////////////////////////////
 
-  // Insert tuples into tile_group.
-  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
-  const bool allocate = true;
-  auto txn = txn_manager.BeginTransaction();
-  std::unique_ptr<executor::ExecutorContext> context(
-      new executor::ExecutorContext(txn));
+  // Build the table column at a time and bulk load it
+  std::vector<std::vector<Value>> column_batches(col_count);
+  for (oid_t col_itr = 0; col_itr < col_count; col_itr++) {
+    column_batches[col_itr].reserve(tuple_count);
+  }
 
   int rowid;
   for (rowid = 0; rowid < tuple_count; rowid++) {
-    std::unique_ptr<storage::Tuple> tuple(
-        new storage::Tuple(table_schema, allocate));
     auto key_value = ValueFactory::GetIntegerValue(rowid);
 
     for (oid_t col_itr = 0; col_itr < col_count; col_itr++) {
-      tuple->SetValue(col_itr, key_value, nullptr);
+      column_batches[col_itr].push_back(key_value);
     }
-
-    planner::InsertPlan node(user_table, std::move(tuple));
-    executor::InsertExecutor executor(&node, context.get());
-    executor.Execute();
   }
 
-  txn_manager.CommitTransaction(txn);
+  UNUSED_ATTRIBUTE bool status = user_table->BulkLoad(column_batches);
+  PL_ASSERT(status == true);
 }
 
 }  // namespace ycsb
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// logging_service.cpp
+//
+// Identification: src/networking/logging_service.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#include "networking/logging_service.h"
+#include "logging/log_manager.h"
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace peloton {
+namespace networking {
+
+void LoggingService::LogRecordReplay(
+    ::google::protobuf::RpcController* controller,
+    const LogRecordReplayRequest* request, LogRecordReplayResponse* response,
+    ::google::protobuf::Closure* done) {
+  if (controller->Failed()) {
+    std::string error = controller->ErrorText();
+    LOG_TRACE("LoggingService with controller failed:%s ", error.c_str());
+  }
+
+  auto &log_manager = logging::LogManager::GetInstance();
+
+  // If request is not null, this is a rpc call, the standby replays the log
+  if (request != NULL) {
+    LOG_TRACE("Received batch %ld of log stream %d",
+              request->sequence_number(), request->logger_id());
+
+    auto &log_replayer = log_manager.GetLogReplayer();
+    int64_t sequence_number =
+        log_replayer.Replay(request->logger_id(), request->sequence_number(),
+                            request->log(), request->logger_count());
+
+    response->set_sequence_number(sequence_number);
+    response->set_logger_id(request->logger_id());
+    response->set_status(REPLAY_COMPLETE);
+
+    // if callback exist, run it
+    if (done) {
+      done->Run();
+    }
+  }
+  // Here is for the client callback, the primary takes the answer
+  else {
+    PL_ASSERT(response);
+    LOG_TRACE("Standby replayed log stream %d up to batch %ld",
+              response->logger_id(), response->sequence_number());
+
+    log_manager.AcknowledgeShippedLog(response->logger_id(),
+                                      response->sequence_number());
+  }
+}
+
+}  // namespace networking
+}  // namespace peloton
@@ -12,6 +12,8 @@
 
 #include <mutex>
 #include <utility>
+#include <algorithm>
+#include <numeric>
 
 #include "brain/clusterer.h"
 #include "brain/sample.h"
@@ -30,6 +32,7 @@
 #include "storage/tile.h"
 #include "storage/tile_group_header.h"
 #include "storage/tile_group_factory.h"
+#include "storage/storage_manager.h"
 #include "storage/abstract_table.h"
 #include "storage/database.h"
 #include "storage/data_table.h"
@@ -468,6 +471,298 @@ bool DataTable::CheckForeignKeyConstraints(const storage::Tuple *tuple
   return true;
 }
 
+//===--------------------------------------------------------------------===//
+// BULK LOAD
+//===--------------------------------------------------------------------===//
+
+bool DataTable::BulkLoad(
+    const std::vector<std::vector<Value>> &column_batches) {
+  oid_t column_count = schema->GetColumnCount();
+  if (column_batches.size() != column_count) {
+    LOG_ERROR("Bulk load has %lu columns, table has %u", column_batches.size(),
+              column_count);
+    return false;
+  }
+
+  // The values are copied into the tiles as they are, so they must already
+  // have the types of the columns
+  size_t tuple_count = column_batches[0].size();
+  for (oid_t column_itr = 0; column_itr < column_count; column_itr++) {
+    auto &column_batch = column_batches[column_itr];
+    if (column_batch.size() != tuple_count) {
+      LOG_ERROR("Bulk load column %u has %lu values instead of %lu",
+                column_itr, column_batch.size(), tuple_count);
+      return false;
+    }
+
+    auto column_type = schema->GetType(column_itr);
+    auto allow_null = schema->AllowNull(column_itr);
+    for (auto &value : column_batch) {
+      if (value.IsNull() == true) {
+        if (allow_null == false) {
+          LOG_ERROR("Bulk load column %u is not nullable", column_itr);
+          return false;
+        }
+      } else if (value.GetValueType() != column_type) {
+        LOG_ERROR("Bulk load column %u has a value of the wrong type",
+                  column_itr);
+        return false;
+      }
+    }
+  }
+
+  if (tuple_count == 0) {
+    return true;
+  }
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  auto txn = txn_manager.BeginTransaction();
+
+  // Build the tile groups and hand their tuples to the transaction, so they
+  // all become visible when it commits
+  std::vector<ItemPointer *> index_entry_ptrs;
+  index_entry_ptrs.reserve(tuple_count);
+
+  std::vector<std::shared_ptr<TileGroup>> tile_groups;
+  for (size_t begin_offset = 0; begin_offset < tuple_count;
+       begin_offset += tuples_per_tilegroup_) {
+    size_t chunk_size =
+        std::min(tuples_per_tilegroup_, tuple_count - begin_offset);
+    tile_groups.push_back(
+        BuildTileGroup(column_batches, begin_offset, chunk_size));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(data_table_mutex_);
+    for (auto &tile_group : tile_groups) {
+      auto tile_group_id = tile_group->GetTileGroupId();
+
+      tile_groups_.Append(tile_group_id);
+
+      // add tile group metadata in locator
+      catalog_manager.AddTileGroup(tile_group_id, tile_group);
+
+      // we must guarantee that the compiler always add tile group before
+      // adding tile_group_count_.
+      COMPILER_MEMORY_FENCE;
+
+      tile_group_count_++;
+
+      LOG_TRACE("Bulk loaded tile group : %u ", tile_group_id);
+    }
+  }
+
+  for (auto &tile_group : tile_groups) {
+    auto tile_group_id = tile_group->GetTileGroupId();
+    auto chunk_size = tile_group->GetNextTupleSlot();
+    for (oid_t tuple_itr = 0; tuple_itr < chunk_size; tuple_itr++) {
+      ItemPointer location(tile_group_id, tuple_itr);
+      auto index_entry_ptr = new ItemPointer(location);
+      txn_manager.PerformInsert(txn, location, index_entry_ptr);
+      index_entry_ptrs.push_back(index_entry_ptr);
+    }
+  }
+
+  // Primary keys go first, so that a violation leaves the other indexes
+  // alone. Their keys are kept to take the entries out again on a violation.
+  std::vector<std::shared_ptr<index::Index>> primary_indexes;
+  std::vector<std::vector<std::unique_ptr<storage::Tuple>>> primary_keys;
+  std::vector<std::vector<size_t>> primary_key_orders;
+  std::vector<size_t> primary_inserted_counts;
+
+  oid_t index_count = GetIndexCount();
+  bool res = true;
+  for (oid_t index_itr = 0; index_itr < index_count && res; index_itr++) {
+    auto index = GetIndex(index_itr);
+    if (index->GetIndexType() != INDEX_CONSTRAINT_TYPE_PRIMARY_KEY) {
+      continue;
+    }
+    primary_indexes.push_back(index);
+    primary_keys.emplace_back();
+    primary_key_orders.emplace_back();
+    primary_inserted_counts.push_back(0);
+    BuildBulkIndexKeys(index, column_batches, primary_keys.back(),
+                       primary_key_orders.back());
+    res = BulkInsertInIndex(index, primary_keys.back(),
+                            primary_key_orders.back(), index_entry_ptrs, txn,
+                            primary_inserted_counts.back());
+  }
+
+  if (res == false) {
+    LOG_TRACE("Index constraint violated");
+    for (size_t primary_itr = 0; primary_itr < primary_indexes.size();
+         primary_itr++) {
+      BulkDeleteFromIndex(primary_indexes[primary_itr],
+                          primary_keys[primary_itr],
+                          primary_key_orders[primary_itr], index_entry_ptrs,
+                          primary_inserted_counts[primary_itr]);
+    }
+    txn_manager.AbortTransaction(txn);
+
+    // No index leads to the tuples anymore. The index entry pointers are
+    // left alone, as a concurrent index scan may still hold one of them.
+    for (auto &tile_group : tile_groups) {
+      DropTileGroup(tile_group->GetTileGroupId());
+    }
+    return false;
+  }
+
+  primary_keys.clear();
+  for (oid_t index_itr = 0; index_itr < index_count; index_itr++) {
+    auto index = GetIndex(index_itr);
+    if (index->GetIndexType() == INDEX_CONSTRAINT_TYPE_PRIMARY_KEY) {
+      continue;
+    }
+    std::vector<std::unique_ptr<storage::Tuple>> keys;
+    std::vector<size_t> key_order;
+    size_t inserted_count = 0;
+    BuildBulkIndexKeys(index, column_batches, keys, key_order);
+    BulkInsertInIndex(index, keys, key_order, index_entry_ptrs, txn,
+                      inserted_count);
+  }
+
+  // The whole load is logged as a single transaction at commit
+  if (txn_manager.CommitTransaction(txn) != Result::RESULT_SUCCESS) {
+    return false;
+  }
+
+  IncreaseTupleCount(tuple_count);
+
+  return true;
+}
+
+std::shared_ptr<TileGroup> DataTable::BuildTileGroup(
+    const std::vector<std::vector<Value>> &column_batches,
+    const size_t &begin_offset, const size_t &tuple_count) {
+  auto column_map = GetTileGroupLayout((LayoutType)peloton_layout_mode);
+  std::shared_ptr<TileGroup> tile_group(GetTileGroupWithLayout(column_map));
+  PL_ASSERT(tile_group.get());
+  PL_ASSERT(tuple_count <= tile_group->GetAllocatedTupleCount());
+
+  // Claim the slots at once
+  tile_group->GetHeader()->GetEmptyTupleSlot(tuple_count - 1);
+
+  // Fill in a column at a time, so the schema is looked up once per column
+  oid_t column_count = schema->GetColumnCount();
+  for (oid_t column_itr = 0; column_itr < column_count; column_itr++) {
+    oid_t tile_offset, tile_column_offset;
+    tile_group->LocateTileAndColumn(column_itr, tile_offset,
+                                    tile_column_offset);
+
+    auto tile = tile_group->GetTile(tile_offset);
+    auto tile_schema = tile->GetSchema();
+    auto column_offset = tile_schema->GetOffset(tile_column_offset);
+    auto is_inlined = tile_schema->IsInlined(tile_column_offset);
+    auto column_length = tile_schema->GetAppropriateLength(tile_column_offset);
+
+    auto &column_batch = column_batches[column_itr];
+    for (oid_t tuple_itr = 0; tuple_itr < tuple_count; tuple_itr++) {
+      tile->SetValueFast(column_batch[begin_offset + tuple_itr], tuple_itr,
+                         column_offset, is_inlined, column_length);
+    }
+  }
+
+  return tile_group;
+}
+
+void DataTable::BuildBulkIndexKeys(
+    const std::shared_ptr<index::Index> &index,
+    const std::vector<std::vector<Value>> &column_batches,
+    std::vector<std::unique_ptr<storage::Tuple>> &keys,
+    std::vector<size_t> &key_order) {
+  auto index_schema = index->GetKeySchema();
+  auto indexed_columns = index_schema->GetIndexedColumns();
+  size_t tuple_count = column_batches[0].size();
+
+  keys.reserve(tuple_count);
+  for (size_t tuple_itr = 0; tuple_itr < tuple_count; tuple_itr++) {
+    std::unique_ptr<storage::Tuple> key(new storage::Tuple(index_schema, true));
+    for (oid_t key_itr = 0; key_itr < indexed_columns.size(); key_itr++) {
+      key->SetValue(key_itr,
+                    column_batches[indexed_columns[key_itr]][tuple_itr],
+                    index->GetPool());
+    }
+    keys.push_back(std::move(key));
+  }
+
+  // Inserting in key order keeps the index nodes being filled in cache
+  key_order.resize(tuple_count);
+  std::iota(key_order.begin(), key_order.end(), 0);
+  std::sort(key_order.begin(), key_order.end(),
+            [&keys](const size_t &lhs, const size_t &rhs) {
+              return keys[lhs]->Compare(*keys[rhs]) < 0;
+            });
+}
+
+bool DataTable::BulkInsertInIndex(
+    const std::shared_ptr<index::Index> &index,
+    const std::vector<std::unique_ptr<storage::Tuple>> &keys,
+    const std::vector<size_t> &key_order,
+    const std::vector<ItemPointer *> &index_entry_ptrs,
+    concurrency::Transaction *transaction, size_t &inserted_count) {
+  size_t tuple_count = keys.size();
+  inserted_count = 0;
+
+  auto &transaction_manager =
+      concurrency::TransactionManagerFactory::GetInstance();
+
+  std::function<bool(const ItemPointer &)> fn =
+      std::bind(&concurrency::TransactionManager::IsOccupied,
+                &transaction_manager, transaction, std::placeholders::_1);
+
+  switch (index->GetIndexType()) {
+    case INDEX_CONSTRAINT_TYPE_PRIMARY_KEY: {
+      // duplicates within the batch are next to each other now
+      for (size_t order_itr = 1; order_itr < tuple_count; order_itr++) {
+        if (keys[key_order[order_itr - 1]]->Compare(
+                *keys[key_order[order_itr]]) == 0) {
+          LOG_TRACE("Duplicate key in bulk load on %s",
+                    index->GetName().c_str());
+          return false;
+        }
+      }
+      for (auto tuple_itr : key_order) {
+        if (index->CondInsertEntry(keys[tuple_itr].get(),
+                                   index_entry_ptrs[tuple_itr], fn) == false) {
+          return false;
+        }
+        inserted_count++;
+      }
+    } break;
+    case INDEX_CONSTRAINT_TYPE_UNIQUE: {
+      // unique constraints are not enforced on insert either
+    } break;
+
+    case INDEX_CONSTRAINT_TYPE_DEFAULT:
+    default:
+      for (auto tuple_itr : key_order) {
+        index->InsertEntry(keys[tuple_itr].get(), index_entry_ptrs[tuple_itr]);
+      }
+      inserted_count = tuple_count;
+      break;
+  }
+
+  LOG_TRACE("Bulk inserted %lu keys in %s", tuple_count,
+            index->GetName().c_str());
+  return true;
+}
+
+void DataTable::BulkDeleteFromIndex(
+    const std::shared_ptr<index::Index> &index,
+    const std::vector<std::unique_ptr<storage::Tuple>> &keys,
+    const std::vector<size_t> &key_order,
+    const std::vector<ItemPointer *> &index_entry_ptrs,
+    const size_t &inserted_count) {
+  for (size_t order_itr = 0; order_itr < inserted_count; order_itr++) {
+    auto tuple_itr = key_order[order_itr];
+    index->DeleteEntry(keys[tuple_itr].get(), index_entry_ptrs[tuple_itr]);
+  }
+
+  LOG_TRACE("Bulk deleted %lu keys from %s", inserted_count,
+            index->GetName().c_str());
+}
+
 //===--------------------------------------------------------------------===//
 // STATS
 //===--------------------------------------------------------------------===//
@@ -602,16 +897,19 @@ oid_t DataTable::AddDefaultTileGroup(const size_t &active_tile_group_id) {
 
   LOG_TRACE("Added a tile group ");
 
-  tile_groups_.Append(tile_group_id);
+  {
+    std::lock_guard<std::mutex> lock(data_table_mutex_);
+    tile_groups_.Append(tile_group_id);
 
-  // add tile group metadata in locator
-  catalog::Manager::GetInstance().AddTileGroup(tile_group_id, tile_group);
+    // add tile group metadata in locator
+    catalog::Manager::GetInstance().AddTileGroup(tile_group_id, tile_group);
 
-  // we must guarantee that the compiler always add tile group before adding
-  // tile_group_count_.
-  COMPILER_MEMORY_FENCE;
+    // we must guarantee that the compiler always add tile group before adding
+    // tile_group_count_.
+    COMPILER_MEMORY_FENCE;
 
-  tile_group_count_++;
+    tile_group_count_++;
+  }
 
   LOG_TRACE("Recording tile group : %u ", tile_group_id);
 
@@ -635,6 +933,7 @@ void DataTable::AddTileGroupWithOidForRecovery(const oid_t &tile_group_id) {
       database_oid, table_oid, tile_group_id, this, schemas, column_map,
       tuples_per_tilegroup_));
 
+  std::lock_guard<std::mutex> lock(data_table_mutex_);
   auto tile_groups_exists = tile_groups_.Contains(tile_group_id);
 
   if (tile_groups_exists == false) {
@@ -665,6 +964,7 @@ void DataTable::AddTileGroup(const std::shared_ptr<TileGroup> &tile_group) {
 
   oid_t tile_group_id = tile_group->GetTileGroupId();
 
+  std::lock_guard<std::mutex> lock(data_table_mutex_);
   tile_groups_.Append(tile_group_id);
 
   // add tile group in catalog
@@ -685,12 +985,34 @@ std::shared_ptr<storage::TileGroup> DataTable::GetTileGroup(
     const std::size_t &tile_group_offset) const {
   PL_ASSERT(tile_group_offset < GetTileGroupCount());
 
-  auto tile_group_id =
-      tile_groups_.FindValid(tile_group_offset, invalid_tile_group_id);
+  // dropped tile groups keep their offset, so concurrent scans neither skip
+  // nor revisit a tile group
+  auto tile_group_id = tile_groups_.Find(tile_group_offset);
+  if (tile_group_id == invalid_tile_group_id) {
+    return nullptr;
+  }
 
+  // returns nullptr if the tile group was dropped by compaction
   return GetTileGroupById(tile_group_id);
 }
 
+void DataTable::DropTileGroup(const oid_t &tile_group_id) {
+  {
+    std::lock_guard<std::mutex> lock(data_table_mutex_);
+    auto tile_groups_size = tile_groups_.GetSize();
+    for (size_t tile_groups_itr = 0; tile_groups_itr < tile_groups_size;
+         tile_groups_itr++) {
+      if (tile_groups_.Find(tile_groups_itr) == tile_group_id) {
+        tile_groups_.Erase(tile_groups_itr, invalid_tile_group_id);
+        break;
+      }
+    }
+  }
+
+  LOG_TRACE("Dropping tile group : %u ", tile_group_id);
+  catalog::Manager::GetInstance().DropTileGroup(tile_group_id);
+}
+
 std::shared_ptr<storage::TileGroup> DataTable::GetTileGroupById(
     const oid_t &tile_group_id) const {
   auto &manager = catalog::Manager::GetInstance();
@@ -719,6 +1041,193 @@ void DataTable::DropTileGroups() {
   tile_group_count_ = 0;
 }
 
+//===--------------------------------------------------------------------===//
+// COMPACTION
+//===--------------------------------------------------------------------===//
+
+double DataTable::GetTileGroupOccupancy(const TileGroup *tile_group) const {
+  auto tile_group_header = tile_group->GetHeader();
+  auto allocated_tuple_count = tile_group->GetAllocatedTupleCount();
+  auto next_tuple_slot = tile_group->GetNextTupleSlot();
+  oid_t live_tuple_count = 0;
+
+  for (oid_t tuple_id = 0; tuple_id < next_tuple_slot; tuple_id++) {
+    if (tile_group_header->GetTransactionId(tuple_id) != INVALID_TXN_ID &&
+        tile_group_header->GetEndCommitId(tuple_id) == MAX_CID) {
+      live_tuple_count++;
+    }
+  }
+
+  return (double)live_tuple_count / allocated_tuple_count;
+}
+
+bool DataTable::MigrateTileGroup(const std::shared_ptr<TileGroup> &tile_group) {
+  // tuples are never copied to new slots with rollback segments
+  if (concurrency::TransactionManagerFactory::IsRB() == true) {
+    return false;
+  }
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  auto tile_group_header = tile_group->GetHeader();
+  auto tile_group_id = tile_group->GetTileGroupId();
+  auto next_tuple_slot = tile_group->GetNextTupleSlot();
+
+  std::unique_ptr<storage::Tuple> tuple(new storage::Tuple(schema, true));
+
+  auto txn = txn_manager.BeginTransaction();
+
+  for (oid_t tuple_id = 0; tuple_id < next_tuple_slot; tuple_id++) {
+    // only the latest committed versions are moved
+    if (tile_group_header->GetTransactionId(tuple_id) == INVALID_TXN_ID ||
+        tile_group_header->GetEndCommitId(tuple_id) != MAX_CID) {
+      continue;
+    }
+
+    // the tuple is being modified by a concurrent transaction.
+    // the write set only records updates of tuples that were read first.
+    ItemPointer old_location(tile_group_id, tuple_id);
+    if (txn_manager.PerformRead(txn, old_location) == false ||
+        txn_manager.IsOwnable(txn, tile_group_header, tuple_id) == false ||
+        txn_manager.AcquireOwnership(txn, tile_group_header, tuple_id) ==
+            false) {
+      LOG_TRACE("Could not migrate tuple (%u, %u)", tile_group_id, tuple_id);
+      txn_manager.SetTransactionResult(txn, Result::RESULT_FAILURE);
+      break;
+    }
+
+    // the new version goes to the active tile group
+    ItemPointer new_location = AcquireVersion();
+    if (new_location.IsNull() == true) {
+      txn_manager.YieldOwnership(txn, tile_group_id, tuple_id);
+      txn_manager.SetTransactionResult(txn, Result::RESULT_FAILURE);
+      break;
+    }
+
+    auto new_tile_group = catalog_manager.GetTileGroup(new_location.block);
+    tile_group->CopyTuple(tuple_id, tuple.get());
+    new_tile_group->CopyTuple(tuple.get(), new_location.offset);
+
+    // this also points the indirection of the tuple to the new version,
+    // so the indexes need not be touched
+    txn_manager.PerformUpdate(txn, old_location, new_location);
+  }
+
+  if (txn->GetResult() != Result::RESULT_SUCCESS) {
+    txn_manager.AbortTransaction(txn);
+    return false;
+  }
+
+  return txn_manager.CommitTransaction(txn) == Result::RESULT_SUCCESS;
+}
+
+bool DataTable::DropCompactedTileGroup(const oid_t &tile_group_id,
+                                       const cid_t &max_committed_cid) {
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  auto tile_group = catalog_manager.GetTileGroup(tile_group_id);
+  if (tile_group == nullptr) {
+    return true;
+  }
+
+  auto tile_group_header = tile_group->GetHeader();
+  auto next_tuple_slot = tile_group->GetNextTupleSlot();
+
+  // Wait till no running transaction can see any version in it
+  for (oid_t tuple_id = 0; tuple_id < next_tuple_slot; tuple_id++) {
+    auto tuple_txn_id = tile_group_header->GetTransactionId(tuple_id);
+    if (tuple_txn_id == INVALID_TXN_ID) {
+      continue;
+    }
+    if (tuple_txn_id != INITIAL_TXN_ID ||
+        tile_group_header->GetEndCommitId(tuple_id) > max_committed_cid) {
+      return false;
+    }
+  }
+
+  // Cut the version chains right above and below the versions being dropped
+  for (oid_t tuple_id = 0; tuple_id < next_tuple_slot; tuple_id++) {
+    auto newer_location = tile_group_header->GetPrevItemPointer(tuple_id);
+    if (newer_location.IsNull() == false &&
+        newer_location.block != tile_group_id) {
+      auto newer_tile_group =
+          catalog_manager.GetTileGroup(newer_location.block);
+      if (newer_tile_group != nullptr) {
+        newer_tile_group->GetHeader()->SetNextItemPointer(
+            newer_location.offset, INVALID_ITEMPOINTER);
+      }
+    }
+
+    auto older_location = tile_group_header->GetNextItemPointer(tuple_id);
+    if (older_location.IsNull() == false &&
+        older_location.block != tile_group_id) {
+      auto older_tile_group =
+          catalog_manager.GetTileGroup(older_location.block);
+      if (older_tile_group != nullptr) {
+        older_tile_group->GetHeader()->SetPrevItemPointer(
+            older_location.offset, INVALID_ITEMPOINTER);
+      }
+    }
+  }
+
+  // The tiles are released to the storage manager once the last reference
+  // goes away
+  LOG_TRACE("Dropping compacted tile group : %u ", tile_group_id);
+  DropTileGroup(tile_group_id);
+
+  return true;
+}
+
+size_t DataTable::CompactTileGroups(const double &occupancy_threshold) {
+  std::lock_guard<std::mutex> lock(compaction_mutex_);
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  size_t dropped_tile_group_count = 0;
+
+  // First, drop the tile groups compacted in earlier rounds
+  auto max_committed_cid = txn_manager.GetMaxCommittedCid();
+  auto compacted_itr = compacted_tile_groups_.begin();
+  while (compacted_itr != compacted_tile_groups_.end()) {
+    if (DropCompactedTileGroup(*compacted_itr, max_committed_cid) == true) {
+      compacted_itr = compacted_tile_groups_.erase(compacted_itr);
+      dropped_tile_group_count++;
+    } else {
+      compacted_itr++;
+    }
+  }
+
+  // Then, migrate the tuples of sparse tile groups
+  auto tile_group_count = GetTileGroupCount();
+  for (oid_t tile_group_offset = 0; tile_group_offset < tile_group_count;
+       tile_group_offset++) {
+    auto tile_group = GetTileGroup(tile_group_offset);
+    if (tile_group == nullptr) {
+      continue;
+    }
+
+    // Skip tile groups that still take inserts
+    if (tile_group->GetNextTupleSlot() < tile_group->GetAllocatedTupleCount()) {
+      continue;
+    }
+
+    auto tile_group_id = tile_group->GetTileGroupId();
+    if (std::find(compacted_tile_groups_.begin(), compacted_tile_groups_.end(),
+                  tile_group_id) != compacted_tile_groups_.end()) {
+      continue;
+    }
+
+    if (GetTileGroupOccupancy(tile_group.get()) >= occupancy_threshold) {
+      continue;
+    }
+
+    if (MigrateTileGroup(tile_group) == true) {
+      LOG_TRACE("Compacted tile group : %u ", tile_group_id);
+      compacted_tile_groups_.push_back(tile_group_id);
+    }
+  }
+
+  return dropped_tile_group_count;
+}
+
 const std::string DataTable::GetInfo() const {
   std::ostringstream os;
 
@@ -733,6 +1242,9 @@ const std::string DataTable::GetInfo() const {
   for (oid_t tile_group_itr = 0; tile_group_itr < tile_group_count;
        tile_group_itr++) {
     auto tile_group = GetTileGroup(tile_group_itr);
+    if (tile_group == nullptr) {
+      continue;
+    }
     table_id = tile_group->GetTableId();
     auto tile_tuple_count = tile_group->GetNextTupleSlot();
 
@@ -953,9 +1465,35 @@ storage::TileGroup *DataTable::TransformTileGroup(
   auto tile_group_id =
       tile_groups_.FindValid(tile_group_offset, invalid_tile_group_id);
 
+  // A tile group is transformed by one thread at a time, the others leave it
+  {
+    std::lock_guard<std::mutex> lock(transform_mutex_);
+    if (transforming_tile_group_ids_.insert(tile_group_id).second == false) {
+      return nullptr;
+    }
+  }
+
+  auto new_tile_group = TransformTileGroupById(tile_group_id, theta);
+
+  {
+    std::lock_guard<std::mutex> lock(transform_mutex_);
+    transforming_tile_group_ids_.erase(tile_group_id);
+  }
+
+  return new_tile_group;
+}
+
+storage::TileGroup *DataTable::TransformTileGroupById(
+    const oid_t &tile_group_id, const double &theta) {
   // Get orig tile group from catalog
   auto &catalog_manager = catalog::Manager::GetInstance();
   auto tile_group = catalog_manager.GetTileGroup(tile_group_id);
+
+  // the tile group was dropped by compaction
+  if (tile_group == nullptr) {
+    return nullptr;
+  }
+
   auto diff = tile_group->GetSchemaDifference(default_partition_);
 
   // Check threshold for transformation
@@ -1047,5 +1585,9 @@ void DataTable::SetDefaultLayout(const column_map_type &layout) {
   default_partition_ = layout;
 }
 
+const column_map_type &DataTable::GetDefaultLayout() const {
+  return default_partition_;
+}
+
 }  // End storage namespace
 }  // End peloton namespace
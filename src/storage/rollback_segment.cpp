@@ -55,6 +55,7 @@ RBSegType RollbackSegmentPool::CreateSegmentFromTuple(
   // Fill in the header
   SetNextPtr(rb_seg, nullptr);
   SetTimeStamp(rb_seg, MAX_CID);
+  SetBeginTimeStamp(rb_seg, MAX_CID);
   SetColCount(rb_seg, col_count);
 
   // Fill in the col_id & offset pair and set the data field
@@ -29,6 +29,7 @@
 #include "common/logger.h"
 #include "common/macros.h"
 #include "common/exception.h"
+#include "common/numa_util.h"
 #include "storage/storage_manager.h"
 
 //===--------------------------------------------------------------------===//
@@ -498,6 +499,9 @@ void *StorageManager::Allocate(BackendType type, size_t size) {
 }
 
 void StorageManager::Release(BackendType type, void *address) {
+  // Update release count
+  release_count++;
+
   switch (type) {
     case BACKEND_TYPE_MM:
     case BACKEND_TYPE_NVM: {
@@ -549,5 +553,50 @@ void StorageManager::Sync(BackendType type, void *address, size_t length) {
   }
 }
 
+void *StorageManager::AllocateOnNumaNode(BackendType type, size_t size,
+                                         int numa_node) {
+  switch (type) {
+    case BACKEND_TYPE_MM:
+    case BACKEND_TYPE_NVM: {
+      auto address = NumaUtil::AllocateOnNode(size, numa_node);
+      if (address != nullptr) {
+        allocation_count++;
+      }
+      return address;
+    } break;
+
+    case BACKEND_TYPE_SSD:
+    case BACKEND_TYPE_HDD: {
+      // Nothing to do here (pages belong to the mmap'ed data file)
+      return nullptr;
+    } break;
+
+    case BACKEND_TYPE_INVALID:
+    default: {
+      return nullptr;
+    }
+  }
+}
+
+void StorageManager::ReleaseOnNumaNode(BackendType type, void *address,
+                                       size_t size) {
+  // Update release count
+  release_count++;
+
+  switch (type) {
+    case BACKEND_TYPE_MM:
+    case BACKEND_TYPE_NVM: {
+      NumaUtil::FreeOnNode(address, size);
+    } break;
+
+    case BACKEND_TYPE_SSD:
+    case BACKEND_TYPE_HDD:
+    case BACKEND_TYPE_INVALID:
+    default: {
+      // Nothing to do here
+    } break;
+  }
+}
+
 }  // End storage namespace
 }  // End peloton namespace
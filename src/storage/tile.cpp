@@ -72,7 +72,11 @@ Tile::Tile(BackendType backend_type, TileGroupHeader *tile_header,
 Tile::~Tile() {
   // reclaim the tile memory (INLINED data)
   auto &storage_manager = storage::StorageManager::GetInstance();
-  storage_manager.Release(backend_type, data);
+  if (numa_node != NUMA_NODE_ANY) {
+    storage_manager.ReleaseOnNumaNode(backend_type, data, tile_size);
+  } else {
+    storage_manager.Release(backend_type, data);
+  }
   data = NULL;
 
   // reclaim the tile memory (UNINLINED data)
@@ -477,6 +481,25 @@ void Tile::Sync() {
   storage_manager.Sync(backend_type, data, tile_size);
 }
 
+void Tile::MoveToNumaNode(int numa_node_) {
+  auto &storage_manager = storage::StorageManager::GetInstance();
+  auto node_data = reinterpret_cast<char *>(
+      storage_manager.AllocateOnNumaNode(backend_type, tile_size, numa_node_));
+  if (node_data == nullptr) {
+    return;
+  }
+
+  PL_MEMCPY(node_data, data, tile_size);
+  if (numa_node != NUMA_NODE_ANY) {
+    storage_manager.ReleaseOnNumaNode(backend_type, data, tile_size);
+  } else {
+    storage_manager.Release(backend_type, data);
+  }
+
+  data = node_data;
+  numa_node = numa_node_;
+}
+
 //===--------------------------------------------------------------------===//
 // Utilities
 //===--------------------------------------------------------------------===//
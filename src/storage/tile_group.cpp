@@ -17,6 +17,7 @@
 #include "common/platform.h"
 #include "catalog/manager.h"
 #include "common/logger.h"
+#include "common/numa_util.h"
 #include "common/types.h"
 #include "storage/abstract_table.h"
 #include "storage/tile.h"
@@ -40,7 +41,8 @@ TileGroup::TileGroup(BackendType backend_type,
       tile_group_header(tile_group_header),
       table(table),
       num_tuple_slots(tuple_count),
-      column_map(column_map) {
+      column_map(column_map),
+      numa_node(NUMA_NODE_ANY) {
   tile_count = tile_schemas.size();
 
   for (oid_t tile_itr = 0; tile_itr < tile_count; tile_itr++) {
@@ -137,6 +139,20 @@ void TileGroup::CopyTuple(const oid_t &tuple_slot_id, Tuple *tuple) {
   }
 }
 
+// Write the before-image kept in the rollback segment back into the tuple.
+// Used when a transaction that updated the tuple in place aborts.
+void TileGroup::ApplyRollbackSegment(char *rb_seg,
+                                     const oid_t &tuple_slot_id) {
+  auto schema = table->GetSchema();
+  auto col_count = RollbackSegmentPool::GetColCount(rb_seg);
+
+  for (size_t idx = 0; idx < col_count; ++idx) {
+    auto col_id = RollbackSegmentPool::GetIdOffsetPair(rb_seg, idx)->col_id;
+    Value value = RollbackSegmentPool::GetValue(rb_seg, schema, idx);
+    SetValue(value, tuple_slot_id, col_id);
+  }
+}
+
 /**
  * Grab next slot (thread-safe) and fill in the tuple if tuple != nullptr
  *
@@ -154,6 +170,8 @@ oid_t TileGroup::InsertTuple(const Tuple *tuple) {
     return INVALID_OID;
   }
 
+  IncrementWriteCount();
+
   // if the input tuple is nullptr, then it means that the tuple with be filled in
   // outside the function. directly return the empty slot.
   if (tuple == nullptr) {
@@ -178,6 +196,9 @@ oid_t TileGroup::InsertTuple(const Tuple *tuple) {
  */
 oid_t TileGroup::InsertTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id,
                                          const Tuple *tuple) {
+  // the replayed log is not in the checkpoint recovered from
+  SetCheckpointDirty();
+
   auto status = tile_group_header->GetEmptyTupleSlot(tuple_slot_id);
 
   // No more slots
@@ -229,6 +250,9 @@ oid_t TileGroup::InsertTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id,
 }
 
 oid_t TileGroup::DeleteTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id) {
+  // the replayed log is not in the checkpoint recovered from
+  SetCheckpointDirty();
+
   auto status = tile_group_header->GetEmptyTupleSlot(tuple_slot_id);
 
   tile_group_header->GetHeaderLock().Lock();
@@ -254,6 +278,9 @@ oid_t TileGroup::DeleteTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id) {
 
 oid_t TileGroup::UpdateTupleFromRecovery(cid_t commit_id, oid_t tuple_slot_id,
                                          ItemPointer new_location) {
+  // the replayed log is not in the checkpoint recovered from
+  SetCheckpointDirty();
+
   auto status = tile_group_header->GetEmptyTupleSlot(tuple_slot_id);
 
   tile_group_header->GetHeaderLock().Lock();
@@ -404,6 +431,15 @@ void TileGroup::Sync() {
   }
 }
 
+void TileGroup::SetNumaNode(int numa_node_) {
+  numa_node = numa_node_;
+
+  tile_group_header->MoveToNumaNode(numa_node);
+  for (auto tile : tiles) {
+    tile->MoveToNumaNode(numa_node);
+  }
+}
+
 //===--------------------------------------------------------------------===//
 // Utilities
 //===--------------------------------------------------------------------===//
@@ -13,6 +13,8 @@
 
 #include "storage/tile_group_factory.h"
 #include "storage/tile_group_header.h"
+#include "common/config.h"
+#include "common/numa_util.h"
 
 //===--------------------------------------------------------------------===//
 // GUC Variables
@@ -41,6 +43,12 @@ TileGroup *TileGroupFactory::GetTileGroup(
   tile_group->tile_group_id = tile_group_id;
   tile_group->table_id = table_id;
 
+  // Tile groups are spread over the nodes by id, so a transformed tile group
+  // stays on the node of the one it replaces
+  if (FLAGS_numa_aware == true) {
+    tile_group->SetNumaNode(NumaUtil::GetTileGroupNode(tile_group_id));
+  }
+
   return tile_group;
 }
 
@@ -32,6 +32,7 @@ namespace storage {
 TileGroupHeader::TileGroupHeader(const BackendType &backend_type,
                                  const int &tuple_count)
     : backend_type(backend_type),
+      numa_node(NUMA_NODE_ANY),
       data(nullptr),
       num_tuple_slots(tuple_count),
       next_tuple_slot(0),
@@ -47,6 +48,8 @@ TileGroupHeader::TileGroupHeader(const BackendType &backend_type,
   // zero out the data
   PL_MEMSET(data, 0, header_size);
 
+  SetFieldPointers();
+
   // Set MVCC Initial Value
   for (oid_t tuple_slot_id = START_OID; tuple_slot_id < num_tuple_slots;
        tuple_slot_id++) {
@@ -55,17 +58,32 @@ TileGroupHeader::TileGroupHeader(const BackendType &backend_type,
     SetEndCommitId(tuple_slot_id, MAX_CID);
     SetNextItemPointer(tuple_slot_id, INVALID_ITEMPOINTER);
     SetPrevItemPointer(tuple_slot_id, INVALID_ITEMPOINTER);
+    SetVersionHint(tuple_slot_id, INVALID_ITEMPOINTER);
   }
 }
 
 TileGroupHeader::~TileGroupHeader() {
   // reclaim the space
   auto &storage_manager = storage::StorageManager::GetInstance();
-  storage_manager.Release(backend_type, data);
+  if (numa_node != NUMA_NODE_ANY) {
+    storage_manager.ReleaseOnNumaNode(backend_type, data, header_size);
+  } else {
+    storage_manager.Release(backend_type, data);
+  }
 
   data = nullptr;
 }
 
+void TileGroupHeader::SetFieldPointers() {
+  // lay out the visibility fields column-wise, followed by the other fields
+  txn_ids = reinterpret_cast<txn_id_t *>(data);
+  begin_cids = reinterpret_cast<cid_t *>(txn_ids + num_tuple_slots);
+  end_cids = begin_cids + num_tuple_slots;
+  cold_data = reinterpret_cast<char *>(end_cids + num_tuple_slots);
+  abort_counts = reinterpret_cast<uint32_t *>(
+      cold_data + num_tuple_slots * cold_entry_size);
+}
+
 //===--------------------------------------------------------------------===//
 // Tile Group Header
 //===--------------------------------------------------------------------===//
@@ -122,6 +140,26 @@ void TileGroupHeader::Sync() {
   storage_manager.Sync(backend_type, data, header_size);
 }
 
+void TileGroupHeader::MoveToNumaNode(int numa_node_) {
+  auto &storage_manager = storage::StorageManager::GetInstance();
+  auto node_data = reinterpret_cast<char *>(storage_manager.AllocateOnNumaNode(
+      backend_type, header_size, numa_node_));
+  if (node_data == nullptr) {
+    return;
+  }
+
+  PL_MEMCPY(node_data, data, header_size);
+  if (numa_node != NUMA_NODE_ANY) {
+    storage_manager.ReleaseOnNumaNode(backend_type, data, header_size);
+  } else {
+    storage_manager.Release(backend_type, data);
+  }
+
+  data = node_data;
+  numa_node = numa_node_;
+  SetFieldPointers();
+}
+
 void TileGroupHeader::PrintVisibility(txn_id_t txn_id, cid_t at_cid) {
   oid_t active_tuple_slots = GetCurrentNextTupleSlot();
   std::stringstream os;
@@ -263,6 +263,39 @@ void Tuple::DeserializeFrom(SerializeInputBE &input, VarlenPool *dataPool) {
   }
 }
 
+void Tuple::DeserializeColumnsFrom(SerializeInputBE &input,
+                                   VarlenPool *dataPool,
+                                   std::vector<oid_t> &column_ids) {
+  PL_ASSERT(tuple_schema);
+  PL_ASSERT(tuple_data);
+
+  input.ReadInt();
+  const size_t column_count = input.ReadVarint();
+  column_ids.clear();
+  column_ids.reserve(column_count);
+
+  for (size_t column_itr = 0; column_itr < column_count; column_itr++) {
+    const oid_t column_id = static_cast<oid_t>(input.ReadVarint());
+    PL_ASSERT(column_id < tuple_schema->GetColumnCount());
+    column_ids.push_back(column_id);
+
+    const ValueType type = tuple_schema->GetType(column_id);
+    const bool is_inlined = tuple_schema->IsInlined(column_id);
+    int32_t column_length;
+    char *data_ptr = GetDataPtr(column_id);
+
+    if (is_inlined) {
+      column_length = tuple_schema->GetLength(column_id);
+    } else {
+      column_length = tuple_schema->GetVariableLength(column_id);
+    }
+
+    const bool is_in_bytes = false;
+    Value::DeserializeFrom(input, dataPool, data_ptr, type, is_inlined,
+                           column_length, is_in_bytes);
+  }
+}
+
 void Tuple::DeserializeWithHeaderFrom(SerializeInputBE &input) {
   PL_ASSERT(tuple_schema);
   PL_ASSERT(tuple_data);
@@ -320,6 +353,22 @@ void Tuple::SerializeTo(SerializeOutput &output) {
       start, static_cast<int32_t>(output.Position() - start - sizeof(int32_t)));
 }
 
+void Tuple::SerializeColumnsTo(SerializeOutput &output,
+                               const std::vector<oid_t> &column_ids) {
+  PL_ASSERT(tuple_schema);
+  size_t start = output.ReserveBytes(4);
+  output.WriteVarint(column_ids.size());
+
+  for (auto column_id : column_ids) {
+    output.WriteVarint(column_id);
+    Value value = GetValue(column_id);
+    value.SerializeTo(output);
+  }
+
+  output.WriteIntAt(
+      start, static_cast<int32_t>(output.Position() - start - sizeof(int32_t)));
+}
+
 void Tuple::SerializeToExport(ExportSerializeOutput &output, int colOffset,
                               uint8_t *null_array) {
   const int column_count = GetColumnCount();
@@ -49,7 +49,7 @@ TrafficCop::~TrafficCop() {
 Result TrafficCop::ExecuteStatement(
     const std::string &query, std::vector<ResultType> &result,
     std::vector<FieldInfoType> &tuple_descriptor, int &rows_changed,
-    std::string &error_message) {
+    std::string &error_message, bool sync_commit) {
   LOG_TRACE("Received %s", query.c_str());
 
   // Prepare the statement
@@ -62,8 +62,8 @@ Result TrafficCop::ExecuteStatement(
 
   // Then, execute the statement
   bool unnamed = true;
-  auto status =
-      ExecuteStatement(statement, unnamed, result, rows_changed, error_message);
+  auto status = ExecuteStatement(statement, unnamed, result, rows_changed,
+                                 error_message, sync_commit);
 
   if (status == Result::RESULT_SUCCESS) {
     LOG_TRACE("Execution succeeded!");
@@ -78,13 +78,14 @@ Result TrafficCop::ExecuteStatement(
 Result TrafficCop::ExecuteStatement(
     const std::shared_ptr<Statement> &statement,
     UNUSED_ATTRIBUTE const bool unnamed, std::vector<ResultType> &result,
-    int &rows_changed, UNUSED_ATTRIBUTE std::string &error_message) {
+    int &rows_changed, UNUSED_ATTRIBUTE std::string &error_message,
+    bool sync_commit) {
 
   LOG_TRACE("Execute Statement %s", statement->GetStatementName().c_str());
   std::vector<Value> params;
   bridge::PlanExecutor::PrintPlan(statement->GetPlanTree().get(), "Plan");
   bridge::peloton_status status = bridge::PlanExecutor::ExecutePlan(
-      statement->GetPlanTree().get(), params, result);
+      statement->GetPlanTree().get(), params, result, sync_commit);
   LOG_TRACE("Statement executed. Result: %d", status.m_result);
 
   rows_changed = status.m_processed;
@@ -97,6 +97,13 @@ bool PacketManager::ProcessStartupPacket(Packet *pkt,
     }
   }
 
+  // session settings passed at startup
+  auto sync_commit_option = client.cmdline_options.find("synchronous_commit");
+  if (sync_commit_option != client.cmdline_options.end()) {
+    ApplySessionSetting("SET synchronous_commit = " +
+                        sync_commit_option->second);
+  }
+
   // send auth-ok ('R')
   response->msg_type = 'R';
   PacketPutInt(response, 0, 4);
@@ -217,6 +224,39 @@ bool PacketManager::HardcodedExecuteFilter(std::string query_type) {
   return true;
 }
 
+/*
+ * ApplySessionSetting - SET [SESSION | LOCAL] name {TO | =} value
+ *  synchronous_commit = off lets the transactions of the session commit
+ *  before their log is flushed. The log manager bounds the lag.
+ *  Returns false if the query does not set a session setting.
+ */
+bool PacketManager::ApplySessionSetting(const std::string &query) {
+  std::vector<std::string> tokens;
+  auto trimmed_query = boost::trim_copy(query);
+  boost::split(tokens, trimmed_query, boost::is_any_of(" \t="),
+               boost::token_compress_on);
+
+  size_t name_index = 1;
+  if (tokens.size() > 1 && (boost::iequals(tokens[1], "SESSION") ||
+                            boost::iequals(tokens[1], "LOCAL"))) {
+    name_index++;
+  }
+  if (tokens.size() < name_index + 2 || !boost::iequals(tokens[0], "SET")) {
+    return false;
+  }
+
+  if (boost::iequals(tokens[name_index], "synchronous_commit") == false) {
+    return false;
+  }
+
+  auto value = boost::trim_copy_if(tokens.back(), boost::is_any_of("'\""));
+  sync_commit_ = !(boost::iequals(value, "off") ||
+                   boost::iequals(value, "false") ||
+                   boost::iequals(value, "no") || value == "0");
+  LOG_TRACE("Session synchronous_commit : %d", sync_commit_);
+  return true;
+}
+
 // The Simple Query Protocol
 void PacketManager::ExecQueryMessage(Packet *pkt, ResponseBuffer &responses) {
   std::string q_str;
@@ -248,9 +288,17 @@ void PacketManager::ExecQueryMessage(Packet *pkt, ResponseBuffer &responses) {
     std::string error_message;
     int rows_affected;
 
+    // session settings are kept by the session, other SETs are executed
+    if (boost::iequals(get_query_type(boost::trim_copy(query)), "SET") &&
+        ApplySessionSetting(query)) {
+      CompleteCommand("SET", 0, responses);
+      continue;
+    }
+
     // execute the query in Sqlite
     auto status = tcop.ExecuteStatement(query, result, tuple_descriptor,
-                                        rows_affected, error_message);
+                                        rows_affected, error_message,
+                                        sync_commit_);
 
     // check status
     if (status == Result::RESULT_FAILURE) {
@@ -542,6 +590,9 @@ void PacketManager::ExecExecuteMessage(Packet *pkt, ResponseBuffer &responses) {
   // covers weird JDBC edge case of sending double BEGIN statements. Don't
   // execute them
   if (skipped_stmt_) {
+    if (skipped_query_type_.compare("SET") == 0) {
+      ApplySessionSetting(skipped_query_string_);
+    }
     CompleteCommand(skipped_query_type_, rows_affected, responses);
     skipped_stmt_ = false;
     return;
@@ -569,7 +620,8 @@ void PacketManager::ExecExecuteMessage(Packet *pkt, ResponseBuffer &responses) {
 
   auto &tcop = tcop::TrafficCop::GetInstance();
   auto status = tcop.ExecuteStatement(statement, unnamed, results,
-                                      rows_affected, error_message);
+                                      rows_affected, error_message,
+                                      sync_commit_);
 
   if (status == Result::RESULT_FAILURE) {
     LOG_ERROR("Failed to execute: %s", error_message.c_str());
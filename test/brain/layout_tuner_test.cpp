@@ -0,0 +1,134 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// layout_tuner_test.cpp
+//
+// Identification: test/brain/layout_tuner_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common/harness.h"
+
+#include "brain/layout_tuner.h"
+#include "concurrency/transaction_manager_factory.h"
+#include "executor/executor_tests_util.h"
+#include "storage/data_table.h"
+#include "storage/tile_group.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Layout Tuner Tests
+//===--------------------------------------------------------------------===//
+
+class LayoutTunerTests : public PelotonTest {};
+
+TEST_F(LayoutTunerTests, BasicTest) {
+  const int tuples_per_tile_group = TESTS_TUPLES_PER_TILEGROUP;
+  const int tuple_count = tuples_per_tile_group * 4;
+
+  // Create and populate a table
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto txn = txn_manager.BeginTransaction();
+  std::unique_ptr<storage::DataTable> data_table(
+      ExecutorTestsUtil::CreateTable(tuples_per_tile_group, false));
+  ExecutorTestsUtil::PopulateTable(data_table.get(), tuple_count, false, false,
+                                   true, txn);
+  txn_manager.CommitTransaction(txn);
+
+  // Scan the first tile group a few times to make it the hottest one
+  const size_t access_count = 10;
+  auto hot_tile_group = data_table->GetTileGroup(0);
+  for (size_t access_itr = 0; access_itr < access_count; access_itr++) {
+    hot_tile_group->IncrementAccessCount();
+  }
+  EXPECT_EQ(access_count, hot_tile_group->GetAccessCount());
+
+  // Desired layout
+  storage::column_map_type column_map;
+  column_map[0] = std::make_pair(0, 0);
+  column_map[1] = std::make_pair(0, 1);
+  column_map[2] = std::make_pair(1, 0);
+  column_map[3] = std::make_pair(1, 1);
+  data_table->SetDefaultLayout(column_map);
+
+  auto &layout_tuner = brain::LayoutTuner::GetInstance();
+  layout_tuner.AddTable(data_table.get());
+  layout_tuner.Start();
+
+  // Wait for the table to converge
+  for (int wait_itr = 0; wait_itr < 1000; wait_itr++) {
+    if (layout_tuner.GetConvergence(data_table.get()) == 1.0) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  layout_tuner.Stop();
+  layout_tuner.ClearTables();
+
+  // All tile groups must have the desired layout
+  auto tile_group_count = data_table->GetTileGroupCount();
+  for (size_t tile_group_itr = 0; tile_group_itr < tile_group_count;
+       tile_group_itr++) {
+    auto tile_group = data_table->GetTileGroup(tile_group_itr);
+    EXPECT_EQ(0, tile_group->GetSchemaDifference(column_map));
+  }
+}
+
+TEST_F(LayoutTunerTests, ConcurrentTransformTest) {
+  const int tuples_per_tile_group = TESTS_TUPLES_PER_TILEGROUP;
+  const int tuple_count = tuples_per_tile_group * 4;
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto txn = txn_manager.BeginTransaction();
+  std::unique_ptr<storage::DataTable> data_table(
+      ExecutorTestsUtil::CreateTable(tuples_per_tile_group, false));
+  ExecutorTestsUtil::PopulateTable(data_table.get(), tuple_count, false, false,
+                                   true, txn);
+  txn_manager.CommitTransaction(txn);
+
+  storage::column_map_type column_map;
+  column_map[0] = std::make_pair(0, 0);
+  column_map[1] = std::make_pair(1, 0);
+  column_map[2] = std::make_pair(1, 1);
+  column_map[3] = std::make_pair(1, 2);
+  data_table->SetDefaultLayout(column_map);
+
+  // Every thread tries to transform every tile group
+  auto tile_group_count = data_table->GetTileGroupCount();
+  auto transform = [&]() {
+    for (oid_t tile_group_itr = 0; tile_group_itr < tile_group_count;
+         tile_group_itr++) {
+      data_table->TransformTileGroup(tile_group_itr, 0.0);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int thread_itr = 0; thread_itr < 4; thread_itr++) {
+    threads.push_back(std::thread(transform));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Every tile group has the new layout, and kept its tuples
+  size_t active_tuple_count = 0;
+  for (size_t tile_group_itr = 0; tile_group_itr < tile_group_count;
+       tile_group_itr++) {
+    auto tile_group = data_table->GetTileGroup(tile_group_itr);
+    EXPECT_EQ(0, tile_group->GetSchemaDifference(column_map));
+    active_tuple_count += tile_group->GetActiveTupleCount();
+  }
+  EXPECT_EQ(tuple_count, active_tuple_count);
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -13,6 +13,8 @@
 #include "common/thread_pool.h"
 #include "common/harness.h"
 
+#include <future>
+
 namespace peloton {
 namespace test {
 
@@ -43,5 +45,22 @@ TEST_F(ThreadPoolTests, BasicTest) {
   EXPECT_EQ(1, var4);
 }
 
+TEST_F(ThreadPoolTests, NumaNodeTest) {
+  EXPECT_GE(NumaUtil::GetNodeCount(), 1);
+
+  // Threads of the pool only run on the cpus of the last node
+  int numa_node = NumaUtil::GetNodeCount() - 1;
+  ThreadPool thread_pool;
+  thread_pool.Initialize(2, numa_node);
+
+  std::promise<int> task_node;
+  auto task_node_future = task_node.get_future();
+  thread_pool.SubmitTask([](std::promise<int> *node) {
+    node->set_value(NumaUtil::GetCurrentNode());
+  }, &task_node);
+
+  EXPECT_EQ(numa_node, task_node_future.get());
+}
+
 }  // End test namespace
 }  // End peloton namespace
@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// epoch_manager_test.cpp
+//
+// Identification: test/concurrency/epoch_manager_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <thread>
+
+#include "common/harness.h"
+#include "concurrency/epoch_manager.h"
+
+namespace peloton {
+
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Epoch Manager Tests
+//===--------------------------------------------------------------------===//
+
+class EpochManagerTests : public PelotonTest {};
+
+// the epochs are advanced directly, a background advance only repeats the
+// same computation.
+TEST_F(EpochManagerTests, MaxDeadTxnCidTest) {
+  auto &epoch_manager = concurrency::EpochManagerFactory::GetInstance();
+  epoch_manager.Reset();
+
+  const cid_t begin_cid = 1000;
+
+  // a running transaction holds back the dead cid, even if a later one ends
+  auto slot_id = epoch_manager.EnterEpoch(begin_cid);
+
+  std::thread other_thread([&epoch_manager, begin_cid] {
+    auto other_slot_id = epoch_manager.EnterEpoch(begin_cid + 10);
+    epoch_manager.ExitEpoch(other_slot_id, begin_cid + 10);
+  });
+  other_thread.join();
+
+  epoch_manager.AdvanceEpoch();
+  epoch_manager.AdvanceEpoch();
+  EXPECT_EQ(begin_cid - 1, epoch_manager.GetMaxDeadTxnCid());
+
+  // once it ends, the dead cid catches up with every entered cid
+  epoch_manager.ExitEpoch(slot_id, begin_cid);
+
+  epoch_manager.AdvanceEpoch();
+  EXPECT_EQ(begin_cid + 10, epoch_manager.GetMaxDeadTxnCid());
+}
+
+TEST_F(EpochManagerTests, SlotMinCidTest) {
+  auto &epoch_manager = concurrency::EpochManagerFactory::GetInstance();
+  epoch_manager.Reset();
+
+  const cid_t begin_cid = 2000;
+
+  // the oldest transaction of a slot ends while a younger one keeps running
+  auto slot_id = epoch_manager.EnterEpoch(begin_cid);
+  auto younger_slot_id = epoch_manager.EnterEpoch(begin_cid + 10);
+  EXPECT_EQ(slot_id, younger_slot_id);
+
+  epoch_manager.ExitEpoch(slot_id, begin_cid);
+
+  epoch_manager.AdvanceEpoch();
+  epoch_manager.AdvanceEpoch();
+  EXPECT_EQ(begin_cid + 9, epoch_manager.GetMaxDeadTxnCid());
+
+  epoch_manager.ExitEpoch(younger_slot_id, begin_cid + 10);
+
+  epoch_manager.AdvanceEpoch();
+  EXPECT_EQ(begin_cid + 10, epoch_manager.GetMaxDeadTxnCid());
+}
+
+TEST_F(EpochManagerTests, ResetTest) {
+  auto &epoch_manager = concurrency::EpochManagerFactory::GetInstance();
+  epoch_manager.Reset();
+
+  // a reset forgets the slots, including the transactions entered before
+  epoch_manager.EnterEpoch(3000);
+  epoch_manager.Reset();
+
+  auto slot_id = epoch_manager.EnterEpoch(50);
+  epoch_manager.ExitEpoch(slot_id, 50);
+
+  epoch_manager.AdvanceEpoch();
+  epoch_manager.AdvanceEpoch();
+  EXPECT_EQ((cid_t)50, epoch_manager.GetMaxDeadTxnCid());
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -0,0 +1,178 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// ssi_transaction_manager_test.cpp
+//
+// Identification: test/concurrency/ssi_transaction_manager_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/harness.h"
+#include "concurrency/transaction_tests_util.h"
+
+namespace peloton {
+
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Serializable Snapshot Isolation Tests
+//===--------------------------------------------------------------------===//
+
+class SsiTransactionManagerTests : public PelotonTest {};
+
+TEST_F(SsiTransactionManagerTests, SnapshotReadTest) {
+  concurrency::TransactionManagerFactory::Configure(CONCURRENCY_TYPE_SSI);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // a reader is not blocked by a later writer and keeps its snapshot
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(1);
+    scheduler.Txn(1).Update(0, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(0, scheduler.schedules[0].results[1]);
+  }
+
+  // first updater wins
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(2);
+    scheduler.Txn(1).Update(2, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Update(2, 2);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+  }
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+}
+
+TEST_F(SsiTransactionManagerTests, WriteSkewTest) {
+  concurrency::TransactionManagerFactory::Configure(CONCURRENCY_TYPE_SSI);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // each transaction overwrites what the other one read
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(0).Read(1);
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Read(1);
+    scheduler.Txn(0).Update(0, 1);
+    scheduler.Txn(1).Update(1, 1);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[1].txn_result);
+  }
+
+  // a single rw-antidependency is serializable
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(2);
+    scheduler.Txn(1).Read(3);
+    scheduler.Txn(1).Update(2, 5);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+  }
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+}
+
+TEST_F(SsiTransactionManagerTests, DangerousStructureTest) {
+  concurrency::TransactionManagerFactory::Configure(CONCURRENCY_TYPE_SSI);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // T2 -> T0 -> T1 with T1 committing first: the pivot T0 aborts
+  {
+    TransactionScheduler scheduler(3, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(2).Read(1);
+    scheduler.Txn(1).Update(0, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Update(1, 1);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(2).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[2].txn_result);
+  }
+
+  // T2 sees T1 but not T0, so the in edge of the committed pivot T0 only
+  // appears when T2 reads what T0 overwrote, and T2 aborts
+  {
+    TransactionScheduler scheduler(3, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(2);
+    scheduler.Txn(1).Update(2, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(2).Read(2);
+    scheduler.Txn(0).Update(3, 1);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(2).Read(3);
+    scheduler.Txn(2).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[2].txn_result);
+    EXPECT_EQ(1, scheduler.schedules[2].results[0]);
+  }
+
+  // the pivot T0 commits before T1, which is serializable
+  {
+    TransactionScheduler scheduler(3, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(5);
+    scheduler.Txn(2).Read(6);
+    scheduler.Txn(1).Update(5, 1);
+    scheduler.Txn(0).Update(6, 1);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(2).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[2].txn_result);
+  }
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+}
+
+}  // End test namespace
+}  // End peloton namespace
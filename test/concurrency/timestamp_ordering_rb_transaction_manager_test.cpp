@@ -0,0 +1,245 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// timestamp_ordering_rb_transaction_manager_test.cpp
+//
+// Identification:
+// test/concurrency/timestamp_ordering_rb_transaction_manager_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+
+#include "common/harness.h"
+#include "concurrency/transaction_tests_util.h"
+
+namespace peloton {
+
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Rollback Segment Transaction Tests
+//===--------------------------------------------------------------------===//
+
+class TimestampOrderingRbTransactionManagerTests : public PelotonTest {};
+
+TEST_F(TimestampOrderingRbTransactionManagerTests, UpdateTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING_RB);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+  // update in place, update again, read own write
+  {
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Update(0, 1);
+    scheduler.Txn(0).Update(0, 2);
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(2, scheduler.schedules[0].results[0]);
+    EXPECT_EQ(2, scheduler.schedules[1].results[0]);
+  }
+
+  // an older transaction reads the version saved in the rollback segment
+  {
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+    TransactionScheduler scheduler(3, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(1);
+    scheduler.Txn(1).Update(0, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(2).Update(0, 2);
+    scheduler.Txn(2).Commit();
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[2].txn_result);
+    EXPECT_EQ(0, scheduler.schedules[0].results[1]);
+  }
+
+  // an older transaction cannot update a newer master version
+  {
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(1);
+    scheduler.Txn(1).Update(0, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Update(0, 2);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+  }
+}
+
+TEST_F(TimestampOrderingRbTransactionManagerTests, AbortTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING_RB);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // the master version is restored from the rollback segment
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Update(0, 1);
+    scheduler.Txn(0).Update(0, 2);
+    scheduler.Txn(0).Abort();
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(0, scheduler.schedules[1].results[0]);
+  }
+
+  // aborted deletes and inserts leave nothing behind
+  {
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Delete(0);
+    scheduler.Txn(0).Insert(100, 0);
+    scheduler.Txn(0).Abort();
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Read(100);
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(0, scheduler.schedules[1].results[0]);
+    EXPECT_EQ(-1, scheduler.schedules[1].results[1]);
+  }
+}
+
+TEST_F(TimestampOrderingRbTransactionManagerTests, DeleteTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING_RB);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // update then delete, an older transaction still reads the old version
+  {
+    TransactionScheduler scheduler(3, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(1);
+    scheduler.Txn(1).Update(0, 1);
+    scheduler.Txn(1).Delete(0);
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(2).Read(0);
+    scheduler.Txn(2).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[2].txn_result);
+    EXPECT_EQ(-1, scheduler.schedules[1].results[0]);
+    EXPECT_EQ(0, scheduler.schedules[0].results[1]);
+    EXPECT_EQ(-1, scheduler.schedules[2].results[0]);
+  }
+
+  // the key can be inserted again after the delete commits
+  {
+    TransactionScheduler scheduler(1, table.get(), &txn_manager);
+    scheduler.Txn(0).Insert(0, 2);
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(2, scheduler.schedules[0].results[0]);
+  }
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+}
+
+// the writer updates two tuples in place in every transaction. the readers
+// copy them while they are written, and must see both from the same update.
+void RbReadWriteThread(storage::DataTable *table, std::atomic<bool> *done,
+                       std::atomic<int> *read_count,
+                       std::atomic<int> *mismatch_count, uint64_t thread_itr) {
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+  if (thread_itr == 0) {
+    for (int value = 1; value <= 1000; value++) {
+      auto txn = txn_manager.BeginTransaction();
+      if (TransactionTestsUtil::ExecuteUpdate(txn, table, 0, value) == true &&
+          TransactionTestsUtil::ExecuteUpdate(txn, table, 1, value) == true &&
+          txn->GetResult() == RESULT_SUCCESS) {
+        txn_manager.CommitTransaction(txn);
+      } else {
+        txn_manager.AbortTransaction(txn);
+      }
+    }
+    done->store(true);
+    return;
+  }
+
+  while (done->load() == false) {
+    int first = -1;
+    int second = -1;
+    auto txn = txn_manager.BeginTransaction();
+    if (TransactionTestsUtil::ExecuteRead(txn, table, 0, first) == false ||
+        TransactionTestsUtil::ExecuteRead(txn, table, 1, second) == false ||
+        txn->GetResult() != RESULT_SUCCESS) {
+      txn_manager.AbortTransaction(txn);
+      continue;
+    }
+    if (txn_manager.CommitTransaction(txn) != RESULT_SUCCESS) {
+      continue;
+    }
+
+    (*read_count)++;
+    if (first != second) {
+      (*mismatch_count)++;
+    }
+  }
+}
+
+TEST_F(TimestampOrderingRbTransactionManagerTests, ConcurrentReadWriteTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING_RB);
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  std::atomic<bool> done(false);
+  std::atomic<int> read_count(0);
+  std::atomic<int> mismatch_count(0);
+  LaunchParallelTest(4, RbReadWriteThread, table.get(), &done, &read_count,
+                     &mismatch_count);
+
+  EXPECT_LT(0, read_count.load());
+  EXPECT_EQ(0, mismatch_count.load());
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+}
+
+}  // End test namespace
+}  // End peloton namespace
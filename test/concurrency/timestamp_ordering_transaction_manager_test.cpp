@@ -10,8 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>
+#include <thread>
 
+#include "common/config.h"
 #include "common/harness.h"
+#include "concurrency/timestamp_ordering_transaction_manager.h"
 #include "concurrency/transaction_tests_util.h"
 
 namespace peloton {
@@ -29,5 +33,137 @@ TEST_F(TimestampOrderingTransactionManagerTests, Test) {
   EXPECT_TRUE(true);
 }
 
+TEST_F(TimestampOrderingTransactionManagerTests, ReadonlyTransactionTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // the snapshot catches up with the loaded tuples once their epoch is over
+  int result = -1;
+  for (int wait_itr = 0; wait_itr < 100; wait_itr++) {
+    auto txn = txn_manager.BeginReadonlyTransaction();
+    TransactionTestsUtil::ExecuteRead(txn, table.get(), 0, result);
+    // reads are not tracked
+    EXPECT_TRUE(txn->GetRWSet().empty());
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+    if (result == 0) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(0, result);
+
+  // a writer that commits after the snapshot is not seen
+  auto readonly_txn = txn_manager.BeginReadonlyTransaction();
+  auto txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 0, 1));
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  // the versions the snapshot reads are kept
+  EXPECT_LE(txn_manager.GetMaxCommittedCid(),
+            readonly_txn->GetBeginCommitId());
+
+  EXPECT_TRUE(
+      TransactionTestsUtil::ExecuteRead(readonly_txn, table.get(), 0, result));
+  EXPECT_EQ(0, result);
+
+  // writes are rejected
+  EXPECT_FALSE(
+      TransactionTestsUtil::ExecuteUpdate(readonly_txn, table.get(), 1, 1));
+  EXPECT_EQ(RESULT_FAILURE, readonly_txn->GetResult());
+  txn_manager.AbortTransaction(readonly_txn);
+}
+
+// runs an update of the key that the owner holds in a thread, and finishes
+// the owner once the update waits for it
+static bool UpdateAfterOwner(concurrency::Transaction *txn,
+                             concurrency::Transaction *owner_txn,
+                             bool owner_commits, storage::DataTable *table) {
+  auto &txn_manager = concurrency::TimestampOrderingTransactionManager::
+      GetInstance();
+
+  bool update_result = false;
+  std::thread update_thread([&] {
+    update_result = TransactionTestsUtil::ExecuteUpdate(txn, table, 0, 2);
+  });
+
+  while (txn_manager.GetOwnerWaiterCount() == 0) {
+    std::this_thread::yield();
+  }
+
+  if (owner_commits == true) {
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(owner_txn));
+  } else {
+    txn_manager.AbortTransaction(owner_txn);
+  }
+
+  update_thread.join();
+  EXPECT_EQ(0U, txn_manager.GetOwnerWaiterCount());
+  return update_result;
+}
+
+TEST_F(TimestampOrderingTransactionManagerTests, HotTupleWaitTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // every loaded tuple is hot after a single failure
+  FLAGS_hot_tuple_threshold = 1;
+  auto tile_group_header = table->GetTileGroup(0)->GetHeader();
+  for (oid_t tuple_id = 0; tuple_id < 10; tuple_id++) {
+    tile_group_header->IncrementAbortCount(tuple_id);
+  }
+
+  // an older transaction waits for the owner, and gets the tuple once the
+  // owner aborts
+  {
+    auto txn = txn_manager.BeginTransaction();
+    auto owner_txn = txn_manager.BeginTransaction();
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(owner_txn, table.get(),
+                                                    0, 1));
+
+    EXPECT_TRUE(UpdateAfterOwner(txn, owner_txn, false, table.get()));
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+  }
+
+  // it waits as well if the owner commits, but the version it read is no
+  // longer the latest one
+  {
+    auto txn = txn_manager.BeginTransaction();
+    auto owner_txn = txn_manager.BeginTransaction();
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(owner_txn, table.get(),
+                                                    0, 1));
+
+    EXPECT_FALSE(UpdateAfterOwner(txn, owner_txn, true, table.get()));
+    txn_manager.AbortTransaction(txn);
+  }
+
+  // a younger transaction never waits for an older owner
+  {
+    auto owner_txn = txn_manager.BeginTransaction();
+    auto txn = txn_manager.BeginTransaction();
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(owner_txn, table.get(),
+                                                    0, 3));
+
+    EXPECT_FALSE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 0, 4));
+    EXPECT_EQ(0U, concurrency::TimestampOrderingTransactionManager::
+                     GetInstance().GetOwnerWaiterCount());
+    txn_manager.AbortTransaction(txn);
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(owner_txn));
+  }
+
+  int result = -1;
+  auto txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 0, result));
+  EXPECT_EQ(3, result);
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  FLAGS_hot_tuple_threshold = 0;
+}
+
 }  // End test namespace
 }  // End peloton namespace
@@ -0,0 +1,233 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// two_phase_locking_transaction_manager_test.cpp
+//
+// Identification:
+// test/concurrency/two_phase_locking_transaction_manager_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <functional>
+#include <thread>
+
+#include "common/harness.h"
+#include "concurrency/transaction_tests_util.h"
+#include "concurrency/two_phase_locking_transaction_manager.h"
+
+namespace peloton {
+
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Two-Phase Locking Transaction Tests
+//===--------------------------------------------------------------------===//
+
+class TwoPhaseLockingTransactionManagerTests : public PelotonTest {};
+
+TEST_F(TwoPhaseLockingTransactionManagerTests, NoWaitTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TWO_PHASE_LOCKING_NO_WAIT);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+  // a write conflicts with a shared lock
+  {
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(1).Update(0, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[1].txn_result);
+  }
+
+  // a read conflicts with an exclusive lock
+  {
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Update(0, 1);
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[1].txn_result);
+  }
+
+  // the latest committed version is read, and the locks are released at
+  // commit
+  {
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(1);
+    scheduler.Txn(1).Update(0, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(0).Update(1, 2);
+    scheduler.Txn(0).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(1, scheduler.schedules[0].results[1]);
+  }
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+}
+
+TEST_F(TwoPhaseLockingTransactionManagerTests, WaitDieTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+  // a younger transaction dies, the older one upgrades its shared lock
+  {
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+    TransactionScheduler scheduler(3, table.get(), &txn_manager);
+    scheduler.Txn(0).Read(0);
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Update(0, 1);
+    scheduler.Txn(1).Commit();
+    scheduler.Txn(0).Update(0, 2);
+    scheduler.Txn(0).Commit();
+    scheduler.Txn(2).Read(0);
+    scheduler.Txn(2).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[2].txn_result);
+    EXPECT_EQ(2, scheduler.schedules[2].results[0]);
+  }
+
+  // an aborted writer leaves the previous version behind
+  {
+    std::unique_ptr<storage::DataTable> table(
+        TransactionTestsUtil::CreateTable());
+    TransactionScheduler scheduler(2, table.get(), &txn_manager);
+    scheduler.Txn(0).Update(0, 1);
+    scheduler.Txn(0).Abort();
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Update(0, 2);
+    scheduler.Txn(1).Read(0);
+    scheduler.Txn(1).Commit();
+
+    scheduler.Run();
+
+    EXPECT_EQ(RESULT_ABORTED, scheduler.schedules[0].txn_result);
+    EXPECT_EQ(RESULT_SUCCESS, scheduler.schedules[1].txn_result);
+    EXPECT_EQ(0, scheduler.schedules[1].results[0]);
+    EXPECT_EQ(2, scheduler.schedules[1].results[1]);
+  }
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+}
+
+// Run the operation in another thread, and finish the holder once the
+// operation waits for its lock
+static bool RunAfterHolder(concurrency::Transaction *holder_txn,
+                           std::function<bool()> operation) {
+  auto &txn_manager =
+      concurrency::TwoPhaseLockingTransactionManager::GetInstance(
+          CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE);
+
+  bool operation_result = false;
+  std::thread operation_thread([&] { operation_result = operation(); });
+
+  while (txn_manager.GetOwnerWaiterCount() == 0) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(holder_txn));
+
+  operation_thread.join();
+  EXPECT_EQ(0U, txn_manager.GetOwnerWaiterCount());
+  return operation_result;
+}
+
+TEST_F(TwoPhaseLockingTransactionManagerTests, WaitTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TWO_PHASE_LOCKING_WAIT_DIE);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable());
+
+  // an older read waits for the writer, and reads the version it committed
+  {
+    auto txn = txn_manager.BeginTransaction();
+    auto writer_txn = txn_manager.BeginTransaction();
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(writer_txn, table.get(),
+                                                    0, 1));
+
+    int result = -1;
+    EXPECT_TRUE(RunAfterHolder(writer_txn, [&] {
+      return TransactionTestsUtil::ExecuteRead(txn, table.get(), 0, result);
+    }));
+    EXPECT_EQ(1, result);
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+  }
+
+  // an older write waits for a younger reader to leave
+  {
+    auto txn = txn_manager.BeginTransaction();
+    auto reader_txn = txn_manager.BeginTransaction();
+    int result = -1;
+    EXPECT_TRUE(
+        TransactionTestsUtil::ExecuteRead(reader_txn, table.get(), 1, result));
+    EXPECT_EQ(0, result);
+
+    EXPECT_TRUE(RunAfterHolder(reader_txn, [&] {
+      return TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 1, 2);
+    }));
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+  }
+
+  // once a reader older than the write leaves, the write waits for the
+  // younger ones
+  {
+    auto old_reader_txn = txn_manager.BeginTransaction();
+    auto txn = txn_manager.BeginTransaction();
+    auto reader_txn = txn_manager.BeginTransaction();
+    int result = -1;
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(old_reader_txn, table.get(),
+                                                  0, result));
+    EXPECT_TRUE(
+        TransactionTestsUtil::ExecuteRead(reader_txn, table.get(), 0, result));
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(old_reader_txn));
+
+    EXPECT_TRUE(RunAfterHolder(reader_txn, [&] {
+      return TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 0, 3);
+    }));
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+  }
+
+  int result = -1;
+  auto txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 0, result));
+  EXPECT_EQ(3, result);
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 1, result));
+  EXPECT_EQ(2, result);
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+}
+
+}  // End test namespace
+}  // End peloton namespace
@@ -36,6 +36,11 @@
 #include "optimizer/simple_optimizer.h"
 
 #include "executor/executor_tests_util.h"
+#include "concurrency/transaction_tests_util.h"
+#include "catalog/manager.h"
+#include "index/index.h"
+#include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
 
 using ::testing::NotNull;
 using ::testing::Return;
@@ -287,5 +292,99 @@ TEST_F(IndexScanTests, SQLTest) {
   txn_manager.CommitTransaction(txn);
 }
 
+// Returns the value of the version that the head of the only chain in the
+// table hints at, or -1 if there is no hint.
+static int GetHintValue(storage::DataTable *table) {
+  std::vector<ItemPointer *> tuple_location_ptrs;
+  table->GetIndex(0)->ScanAllKeys(tuple_location_ptrs);
+  EXPECT_EQ(1U, tuple_location_ptrs.size());
+
+  auto &manager = catalog::Manager::GetInstance();
+  ItemPointer head_location = *tuple_location_ptrs[0];
+  ItemPointer hint_location = manager.GetTileGroup(head_location.block)
+                                  ->GetHeader()
+                                  ->GetVersionHint(head_location.offset);
+  if (hint_location.IsNull() == true) {
+    return -1;
+  }
+  return manager.GetTileGroup(hint_location.block)
+      ->GetValue(hint_location.offset, 1)
+      .GetIntegerForTestsOnly();
+}
+
+// Old snapshots leave a hint at the head of a long chain and follow it on
+// later reads, also after the chain grows.
+TEST_F(IndexScanTests, VersionHintTest) {
+  concurrency::TransactionManagerFactory::Configure(
+      CONCURRENCY_TYPE_TIMESTAMP_ORDERING);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  std::unique_ptr<storage::DataTable> table(
+      TransactionTestsUtil::CreateTable(1));
+
+  auto update = [&](int value) {
+    auto txn = txn_manager.BeginTransaction();
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 0,
+                                                    value));
+    EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+  };
+
+  int result = -1;
+  auto old_txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(
+      TransactionTestsUtil::ExecuteRead(old_txn, table.get(), 0, result));
+  EXPECT_EQ(0, result);
+
+  update(1);
+  update(2);
+
+  auto mid_txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(
+      TransactionTestsUtil::ExecuteRead(mid_txn, table.get(), 0, result));
+  EXPECT_EQ(2, result);
+
+  update(3);
+  update(4);
+  EXPECT_EQ(-1, GetHintValue(table.get()));
+
+  // the old snapshot walks 4 -> 3 -> 2 -> 1 -> 0 and leaves the newest
+  // version that was too new for it
+  EXPECT_TRUE(
+      TransactionTestsUtil::ExecuteRead(old_txn, table.get(), 0, result));
+  EXPECT_EQ(0, result);
+  EXPECT_EQ(1, GetHintValue(table.get()));
+
+  // the new versions inherit the hint
+  for (int value = 5; value <= 8; value++) {
+    update(value);
+  }
+  EXPECT_EQ(1, GetHintValue(table.get()));
+
+  // the old snapshot jumps from 8 to 1 and still reads 0
+  EXPECT_TRUE(
+      TransactionTestsUtil::ExecuteRead(old_txn, table.get(), 0, result));
+  EXPECT_EQ(0, result);
+  EXPECT_EQ(1, GetHintValue(table.get()));
+
+  // the hint is older than the middle snapshot, which must not follow it
+  EXPECT_TRUE(
+      TransactionTestsUtil::ExecuteRead(mid_txn, table.get(), 0, result));
+  EXPECT_EQ(2, result);
+  EXPECT_EQ(3, GetHintValue(table.get()));
+
+  // the old snapshot follows the new hint and walks on from there
+  EXPECT_TRUE(
+      TransactionTestsUtil::ExecuteRead(old_txn, table.get(), 0, result));
+  EXPECT_EQ(0, result);
+
+  auto new_txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(
+      TransactionTestsUtil::ExecuteRead(new_txn, table.get(), 0, result));
+  EXPECT_EQ(8, result);
+
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(new_txn));
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(mid_txn));
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(old_txn));
+}
+
 }  // namespace test
 }  // namespace peloton
@@ -10,8 +10,17 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "catalog/schema.h"
 #include "common/harness.h"
+#include "common/value_factory.h"
 #include "concurrency/transaction_tests_util.h"
+#include "executor/executor_context.h"
+#include "executor/logical_tile.h"
+#include "executor/seq_scan_executor.h"
+#include "index/index_factory.h"
+#include "planner/seq_scan_plan.h"
+#include "storage/data_table.h"
+#include "storage/tuple.h"
 #include "gc/gc_manager.h"
 #include "gc/gc_manager_factory.h"
 #include "concurrency/epoch_manager.h"
@@ -28,6 +37,144 @@ class GCTest : public PelotonTest {};
 // FIXME: see the explanation rpc_client_test and rpc_server_test
 TEST_F(GCTest, BlankTest) {}
 
+// number of entries of the key in an index on a single integer column
+static size_t CountIndexEntries(index::Index *index, int value) {
+  std::unique_ptr<storage::Tuple> key(
+      new storage::Tuple(index->GetKeySchema(), true));
+  key->SetValue(0, ValueFactory::GetIntegerValue(value), nullptr);
+
+  std::vector<ItemPointer *> result;
+  index->ScanKey(key.get(), result);
+  return result.size();
+}
+
+// stopping the gc recycles all the pending garbage at once, as no
+// transaction is running.
+TEST_F(GCTest, DeleteFromIndexesTest) {
+  gc::GCManagerFactory::Configure(GARBAGE_COLLECTION_TYPE_ON);
+  auto &gc_manager = gc::GCManagerFactory::GetInstance();
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+  std::unique_ptr<storage::DataTable> table(TransactionTestsUtil::CreateTable(
+      0, "TEST_TABLE", INVALID_OID, INVALID_OID, 1234, true));
+
+  // a secondary index on the value column
+  auto tuple_schema = table->GetSchema();
+  std::vector<oid_t> key_attrs = {1};
+  auto key_schema = catalog::Schema::CopySchema(tuple_schema, key_attrs);
+  key_schema->SetIndexedColumns(key_attrs);
+  auto index_metadata = new index::IndexMetadata(
+      "secondary_btree_index", 1235, INVALID_OID, INVALID_OID,
+      INDEX_TYPE_BWTREE, INDEX_CONSTRAINT_TYPE_DEFAULT, tuple_schema,
+      key_schema, key_attrs, false);
+  std::shared_ptr<index::Index> secondary_index(
+      index::IndexFactory::GetInstance(index_metadata));
+  table->AddIndex(secondary_index);
+  auto primary_index = table->GetIndex(0);
+
+  auto txn = txn_manager.BeginTransaction();
+  for (int key = 0; key < 4; key++) {
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteInsert(txn, table.get(), key, 0));
+  }
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  // the update adds the new value next to the old one
+  txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 0, 1));
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteDelete(txn, table.get(), 1));
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteUpdate(txn, table.get(), 2, 2));
+  txn_manager.AbortTransaction(txn);
+
+  EXPECT_EQ(4U, CountIndexEntries(secondary_index.get(), 0));
+  EXPECT_EQ(1U, CountIndexEntries(secondary_index.get(), 1));
+  EXPECT_EQ(1U, CountIndexEntries(secondary_index.get(), 2));
+
+  gc_manager.StopGC();
+
+  // only the entries of the updated key, the deleted tuple and the aborted
+  // update are gone
+  EXPECT_EQ(2U, CountIndexEntries(secondary_index.get(), 0));
+  EXPECT_EQ(1U, CountIndexEntries(secondary_index.get(), 1));
+  EXPECT_EQ(0U, CountIndexEntries(secondary_index.get(), 2));
+
+  EXPECT_EQ(1U, CountIndexEntries(primary_index.get(), 0));
+  EXPECT_EQ(0U, CountIndexEntries(primary_index.get(), 1));
+  EXPECT_EQ(1U, CountIndexEntries(primary_index.get(), 2));
+
+  // the remaining tuples are still found through both indexes
+  int result = -1;
+  txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 0, result));
+  EXPECT_EQ(1, result);
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, table.get(), 2, result));
+  EXPECT_EQ(0, result);
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  gc_manager.StartGC();
+  gc::GCManagerFactory::Configure(GARBAGE_COLLECTION_TYPE_OFF);
+}
+
+TEST_F(GCTest, RetireTileGroupTest) {
+  gc::GCManagerFactory::Configure(GARBAGE_COLLECTION_TYPE_ON);
+  auto &gc_manager = gc::GCManagerFactory::GetInstance();
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+
+  // a full first tile group of 100 tuples, and a few in the second one
+  std::unique_ptr<storage::DataTable> table(TransactionTestsUtil::CreateTable(
+      110, "TEST_TABLE", INVALID_OID, INVALID_OID, 1234, true));
+  auto dead_tile_group_id = table->GetTileGroup(0)->GetTileGroupId();
+  auto tile_group_count = table->GetTileGroupCount();
+
+  // the garbage of the deletes waits in the queue until the gc runs again
+  gc_manager.StopGC();
+
+  auto txn = txn_manager.BeginTransaction();
+  for (int key = 0; key < 100; key++) {
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteDelete(txn, table.get(), key));
+  }
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  // the scan counts the tile groups before the first one is retired
+  txn = txn_manager.BeginTransaction();
+  std::unique_ptr<executor::ExecutorContext> context(
+      new executor::ExecutorContext(txn));
+  std::vector<oid_t> column_ids = {0, 1};
+  planner::SeqScanPlan seq_scan_node(table.get(), nullptr, column_ids);
+  executor::SeqScanExecutor seq_scan_executor(&seq_scan_node, context.get());
+  EXPECT_TRUE(seq_scan_executor.Init());
+
+  gc_manager.StartGC();
+  gc_manager.StopGC();
+
+  EXPECT_EQ(nullptr, table->GetTileGroup(0));
+  EXPECT_EQ(nullptr, table->GetTileGroupById(dead_tile_group_id));
+  EXPECT_EQ(tile_group_count, table->GetTileGroupCount());
+
+  // the scan skips the retired tile group and finds every live tuple
+  size_t tuple_count = 0;
+  while (seq_scan_executor.Execute() == true) {
+    std::unique_ptr<executor::LogicalTile> result_tile(
+        seq_scan_executor.GetOutput());
+    for (size_t tuple_itr = 0; tuple_itr < result_tile->GetTupleCount();
+         tuple_itr++) {
+      EXPECT_LE(100, result_tile->GetValue(tuple_itr, 0)
+                         .GetIntegerForTestsOnly());
+      tuple_count++;
+    }
+  }
+  EXPECT_EQ(10U, tuple_count);
+  EXPECT_EQ(RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  gc_manager.StartGC();
+  gc::GCManagerFactory::Configure(GARBAGE_COLLECTION_TYPE_OFF);
+}
+
 /*
 int UpdateTable(storage::DataTable *table, const int scale, const int num_key,
 const int num_txn) {
@@ -156,6 +156,45 @@ TEST_F(IndexTests, BasicTest) {
   delete tuple_schema;
 }
 
+TEST_F(IndexTests, DeleteSharedPointerTest) {
+  auto pool = TestingHarness::GetInstance().GetTestingPool();
+  std::vector<ItemPointer *> location_ptrs;
+
+  std::unique_ptr<index::Index> index(BuildIndex(false));
+
+  std::unique_ptr<storage::Tuple> key0(new storage::Tuple(key_schema, true));
+  key0->SetValue(0, ValueFactory::GetIntegerValue(100), pool);
+  key0->SetValue(1, ValueFactory::GetStringValue("a"), pool);
+
+  std::unique_ptr<storage::Tuple> key1(new storage::Tuple(key_schema, true));
+  key1->SetValue(0, ValueFactory::GetIntegerValue(100), pool);
+  key1->SetValue(1, ValueFactory::GetStringValue("b"), pool);
+
+  // two keys of the same tuple share the pointer to the version chain
+  ItemPointer *head = new ItemPointer(item0);
+  ItemPointer *other_head = new ItemPointer(item1);
+  index->InsertEntry(key0.get(), head);
+  index->InsertEntry(key1.get(), head);
+  index->InsertEntry(key0.get(), other_head);
+
+  // the entry of the stale key is removed, the pointer stays valid
+  EXPECT_TRUE(index->DeleteEntry(key0.get(), head));
+
+  index->ScanKey(key0.get(), location_ptrs);
+  EXPECT_EQ(location_ptrs.size(), 1);
+  EXPECT_EQ(other_head, location_ptrs[0]);
+  location_ptrs.clear();
+
+  index->ScanKey(key1.get(), location_ptrs);
+  EXPECT_EQ(location_ptrs.size(), 1);
+  EXPECT_EQ(item0.offset, location_ptrs[0]->offset);
+  location_ptrs.clear();
+
+  EXPECT_FALSE(index->DeleteEntry(key0.get(), head));
+
+  delete tuple_schema;
+}
+
 // INSERT HELPER FUNCTION
 void InsertTest(index::Index *index, VarlenPool *pool, size_t scale_factor,
                 UNUSED_ATTRIBUTE uint64_t thread_itr) {
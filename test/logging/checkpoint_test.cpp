@@ -12,6 +12,7 @@
 
 #include "common/harness.h"
 #include "catalog/catalog.h"
+#include "common/value_peeker.h"
 #include "logging/checkpoint.h"
 #include "logging/logging_util.h"
 #include "logging/loggers/wal_backend_logger.h"
@@ -113,6 +114,160 @@ TEST_F(CheckpointTests, CheckpointIntegrationTest) {
   logging::LoggingUtil::RemoveDirectory("pl_checkpoint", false);
 }
 
+TEST_F(CheckpointTests, CheckpointIncrementalTest) {
+  logging::LoggingUtil::RemoveDirectory("pl_checkpoint", false);
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  auto txn = txn_manager.BeginTransaction();
+
+  size_t tile_group_size = TESTS_TUPLES_PER_TILEGROUP;
+  size_t table_tile_group_count = 3;
+
+  // table has 3 tile groups, and no index so that the rows may repeat
+  oid_t default_table_oid = 14;
+  storage::DataTable *target_table =
+      ExecutorTestsUtil::CreateTable(tile_group_size, false, default_table_oid);
+  ExecutorTestsUtil::PopulateTable(target_table,
+                                   tile_group_size * table_tile_group_count,
+                                   false, false, false, txn);
+  txn_manager.CommitTransaction(txn);
+
+  auto catalog = catalog::Catalog::GetInstance();
+  storage::Database *db(new storage::Database(DEFAULT_DB_ID));
+  db->AddTable(target_table);
+  catalog->AddDatabase(db);
+
+  auto &checkpoint_manager = logging::CheckpointManager::GetInstance();
+  auto &log_manager = logging::LogManager::GetInstance();
+  checkpoint_manager.Configure(CHECKPOINT_TYPE_NORMAL, false, 1);
+  checkpoint_manager.DestroyCheckpointers();
+  checkpoint_manager.InitCheckpointers();
+  auto checkpointer = reinterpret_cast<logging::SimpleCheckpoint *>(
+      checkpoint_manager.GetCheckpointer(0));
+
+  // the first checkpoint is full
+  log_manager.SetGlobalMaxFlushedCommitId(txn_manager.GetNextCommitId());
+  checkpointer->DoCheckpoint();
+  EXPECT_EQ(checkpointer->GetCheckpointChain().size(), 1);
+  EXPECT_TRUE(checkpointer->GetCheckpointChain().back().full);
+
+  // a tuple is inserted, the first one of the first tile group updated and
+  // the first one of the second tile group deleted
+  txn = txn_manager.BeginTransaction();
+  ExecutorTestsUtil::PopulateTable(target_table, 1, false, false, false, txn);
+  txn_manager.CommitTransaction(txn);
+
+  std::unique_ptr<VarlenPool> pool(new VarlenPool(BACKEND_TYPE_MM));
+  oid_t updated_tuple_id = 100;
+  auto updated_tuple =
+      ExecutorTestsUtil::GetTuple(target_table, updated_tuple_id, pool.get());
+  ItemPointer updated_location(target_table->GetTileGroup(0)->GetTileGroupId(),
+                               0);
+  txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(txn_manager.AcquireOwnership(
+      txn, catalog_manager.GetTileGroup(updated_location.block)->GetHeader(),
+      updated_location.offset));
+  auto new_version = target_table->AcquireVersion();
+  catalog_manager.GetTileGroup(new_version.block)
+      ->CopyTuple(updated_tuple.get(), new_version.offset);
+  txn_manager.PerformUpdate(txn, updated_location, new_version);
+  txn_manager.CommitTransaction(txn);
+
+  ItemPointer deleted_location(target_table->GetTileGroup(1)->GetTileGroupId(),
+                               0);
+  txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(txn_manager.AcquireOwnership(
+      txn, catalog_manager.GetTileGroup(deleted_location.block)->GetHeader(),
+      deleted_location.offset));
+  auto empty_version = target_table->InsertEmptyVersion();
+  txn_manager.PerformDelete(txn, deleted_location, empty_version);
+  txn_manager.CommitTransaction(txn);
+
+  // the next one only holds the tile groups that changed
+  log_manager.SetGlobalMaxFlushedCommitId(txn_manager.GetNextCommitId());
+  checkpointer->DoCheckpoint();
+  auto &checkpoint_chain = checkpointer->GetCheckpointChain();
+  EXPECT_EQ(checkpoint_chain.size(), 2);
+  EXPECT_FALSE(checkpoint_chain.back().full);
+  EXPECT_LT(checkpoint_chain.back().tile_group_ids.size(),
+            table_tile_group_count + 1);
+
+  // the database is recovered into an empty table
+  auto recreate_table = [&] {
+    catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
+    db = new storage::Database(DEFAULT_DB_ID);
+    db->AddTable(ExecutorTestsUtil::CreateTable(tile_group_size, false,
+                                                default_table_oid));
+    catalog->AddDatabase(db);
+    checkpoint_manager.DestroyCheckpointers();
+    checkpoint_manager.InitCheckpointers();
+    log_manager.PrepareRecovery();
+    return reinterpret_cast<logging::SimpleCheckpoint *>(
+        checkpoint_manager.GetCheckpointer(0));
+  };
+  auto recovery_checkpointer = recreate_table();
+
+  // recovery assembles the database from both checkpoints, the updated and
+  // deleted versions of the full one are overridden
+  recovery_checkpointer->DoRecovery();
+  EXPECT_FALSE(log_manager.IsRecoveryFailed());
+  EXPECT_EQ(recovery_checkpointer->GetCheckpointChain().size(), 2);
+  EXPECT_EQ(db->GetTable(0)->GetTupleCount(),
+            tile_group_size * table_tile_group_count);
+
+  auto updated_tile_group =
+      catalog_manager.GetTileGroup(updated_location.block);
+  EXPECT_EQ(updated_tile_group->GetHeader()->GetTransactionId(
+                updated_location.offset),
+            INVALID_TXN_ID);
+  auto new_tile_group = catalog_manager.GetTileGroup(new_version.block);
+  EXPECT_EQ(
+      new_tile_group->GetHeader()->GetTransactionId(new_version.offset),
+      INITIAL_TXN_ID);
+  EXPECT_EQ(ValuePeeker::PeekAsInteger(
+                new_tile_group->GetValue(new_version.offset, 0)),
+            ExecutorTestsUtil::PopulatedValue(updated_tuple_id, 0));
+  auto deleted_tile_group =
+      catalog_manager.GetTileGroup(deleted_location.block);
+  EXPECT_EQ(deleted_tile_group->GetHeader()->GetTransactionId(
+                deleted_location.offset),
+            INVALID_TXN_ID);
+
+  // without a manifest, recovery starts from the full checkpoint
+  auto manifest_name =
+      std::string("pl_checkpoint/") + CHECKPOINT_MANIFEST_FILE_NAME;
+  fclose(fopen(manifest_name.c_str(), "wb"));
+  recovery_checkpointer = recreate_table();
+  recovery_checkpointer->DoRecovery();
+  EXPECT_FALSE(log_manager.IsRecoveryFailed());
+  EXPECT_EQ(recovery_checkpointer->GetCheckpointChain().size(), 1);
+  EXPECT_EQ(db->GetTable(0)->GetTupleCount(),
+            tile_group_size * table_tile_group_count);
+
+  updated_tile_group = catalog_manager.GetTileGroup(updated_location.block);
+  EXPECT_EQ(ValuePeeker::PeekAsInteger(
+                updated_tile_group->GetValue(updated_location.offset, 0)),
+            ExecutorTestsUtil::PopulatedValue(0, 0));
+  deleted_tile_group = catalog_manager.GetTileGroup(deleted_location.block);
+  EXPECT_EQ(deleted_tile_group->GetHeader()->GetTransactionId(
+                deleted_location.offset),
+            INITIAL_TXN_ID);
+
+  // and fails without a full checkpoint
+  auto full_checkpoint_name = std::string("pl_checkpoint/peloton_checkpoint_") +
+                              std::to_string(checkpoint_chain.front().version) +
+                              ".log";
+  fclose(fopen(full_checkpoint_name.c_str(), "wb"));
+  recovery_checkpointer = recreate_table();
+  EXPECT_EQ(recovery_checkpointer->DoRecovery(), 0U);
+  EXPECT_TRUE(log_manager.IsRecoveryFailed());
+  EXPECT_EQ(db->GetTable(0)->GetTupleCount(), 0U);
+
+  log_manager.ResetLogStatus();
+  catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
+  logging::LoggingUtil::RemoveDirectory("pl_checkpoint", false);
+}
+
 TEST_F(CheckpointTests, CheckpointScanTest) {
   logging::LoggingUtil::RemoveDirectory("pl_checkpoint", false);
 
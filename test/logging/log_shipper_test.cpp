@@ -0,0 +1,139 @@
+//===----------------------------------------------------------------------===//
+//
+//                         Peloton
+//
+// log_shipper_test.cpp
+//
+// Identification: test/logging/log_shipper_test.cpp
+//
+// Copyright (c) 2015-16, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/harness.h"
+
+#include "logging/log_shipper.h"
+
+namespace peloton {
+namespace test {
+
+//===--------------------------------------------------------------------===//
+// Log Shipper Tests
+//===--------------------------------------------------------------------===//
+class LogShipperTests : public PelotonTest {};
+
+// records the batches instead of sending them to a standby
+class TestLogShipper : public logging::LogShipper {
+ public:
+  TestLogShipper(ReplicationType replication_type, int64_t resend_timeout,
+                 int64_t sync_timeout)
+      : logging::LogShipper("127.0.0.1:1", replication_type, 1) {
+    resend_timeout_micros_ = resend_timeout;
+    sync_timeout_micros_ = sync_timeout;
+  }
+
+  std::vector<int64_t> GetSentBatches() {
+    std::lock_guard<std::mutex> lock(sent_mutex_);
+    return sent_batches_;
+  }
+
+  bool fail_sends = false;
+
+ protected:
+  bool SendBatch(UNUSED_ATTRIBUTE int logger_id, int64_t sequence_number,
+                 UNUSED_ATTRIBUTE const std::string &log) override {
+    std::lock_guard<std::mutex> lock(sent_mutex_);
+    if (fail_sends) {
+      return false;
+    }
+    sent_batches_.push_back(sequence_number);
+    return true;
+  }
+
+ private:
+  std::mutex sent_mutex_;
+
+  std::vector<int64_t> sent_batches_;
+};
+
+TEST_F(LogShipperTests, ResendBatchTest) {
+  TestLogShipper shipper(ASYNC_REPLICATION, 1000, 1000000);
+
+  shipper.Ship(0, "first");
+  EXPECT_EQ(shipper.GetSentBatches(), std::vector<int64_t>({1}));
+
+  // the unanswered batch goes again before the next one
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  shipper.Ship(0, "second");
+  EXPECT_EQ(shipper.GetSentBatches(), std::vector<int64_t>({1, 1, 2}));
+
+  // the answered batches are not sent again
+  shipper.Acknowledge(0, 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  shipper.Ship(0, "third");
+  EXPECT_EQ(shipper.GetSentBatches(), std::vector<int64_t>({1, 1, 2, 3}));
+  EXPECT_EQ(shipper.GetShippedSequenceNumber(0), 3);
+  EXPECT_FALSE(shipper.IsStopped());
+}
+
+TEST_F(LogShipperTests, SyncAcknowledgeTest) {
+  TestLogShipper shipper(SYNC_REPLICATION, 1000, 10000000);
+
+  std::thread standby([&shipper] {
+    while (shipper.GetShippedSequenceNumber(0) < 1) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    shipper.Acknowledge(0, 1);
+  });
+
+  shipper.Ship(0, "first");
+  standby.join();
+
+  EXPECT_EQ(shipper.GetAcknowledgedSequenceNumber(0), 1);
+  EXPECT_EQ(shipper.GetReplicationType(), SYNC_REPLICATION);
+}
+
+TEST_F(LogShipperTests, SyncTimeoutTest) {
+  TestLogShipper shipper(SYNC_REPLICATION, 1000, 20000);
+
+  // the standby never answers, the batch is sent again while it is waited
+  // for and the standby is shipped to asynchronously after the timeout
+  shipper.Ship(0, "first");
+  EXPECT_GT(shipper.GetSentBatches().size(), 1U);
+  EXPECT_EQ(shipper.GetReplicationType(), ASYNC_REPLICATION);
+  EXPECT_FALSE(shipper.IsStopped());
+
+  shipper.Ship(0, "second");
+  EXPECT_EQ(shipper.GetShippedSequenceNumber(0), 2);
+}
+
+TEST_F(LogShipperTests, StopShippingTest) {
+  TestLogShipper shipper(ASYNC_REPLICATION, 1000000, 1000000);
+
+  // shipping stops once the standby has not answered too many batches
+  for (int batch = 0; batch < LOG_SHIPPING_MAX_UNACKNOWLEDGED_BATCHES;
+       batch++) {
+    shipper.Ship(0, "batch");
+  }
+  EXPECT_FALSE(shipper.IsStopped());
+  shipper.Ship(0, "batch");
+  EXPECT_TRUE(shipper.IsStopped());
+  EXPECT_EQ(shipper.GetShippedSequenceNumber(0),
+            LOG_SHIPPING_MAX_UNACKNOWLEDGED_BATCHES);
+
+  // and once a batch could not be sent
+  TestLogShipper failing_shipper(ASYNC_REPLICATION, 1000000, 1000000);
+  failing_shipper.fail_sends = true;
+  failing_shipper.Ship(0, "batch");
+  EXPECT_TRUE(failing_shipper.IsStopped());
+  EXPECT_EQ(failing_shipper.GetShippedSequenceNumber(0), 0);
+}
+
+}  // End test namespace
+}  // End peloton namespace
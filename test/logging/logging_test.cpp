@@ -10,6 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>
+#include <thread>
+
 #include "common/harness.h"
 #include "catalog/catalog.h"
 
@@ -17,7 +20,12 @@
 #include "executor/logical_tile_factory.h"
 #include "storage/data_table.h"
 #include "storage/tile.h"
+#include "logging/buffer_pool.h"
+#include "logging/log_buffer.h"
+#include "logging/loggers/wal_backend_logger.h"
 #include "logging/loggers/wal_frontend_logger.h"
+#include "logging/records/transaction_record.h"
+#include "logging/records/tuple_record.h"
 #include "logging/logging_util.h"
 #include "storage/table_factory.h"
 #include "storage/database.h"
@@ -316,6 +324,51 @@ TEST_F(LoggingTests, InsertUpdateDeleteTest) {
   scheduler.Cleanup();
 }
 
+// A committing transaction prepares its backend logger before its writes
+// become visible. A transaction that read them and committed on another
+// backend logger is not reported durable until the writes are logged.
+TEST_F(LoggingTests, VisibleBeforeDurableTest) {
+  std::unique_ptr<storage::DataTable> table(ExecutorTestsUtil::CreateTable(1));
+
+  auto &log_manager = logging::LogManager::GetInstance();
+
+  LoggingScheduler scheduler(2, 1, &log_manager, table.get());
+
+  scheduler.Init();
+  scheduler.BackendLogger(0, 0).Prepare();
+  scheduler.BackendLogger(0, 0).Begin(2);
+  scheduler.BackendLogger(0, 0).Insert(2);
+  scheduler.BackendLogger(0, 0).Commit(2);
+  scheduler.BackendLogger(0, 1).Prepare();
+  scheduler.BackendLogger(0, 1).Begin(3);
+  scheduler.BackendLogger(0, 1).Insert(3);
+  scheduler.BackendLogger(0, 1).Commit(3);
+  scheduler.FrontendLogger(0).Collect();
+  scheduler.FrontendLogger(0).Flush();
+  // transaction 4 installs its writes, and transaction 5 reads them
+  scheduler.BackendLogger(0, 0).Prepare();
+  scheduler.BackendLogger(0, 1).Prepare();
+  scheduler.BackendLogger(0, 1).Begin(5);
+  scheduler.BackendLogger(0, 1).Insert(5);
+  scheduler.BackendLogger(0, 1).Commit(5);
+  scheduler.FrontendLogger(0).Collect();
+  scheduler.FrontendLogger(0).Flush();
+  scheduler.BackendLogger(0, 0).Begin(4);
+  scheduler.BackendLogger(0, 0).Insert(4);
+  scheduler.BackendLogger(0, 0).Commit(4);
+  scheduler.FrontendLogger(0).Collect();
+  scheduler.FrontendLogger(0).Flush();
+  scheduler.BackendLogger(0, 0).Done(1);
+  scheduler.BackendLogger(0, 1).Done(1);
+  scheduler.Run();
+
+  auto results = scheduler.frontend_threads[0].results;
+  EXPECT_EQ(3U, results[0]);
+  EXPECT_EQ(3U, results[1]);
+  EXPECT_LE(4U, results[2]);
+  scheduler.Cleanup();
+}
+
 TEST_F(LoggingTests, BasicLogManagerTest) {
   peloton_logging_mode = LOGGING_TYPE_INVALID;
   auto &log_manager = logging::LogManager::GetInstance();
@@ -369,8 +422,100 @@ TEST_F(LoggingTests, BasicLogManagerTest) {
 
   // since we are doing sync commit we should have reached 5 already
   EXPECT_EQ(commit_id, log_manager.GetPersistentFlushedCommitId());
+
+  // the same writes logged as one batch
+  commit_id = 6;
+  std::vector<logging::LogWrite> writes;
+  writes.emplace_back(LOGRECORD_TYPE_TUPLE_INSERT, INVALID_ITEMPOINTER,
+                      insert_loc);
+  writes.emplace_back(LOGRECORD_TYPE_TUPLE_UPDATE, update_old, update_new);
+  writes.emplace_back(LOGRECORD_TYPE_TUPLE_DELETE, delete_loc,
+                      INVALID_ITEMPOINTER);
+  log_manager.PrepareLogging();
+  log_manager.LogTransaction(commit_id, writes);
+
+  EXPECT_EQ(commit_id, log_manager.GetPersistentFlushedCommitId());
+
+  // an asynchronous commit does not wait for the flush. without a waiter,
+  // the frontend logger defers the flush up to the maximum commit lag.
+  auto max_commit_lag = log_manager.GetMaxCommitLagMicros();
+  log_manager.SetMaxCommitLagMicros(10 * 1000 * 1000);
+  commit_id = 7;
+  log_manager.PrepareLogging();
+  log_manager.LogTransaction(commit_id, writes, false);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(commit_id - 1, log_manager.GetPersistentFlushedCommitId());
+
+  // a waiter has the deferred flush done right away
+  log_manager.WaitForFlush(commit_id);
+  EXPECT_EQ(commit_id, log_manager.GetPersistentFlushedCommitId());
+
+  // a synchronous commit is flushed without waiting for the lag either
+  commit_id = 8;
+  log_manager.PrepareLogging();
+  log_manager.LogTransaction(commit_id, writes);
+  EXPECT_EQ(commit_id, log_manager.GetPersistentFlushedCommitId());
+
+  // a commit after a failed write is not reported as flushed
+  log_manager.SetLogFailed();
+  commit_id = 9;
+  log_manager.PrepareLogging();
+  EXPECT_FALSE(log_manager.LogTransaction(commit_id, writes));
+  EXPECT_EQ(commit_id - 1, log_manager.GetPersistentFlushedCommitId());
+
+  log_manager.SetMaxCommitLagMicros(max_commit_lag);
   log_manager.EndLogging();
 }
 
+// The records of a transaction reach the log buffers in full and in order,
+// also when they do not fit in one buffer.
+TEST_F(LoggingTests, LogRecordsTest) {
+  auto &log_manager = logging::LogManager::GetInstance();
+
+  cid_t commit_id = 10;
+  std::vector<std::unique_ptr<logging::LogRecord>> records;
+  records.emplace_back(new logging::TransactionRecord(
+      LOGRECORD_TYPE_TRANSACTION_BEGIN, commit_id));
+  for (oid_t tuple_id = 0; tuple_id < 4; tuple_id++) {
+    records.emplace_back(new logging::TupleRecord(
+        LOGRECORD_TYPE_WAL_TUPLE_DELETE, commit_id, 1, INVALID_ITEMPOINTER,
+        ItemPointer(1, tuple_id), nullptr, 1));
+  }
+  records.emplace_back(new logging::TransactionRecord(
+      LOGRECORD_TYPE_TRANSACTION_COMMIT, commit_id));
+
+  // buffers that hold about two records each
+  auto log_buffer_capacity = log_manager.GetLogBufferCapacity();
+  log_manager.SetLogBufferCapacity(64);
+  logging::WriteAheadBackendLogger backend_logger;
+  for (int buffer_itr = 0; buffer_itr < BUFFER_POOL_SIZE; buffer_itr++) {
+    std::unique_ptr<logging::LogBuffer> buffer(
+        new logging::LogBuffer(&backend_logger));
+    backend_logger.GrantEmptyBuffer(std::move(buffer));
+  }
+  log_manager.SetLogBufferCapacity(log_buffer_capacity);
+
+  EXPECT_TRUE(backend_logger.Log(records));
+
+  auto cid_pair = backend_logger.PrepareLogBuffers();
+  EXPECT_EQ(INVALID_CID, cid_pair.first);
+  EXPECT_EQ(commit_id, cid_pair.second);
+
+  auto &log_buffers = backend_logger.GetLogBuffers();
+  EXPECT_LT(1U, log_buffers.size());
+
+  std::string expected_data;
+  for (auto &record : records) {
+    expected_data.append(record->GetMessage(), record->GetMessageLength());
+  }
+  std::string logged_data;
+  for (auto &log_buffer : log_buffers) {
+    EXPECT_EQ(commit_id, log_buffer->GetMaxLogId());
+    logged_data.append(log_buffer->GetData(), log_buffer->GetSize());
+  }
+  EXPECT_EQ(expected_data, logged_data);
+  log_buffers.clear();
+}
+
 }  // End test namespace
 }  // End peloton namespace
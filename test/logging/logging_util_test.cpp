@@ -11,8 +11,12 @@
 //===----------------------------------------------------------------------===//
 
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "common/harness.h"
 
+#include "logging/async_file_writer.h"
 #include "logging/logging_util.h"
 
 namespace peloton {
@@ -31,5 +35,86 @@ TEST_F(LoggingUtilTests, BasicLoggingUtilTest) {
   EXPECT_EQ(status, true);
 }
 
+TEST_F(LoggingUtilTests, AsyncFileWriterTest) {
+  std::string file_name = "async_file_writer_test.log";
+  int fd = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  EXPECT_NE(fd, -1);
+
+  // the writes land at their offsets whether or not io_uring is available
+  logging::AsyncFileWriter writer(4);
+  std::vector<std::string> chunks = {"abcd", "efgh", "ijkl", "mnop", "qrst"};
+  for (size_t chunk_itr = 0; chunk_itr < chunks.size(); chunk_itr++) {
+    writer.Write(fd, chunks[chunk_itr].c_str(), chunks[chunk_itr].size(),
+                 chunk_itr * 4);
+  }
+  auto ticket = writer.Sync(fd);
+  writer.Submit();
+
+  EXPECT_EQ(writer.Reap(true), ticket);
+  EXPECT_EQ(writer.GetLastTicket(), ticket);
+  EXPECT_EQ(writer.GetFailedCount(), 0UL);
+
+  char buffer[20];
+  EXPECT_EQ(pread(fd, buffer, sizeof(buffer), 0), (ssize_t)sizeof(buffer));
+  EXPECT_EQ(std::string(buffer, sizeof(buffer)), "abcdefghijklmnopqrst");
+
+  close(fd);
+  EXPECT_EQ(unlink(file_name.c_str()), 0);
+}
+
+TEST_F(LoggingUtilTests, AsyncFileWriterLinkedSyncTest) {
+  std::string file_name = "async_file_writer_linked_sync_test.log";
+  int fd = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  EXPECT_NE(fd, -1);
+
+  // each sync follows its own write, and the queue depth is reached on the
+  // way, so a write and its sync have to be queued together
+  logging::AsyncFileWriter writer(3);
+  std::vector<std::string> chunks = {"abcd", "efgh", "ijkl", "mnop", "qrst"};
+  uint64_t ticket = 0;
+  for (size_t chunk_itr = 0; chunk_itr < chunks.size(); chunk_itr++) {
+    ticket = writer.WriteAndSync(fd, chunks[chunk_itr].c_str(),
+                                 chunks[chunk_itr].size(), chunk_itr * 4);
+    writer.Submit();
+  }
+
+  EXPECT_EQ(writer.Reap(true), ticket);
+  EXPECT_EQ(writer.GetLastTicket(), 10U);
+  EXPECT_EQ(writer.GetFailedCount(), 0UL);
+
+  char buffer[20];
+  EXPECT_EQ(pread(fd, buffer, sizeof(buffer), 0), (ssize_t)sizeof(buffer));
+  EXPECT_EQ(std::string(buffer, sizeof(buffer)), "abcdefghijklmnopqrst");
+
+  close(fd);
+  EXPECT_EQ(unlink(file_name.c_str()), 0);
+}
+
+TEST_F(LoggingUtilTests, AsyncFileWriterFailureTest) {
+  std::string file_name = "async_file_writer_failure_test.log";
+  int fd = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  EXPECT_NE(fd, -1);
+  int read_only_fd = open(file_name.c_str(), O_RDONLY);
+  EXPECT_NE(read_only_fd, -1);
+
+  // the tickets stop completing at the failed write
+  logging::AsyncFileWriter writer(4);
+  std::string chunk = "abcd";
+  writer.Write(fd, chunk.c_str(), chunk.size(), 0);
+  auto failed_ticket =
+      writer.Write(read_only_fd, chunk.c_str(), chunk.size(), 4);
+  auto sync_ticket = writer.Sync(fd);
+  writer.Submit();
+
+  EXPECT_EQ(writer.Reap(true), failed_ticket - 1);
+  EXPECT_EQ(writer.GetLastTicket(), sync_ticket);
+  EXPECT_EQ(writer.GetFailedTicket(), failed_ticket);
+  EXPECT_GE(writer.GetFailedCount(), 1UL);
+
+  close(read_only_fd);
+  close(fd);
+  EXPECT_EQ(unlink(file_name.c_str()), 0);
+}
+
 }  // End test namespace
 }  // End peloton namespace
@@ -14,6 +14,9 @@
 #include <sys/types.h>
 #include <sys/mman.h>
 #include <dirent.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 #include "common/harness.h"
 #include "catalog/catalog.h"
@@ -23,7 +26,9 @@
 #include "storage/data_table.h"
 #include "storage/tile.h"
 #include "logging/loggers/wal_frontend_logger.h"
+#include "logging/checkpoint_manager.h"
 #include "logging/log_manager.h"
+#include "logging/log_replayer.h"
 #include "logging/logging_util.h"
 #include "index/index.h"
 #include "storage/database.h"
@@ -277,6 +282,385 @@ TEST_F(RecoveryTests, RestartTest) {
   catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
 }
 
+TEST_F(RecoveryTests, DirectIOSegmentTest) {
+  std::string dir_name = logging::WriteAheadFrontendLogger::wal_directory_path;
+  auto &log_manager = logging::LogManager::GetInstance();
+  auto file_size_limit = log_manager.GetLogFileSizeLimit();
+
+  logging::LoggingUtil::RemoveDirectory(dir_name.c_str(), false);
+  log_manager.SetLogDirectoryName("./");
+  log_manager.SetLogFileSizeLimit(64);
+
+  auto log_file_name = [&dir_name](std::string prefix, int version) {
+    return dir_name + "/" + prefix + std::to_string(version) + ".log";
+  };
+  struct stat stat_buf;
+
+  auto write_delimiter = [](logging::WriteAheadFrontendLogger &wal_fel,
+                            cid_t commit_id) {
+    logging::TransactionRecord record(LOGRECORD_TYPE_ITERATION_DELIMITER,
+                                      commit_id);
+    CopySerializeOutput output_buffer;
+    record.Serialize(output_buffer);
+    wal_fel.WriteLogFile(record.GetMessage(), record.GetMessageLength());
+    wal_fel.SyncLogFile();
+  };
+
+  {
+    logging::WriteAheadFrontendLogger wal_fel;
+    wal_fel.SetDirectIO(true);
+
+    // each sync writes a frame of its own
+    wal_fel.CreateNewLogFile(false);
+    write_delimiter(wal_fel, 8);
+    write_delimiter(wal_fel, 9);
+    wal_fel.CreateNewLogFile(true);
+
+    // the truncated segment is kept for reuse
+    wal_fel.TruncateLog(1);
+    EXPECT_NE(stat(log_file_name("peloton_log_", 0).c_str(), &stat_buf), 0);
+    EXPECT_EQ(
+        stat(log_file_name("peloton_free_log_", 0).c_str(), &stat_buf), 0);
+
+    // the reused segment still holds the second frame of its first use
+    wal_fel.CreateNewLogFile(true);
+    EXPECT_EQ(wal_fel.GetLogFileCounter(), 3);
+    EXPECT_NE(
+        stat(log_file_name("peloton_free_log_", 0).c_str(), &stat_buf), 0);
+    EXPECT_EQ(stat(log_file_name("peloton_log_", 2).c_str(), &stat_buf), 0);
+    write_delimiter(wal_fel, 7);
+  }
+
+  // the stale frame of the reused segment is not read
+  {
+    logging::WriteAheadFrontendLogger wal_fel;
+    EXPECT_EQ(wal_fel.GetLogFileCounter(), 3);
+    EXPECT_EQ(wal_fel.GetMaxDelimiterForRecovery(), 7);
+    wal_fel.OpenNextLogFile();
+    EXPECT_EQ(wal_fel.GetNextLogRecordTypeForRecovery(),
+              LOGRECORD_TYPE_ITERATION_DELIMITER);
+    EXPECT_EQ(wal_fel.GetLogFileCursor(), 2);
+  }
+
+  // a torn frame ends the records of its segment
+  FILE *segment = fopen(log_file_name("peloton_log_", 2).c_str(), "rb+");
+  ASSERT_TRUE(segment != nullptr);
+  char byte = 0x7f;
+  fseek(segment, WAL_DIRECT_IO_ALIGNMENT + 20, SEEK_SET);
+  fwrite(&byte, 1, 1, segment);
+  fclose(segment);
+
+  logging::WriteAheadFrontendLogger wal_fel;
+  wal_fel.OpenNextLogFile();
+  EXPECT_EQ(wal_fel.GetNextLogRecordTypeForRecovery(), LOGRECORD_TYPE_INVALID);
+  EXPECT_EQ(wal_fel.GetLogFileCursor(), 2);
+
+  log_manager.SetLogFileSizeLimit(file_size_limit);
+  auto status = logging::LoggingUtil::RemoveDirectory(dir_name.c_str(), false);
+  EXPECT_EQ(status, true);
+}
+
+TEST_F(RecoveryTests, LogStreamDirectoryTest) {
+  std::string dir_name = logging::WriteAheadFrontendLogger::wal_directory_path;
+  auto &log_manager = logging::LogManager::GetInstance();
+  log_manager.SetLogDirectoryName("./");
+
+  // each stream writes its own segments, the first one where a single
+  // stream does
+  struct stat stat_buf;
+  {
+    logging::WriteAheadFrontendLogger stream_0(false, 0);
+    logging::WriteAheadFrontendLogger stream_1(false, 1);
+    stream_0.CreateNewLogFile(false);
+    stream_1.CreateNewLogFile(false);
+  }
+  EXPECT_EQ(stat((dir_name + "/peloton_log_0.log").c_str(), &stat_buf), 0);
+  EXPECT_EQ(stat((dir_name + "1/peloton_log_0.log").c_str(), &stat_buf), 0);
+
+  // the streams are spread over the log devices
+  log_manager.SetLogStreamDirectoryNames({"./device_0/", "./device_1/"});
+  EXPECT_EQ(log_manager.GetLogStreamDirectoryName(3), "./device_1/");
+  log_manager.SetLogStreamDirectoryNames({});
+  EXPECT_EQ(log_manager.GetLogStreamDirectoryName(3), "./");
+
+  EXPECT_TRUE(logging::LoggingUtil::RemoveDirectory(dir_name.c_str(), false));
+  EXPECT_TRUE(
+      logging::LoggingUtil::RemoveDirectory((dir_name + "1").c_str(), false));
+}
+
+// Each stream recovers its own segments up to the delimiter all the streams
+// reached, and a commit is flushed once the slowest stream flushed it.
+TEST_F(RecoveryTests, MultiStreamRecoveryTest) {
+  auto catalog = catalog::Catalog::GetInstance();
+  auto recovery_table = ExecutorTestsUtil::CreateTable(1024);
+  storage::Database *db = new storage::Database(DEFAULT_DB_ID);
+  catalog->AddDatabase(db);
+  db->AddTable(recovery_table);
+
+  size_t tile_group_size = 5;
+  size_t table_tile_group_count = 3;
+  std::vector<std::shared_ptr<storage::Tuple>> tuples =
+      LoggingTestsUtil::BuildTuples(
+          recovery_table, tile_group_size * table_tile_group_count, false,
+          false);
+  // the records of tile group i commit with commit id i + 2
+  std::vector<logging::TupleRecord> records =
+      LoggingTestsUtil::BuildTupleRecordsForRestartTest(
+          tuples, tile_group_size, table_tile_group_count, 0, 0);
+
+  std::string dir_name = logging::WriteAheadFrontendLogger::wal_directory_path;
+  std::vector<std::string> stream_dir_names = {dir_name, dir_name + "1"};
+  for (auto &stream_dir_name : stream_dir_names) {
+    logging::LoggingUtil::RemoveDirectory(stream_dir_name.c_str(), false);
+    EXPECT_TRUE(
+        logging::LoggingUtil::CreateDirectory(stream_dir_name.c_str(), 0700));
+  }
+  auto &log_manager = logging::LogManager::GetInstance();
+  log_manager.SetLogDirectoryName("./");
+
+  // a segment holds the transaction of one tile group and its delimiter
+  auto write_segment = [&](const std::string &stream_dir_name, int version,
+                           size_t tile_group_itr) {
+    std::string file_name = stream_dir_name + "/peloton_log_" +
+                            std::to_string(version) + ".log";
+    FILE *fp = fopen(file_name.c_str(), "wb");
+    cid_t default_commit_id = INVALID_CID;
+    fwrite((void *)&default_commit_id, sizeof(default_commit_id), 1, fp);
+    fwrite((void *)&default_commit_id, sizeof(default_commit_id), 1, fp);
+
+    cid_t commit_id = tile_group_itr + 2;
+    logging::TransactionRecord record_begin(LOGRECORD_TYPE_TRANSACTION_BEGIN,
+                                            commit_id);
+    CopySerializeOutput output_buffer_begin;
+    record_begin.Serialize(output_buffer_begin);
+    fwrite(record_begin.GetMessage(), sizeof(char),
+           record_begin.GetMessageLength(), fp);
+
+    for (size_t offset = 0; offset < tile_group_size; offset++) {
+      auto &record = records[tile_group_itr * tile_group_size + offset];
+      CopySerializeOutput output_buffer;
+      record.Serialize(output_buffer);
+      fwrite(record.GetMessage(), sizeof(char), record.GetMessageLength(), fp);
+    }
+
+    logging::TransactionRecord record_commit(
+        LOGRECORD_TYPE_TRANSACTION_COMMIT, commit_id);
+    CopySerializeOutput output_buffer_commit;
+    record_commit.Serialize(output_buffer_commit);
+    fwrite(record_commit.GetMessage(), sizeof(char),
+           record_commit.GetMessageLength(), fp);
+
+    logging::TransactionRecord record_delim(
+        LOGRECORD_TYPE_ITERATION_DELIMITER, commit_id);
+    CopySerializeOutput output_buffer_delim;
+    record_delim.Serialize(output_buffer_delim);
+    fwrite(record_delim.GetMessage(), sizeof(char),
+           record_delim.GetMessageLength(), fp);
+    fclose(fp);
+  };
+
+  // stream 0 got up to commit id 4, stream 1 only up to 3
+  write_segment(stream_dir_names[0], 0, 0);
+  write_segment(stream_dir_names[0], 1, 2);
+  write_segment(stream_dir_names[1], 0, 1);
+
+  {
+    logging::WriteAheadFrontendLogger stream_0(false, 0);
+    logging::WriteAheadFrontendLogger stream_1(false, 1);
+    EXPECT_EQ(stream_0.GetMaxDelimiterForRecovery(), 4U);
+    EXPECT_EQ(stream_1.GetMaxDelimiterForRecovery(), 3U);
+
+    // commit id 4 may depend on a commit stream 1 lost
+    log_manager.SetGlobalMaxFlushedIdForRecovery(
+        std::min(stream_0.GetMaxDelimiterForRecovery(),
+                 stream_1.GetMaxDelimiterForRecovery()));
+    logging::WriteAheadFrontendLogger::RecoverStreams({&stream_0, &stream_1});
+    EXPECT_FALSE(log_manager.IsRecoveryFailed());
+    EXPECT_EQ(recovery_table->GetTupleCount(), 2 * tile_group_size);
+  }
+
+  for (auto &stream_dir_name : stream_dir_names) {
+    EXPECT_TRUE(
+        logging::LoggingUtil::RemoveDirectory(stream_dir_name.c_str(), false));
+  }
+  catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
+
+  // the streams flush on their own, the commits wait for the slowest one
+  log_manager.DropFrontendLoggers();
+  log_manager.Configure(LOGGING_TYPE_NVM_WAL, true, 2);
+  log_manager.InitFrontendLoggers();
+  log_manager.GetFrontendLogger(0)->SetMaxFlushedCommitId(5);
+  log_manager.GetFrontendLogger(1)->SetMaxFlushedCommitId(3);
+  EXPECT_EQ(log_manager.GetPersistentFlushedCommitId(), 3U);
+  EXPECT_TRUE(log_manager.WaitForFlush(3));
+
+  std::atomic<bool> flushed(false);
+  std::thread committer([&log_manager, &flushed] {
+    EXPECT_TRUE(log_manager.WaitForFlush(5));
+    flushed = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_FALSE(flushed);
+
+  log_manager.GetFrontendLogger(1)->SetMaxFlushedCommitId(5);
+  log_manager.FrontendLoggerFlushed();
+  committer.join();
+  EXPECT_TRUE(flushed);
+  EXPECT_EQ(log_manager.GetPersistentFlushedCommitId(), 5U);
+
+  log_manager.ResetFrontendLoggers();
+  log_manager.DropFrontendLoggers();
+  log_manager.Configure(LOGGING_TYPE_NVM_WAL, true);
+}
+
+TEST_F(RecoveryTests, CrossStreamUpdateTest) {
+  auto catalog = catalog::Catalog::GetInstance();
+  auto recovery_table = ExecutorTestsUtil::CreateTable(1024);
+  storage::Database *db = new storage::Database(DEFAULT_DB_ID);
+  catalog->AddDatabase(db);
+  db->AddTable(recovery_table);
+
+  auto tuples = BuildLoggingTuples(recovery_table, 2, false, false);
+  Value val0 = tuples[0]->GetValue(0);
+  Value val1 = tuples[1]->GetValue(1);
+
+  std::string dir_name = logging::WriteAheadFrontendLogger::wal_directory_path;
+  std::vector<std::string> stream_dir_names = {dir_name, dir_name + "1"};
+  for (auto &stream_dir_name : stream_dir_names) {
+    logging::LoggingUtil::RemoveDirectory(stream_dir_name.c_str(), false);
+    EXPECT_TRUE(
+        logging::LoggingUtil::CreateDirectory(stream_dir_name.c_str(), 0700));
+  }
+  auto &log_manager = logging::LogManager::GetInstance();
+  log_manager.SetLogDirectoryName("./");
+
+  // a segment holds the transaction of one record and its delimiter
+  auto write_segment = [](const std::string &stream_dir_name,
+                          logging::TupleRecord &record) {
+    std::string file_name = stream_dir_name + "/peloton_log_0.log";
+    FILE *fp = fopen(file_name.c_str(), "wb");
+    cid_t default_commit_id = INVALID_CID;
+    fwrite((void *)&default_commit_id, sizeof(default_commit_id), 1, fp);
+    fwrite((void *)&default_commit_id, sizeof(default_commit_id), 1, fp);
+
+    auto write_txn_record = [&record, fp](LogRecordType record_type) {
+      logging::TransactionRecord txn_record(record_type,
+                                            record.GetTransactionId());
+      CopySerializeOutput output_buffer;
+      txn_record.Serialize(output_buffer);
+      fwrite(txn_record.GetMessage(), sizeof(char),
+             txn_record.GetMessageLength(), fp);
+    };
+
+    write_txn_record(LOGRECORD_TYPE_TRANSACTION_BEGIN);
+    CopySerializeOutput output_buffer;
+    record.Serialize(output_buffer);
+    fwrite(record.GetMessage(), sizeof(char), record.GetMessageLength(), fp);
+    write_txn_record(LOGRECORD_TYPE_TRANSACTION_COMMIT);
+    write_txn_record(LOGRECORD_TYPE_ITERATION_DELIMITER);
+    fclose(fp);
+  };
+
+  // stream 1 inserts the tuple with commit id 2, and stream 0 then updates
+  // only its second column
+  logging::TupleRecord insert_rec(
+      LOGRECORD_TYPE_WAL_TUPLE_INSERT, 2, recovery_table->GetOid(),
+      ItemPointer(100, 4), INVALID_ITEMPOINTER, tuples[0], DEFAULT_DB_ID);
+  logging::TupleRecord update_rec(
+      LOGRECORD_TYPE_WAL_TUPLE_UPDATE, 3, recovery_table->GetOid(),
+      ItemPointer(100, 5), ItemPointer(100, 4), tuples[1], DEFAULT_DB_ID);
+  update_rec.SetColumnIds({1});
+  write_segment(stream_dir_names[0], update_rec);
+  write_segment(stream_dir_names[1], insert_rec);
+  delete tuples[0];
+  delete tuples[1];
+
+  {
+    logging::WriteAheadFrontendLogger stream_0(false, 0);
+    logging::WriteAheadFrontendLogger stream_1(false, 1);
+    log_manager.SetGlobalMaxFlushedIdForRecovery(3);
+
+    // the update of the first stream waits for the insert of the second one
+    logging::WriteAheadFrontendLogger::RecoverStreams({&stream_0, &stream_1});
+    EXPECT_FALSE(log_manager.IsRecoveryFailed());
+  }
+
+  auto tile_group = recovery_table->GetTileGroupById(100);
+  EXPECT_EQ(tile_group->GetHeader()->GetEndCommitId(4), 3U);
+  EXPECT_EQ(tile_group->GetHeader()->GetBeginCommitId(5), 3U);
+  EXPECT_TRUE(val0.Compare(tile_group->GetValue(5, 0)) == 0);
+  EXPECT_TRUE(val1.Compare(tile_group->GetValue(5, 1)) == 0);
+  EXPECT_EQ(recovery_table->GetTupleCount(), 1);
+
+  for (auto &stream_dir_name : stream_dir_names) {
+    EXPECT_TRUE(
+        logging::LoggingUtil::RemoveDirectory(stream_dir_name.c_str(), false));
+  }
+  catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
+}
+
+TEST_F(RecoveryTests, LogManifestTest) {
+  std::string dir_name = logging::WriteAheadFrontendLogger::wal_directory_path;
+  auto &log_manager = logging::LogManager::GetInstance();
+
+  logging::LoggingUtil::RemoveDirectory(dir_name.c_str(), false);
+  log_manager.SetLogDirectoryName("./");
+
+  auto log_file_name = [&dir_name](int version) {
+    return dir_name + "/peloton_log_" + std::to_string(version) + ".log";
+  };
+  struct stat stat_buf;
+
+  {
+    logging::WriteAheadFrontendLogger wal_fel;
+    wal_fel.CreateNewLogFile(false);
+    wal_fel.CreateNewLogFile(true);
+    wal_fel.CreateNewLogFile(true);
+
+    // the segments are recycled on the next flush of the frontend logger
+    wal_fel.RequestTruncation(1);
+    EXPECT_EQ(stat(log_file_name(0).c_str(), &stat_buf), 0);
+    wal_fel.FlushLogRecords();
+
+    EXPECT_NE(stat(log_file_name(0).c_str(), &stat_buf), 0);
+    EXPECT_NE(stat(log_file_name(1).c_str(), &stat_buf), 0);
+    EXPECT_EQ(wal_fel.GetManifestStartSegment(), 2);
+    EXPECT_EQ(wal_fel.GetManifestCommitId(), 1);
+  }
+
+  // a segment the manifest skips is not read, and is kept until a
+  // checkpoint is known to cover it
+  FILE *fp = fopen(log_file_name(0).c_str(), "wb");
+  cid_t header[2] = {5, 5};
+  fwrite(header, sizeof(header), 1, fp);
+  fclose(fp);
+
+  logging::WriteAheadFrontendLogger wal_fel;
+  EXPECT_EQ(wal_fel.GetManifestStartSegment(), 2);
+  EXPECT_EQ(wal_fel.GetManifestCommitId(), 1);
+  EXPECT_EQ(wal_fel.GetLogFileCounter(), 3);
+  EXPECT_EQ(stat(log_file_name(0).c_str(), &stat_buf), 0);
+
+  // recovery fails when the checkpoint does not reach the truncation
+  auto &checkpoint_manager = logging::CheckpointManager::GetInstance();
+  cid_t recovered_commit_id = checkpoint_manager.GetRecoveredCid();
+  checkpoint_manager.SetRecoveredCid(0);
+  wal_fel.DoRecovery();
+  EXPECT_TRUE(log_manager.IsRecoveryFailed());
+  EXPECT_EQ(stat(log_file_name(0).c_str(), &stat_buf), 0);
+  log_manager.ResetLogStatus();
+  checkpoint_manager.SetRecoveredCid(recovered_commit_id);
+
+  // a checkpoint past the truncation covers the segment
+  wal_fel.CreateNewLogFile(false);
+  wal_fel.RequestTruncation(1);
+  wal_fel.FlushLogRecords();
+  EXPECT_NE(stat(log_file_name(0).c_str(), &stat_buf), 0);
+
+  auto status = logging::LoggingUtil::RemoveDirectory(dir_name.c_str(), false);
+  EXPECT_EQ(status, true);
+}
+
 TEST_F(RecoveryTests, BasicInsertTest) {
   auto recovery_table = ExecutorTestsUtil::CreateTable(1024);
   auto catalog = catalog::Catalog::GetInstance();
@@ -369,6 +753,90 @@ TEST_F(RecoveryTests, BasicUpdateTest) {
   catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
 }
 
+TEST_F(RecoveryTests, PartialUpdateTest) {
+  auto catalog = catalog::Catalog::GetInstance();
+  auto recovery_table = ExecutorTestsUtil::CreateTable(1024);
+  storage::Database *db = new storage::Database(DEFAULT_DB_ID);
+  catalog->AddDatabase(db);
+  db->AddTable(recovery_table);
+
+  auto tuples = BuildLoggingTuples(recovery_table, 2, false, false);
+  EXPECT_EQ(tuples.size(), 2);
+  logging::WriteAheadFrontendLogger fel(true);
+  cid_t test_commit_id = 10;
+
+  Value val0 = tuples[0]->GetValue(0);
+  Value val1 = tuples[1]->GetValue(1);
+  Value val2 = tuples[0]->GetValue(2);
+  Value val3 = tuples[0]->GetValue(3);
+
+  // an update that only changes the second column
+  logging::TupleRecord full_rec(
+      LOGRECORD_TYPE_WAL_TUPLE_UPDATE, test_commit_id + 1,
+      recovery_table->GetOid(), ItemPointer(100, 5), ItemPointer(100, 4),
+      tuples[1], DEFAULT_DB_ID);
+  CopySerializeOutput output;
+  full_rec.Serialize(output);
+
+  logging::TupleRecord partial_rec(
+      LOGRECORD_TYPE_WAL_TUPLE_UPDATE, test_commit_id + 1,
+      recovery_table->GetOid(), ItemPointer(100, 5), ItemPointer(100, 4),
+      tuples[1], DEFAULT_DB_ID);
+  partial_rec.SetColumnIds({1});
+  partial_rec.Serialize(output);
+  EXPECT_LT(partial_rec.GetMessageLength(), full_rec.GetMessageLength());
+  delete tuples[1];
+
+  // decode the record, skipping its type
+  logging::TupleRecord decoded_rec(LOGRECORD_TYPE_WAL_TUPLE_UPDATE);
+  CopySerializeInputBE input(partial_rec.GetMessage() + 1,
+                             partial_rec.GetMessageLength() - 1);
+  decoded_rec.DeserializeHeader(input);
+  EXPECT_EQ(test_commit_id + 1, decoded_rec.GetTransactionId());
+  EXPECT_EQ(recovery_table->GetOid(), decoded_rec.GetTableId());
+  EXPECT_EQ(DEFAULT_DB_ID, decoded_rec.GetDatabaseOid());
+  EXPECT_EQ(5, decoded_rec.GetInsertLocation().offset);
+  EXPECT_EQ(4, decoded_rec.GetDeleteLocation().offset);
+  EXPECT_TRUE(decoded_rec.IsPartialImage());
+  decoded_rec.SetTuple(decoded_rec.DeserializeBody(
+      input, recovery_table->GetSchema(),
+      TestingHarness::GetInstance().GetTestingPool()));
+  EXPECT_EQ(std::vector<oid_t>({1}), decoded_rec.GetColumnIds());
+
+  // the old version is recovered first
+  auto curr_rec = new logging::TupleRecord(
+      LOGRECORD_TYPE_TUPLE_INSERT, test_commit_id, recovery_table->GetOid(),
+      ItemPointer(100, 4), INVALID_ITEMPOINTER, tuples[0], DEFAULT_DB_ID);
+  curr_rec->SetTuple(tuples[0]);
+  fel.InsertTuple(curr_rec);
+  delete curr_rec;
+
+  EXPECT_TRUE(fel.UpdateTuple(&decoded_rec));
+
+  auto tile_group = recovery_table->GetTileGroupById(100);
+  EXPECT_EQ(tile_group->GetHeader()->GetEndCommitId(4), test_commit_id + 1);
+  EXPECT_TRUE(val0.Compare(tile_group->GetValue(5, 0)) == 0);
+  EXPECT_TRUE(val1.Compare(tile_group->GetValue(5, 1)) == 0);
+  EXPECT_TRUE(val2.Compare(tile_group->GetValue(5, 2)) == 0);
+  EXPECT_TRUE(val3.Compare(tile_group->GetValue(5, 3)) == 0);
+
+  // a partial update whose old version was never recovered fails the
+  // recovery
+  auto orphan_tuple = new storage::Tuple(recovery_table->GetSchema(), true);
+  orphan_tuple->SetValue(1, val1,
+                         TestingHarness::GetInstance().GetTestingPool());
+  logging::TupleRecord orphan_rec(
+      LOGRECORD_TYPE_WAL_TUPLE_UPDATE, test_commit_id + 2,
+      recovery_table->GetOid(), ItemPointer(100, 7), ItemPointer(100, 6),
+      orphan_tuple, DEFAULT_DB_ID);
+  orphan_rec.SetColumnIds({1});
+  orphan_rec.SetTuple(orphan_tuple);
+  EXPECT_FALSE(fel.UpdateTuple(&orphan_rec));
+  EXPECT_EQ(MAX_CID, tile_group->GetHeader()->GetBeginCommitId(7));
+
+  catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
+}
+
 /* (From Joy) TODO FIX this
 TEST_F(RecoveryTests, BasicDeleteTest) {
   auto recovery_table = ExecutorTestsUtil::CreateTable(1024);
@@ -436,5 +904,185 @@ TEST_F(RecoveryTests, OutOfOrderCommitTest) {
   EXPECT_EQ(recovery_table->GetTileGroupCount(), 2);
 }
 
+TEST_F(RecoveryTests, ReplayShippedLogTest) {
+  auto recovery_table = ExecutorTestsUtil::CreateTable(1024);
+  auto catalog = catalog::Catalog::GetInstance();
+  storage::Database *db = new storage::Database(DEFAULT_DB_ID);
+  catalog->AddDatabase(db);
+  db->AddTable(recovery_table);
+
+  auto tuples = BuildLoggingTuples(recovery_table, 1, false, false);
+  EXPECT_EQ(tuples.size(), 1);
+  cid_t test_commit_id = 10;
+
+  // the first batch holds the insert, the second one its commit
+  std::string first_batch;
+  std::string second_batch;
+
+  logging::TransactionRecord record_begin(LOGRECORD_TYPE_TRANSACTION_BEGIN,
+                                          test_commit_id);
+  CopySerializeOutput output_buffer_begin;
+  record_begin.Serialize(output_buffer_begin);
+  first_batch.append(record_begin.GetMessage(),
+                     record_begin.GetMessageLength());
+
+  logging::TupleRecord record_insert(
+      LOGRECORD_TYPE_WAL_TUPLE_INSERT, test_commit_id,
+      recovery_table->GetOid(), ItemPointer(100, 5), INVALID_ITEMPOINTER,
+      tuples[0], DEFAULT_DB_ID);
+  CopySerializeOutput output_buffer_insert;
+  record_insert.Serialize(output_buffer_insert);
+  first_batch.append(record_insert.GetMessage(),
+                     record_insert.GetMessageLength());
+
+  logging::TransactionRecord record_commit(LOGRECORD_TYPE_TRANSACTION_COMMIT,
+                                           test_commit_id);
+  CopySerializeOutput output_buffer_commit;
+  record_commit.Serialize(output_buffer_commit);
+  second_batch.append(record_commit.GetMessage(),
+                      record_commit.GetMessageLength());
+
+  logging::TransactionRecord record_delim(LOGRECORD_TYPE_ITERATION_DELIMITER,
+                                          test_commit_id);
+  CopySerializeOutput output_buffer_delim;
+  record_delim.Serialize(output_buffer_delim);
+  second_batch.append(record_delim.GetMessage(),
+                      record_delim.GetMessageLength());
+
+  // the other log stream of the primary only ships its delimiter
+  std::string delimiter_batch(record_delim.GetMessage(),
+                              record_delim.GetMessageLength());
+
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  logging::LogReplayer log_replayer;
+  cid_t recovered_commit_id = log_replayer.GetReplayedCommitId();
+
+  // the second batch waits for the first one
+  EXPECT_EQ(log_replayer.Replay(0, 2, second_batch, 2), 0);
+  EXPECT_EQ(log_replayer.GetReplayedCommitId(), recovered_commit_id);
+  EXPECT_EQ(recovery_table->GetTupleCount(), 0);
+
+  // a batch too far ahead is dropped, the primary sends it again
+  EXPECT_EQ(log_replayer.Replay(0, LOG_REPLAY_MAX_PENDING_BATCHES + 1,
+                                second_batch, 2),
+            0);
+
+  // the log stream that has not shipped holds back the snapshot
+  EXPECT_EQ(log_replayer.Replay(0, 1, first_batch, 2), 2);
+  EXPECT_EQ(log_replayer.GetReplayedCommitId(), recovered_commit_id);
+  EXPECT_EQ(recovery_table->GetTupleCount(), 1);
+
+  EXPECT_EQ(log_replayer.Replay(1, 1, delimiter_batch, 2), 1);
+  EXPECT_EQ(log_replayer.GetReplayedCommitId(), test_commit_id);
+  EXPECT_EQ(txn_manager.GetReplayedCid(), test_commit_id);
+
+  // a batch shipped again is not replayed twice
+  EXPECT_EQ(log_replayer.Replay(0, 1, first_batch, 2), 2);
+  EXPECT_EQ(recovery_table->GetTupleCount(), 1);
+
+  log_replayer.Promote();
+  EXPECT_EQ(txn_manager.GetReplayedCid(), INVALID_CID);
+  EXPECT_GT(txn_manager.GetCurrentCommitId(), test_commit_id);
+
+  catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
+}
+
+TEST_F(RecoveryTests, ReplayShippedIndexTest) {
+  auto recovery_table = ExecutorTestsUtil::CreateTable(1024);
+  auto catalog = catalog::Catalog::GetInstance();
+  storage::Database *db = new storage::Database(DEFAULT_DB_ID);
+  catalog->AddDatabase(db);
+  db->AddTable(recovery_table);
+
+  auto tuples = BuildLoggingTuples(recovery_table, 2, false, false);
+  EXPECT_EQ(tuples.size(), 2);
+  cid_t test_commit_id = 10;
+
+  // the primary inserts a tuple, and then changes its second column
+  auto testing_pool = TestingHarness::GetInstance().GetTestingPool();
+  auto updated_tuple = new storage::Tuple(recovery_table->GetSchema(), true);
+  for (oid_t column_id = 0; column_id < 4; column_id++) {
+    updated_tuple->SetValue(column_id, tuples[0]->GetValue(column_id),
+                            testing_pool);
+  }
+  updated_tuple->SetValue(1, tuples[1]->GetValue(1), testing_pool);
+
+  logging::TupleRecord insert_rec(
+      LOGRECORD_TYPE_WAL_TUPLE_INSERT, test_commit_id,
+      recovery_table->GetOid(), ItemPointer(100, 5), INVALID_ITEMPOINTER,
+      tuples[0], DEFAULT_DB_ID);
+  logging::TupleRecord update_rec(
+      LOGRECORD_TYPE_WAL_TUPLE_UPDATE, test_commit_id + 1,
+      recovery_table->GetOid(), ItemPointer(100, 6), ItemPointer(100, 5),
+      updated_tuple, DEFAULT_DB_ID);
+
+  // a batch holds the transaction of one record and its delimiter
+  auto ship_transaction = [](logging::TupleRecord &record) {
+    std::string batch;
+    auto append_txn_record = [&batch, &record](LogRecordType record_type) {
+      logging::TransactionRecord txn_record(record_type,
+                                            record.GetTransactionId());
+      CopySerializeOutput output_buffer;
+      txn_record.Serialize(output_buffer);
+      batch.append(txn_record.GetMessage(), txn_record.GetMessageLength());
+    };
+
+    append_txn_record(LOGRECORD_TYPE_TRANSACTION_BEGIN);
+    CopySerializeOutput output_buffer;
+    record.Serialize(output_buffer);
+    batch.append(record.GetMessage(), record.GetMessageLength());
+    append_txn_record(LOGRECORD_TYPE_TRANSACTION_COMMIT);
+    append_txn_record(LOGRECORD_TYPE_ITERATION_DELIMITER);
+    return batch;
+  };
+
+  // the versions the entries of the key of the tuple in the index lead to
+  typedef std::vector<std::pair<oid_t, oid_t>> Locations;
+  auto lookup = [recovery_table](oid_t index_offset, storage::Tuple *tuple) {
+    auto index = recovery_table->GetIndex(index_offset);
+    std::unique_ptr<storage::Tuple> key(
+        new storage::Tuple(index->GetKeySchema(), true));
+    key->SetFromTuple(tuple, index->GetKeySchema()->GetIndexedColumns(),
+                      index->GetPool());
+    std::vector<ItemPointer *> location_ptrs;
+    index->ScanKey(key.get(), location_ptrs);
+    Locations locations;
+    for (auto location_ptr : location_ptrs) {
+      locations.emplace_back(oid_t(location_ptr->block),
+                             oid_t(location_ptr->offset));
+    }
+    return locations;
+  };
+
+  logging::LogReplayer log_replayer;
+  EXPECT_EQ(log_replayer.Replay(0, 1, ship_transaction(insert_rec), 1), 1);
+  EXPECT_EQ(log_replayer.GetReplayedCommitId(), test_commit_id);
+  EXPECT_EQ(lookup(0, tuples[0]), Locations({{100, 5}}));
+  EXPECT_EQ(lookup(1, tuples[0]), Locations({{100, 5}}));
+
+  // the entries move to the new version, and the changed key of the
+  // secondary index leads to it as well
+  EXPECT_EQ(log_replayer.Replay(0, 2, ship_transaction(update_rec), 1), 2);
+  EXPECT_EQ(log_replayer.GetReplayedCommitId(), test_commit_id + 1);
+  EXPECT_EQ(lookup(0, tuples[0]), Locations({{100, 6}}));
+  EXPECT_EQ(lookup(1, updated_tuple), Locations({{100, 6}}));
+
+  // the promoted standby still enforces the primary key
+  log_replayer.Promote();
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto txn = txn_manager.BeginTransaction();
+  ItemPointer *index_entry_ptr = nullptr;
+  EXPECT_TRUE(
+      recovery_table->InsertTuple(updated_tuple, txn, &index_entry_ptr)
+          .IsNull());
+  txn_manager.AbortTransaction(txn);
+  EXPECT_EQ(lookup(0, tuples[0]), Locations({{100, 6}}));
+
+  delete tuples[0];
+  delete tuples[1];
+  delete updated_tuple;
+  catalog->DropDatabaseWithOid(DEFAULT_DB_ID);
+}
+
 }  // End test namespace
 }  // End peloton namespace
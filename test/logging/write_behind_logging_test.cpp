@@ -11,13 +11,20 @@
 //===----------------------------------------------------------------------===//
 
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+
 #include "common/harness.h"
 
 #include "concurrency/transaction_manager_factory.h"
 #include "executor/logical_tile_factory.h"
 #include "executor/executor_context.h"
 #include "logging/loggers/wal_frontend_logger.h"
+#include "logging/loggers/wbl_frontend_logger.h"
+#include "logging/log_manager.h"
 #include "logging/logging_util.h"
+#include "logging/records/log_record_pool.h"
 #include "storage/data_table.h"
 #include "storage/tile.h"
 #include "storage/table_factory.h"
@@ -162,6 +169,188 @@ TEST_F(WriteBehindLoggingTests, DirtyRangeVisibilityTest) {
   txn_manager.AbortTransaction(txn);
 }
 
+// only the tile groups in the dirty map are undone on recovery
+TEST_F(WriteBehindLoggingTests, DirtyMapRecoveryTest) {
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  auto &log_manager = logging::LogManager::GetInstance();
+
+  std::string log_file_name = "wbl_dirty_map_test.log";
+  remove(log_file_name.c_str());
+  log_manager.SetLogFileName(log_file_name);
+
+  std::unique_ptr<storage::DataTable> dirty_table(
+      ExecutorTestsUtil::CreateTable());
+  std::unique_ptr<storage::DataTable> clean_table(
+      ExecutorTestsUtil::CreateTable());
+  std::unique_ptr<VarlenPool> pool(new VarlenPool(BACKEND_TYPE_MM));
+  cid_t next_cid = txn_manager.GetCurrentCommitId();
+
+  ItemPointer *index_entry_ptr = nullptr;
+  auto txn = txn_manager.BeginTransaction();
+  auto tuple = ExecutorTestsUtil::GetTuple(dirty_table.get(), 1, pool.get());
+  auto dirty = dirty_table->InsertTuple(tuple.get(), txn, &index_entry_ptr);
+  txn_manager.PerformInsert(txn, dirty, index_entry_ptr);
+  tuple = ExecutorTestsUtil::GetTuple(clean_table.get(), 2, pool.get());
+  index_entry_ptr = nullptr;
+  auto clean = clean_table->InsertTuple(tuple.get(), txn, &index_entry_ptr);
+  txn_manager.PerformInsert(txn, clean, index_entry_ptr);
+  txn_manager.CommitTransaction(txn);
+
+  // the commit into the dirty tile group is not durable
+  {
+    logging::WriteBehindFrontendLogger frontend_logger;
+    std::vector<oid_t> tile_group_ids = {dirty.block};
+
+    // in logging mode, the committer waits until a durable group commit has
+    // its tile group in the dirty map
+    auto logging_status = log_manager.GetLoggingStatus();
+    log_manager.SetLoggingStatus(LOGGING_STATUS_TYPE_LOGGING);
+    std::atomic<bool> registered(false);
+    std::thread committer([&frontend_logger, &tile_group_ids, &registered] {
+      frontend_logger.RegisterDirtyTileGroups(tile_group_ids);
+      registered = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(registered);
+
+    frontend_logger.FlushLogRecords();
+    committer.join();
+    EXPECT_TRUE(registered);
+    log_manager.SetLoggingStatus(logging_status);
+
+    frontend_logger.ReleaseDirtyTileGroups(tile_group_ids,
+                                           txn_manager.GetCurrentCommitId());
+    EXPECT_EQ(1UL, frontend_logger.GetDirtyMapVersion());
+  }
+
+  {
+    logging::WriteBehindFrontendLogger frontend_logger;
+    frontend_logger.DoRecovery();
+    EXPECT_EQ(1UL, frontend_logger.GetDirtyMapVersion());
+  }
+
+  auto dirty_header = catalog_manager.GetTileGroup(dirty.block)->GetHeader();
+  auto clean_header = catalog_manager.GetTileGroup(clean.block)->GetHeader();
+  EXPECT_EQ(INVALID_TXN_ID, dirty_header->GetTransactionId(dirty.offset));
+  EXPECT_EQ(INITIAL_TXN_ID, clean_header->GetTransactionId(clean.offset));
+
+  txn_manager.SetNextCid(next_cid + 1);
+  txn_manager.SetMaxGrantCid(MAX_CID);
+  remove(log_file_name.c_str());
+  remove((log_file_name + ".dirty1").c_str());
+}
+
+// a frontend logger whose next group commit makes a given commit id
+// persistent
+class TestWriteBehindFrontendLogger
+    : public logging::WriteBehindFrontendLogger {
+ public:
+  void SetMaxCollectedCommitId(cid_t commit_id) {
+    max_collected_commit_id = commit_id;
+  }
+};
+
+// an undone update leaves the index entry at the version it replaced
+TEST_F(WriteBehindLoggingTests, DirtyMapUndoUpdateTest) {
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto &catalog_manager = catalog::Manager::GetInstance();
+  auto &log_manager = logging::LogManager::GetInstance();
+
+  std::string log_file_name = "wbl_dirty_map_undo_test.log";
+  remove(log_file_name.c_str());
+  log_manager.SetLogFileName(log_file_name);
+
+  std::unique_ptr<storage::DataTable> table(ExecutorTestsUtil::CreateTable());
+  std::unique_ptr<VarlenPool> pool(new VarlenPool(BACKEND_TYPE_MM));
+  cid_t next_cid = txn_manager.GetCurrentCommitId();
+
+  ItemPointer *index_entry_ptr = nullptr;
+  auto txn = txn_manager.BeginTransaction();
+  auto tuple = ExecutorTestsUtil::GetTuple(table.get(), 1, pool.get());
+  auto old_version = table->InsertTuple(tuple.get(), txn, &index_entry_ptr);
+  txn_manager.PerformInsert(txn, old_version, index_entry_ptr);
+  txn_manager.CommitTransaction(txn);
+
+  // the update keeps the key, so the indexes are left alone
+  auto old_header =
+      catalog_manager.GetTileGroup(old_version.block)->GetHeader();
+  txn = txn_manager.BeginTransaction();
+  EXPECT_TRUE(
+      txn_manager.AcquireOwnership(txn, old_header, old_version.offset));
+  auto new_version = table->AcquireVersion();
+  auto new_tile_group = catalog_manager.GetTileGroup(new_version.block);
+  new_tile_group->CopyTuple(tuple.get(), new_version.offset);
+  txn_manager.PerformUpdate(txn, old_version, new_version);
+  txn_manager.CommitTransaction(txn);
+
+  auto new_header = new_tile_group->GetHeader();
+  cid_t insert_commit_id = old_header->GetBeginCommitId(old_version.offset);
+  cid_t update_commit_id = new_header->GetBeginCommitId(new_version.offset);
+  EXPECT_EQ(new_version.offset, index_entry_ptr->offset);
+  EXPECT_EQ(new_version.block, index_entry_ptr->block);
+
+  // only the insert is durable
+  {
+    TestWriteBehindFrontendLogger frontend_logger;
+    std::vector<oid_t> tile_group_ids = {old_version.block, new_version.block};
+    frontend_logger.RegisterDirtyTileGroups(tile_group_ids);
+    frontend_logger.ReleaseDirtyTileGroups(tile_group_ids, update_commit_id);
+    frontend_logger.SetMaxCollectedCommitId(insert_commit_id);
+    frontend_logger.FlushLogRecords();
+  }
+
+  {
+    logging::WriteBehindFrontendLogger frontend_logger;
+    frontend_logger.DoRecovery();
+  }
+
+  EXPECT_EQ(INVALID_TXN_ID, new_header->GetTransactionId(new_version.offset));
+  EXPECT_EQ(INITIAL_TXN_ID, old_header->GetTransactionId(old_version.offset));
+  EXPECT_EQ(MAX_CID, old_header->GetEndCommitId(old_version.offset));
+  EXPECT_TRUE(old_header->GetPrevItemPointer(old_version.offset).IsNull());
+  EXPECT_EQ(old_version.offset, index_entry_ptr->offset);
+  EXPECT_EQ(old_version.block, index_entry_ptr->block);
+
+  txn_manager.SetNextCid(next_cid + 1);
+  txn_manager.SetMaxGrantCid(MAX_CID);
+  remove(log_file_name.c_str());
+  remove((log_file_name + ".dirty1").c_str());
+}
+
+TEST_F(WriteBehindLoggingTests, LogRecordPoolTest) {
+  logging::LogRecordPool record_pool;
+  EXPECT_TRUE(record_pool.IsEmpty());
+
+  // stage records over more than one chunk
+  const size_t record_count = LOG_RECORD_POOL_CHUNK_SIZE + 10;
+  std::vector<logging::TupleRecord *> records;
+  for (size_t record_idx = 0; record_idx < record_count; record_idx++) {
+    records.push_back(record_pool.CreateTupleRecord(
+        LOGRECORD_TYPE_WBL_TUPLE_INSERT, record_idx + 1, 1,
+        ItemPointer(record_idx, 0), INVALID_ITEMPOINTER, 1));
+  }
+  EXPECT_EQ(record_pool.GetRecordCount(), record_count);
+
+  for (size_t record_idx = 0; record_idx < record_count; record_idx++) {
+    auto record = record_pool.GetRecord(record_idx);
+    EXPECT_EQ(record, records[record_idx]);
+    EXPECT_EQ(record->GetTransactionId(), record_idx + 1);
+    EXPECT_EQ(record->GetInsertLocation().block, record_idx);
+  }
+
+  // the next transaction stages its records in the same slots
+  record_pool.Clear();
+  EXPECT_TRUE(record_pool.IsEmpty());
+  for (size_t record_idx = 0; record_idx < record_count; record_idx++) {
+    auto record = record_pool.CreateTupleRecord(
+        LOGRECORD_TYPE_WBL_TUPLE_DELETE, record_idx + 1, 1,
+        INVALID_ITEMPOINTER, ItemPointer(record_idx, 0), 1);
+    EXPECT_EQ(record, records[record_idx]);
+    EXPECT_EQ(record->GetType(), LOGRECORD_TYPE_WBL_TUPLE_DELETE);
+  }
+}
+
 }  // End test namespace
 }  // End peloton namespace
 
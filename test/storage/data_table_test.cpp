@@ -10,11 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>
+#include <thread>
+
 #include "common/harness.h"
 
+#include "common/value_factory.h"
 #include "storage/data_table.h"
+#include "storage/storage_manager.h"
 #include "storage/tile_group.h"
+#include "storage/tile_group_header.h"
 #include "concurrency/transaction_manager_factory.h"
+#include "concurrency/transaction_tests_util.h"
 #include "executor/executor_tests_util.h"
 
 namespace peloton {
@@ -69,6 +76,190 @@ TEST_F(DataTableTests, TransformTileGroupTest) {
   data_table->TransformTileGroup(0, theta);
 }
 
+// Count the live tuples in all tile groups of the table
+static size_t GetLiveTupleCount(storage::DataTable *table) {
+  size_t live_tuple_count = 0;
+  auto tile_group_count = table->GetTileGroupCount();
+  for (size_t tile_group_itr = 0; tile_group_itr < tile_group_count;
+       tile_group_itr++) {
+    auto tile_group = table->GetTileGroup(tile_group_itr);
+    if (tile_group == nullptr) {
+      continue;
+    }
+
+    auto tile_group_header = tile_group->GetHeader();
+    for (oid_t tuple_id = 0; tuple_id < tile_group->GetNextTupleSlot();
+         tuple_id++) {
+      if (tile_group_header->GetTransactionId(tuple_id) == INITIAL_TXN_ID &&
+          tile_group_header->GetEndCommitId(tuple_id) == MAX_CID) {
+        live_tuple_count++;
+      }
+    }
+  }
+  return live_tuple_count;
+}
+
+TEST_F(DataTableTests, CompactTileGroupsTest) {
+  // a hundred tuples per tile group, and an index on the id column
+  const int tuple_count = 300;
+  std::unique_ptr<storage::DataTable> data_table(
+      TransactionTestsUtil::CreateTable(tuple_count));
+
+  // Leave a single live tuple in the first tile group
+  auto &txn_manager = concurrency::TransactionManagerFactory::GetInstance();
+  auto txn = txn_manager.BeginTransaction();
+  auto sparse_tile_group = data_table->GetTileGroup(0);
+  auto sparse_tuple_count = sparse_tile_group->GetNextTupleSlot();
+  for (oid_t id = 1; id < sparse_tuple_count; id++) {
+    EXPECT_TRUE(TransactionTestsUtil::ExecuteDelete(txn, data_table.get(), id));
+  }
+  EXPECT_EQ(Result::RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+
+  // the tiles and the header of the tile group go back to the storage manager
+  auto &storage_manager = storage::StorageManager::GetInstance();
+  size_t released_block_count = sparse_tile_group->NumTiles() + 1;
+  sparse_tile_group.reset();
+
+  size_t live_tuple_count = tuple_count - sparse_tuple_count + 1;
+  EXPECT_EQ(live_tuple_count, GetLiveTupleCount(data_table.get()));
+
+  // Wait till the migrated versions are no longer visible
+  auto release_count = storage_manager.GetReleaseCount();
+  size_t dropped_tile_group_count = 0;
+  for (int wait_itr = 0; wait_itr < 100; wait_itr++) {
+    dropped_tile_group_count += data_table->CompactTileGroups(0.5);
+    if (dropped_tile_group_count > 0) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  EXPECT_EQ(1, (int)dropped_tile_group_count);
+  EXPECT_TRUE(data_table->GetTileGroup(0) == nullptr);
+  EXPECT_GE(storage_manager.GetReleaseCount(),
+            release_count + released_block_count);
+  EXPECT_EQ(live_tuple_count, GetLiveTupleCount(data_table.get()));
+
+  // the index finds the moved tuple, and not the deleted ones
+  txn = txn_manager.BeginTransaction();
+  int result = -1;
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, data_table.get(), 0,
+                                                result));
+  EXPECT_EQ(0, result);
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, data_table.get(), 1,
+                                                result));
+  EXPECT_EQ(-1, result);
+  EXPECT_TRUE(TransactionTestsUtil::ExecuteRead(txn, data_table.get(),
+                                                tuple_count - 1, result));
+  EXPECT_EQ(0, result);
+  EXPECT_EQ(Result::RESULT_SUCCESS, txn_manager.CommitTransaction(txn));
+}
+
+// Column batches with the populated values of the tuples in the given order
+static std::vector<std::vector<Value>> GetColumnBatches(
+    const std::vector<oid_t> &tuple_ids) {
+  std::vector<std::vector<Value>> column_batches(4);
+  for (auto tuple_id : tuple_ids) {
+    column_batches[0].push_back(ValueFactory::GetIntegerValue(
+        ExecutorTestsUtil::PopulatedValue(tuple_id, 0)));
+    column_batches[1].push_back(ValueFactory::GetIntegerValue(
+        ExecutorTestsUtil::PopulatedValue(tuple_id, 1)));
+    column_batches[2].push_back(ValueFactory::GetDoubleValue(
+        ExecutorTestsUtil::PopulatedValue(tuple_id, 2)));
+    column_batches[3].push_back(ValueFactory::GetStringValue(
+        std::to_string(ExecutorTestsUtil::PopulatedValue(tuple_id, 3))));
+  }
+  return column_batches;
+}
+
+TEST_F(DataTableTests, BulkLoadTest) {
+  const int tuples_per_tile_group = TESTS_TUPLES_PER_TILEGROUP;
+  const size_t tuple_count = tuples_per_tile_group * 2 + 1;
+
+  std::unique_ptr<storage::DataTable> data_table(
+      ExecutorTestsUtil::CreateTable(tuples_per_tile_group, true));
+  auto tile_group_count = data_table->GetTileGroupCount();
+
+  // Load the tuples out of key order
+  std::vector<oid_t> tuple_ids;
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    tuple_ids.push_back(tuple_count - tuple_id - 1);
+  }
+  EXPECT_TRUE(data_table->BulkLoad(GetColumnBatches(tuple_ids)));
+
+  EXPECT_EQ(tile_group_count + 3, data_table->GetTileGroupCount());
+  EXPECT_EQ(tuple_count, data_table->GetTupleCount());
+  EXPECT_EQ(tuple_count, GetLiveTupleCount(data_table.get()));
+
+  // The values were written column at a time
+  auto tile_group = data_table->GetTileGroup(tile_group_count);
+  EXPECT_EQ(0, tile_group->GetValue(0, 0).Compare(ValueFactory::GetIntegerValue(
+                   ExecutorTestsUtil::PopulatedValue(tuple_count - 1, 0))));
+  EXPECT_EQ(0, tile_group->GetValue(0, 3).Compare(ValueFactory::GetStringValue(
+                   std::to_string(ExecutorTestsUtil::PopulatedValue(
+                       tuple_count - 1, 3)))));
+
+  // Every key can be found in the primary index
+  auto primary_index = data_table->GetIndex(0);
+  auto key_schema = primary_index->GetKeySchema();
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+    key->SetValue(0, ValueFactory::GetIntegerValue(
+                         ExecutorTestsUtil::PopulatedValue(tuple_id, 0)),
+                  nullptr);
+    std::vector<ItemPointer *> location_ptrs;
+    primary_index->ScanKey(key.get(), location_ptrs);
+    EXPECT_EQ(1, (int)location_ptrs.size());
+  }
+
+  // Duplicate keys within a batch and against the table are rejected
+  EXPECT_FALSE(
+      data_table->BulkLoad(GetColumnBatches({tuple_count, tuple_count})));
+  EXPECT_FALSE(data_table->BulkLoad(GetColumnBatches({0})));
+  EXPECT_EQ(tuple_count, data_table->GetTupleCount());
+  EXPECT_EQ(tuple_count, GetLiveTupleCount(data_table.get()));
+
+  // Malformed batches are rejected
+  auto column_batches = GetColumnBatches({tuple_count + 1});
+  column_batches[1].clear();
+  EXPECT_FALSE(data_table->BulkLoad(column_batches));
+}
+
+TEST_F(DataTableTests, BulkLoadRollbackTest) {
+  const int tuples_per_tile_group = TESTS_TUPLES_PER_TILEGROUP;
+
+  std::unique_ptr<storage::DataTable> data_table(
+      ExecutorTestsUtil::CreateTable(tuples_per_tile_group, true));
+  EXPECT_TRUE(data_table->BulkLoad(GetColumnBatches({5})));
+  auto tile_group_count = data_table->GetTileGroupCount();
+
+  // Keys 1 and 2 are inserted in the primary index before 5 violates it
+  EXPECT_FALSE(data_table->BulkLoad(GetColumnBatches({1, 2, 5})));
+  EXPECT_EQ(1, (int)data_table->GetTupleCount());
+  EXPECT_EQ(1, (int)GetLiveTupleCount(data_table.get()));
+
+  // The appended tile group is gone again
+  EXPECT_EQ(tile_group_count + 1, data_table->GetTileGroupCount());
+  EXPECT_TRUE(data_table->GetTileGroup(tile_group_count) == nullptr);
+
+  // So are the index entries of the keys inserted before the violation
+  auto primary_index = data_table->GetIndex(0);
+  auto key_schema = primary_index->GetKeySchema();
+  for (oid_t tuple_id : {1, 2}) {
+    std::unique_ptr<storage::Tuple> key(new storage::Tuple(key_schema, true));
+    key->SetValue(0, ValueFactory::GetIntegerValue(
+                         ExecutorTestsUtil::PopulatedValue(tuple_id, 0)),
+                  nullptr);
+    std::vector<ItemPointer *> location_ptrs;
+    primary_index->ScanKey(key.get(), location_ptrs);
+    EXPECT_EQ(0, (int)location_ptrs.size());
+  }
+
+  // and the keys can be loaded again
+  EXPECT_TRUE(data_table->BulkLoad(GetColumnBatches({1, 2})));
+  EXPECT_EQ(3, (int)GetLiveTupleCount(data_table.get()));
+}
+
 std::unique_ptr<storage::DataTable> data_table_test_table;
 
 TEST_F(DataTableTests, GlobalTableTest) {
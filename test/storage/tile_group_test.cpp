@@ -544,5 +544,59 @@ TEST_F(TileGroupTests, TileCopyTest) {
   delete schema;
 }
 
+TEST_F(TileGroupTests, TileGroupHeaderTest) {
+  const int tuple_count = 10;
+  storage::TileGroupHeader header(BACKEND_TYPE_MM, tuple_count);
+
+  // Fill every field of every slot with distinct values
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    header.SetTransactionId(tuple_id, tuple_id + 1);
+    header.SetBeginCommitId(tuple_id, tuple_id + 100);
+    header.SetEndCommitId(tuple_id, tuple_id + 200);
+    header.SetNextItemPointer(tuple_id, ItemPointer(tuple_id, 1));
+    header.SetPrevItemPointer(tuple_id, ItemPointer(tuple_id, 2));
+    header.SetVersionHint(tuple_id, ItemPointer(tuple_id, 3));
+    PL_MEMSET(header.GetReservedFieldRef(tuple_id), (int)tuple_id,
+              storage::TileGroupHeader::GetReservedSize());
+    header.SetAbortCount(tuple_id, tuple_id + 300);
+  }
+
+  // The fields must not overlap
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    EXPECT_EQ(tuple_id + 1, header.GetTransactionId(tuple_id));
+    EXPECT_EQ(tuple_id + 100, header.GetBeginCommitId(tuple_id));
+    EXPECT_EQ(tuple_id + 200, header.GetEndCommitId(tuple_id));
+    EXPECT_EQ(tuple_id, header.GetNextItemPointer(tuple_id).block);
+    EXPECT_EQ(1, (int)header.GetNextItemPointer(tuple_id).offset);
+    EXPECT_EQ(tuple_id, header.GetPrevItemPointer(tuple_id).block);
+    EXPECT_EQ(2, (int)header.GetPrevItemPointer(tuple_id).offset);
+    EXPECT_EQ(tuple_id, header.GetVersionHint(tuple_id).block);
+    EXPECT_EQ(3, (int)header.GetVersionHint(tuple_id).offset);
+    auto reserved_field = header.GetReservedFieldRef(tuple_id);
+    for (size_t byte_itr = 0;
+         byte_itr < storage::TileGroupHeader::GetReservedSize(); byte_itr++) {
+      EXPECT_EQ((char)tuple_id, reserved_field[byte_itr]);
+    }
+    EXPECT_EQ(tuple_id + 300, header.GetAbortCount(tuple_id));
+  }
+
+  // Placing the header on a NUMA node keeps every field
+  header.MoveToNumaNode(NumaUtil::GetNodeCount() - 1);
+  for (oid_t tuple_id = 0; tuple_id < tuple_count; tuple_id++) {
+    EXPECT_EQ(tuple_id + 1, header.GetTransactionId(tuple_id));
+    EXPECT_EQ(tuple_id + 100, header.GetBeginCommitId(tuple_id));
+    EXPECT_EQ(tuple_id + 200, header.GetEndCommitId(tuple_id));
+    EXPECT_EQ(tuple_id, header.GetVersionHint(tuple_id).block);
+    EXPECT_EQ(tuple_id + 300, header.GetAbortCount(tuple_id));
+  }
+
+  // The abort counter saturates
+  header.SetAbortCount(0, UINT32_MAX);
+  header.IncrementAbortCount(0);
+  EXPECT_EQ(UINT32_MAX, header.GetAbortCount(0));
+  header.IncrementAbortCount(1);
+  EXPECT_EQ(302, (int)header.GetAbortCount(1));
+}
+
 }  // End test namespace
 }  // End peloton namespace